@@ -0,0 +1,148 @@
+// Blocked Cholesky timing and residual check against the unblocked baseline
+// Usage: cholesky [factors] [threads]  (default 5,000, every hardware thread)
+// Builds a unit-diagonal factor-model correlation matrix (10 global factors
+// plus idiosyncratic variance), factors it with the nested-vector
+// Cholesky-Banachiewicz the engine used before the flat buffer, and with
+// CorrelationMatrix::cholesky_in_place on one thread and on `threads`.
+// Reports the time of each, the largest difference between the blocked and
+// baseline factors, and max |L L^T - C| over the diagonal and a random
+// sample of off-diagonal entries (the full product is another n^3/3).
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/marketEnvironment.hh"
+
+constexpr size_t kFactors = 10;
+constexpr size_t kResidualSamples = 20000;
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// C = B B^T + D, rows of B scaled so that diag(C) = 1 (flat column-major)
+static std::vector<double> factor_correlation(size_t n) {
+    std::mt19937_64 rng(11);
+    std::uniform_real_distribution<double> loading(-0.5, 0.5);
+    std::vector<double> b(n * kFactors);
+    for (double& x : b) x = loading(rng);
+
+    std::vector<double> c(n * n);
+    for (size_t j = 0; j < n; ++j) {
+        for (size_t i = j; i < n; ++i) {
+            double sum = 0.0;
+            for (size_t f = 0; f < kFactors; ++f) sum += b[i * kFactors + f] * b[j * kFactors + f];
+            c[j * n + i] = sum;
+            c[i * n + j] = sum;
+        }
+    }
+    // Idiosyncratic share of 20% at least, then rescale to unit diagonal
+    std::vector<double> scale(n);
+    for (size_t i = 0; i < n; ++i) {
+        double systematic = c[i * n + i];
+        double total = systematic / 0.8;
+        c[i * n + i] = total;
+        scale[i] = 1.0 / std::sqrt(total);
+    }
+    for (size_t j = 0; j < n; ++j) {
+        for (size_t i = 0; i < n; ++i) c[j * n + i] *= scale[i] * scale[j];
+    }
+    return c;
+}
+
+// Cholesky-Banachiewicz on nested rows: the engine's original factorization
+static std::vector<std::vector<double>> baseline_cholesky(const std::vector<double>& c, size_t n) {
+    std::vector<std::vector<double>> l(n, std::vector<double>(n, 0.0));
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j <= i; ++j) {
+            double sum = 0.0;
+            for (size_t k = 0; k < j; ++k) {
+                sum += l[i][k] * l[j][k];
+            }
+            if (i == j) {
+                double val = c[i * n + i] - sum;
+                if (val < 0) {
+                    throw std::runtime_error("Correlation matrix is not positive semi-definite");
+                }
+                l[i][j] = std::sqrt(val);
+            } else {
+                l[i][j] = (c[j * n + i] - sum) / l[j][j];
+            }
+        }
+    }
+    return l;
+}
+
+// max |(L L^T)(i, j) - C(i, j)| over the diagonal and sampled (i, j), i > j
+static double sampled_residual(const std::vector<double>& l, const std::vector<double>& c, size_t n) {
+    auto entry = [&](size_t i, size_t j) {
+        double sum = 0.0;
+        for (size_t k = 0; k <= j; ++k) sum += l[k * n + i] * l[k * n + j];
+        return std::abs(sum - c[j * n + i]);
+    };
+    double worst = 0.0;
+    for (size_t i = 0; i < n; ++i) worst = std::max(worst, entry(i, i));
+    std::mt19937_64 rng(5);
+    std::uniform_int_distribution<size_t> index(0, n - 1);
+    for (size_t s = 0; s < kResidualSamples; ++s) {
+        size_t i = index(rng), j = index(rng);
+        if (i < j) std::swap(i, j);
+        worst = std::max(worst, entry(i, j));
+    }
+    return worst;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 5000;
+    size_t threads = argc > 2 ? std::stoul(argv[2]) : hardware_threads();
+
+    std::cout << "Factors: " << n << ", block " << CorrelationMatrix::kCholeskyBlock
+              << ", threads: " << threads << "\n";
+    std::vector<double> c = factor_correlation(n);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<double>> baseline = baseline_cholesky(c, n);
+    double baseline_ms = elapsed_ms(start);
+
+    std::vector<double> serial = c;
+    start = std::chrono::steady_clock::now();
+    CorrelationMatrix::cholesky_in_place(serial.data(), n, 1);
+    double serial_ms = elapsed_ms(start);
+
+    std::vector<double> blocked = c;
+    start = std::chrono::steady_clock::now();
+    CorrelationMatrix::cholesky_in_place(blocked.data(), n, threads);
+    double blocked_ms = elapsed_ms(start);
+
+    double max_diff = 0.0;
+    bool serial_matches = true;
+    for (size_t j = 0; j < n; ++j) {
+        for (size_t i = 0; i < n; ++i) {
+            double expected = i >= j ? baseline[i][j] : 0.0;
+            max_diff = std::max(max_diff, std::abs(blocked[j * n + i] - expected));
+            serial_matches = serial_matches && serial[j * n + i] == blocked[j * n + i];
+        }
+    }
+    double residual = sampled_residual(blocked, c, n);
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Baseline (nested rows):       " << baseline_ms << " ms\n";
+    std::cout << "Blocked, 1 thread:            " << serial_ms << " ms ("
+              << std::setprecision(2) << baseline_ms / serial_ms << "x)\n";
+    std::cout << std::setprecision(1);
+    std::cout << "Blocked, " << threads << " thread(s):         " << blocked_ms << " ms ("
+              << std::setprecision(2) << baseline_ms / blocked_ms << "x)\n";
+    std::cout << std::scientific << std::setprecision(2);
+    std::cout << "max |L - L_baseline|:         " << max_diff << "\n";
+    std::cout << "max |L L^T - C| (sampled):    " << residual << "\n";
+    std::cout << "Thread count changes L:       " << (serial_matches ? "no" : "YES") << "\n";
+
+    bool ok = max_diff < 1e-10 && residual < 1e-12 && serial_matches;
+    std::cout << (ok ? "PASS" : "FAIL") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,354 @@
+// Correlation sampling checks: structured correlation and regime switching
+// Usage: correlationSampling [samples] [assets]  (default 20,000 and 2,000)
+// Structured: builds a StructuredCorrelation (3 global factors, 20 sectors
+// with a within-sector residual correlation) and the same matrix densely.
+// Draws `samples` correlated vectors through correlate_batch and compares
+// the empirical correlation of 2,000 random pairs (and every asset's
+// variance) to the target, in units of its standard error. Also checks
+// that get_correlation returns the target, and times a correlated sample
+// against the dense Cholesky correlate_batch of the same matrix.
+// Regimes: runs the 3-regime Markov chain through next_regime and compares
+// transition frequencies to the transition matrix and occupancy to its
+// stationary distribution. Then simulates daily paths with the regimes in
+// the environment. The cross-path correlation of each step's returns must
+// match the mix of regime correlations implied by p_0 P^t. Times a path
+// step with regimes against one dense matrix.
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/marketEnvironment.hh"
+#include "../include/model.hh"
+#include "../include/normalMath.hh"
+
+constexpr size_t kFactors = 3;
+constexpr size_t kSectors = 20;
+constexpr double kSectorCorrelation = 0.15;
+constexpr size_t kCheckedPairs = 2000;
+constexpr size_t kBatch = 500;
+constexpr double kMaxZScore = 5.0;
+
+constexpr double kRegimeCorrelation[] = {0.1, 0.5, 0.9};  // Calm, normal, stressed
+constexpr double kTransitions[3][3] = {{0.95, 0.04, 0.01}, {0.10, 0.85, 0.05}, {0.05, 0.15, 0.80}};
+constexpr size_t kChainSteps = 2000000;
+constexpr double kMaxOccupancyError = 0.01;  // The chain is autocorrelated: absolute bound
+constexpr size_t kRegimeAssets = 4;
+constexpr size_t kRegimeSteps = 20;
+constexpr size_t kRegimePaths = 40000;
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Structured model inputs and the dense target C = B B^T + within-sector term, unit diagonal
+struct StructuredFixture {
+    std::vector<std::string> tickers;
+    std::vector<std::vector<double>> loadings;
+    std::vector<size_t> sector_of;
+    std::vector<std::vector<std::vector<double>>> sector_blocks;
+
+    explicit StructuredFixture(size_t n) {
+        std::mt19937_64 rng(17);
+        std::uniform_real_distribution<double> market(0.2, 0.5), style(-0.2, 0.2);
+        std::vector<size_t> sector_size(kSectors, 0);
+        for (size_t i = 0; i < n; ++i) {
+            tickers.push_back("A" + std::to_string(i));
+            loadings.push_back({market(rng), style(rng), style(rng)});
+            sector_of.push_back(i % kSectors);
+            ++sector_size[i % kSectors];
+        }
+        for (size_t s = 0; s < kSectors; ++s) {
+            sector_blocks.emplace_back(sector_size[s], std::vector<double>(sector_size[s], kSectorCorrelation));
+        }
+    }
+
+    double target(size_t i, size_t j) const {
+        if (i == j) return 1.0;
+        double c = 0.0;
+        for (size_t f = 0; f < kFactors; ++f) c += loadings[i][f] * loadings[j][f];
+        return sector_of[i] == sector_of[j] ? c + kSectorCorrelation : c;
+    }
+
+    // Flat column-major dense matrix
+    std::vector<double> dense() const {
+        size_t n = tickers.size();
+        std::vector<double> c(n * n);
+        for (size_t j = 0; j < n; ++j) {
+            for (size_t i = 0; i < n; ++i) c[j * n + i] = target(i, j);
+        }
+        return c;
+    }
+};
+
+struct SamplingError {
+    double max_abs = 0.0;  // Largest |empirical - target|
+    double max_z = 0.0;    // ... in standard errors
+};
+
+// Empirical variances of every asset and correlations of `pairs`, from
+// `samples` draws of sample(z_in, z_out, count); checked against `target`
+template <typename Sample, typename Target>
+static SamplingError check_sampling(size_t n, size_t inputs, size_t samples,
+                                    const std::vector<std::pair<size_t, size_t>>& pairs,
+                                    Sample&& sample, Target&& target) {
+    std::mt19937 rng(29);
+    std::vector<double> z(kBatch * inputs), out(kBatch * n);
+    std::vector<double> sum(n, 0.0), sum_sq(n, 0.0), cross(pairs.size(), 0.0);
+    for (size_t done = 0; done < samples; done += kBatch) {
+        size_t count = std::min(kBatch, samples - done);
+        fill_normals(rng, z.data(), count * inputs);
+        sample(z.data(), out.data(), count);
+        for (size_t s = 0; s < count; ++s) {
+            const double* x = &out[s * n];
+            for (size_t i = 0; i < n; ++i) {
+                sum[i] += x[i];
+                sum_sq[i] += x[i] * x[i];
+            }
+            for (size_t p = 0; p < pairs.size(); ++p) cross[p] += x[pairs[p].first] * x[pairs[p].second];
+        }
+    }
+
+    double m = static_cast<double>(samples);
+    SamplingError err;
+    auto record = [&](double empirical, double expected, double standard_error) {
+        err.max_abs = std::max(err.max_abs, std::abs(empirical - expected));
+        err.max_z = std::max(err.max_z, std::abs(empirical - expected) / standard_error);
+    };
+    std::vector<double> sd(n);
+    for (size_t i = 0; i < n; ++i) {
+        double var = sum_sq[i] / m - (sum[i] / m) * (sum[i] / m);
+        sd[i] = std::sqrt(var);
+        record(var, 1.0, std::sqrt(2.0 / m));
+    }
+    for (size_t p = 0; p < pairs.size(); ++p) {
+        auto [i, j] = pairs[p];
+        double cov = cross[p] / m - (sum[i] / m) * (sum[j] / m);
+        double rho = target(i, j);
+        record(cov / (sd[i] * sd[j]), rho, (1.0 - rho * rho) / std::sqrt(m));
+    }
+    return err;
+}
+
+// Mean time per correlated sample of sample(z_in, z_out, count)
+template <typename Sample>
+static double ns_per_sample(size_t n, size_t inputs, size_t samples, Sample&& sample) {
+    std::mt19937 rng(31);
+    std::vector<double> z(kBatch * inputs), out(kBatch * n);
+    fill_normals(rng, z.data(), z.size());
+    auto start = std::chrono::steady_clock::now();
+    for (size_t done = 0; done < samples; done += kBatch) {
+        sample(z.data(), out.data(), std::min(kBatch, samples - done));
+    }
+    return 1e6 * elapsed_ms(start) / static_cast<double>(samples);
+}
+
+static CorrelationMatrix equicorrelation(const std::vector<std::string>& tickers, double rho) {
+    std::vector<std::vector<double>> c(tickers.size(), std::vector<double>(tickers.size(), rho));
+    for (size_t i = 0; i < tickers.size(); ++i) c[i][i] = 1.0;
+    return CorrelationMatrix(tickers, c);
+}
+
+// Regime chain and path engine checks; returns pass/fail
+static bool check_regimes() {
+    constexpr size_t m = std::size(kRegimeCorrelation);
+    std::vector<std::string> tickers;
+    for (size_t a = 0; a < kRegimeAssets; ++a) tickers.push_back("R" + std::to_string(a));
+    std::vector<CorrelationMatrix> matrices;
+    std::vector<std::vector<double>> transitions(m);
+    for (size_t r = 0; r < m; ++r) {
+        matrices.push_back(equicorrelation(tickers, kRegimeCorrelation[r]));
+        transitions[r].assign(std::begin(kTransitions[r]), std::end(kTransitions[r]));
+    }
+    CorrelationRegimes regimes(matrices, transitions, 0);
+
+    // Stationary distribution by power iteration
+    std::vector<double> stationary(m, 1.0 / m);
+    for (int it = 0; it < 10000; ++it) {
+        std::vector<double> next(m, 0.0);
+        for (size_t from = 0; from < m; ++from) {
+            for (size_t to = 0; to < m; ++to) next[to] += stationary[from] * kTransitions[from][to];
+        }
+        stationary = next;
+    }
+
+    // 1. The chain alone
+    std::mt19937_64 rng(37);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<double> visits(m, 0.0), moves(m * m, 0.0);
+    size_t current = regimes.get_initial_regime();
+    for (size_t step = 0; step < kChainSteps; ++step) {
+        size_t next = regimes.next_regime(current, uniform(rng));
+        moves[current * m + next] += 1.0;
+        visits[next] += 1.0;
+        current = next;
+    }
+    double transition_z = 0.0, occupancy_error = 0.0;
+    for (size_t from = 0; from < m; ++from) {
+        double leaving = 0.0;
+        for (size_t to = 0; to < m; ++to) leaving += moves[from * m + to];
+        for (size_t to = 0; to < m; ++to) {
+            double p = kTransitions[from][to];
+            double se = std::sqrt(p * (1.0 - p) / leaving);
+            transition_z = std::max(transition_z, std::abs(moves[from * m + to] / leaving - p) / se);
+        }
+        occupancy_error = std::max(occupancy_error, std::abs(visits[from] / kChainSteps - stationary[from]));
+    }
+
+    // 2. The path engine: step t correlates with regime mix p_0 P^t
+    MarketEnvironment env;
+    env.set_yield_curve("USD", YieldCurve(0.02));
+    std::map<std::string, double> spots;
+    for (const auto& ticker : tickers) {
+        env.set_spot(ticker, 100.0);
+        env.set_vol_surface(ticker, VolatilitySurface(0.25));
+        spots[ticker] = 100.0;
+    }
+    std::vector<double> dates;
+    for (size_t t = 1; t <= kRegimeSteps; ++t) dates.push_back(t / 252.0);
+
+    BlackScholesModel model;
+    MultiAssetSimulator single_sim(model, 41);
+    env.set_correlation_matrix(matrices[0]);
+    auto start = std::chrono::steady_clock::now();
+    single_sim.simulate_scenario_cube<double>(spots, dates, kRegimePaths, 252, env);
+    double single_ms = elapsed_ms(start);
+
+    MultiAssetSimulator regime_sim(model, 43);
+    env.set_correlation_regimes(regimes);
+    start = std::chrono::steady_clock::now();
+    ScenarioCube<double> cube = regime_sim.simulate_scenario_cube<double>(spots, dates, kRegimePaths, 252, env);
+    double regime_ms = elapsed_ms(start);
+
+    std::vector<double> mix(m, 0.0);
+    mix[regimes.get_initial_regime()] = 1.0;
+    double path_z = 0.0, path_error = 0.0, first = 0.0, last = 0.0;
+    std::vector<double> z(kRegimePaths * kRegimeAssets);
+    for (size_t t = 0; t < kRegimeSteps; ++t) {
+        std::vector<double> next(m, 0.0);
+        for (size_t from = 0; from < m; ++from) {
+            for (size_t to = 0; to < m; ++to) next[to] += mix[from] * kTransitions[from][to];
+        }
+        mix = next;
+        double expected = 0.0;
+        for (size_t r = 0; r < m; ++r) expected += mix[r] * kRegimeCorrelation[r];
+
+        // Standardized log returns of the step, then the mean pairwise product
+        for (size_t a = 0; a < kRegimeAssets; ++a) {
+            double sum = 0.0, sum_sq = 0.0;
+            for (size_t path = 0; path < kRegimePaths; ++path) {
+                double before = t == 0 ? spots[cube.tickers[a]] : cube.get_path(t - 1, path)[a];
+                double x = std::log(cube.get_path(t, path)[a] / before);
+                z[path * kRegimeAssets + a] = x;
+                sum += x;
+                sum_sq += x * x;
+            }
+            double mean = sum / kRegimePaths;
+            double sd = std::sqrt(sum_sq / kRegimePaths - mean * mean);
+            for (size_t path = 0; path < kRegimePaths; ++path) {
+                double& x = z[path * kRegimeAssets + a];
+                x = (x - mean) / sd;
+            }
+        }
+        double sum = 0.0, sum_sq = 0.0;
+        for (size_t path = 0; path < kRegimePaths; ++path) {
+            const double* x = &z[path * kRegimeAssets];
+            double product = 0.0;
+            for (size_t i = 0; i < kRegimeAssets; ++i) {
+                for (size_t j = i + 1; j < kRegimeAssets; ++j) product += x[i] * x[j];
+            }
+            product /= kRegimeAssets * (kRegimeAssets - 1) / 2;
+            sum += product;
+            sum_sq += product * product;
+        }
+        double empirical = sum / kRegimePaths;
+        double se = std::sqrt((sum_sq / kRegimePaths - empirical * empirical) / kRegimePaths);
+        path_error = std::max(path_error, std::abs(empirical - expected));
+        path_z = std::max(path_z, std::abs(empirical - expected) / se);
+        if (t == 0) first = empirical;
+        last = empirical;
+    }
+
+    double path_steps = static_cast<double>(kRegimePaths * kRegimeSteps);
+    std::cout << "Correlation regimes: " << m << " regimes (rho " << kRegimeCorrelation[0] << "/"
+              << kRegimeCorrelation[1] << "/" << kRegimeCorrelation[2] << ")\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "  Chain, " << kChainSteps << " steps: transition frequencies within " << transition_z
+              << " std errors; occupancy";
+    for (size_t r = 0; r < m; ++r) std::cout << " " << std::setprecision(3) << visits[r] / kChainSteps;
+    std::cout << " vs stationary";
+    for (size_t r = 0; r < m; ++r) std::cout << " " << stationary[r];
+    std::cout << "\n";
+    std::cout << "  Paths, " << kRegimePaths << " x " << kRegimeSteps << " days: step correlation "
+              << std::setprecision(3) << first << " -> " << last << ", max |err| vs p0 P^t mix " << std::setprecision(4) << path_error
+              << " (" << std::setprecision(2) << path_z << " std errors)\n";
+    std::cout << std::setprecision(1);
+    std::cout << "  Per path-step: regimes " << 1e6 * regime_ms / path_steps << " ns, one dense matrix "
+              << 1e6 * single_ms / path_steps << " ns\n";
+    return transition_z < kMaxZScore && occupancy_error < kMaxOccupancyError && path_z < kMaxZScore;
+}
+
+int main(int argc, char* argv[]) {
+    size_t samples = argc > 1 ? std::stoul(argv[1]) : 20000;
+    size_t n = argc > 2 ? std::stoul(argv[2]) : 2000;
+    bool ok = true;
+
+    StructuredFixture fixture(n);
+    StructuredCorrelation structured(fixture.tickers, fixture.loadings, fixture.sector_of, fixture.sector_blocks);
+    auto start = std::chrono::steady_clock::now();
+    CorrelationMatrix dense = CorrelationMatrix::from_column_major(fixture.tickers, fixture.dense());
+    double dense_factor_ms = elapsed_ms(start);
+
+    // Half the pairs within a sector, half across
+    std::mt19937_64 rng(23);
+    std::uniform_int_distribution<size_t> asset(0, n - 1);
+    std::vector<std::pair<size_t, size_t>> pairs;
+    while (pairs.size() < kCheckedPairs) {
+        size_t i = asset(rng), j = asset(rng);
+        bool same_sector = fixture.sector_of[i] == fixture.sector_of[j];
+        if (i != j && same_sector == (pairs.size() % 2 == 0)) pairs.emplace_back(i, j);
+    }
+    auto target = [&](size_t i, size_t j) { return fixture.target(i, j); };
+
+    double implied_error = 0.0;
+    for (auto [i, j] : pairs) {
+        implied_error = std::max(implied_error, std::abs(structured.get_correlation(fixture.tickers[i], fixture.tickers[j]) -
+                                                         fixture.target(i, j)));
+    }
+
+    size_t inputs = structured.num_random_inputs();
+    auto structured_sample = [&](const double* z, double* out, size_t count) {
+        structured.correlate_batch(z, out, count);
+    };
+    auto dense_sample = [&](const double* z, double* out, size_t count) {
+        dense.correlate_batch(z, out, count);
+    };
+    SamplingError err = check_sampling(n, inputs, samples, pairs, structured_sample, target);
+
+    size_t timed = std::min<size_t>(samples, 2000);
+    double structured_ns = ns_per_sample(n, inputs, timed, structured_sample);
+    double dense_ns = ns_per_sample(n, n, timed, dense_sample);
+
+    std::cout << "Structured correlation: " << n << " assets, " << kFactors << " factors, " << kSectors
+              << " sectors, " << samples << " samples\n";
+    std::cout << std::scientific << std::setprecision(2);
+    std::cout << "  get_correlation vs target:      " << implied_error << "\n";
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "  Empirical vs target, max |err|: " << err.max_abs << " (" << std::setprecision(2)
+              << err.max_z << " std errors, " << kCheckedPairs << " pairs + variances)\n";
+    std::cout << std::setprecision(1);
+    std::cout << "  Per sample: structured " << structured_ns / 1000.0 << " us, dense Cholesky "
+              << dense_ns / 1000.0 << " us (" << std::setprecision(2) << dense_ns / structured_ns
+              << "x); dense factorization " << std::setprecision(1) << dense_factor_ms << " ms\n";
+    ok &= implied_error < 1e-12 && err.max_z < kMaxZScore;
+    ok &= check_regimes();
+
+    std::cout << (ok ? "PASS" : "FAIL") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+// Curve bootstrap accuracy and re-bootstrap latency
+// Usage: curveBootstrap [ticks]  (default 100,000)
+// Bootstraps a deposit / FRA / futures / semi-annual swap curve, checks that
+// the curve reprices every quote, then replays random single-quote ticks
+// through update_quote and compares the result against a from-scratch
+// bootstrap of the final quotes. Fails if a repricing error or the zero
+// rate difference reaches 1e-12.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/curveBootstrap.hh"
+
+constexpr double kMaxError = 1e-12;  // Rate units
+
+static double elapsed_us(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::vector<RateQuote> usd_quotes() {
+    std::vector<RateQuote> quotes;
+    auto add = [&](RateInstrument type, double start, double maturity, double value, unsigned frequency = 1) {
+        RateQuote q;
+        q.type = type;
+        q.start = start;
+        q.maturity = maturity;
+        q.value = value;
+        q.frequency = frequency;
+        quotes.push_back(q);
+    };
+    add(RateInstrument::Deposit, 0.0, 1.0 / 52, 0.0530);
+    add(RateInstrument::Deposit, 0.0, 1.0 / 12, 0.0532);
+    add(RateInstrument::Deposit, 0.0, 0.25, 0.0535);
+    add(RateInstrument::FRA, 0.25, 0.5, 0.0528);
+    double prices[] = {94.80, 94.95, 95.10, 95.25, 95.40};
+    for (int i = 0; i < 5; ++i) {
+        add(RateInstrument::Future, 0.5 + 0.25 * i, 0.75 + 0.25 * i, prices[i]);
+        quotes.back().convexity = 0.0001 * i;
+    }
+    double tenors[] = {2, 3, 4, 5, 6, 7, 8, 9, 10, 12, 15, 20, 25, 30};
+    double rates[] = {0.0490, 0.0468, 0.0452, 0.0443, 0.0437, 0.0433, 0.0430,
+                      0.0428, 0.0427, 0.0427, 0.0429, 0.0432, 0.0434, 0.0435};
+    for (int i = 0; i < 14; ++i) add(RateInstrument::Swap, 0.0, tenors[i], rates[i], 2);
+    return quotes;
+}
+
+// Quote error in rate units (futures prices are in percent)
+static double max_reprice_error(const CurveBootstrapper& curve) {
+    double worst = 0.0;
+    for (size_t i = 0; i < curve.size(); ++i) {
+        const RateQuote& q = curve.get_quote(i);
+        double error = std::fabs(CurveBootstrapper::implied_value(q, curve.get_curve()) - q.value);
+        if (q.type == RateInstrument::Future) error /= 100.0;
+        worst = std::max(worst, error);
+    }
+    return worst;
+}
+
+int main(int argc, char* argv[]) {
+    size_t num_ticks = argc > 1 ? std::stoul(argv[1]) : 100000;
+    std::vector<RateQuote> quotes = usd_quotes();
+
+    constexpr size_t kBuilds = 2000;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i + 1 < kBuilds; ++i) CurveBootstrapper warmup(quotes);
+    CurveBootstrapper curve(quotes);
+    double build_us = elapsed_us(start) / kBuilds;
+    double initial_error = max_reprice_error(curve);
+
+    // Random single-quote ticks of +-0.25bp
+    std::mt19937_64 rng(17);
+    std::uniform_int_distribution<size_t> pick(0, quotes.size() - 1);
+    std::bernoulli_distribution up(0.5);
+    size_t pillars_solved = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < num_ticks; ++t) {
+        size_t index = pick(rng);
+        const RateQuote& q = curve.get_quote(index);
+        double move = (up(rng) ? 0.000025 : -0.000025) * (q.type == RateInstrument::Future ? -100.0 : 1.0);
+        pillars_solved += curve.update_quote(index, q.value + move);
+    }
+    double tick_us = elapsed_us(start) / num_ticks;
+
+    std::vector<RateQuote> final_quotes;
+    for (size_t i = 0; i < curve.size(); ++i) final_quotes.push_back(curve.get_quote(i));
+    CurveBootstrapper fresh(final_quotes);
+    double worst_zero = 0.0;
+    for (size_t k = 0; k < fresh.get_zero_rates().size(); ++k) {
+        worst_zero = std::max(worst_zero, std::fabs(fresh.get_zero_rates()[k] - curve.get_zero_rates()[k]));
+    }
+
+    std::cout << "Pillars: " << quotes.size() << " (4 money market, 5 futures, 14 swaps)\n";
+    std::cout << std::scientific << std::setprecision(2);
+    std::cout << "Max repricing error: " << initial_error << " initially, " << max_reprice_error(curve)
+              << " after " << num_ticks << " ticks\n";
+    std::cout << "Incremental vs fresh bootstrap: max |zero rate diff| " << worst_zero << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Full bootstrap " << build_us << " us, re-bootstrap per tick " << tick_us << " us ("
+              << static_cast<double>(pillars_solved) / num_ticks << " pillars re-solved on average)\n";
+
+    bool ok = initial_error < kMaxError && max_reprice_error(curve) < kMaxError && worst_zero < kMaxError;
+    std::cout << (ok ? "PASS" : "FAIL") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,249 @@
+// Bulk loader round trip and failure cases
+// Usage: dataLoader [positions]  (default 5,000,000)
+// Writes an instruments CSV (options listed before their underlyings) and
+// a positions CSV of `positions` rows over 1,000 owners. It loads both,
+// saves the book in the columnar format and loads that into a second
+// simulator. Reports load throughput for each format and checks that both
+// books match the generated fixture position by position.
+// Then feeds malformed files to the loaders and checks each error message:
+// path:line for bad numbers, unknown instruments and unknown underlyings;
+// an incomplete vol grid; an asymmetric correlation matrix; and a bad row
+// deep in a multi-chunk file parsed on several threads. That error must
+// propagate out of the parallel parse and leave the simulator untouched.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+#include "../include/marketSimulator.hh"
+#include "../include/dataLoader.hh"
+
+constexpr size_t kStocks = 2000;
+constexpr size_t kOptionsPerStock = 4;
+constexpr size_t kBonds = 100;
+constexpr size_t kOwners = 1000;
+constexpr const char* kCurrencies[] = {"USD", "EUR", "GBP"};
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void write_file(const std::string& path, const std::string& text) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << text;
+}
+
+static std::string instrument_ticker(size_t i) {
+    if (i < kStocks) return "S" + std::to_string(i);
+    if (i < kStocks * (1 + kOptionsPerStock)) return "O" + std::to_string(i - kStocks);
+    return "B" + std::to_string(i - kStocks * (1 + kOptionsPerStock));
+}
+
+static void write_instruments(const std::string& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << "type,ticker,price,currency,underlying,strike,expiry,option_type,duration,coupon\n";
+    for (size_t o = 0; o < kStocks * kOptionsPerStock; ++o) {
+        size_t s = o / kOptionsPerStock;
+        out << "option," << instrument_ticker(kStocks + o) << "," << 1.0 + o % 9 << ",,S" << s << ","
+            << 80 + 10 * (o % kOptionsPerStock) << "," << 0.25 * (1 + o % 8) << "," << (o % 2 ? "put" : "call")
+            << ",,\n";
+    }
+    for (size_t s = 0; s < kStocks; ++s) {
+        out << "stock,S" << s << "," << 20 + s % 180 << "," << kCurrencies[s % 3] << ",,,,,,\n";
+    }
+    for (size_t b = 0; b < kBonds; ++b) {
+        out << "bond,B" << b << "," << 95 + b % 10 << ",USD,,,,," << 1 + b % 10 << ",0.04\n";
+    }
+}
+
+// Row r of the fixture: owners in contiguous runs, deterministic instrument and quantity
+struct PositionFixture {
+    size_t rows;
+    size_t instruments = kStocks * (1 + kOptionsPerStock) + kBonds;
+
+    size_t owner(size_t r) const { return r * kOwners / rows; }
+    size_t instrument(size_t r) const { return (r * 2654435761u) % instruments; }
+    double quantity(size_t r) const { return static_cast<double>(1 + r % 997); }
+
+    void write(const std::string& path) const {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "portfolio,ticker,quantity,currency\n";
+        std::string buffer;
+        for (size_t r = 0; r < rows; ++r) {
+            buffer += "P" + std::to_string(owner(r)) + "," + instrument_ticker(instrument(r)) + "," +
+                      std::to_string(static_cast<int>(quantity(r))) + "," + kCurrencies[owner(r) % 3] + "\n";
+            if (buffer.size() > (1 << 20)) {
+                out << buffer;
+                buffer.clear();
+            }
+        }
+        out << buffer;
+    }
+
+    // Positions of `market` must be exactly the fixture rows, in order, per owner
+    size_t mismatches(const MarketSimulator& market) const {
+        size_t bad = market.get_portfolio_count() == kOwners ? 0 : 1;
+        std::vector<size_t> next(kOwners, 0);
+        for (size_t r = 0; r < rows && bad == 0; ++r) {
+            size_t o = owner(r);
+            const Portfolio& portfolio = market.get_portfolio(o);
+            if (portfolio.get_owner() != "P" + std::to_string(o) || next[o] >= portfolio.get_position_count()) {
+                return 1;
+            }
+            const Position& pos = portfolio.get_position(next[o]++);
+            const Instrument& inst = market.get_registry().get(pos.get_instrument_id());
+            bad += inst.get_ticker() != instrument_ticker(instrument(r)) || pos.get_quantity() != quantity(r);
+        }
+        for (size_t o = 0; o < kOwners && bad == 0; ++o) {
+            bad += next[o] != market.get_portfolio(o).get_position_count();
+        }
+        return bad;
+    }
+};
+
+// Runs `load`, expecting an exception whose message contains `expected`
+static bool expect_failure(const std::string& name, const std::string& expected, const std::function<void()>& load) {
+    std::string message = "(no exception)";
+    try {
+        load();
+    } catch (const std::exception& e) {
+        message = e.what();
+    }
+    bool ok = message.find(expected) != std::string::npos;
+    std::cout << "  " << std::left << std::setw(28) << name << (ok ? "ok    " : "FAIL  ") << message << "\n";
+    return ok;
+}
+
+static bool run_failure_cases() {
+    std::cout << "Failure cases:\n";
+    bool ok = true;
+    std::vector<std::string> files;
+    auto fixture = [&](const std::string& name, const std::string& text) {
+        files.push_back("loader_bench_" + name);
+        write_file(files.back(), text);
+        return files.back();
+    };
+    auto with_instruments = [&](const std::function<void(MarketSimulator&)>& f) {
+        MarketSimulator market;
+        market.add_stock("S0", 100.0);
+        f(market);
+    };
+
+    std::string bad_number = fixture("bad_number.csv", "portfolio,ticker,quantity\nP0,S0,10\nP0,S0,1x0\n");
+    ok &= expect_failure("bad quantity", bad_number + ":3: invalid quantity '1x0'", [&] {
+        with_instruments([&](MarketSimulator& m) { DataLoader::load_positions(bad_number, m); });
+    });
+
+    std::string unknown = fixture("unknown.csv", "portfolio,ticker,quantity\nP0,S0,10\nP0,S0,5\nP1,NOPE,5\n");
+    ok &= expect_failure("unknown instrument", unknown + ":4: unknown instrument 'NOPE'", [&] {
+        with_instruments([&](MarketSimulator& m) { DataLoader::load_positions(unknown, m); });
+    });
+
+    std::string orphan = fixture("orphan.csv",
+                                 "type,ticker,price,underlying,strike,expiry,option_type\n"
+                                 "stock,X,100,,,,\n"
+                                 "option,X_C,5,X,100,1,call\n"
+                                 "option,Y_C,5,Y,100,1,call\n");
+    ok &= expect_failure("unknown underlying", orphan + ":4: unknown underlying 'Y'", [&] {
+        InstrumentRegistry registry;
+        DataLoader::load_instruments(orphan, registry);
+    });
+
+    std::string grid = fixture("grid.csv",
+                               "ticker,expiry,strike,vol\n"
+                               "X,0.5,90,0.2\nX,0.5,110,0.2\nX,1,90,0.21\n");
+    ok &= expect_failure("incomplete vol grid", grid + ": incomplete vol grid for X", [&] {
+        MarketEnvironment env;
+        DataLoader::load_vol_surfaces(grid, env);
+    });
+
+    std::string asymmetric = fixture("asymmetric.csv",
+                                     "corr,A,B,C\n"
+                                     "A,1,0.5,0.2\nB,0.5,1,0.3\nC,0.2,0.35,1\n");
+    ok &= expect_failure("asymmetric correlation", asymmetric + ": matrix is not symmetric at (C, B)", [&] {
+        DataLoader::load_correlation(asymmetric);
+    });
+
+    // ~5 MB, so the parse splits into several 1 MB chunks; the bad row is in a late one
+    constexpr size_t kChunkedRows = 400000;
+    constexpr size_t kBadRow = 330000;
+    std::string chunked_text = "portfolio,ticker,quantity\n";
+    for (size_t r = 0; r < kChunkedRows; ++r) {
+        chunked_text += "P" + std::to_string(r % 7) + "," + instrument_ticker(r % kStocks) + "," +
+                        (r == kBadRow ? std::string("oops") : std::to_string(r % 50 + 1)) + "\n";
+    }
+    std::string chunked = fixture("chunked.csv", chunked_text);
+    MarketSimulator market;
+    DataLoader::load_instruments("loader_bench_instruments.csv", market);
+    ok &= expect_failure("bad row in a parallel chunk", chunked + ":" + std::to_string(kBadRow + 2) +
+                         ": invalid quantity 'oops'", [&] {
+        DataLoader::load_positions(chunked, market, LoadOptions{',', 4});
+    });
+    bool untouched = market.get_portfolio_count() == 0;
+    std::cout << "  " << std::left << std::setw(28) << "simulator untouched" << (untouched ? "ok" : "FAIL") << "\n";
+    ok &= untouched;
+
+    for (const auto& file : files) std::remove(file.c_str());
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    PositionFixture fixture{argc > 1 ? std::stoul(argv[1]) : 5000000};
+    const std::string instruments_path = "loader_bench_instruments.csv";
+    const std::string positions_path = "loader_bench_positions.csv";
+    const std::string columnar_path = "loader_bench_positions.cols";
+
+    write_instruments(instruments_path);
+    fixture.write(positions_path);
+    std::ifstream size_probe(positions_path, std::ios::binary | std::ios::ate);
+    double csv_mb = static_cast<double>(size_probe.tellg()) / (1024.0 * 1024.0);
+
+    MarketSimulator from_csv;
+    auto start = std::chrono::steady_clock::now();
+    size_t num_instruments = DataLoader::load_instruments(instruments_path, from_csv);
+    double instruments_ms = elapsed_ms(start);
+
+    start = std::chrono::steady_clock::now();
+    DataLoader::load_positions(positions_path, from_csv);
+    double csv_ms = elapsed_ms(start);
+
+    start = std::chrono::steady_clock::now();
+    DataLoader::save_positions_columnar(from_csv, columnar_path);
+    double save_ms = elapsed_ms(start);
+    std::ifstream columnar_probe(columnar_path, std::ios::binary | std::ios::ate);
+    double columnar_mb = static_cast<double>(columnar_probe.tellg()) / (1024.0 * 1024.0);
+
+    MarketSimulator from_columnar;
+    DataLoader::load_instruments(instruments_path, from_columnar);
+    start = std::chrono::steady_clock::now();
+    DataLoader::load_positions_columnar(columnar_path, from_columnar);
+    double columnar_ms = elapsed_ms(start);
+
+    size_t csv_bad = fixture.mismatches(from_csv);
+    size_t columnar_bad = fixture.mismatches(from_columnar);
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Instruments: " << num_instruments << " in " << instruments_ms << " ms\n";
+    std::cout << "Positions: " << fixture.rows << " over " << kOwners << " owners, threads: "
+              << hardware_threads() << "\n";
+    std::cout << "CSV load:       " << csv_ms << " ms, " << csv_mb << " MB ("
+              << 1e-3 * fixture.rows / csv_ms << " M rows/s)\n";
+    std::cout << "Columnar save:  " << save_ms << " ms, " << columnar_mb << " MB\n";
+    std::cout << "Columnar load:  " << columnar_ms << " ms (" << 1e-3 * fixture.rows / columnar_ms
+              << " M rows/s, " << csv_ms / columnar_ms << "x CSV)\n";
+    std::cout << "Mismatched positions: CSV " << csv_bad << ", columnar " << columnar_bad << "\n";
+
+    bool failures_ok = run_failure_cases();
+
+    std::remove(instruments_path.c_str());
+    std::remove(positions_path.c_str());
+    std::remove(columnar_path.c_str());
+
+    bool ok = csv_bad == 0 && columnar_bad == 0 && failures_ok;
+    std::cout << (ok ? "PASS" : "FAIL") << "\n";
+    return ok ? 0 : 1;
+}
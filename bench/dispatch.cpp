@@ -0,0 +1,112 @@
+// Visitor dispatch overhead on the pooled registry
+// Usage: dispatch [instruments] [passes]  (default 300,000, 50)
+// One cheap per-instrument kernel (mark-to-market notional) run four ways
+// over the same registry: double dispatch (Instrument::accept then visit,
+// two virtual calls per instrument), registry accept() (one virtual call per
+// instrument), visit_all (static dispatch, one inlined loop per pool) and
+// accept_batch (one virtual call per pool chunk). The kernel is cheap on
+// purpose, so what differs between the four is the dispatch. Checks all
+// four give the same total.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "../include/instrumentRegistry.hh"
+
+// Notional: stocks and bonds at price, option contracts at 100x premium
+class NotionalVisitor final : public StaticConstInstrumentVisitor<NotionalVisitor> {
+public:
+    void operator()(const Stock& stock) { total_ += stock.get_price(); }
+    void operator()(const Option& option) { total_ += 100.0 * option.get_price(); }
+    void operator()(const Bond& bond) { total_ += bond.get_price() * (1.0 + bond.get_coupon_rate()); }
+
+    double get_total() const { return total_; }
+    void reset() { total_ = 0.0; }
+
+private:
+    double total_ = 0.0;
+};
+
+// ns per instrument of pass(), best of three rounds of `passes`
+template <typename Pass>
+static double time_ns(size_t instruments, size_t passes, Pass&& pass) {
+    double best = 1e300;
+    for (int round = 0; round < 3; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t p = 0; p < passes; ++p) pass();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, ns / (double(passes) * instruments));
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 300000;
+    size_t passes = argc > 2 ? std::stoul(argv[2]) : 50;
+
+    // Half stocks, 3/8 options, 1/8 bonds
+    InstrumentRegistry registry;
+    std::vector<InstrumentId> ids;
+    std::vector<InstrumentId> stocks;
+    for (size_t i = 0; i < count / 2; ++i) {
+        stocks.push_back(registry.add_stock("S" + std::to_string(i), 20.0 + i % 100));
+        ids.push_back(stocks.back());
+    }
+    for (size_t i = 0; i < count * 3 / 8; ++i) {
+        ids.push_back(registry.add_option("O" + std::to_string(i), 1.0 + i % 7, 50.0, stocks[i % stocks.size()],
+                                          0.5, i % 2 ? Option::Type::Put : Option::Type::Call));
+    }
+    for (size_t i = 0; ids.size() < count; ++i) {
+        ids.push_back(registry.add_bond("B" + std::to_string(i), 95.0 + i % 10, 5.0, 0.04));
+    }
+    // Double dispatch visits in id order, as portfolios did before pooling
+    std::vector<const Instrument*> instruments;
+    for (InstrumentId id : ids) instruments.push_back(&registry.get(id));
+
+    NotionalVisitor visitor;
+    // Through volatile pointers, so the compiler cannot see the visitor's
+    // type and devirtualize the classic paths
+    ConstInstrumentVisitor* volatile classic = &visitor;
+    ConstBatchInstrumentVisitor* volatile batch = &visitor;
+    double totals[4];
+    double ns[4];
+    ns[0] = time_ns(count, passes, [&] {
+        visitor.reset();
+        ConstInstrumentVisitor& v = *classic;
+        for (const Instrument* inst : instruments) inst->accept(v);
+        totals[0] = visitor.get_total();
+    });
+    ns[1] = time_ns(count, passes, [&] {
+        visitor.reset();
+        registry.accept(*classic);
+        totals[1] = visitor.get_total();
+    });
+    ns[2] = time_ns(count, passes, [&] {
+        visitor.reset();
+        registry.visit_all(visitor);
+        totals[2] = visitor.get_total();
+    });
+    ns[3] = time_ns(count, passes, [&] {
+        visitor.reset();
+        registry.accept_batch(*batch);
+        totals[3] = visitor.get_total();
+    });
+
+    // Summation order differs between the double-dispatch and pool orders
+    bool same = true;
+    for (double total : totals) same = same && std::fabs(total / totals[2] - 1.0) < 1e-12;
+
+    const char* names[4] = {"Instrument::accept (2 virtual)", "registry.accept (1 virtual)",
+                            "visit_all (static)", "accept_batch (per chunk)"};
+    std::cout << "Instruments " << count << ", passes " << passes << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    for (int k = 0; k < 4; ++k) {
+        std::cout << "  " << std::left << std::setw(32) << names[k] << std::right << std::setw(7) << ns[k]
+                  << " ns/instrument (" << ns[0] / ns[k] << "x)\n";
+    }
+    std::cout << "Totals agree: " << (same ? "yes" : "NO") << "\n";
+    return 0;
+}
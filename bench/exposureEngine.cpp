@@ -0,0 +1,120 @@
+// Exposure profiles (EE, PFE) for many netting sets
+// Usage: exposureEngine [netting_sets] [paths]  (default 10,000 x 1,000)
+// 50 correlated stocks with options on each; every netting set holds five
+// random long/short stock and option positions, except the first, which is
+// a single stock position whose EE and PFE are known in closed form.
+// Reports that check, the run time and the memory held by the aggregates.
+// Fails if the EE error exceeds the sketch accuracy plus 1/sqrt(paths), or
+// the PFE error the accuracy plus 2/sqrt(paths) (a few Monte Carlo
+// standard errors of each).
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/exposureEngine.hh"
+
+constexpr size_t kStocks = 50;
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t num_sets = argc > 1 ? std::stoul(argv[1]) : 10000;
+    ExposureSettings settings;
+    settings.num_paths = argc > 2 ? std::stoul(argv[2]) : 1000;
+    for (int month = 1; month <= 12; ++month) settings.dates.push_back(month / 12.0);
+
+    const double rate = 0.03;
+    MarketEnvironment env;
+    env.set_yield_curve("USD", YieldCurve(rate));
+    auto registry = std::make_shared<InstrumentRegistry>();
+    std::vector<InstrumentId> stocks, options;
+    std::vector<std::string> tickers;
+    for (size_t s = 0; s < kStocks; ++s) {
+        std::string ticker = "EXP" + std::to_string(s);
+        double spot = 50.0 + s;
+        env.set_spot(ticker, spot);
+        env.set_vol_surface(ticker, VolatilitySurface(0.20 + 0.004 * s));
+        stocks.push_back(registry->add_stock(ticker, spot));
+        tickers.push_back(ticker);
+        for (double m : {0.9, 1.1}) {
+            for (double expiry : {0.5, 1.0}) {
+                Option::Type type = m < 1.0 ? Option::Type::Put : Option::Type::Call;
+                std::string name = ticker + (m < 1.0 ? "P" : "C") + std::to_string(static_cast<int>(expiry * 12));
+                options.push_back(registry->add_option(name, 0.0, spot * m, stocks.back(), expiry, type));
+            }
+        }
+    }
+    std::vector<std::vector<double>> corr(kStocks, std::vector<double>(kStocks, 0.3));
+    for (size_t i = 0; i < kStocks; ++i) corr[i][i] = 1.0;
+    env.set_correlation_matrix(CorrelationMatrix(tickers, corr));
+
+    std::vector<Portfolio> netting_sets;
+    netting_sets.reserve(num_sets);
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<size_t> pick_stock(0, stocks.size() - 1), pick_option(0, options.size() - 1);
+    std::uniform_real_distribution<double> size(-100.0, 200.0);
+    for (size_t n = 0; n < num_sets; ++n) {
+        netting_sets.emplace_back(registry, "CP" + std::to_string(n), "USD");
+        if (n == 0) {
+            netting_sets.back().add_position(stocks[0], 100.0);
+            continue;
+        }
+        for (int k = 0; k < 5; ++k) {
+            bool stock = k < 2;
+            netting_sets.back().add_position(stock ? stocks[pick_stock(rng)] : options[pick_option(rng)], size(rng));
+        }
+    }
+
+    BlackScholesModel model;
+    ExposureEngine engine(model, env, settings);
+    auto start = std::chrono::steady_clock::now();
+    engine.run(netting_sets);
+    double run_ms = elapsed_ms(start);
+
+    // Single stock: V_t = 100 S_t, lognormal
+    double spot = env.get_spot("EXP0"), vol = 0.20;
+    double worst_ee = 0.0, worst_pfe = 0.0;
+    for (size_t d = 0; d < engine.num_dates(); ++d) {
+        double t = engine.get_date(d);
+        double ee = 100.0 * spot * std::exp(rate * t);
+        double pfe = 100.0 * spot * std::exp((rate - 0.5 * vol * vol) * t + vol * std::sqrt(t) * inv_norm_cdf(0.95));
+        worst_ee = std::max(worst_ee, std::fabs(engine.get_expected_exposure(0, d) / ee - 1.0));
+        worst_pfe = std::max(worst_pfe, std::fabs(engine.get_pfe(0, d, 0.95) / pfe - 1.0));
+    }
+
+    size_t buckets = 0;
+    for (size_t n = 0; n < engine.num_netting_sets(); ++n) {
+        for (size_t d = 0; d < engine.num_dates(); ++d) buckets += engine.get_sketch(n, d).num_buckets();
+    }
+    double aggregate_mb = (buckets * 8.0 + engine.num_netting_sets() * engine.num_dates() *
+                           (sizeof(QuantileSketch) + sizeof(double))) / (1 << 20);
+
+    std::cout << "Netting sets " << num_sets << ", paths " << settings.num_paths << ", dates "
+              << engine.num_dates() << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Single-stock check, max relative error: EE " << worst_ee * 100 << "%, PFE95 "
+              << worst_pfe * 100 << "% (sketch accuracy " << settings.relative_accuracy * 100
+              << "%, plus Monte Carlo noise)\n";
+    size_t last = engine.num_dates() - 1, largest = 0;
+    for (size_t n = 1; n < engine.num_netting_sets(); ++n) {
+        if (engine.get_expected_exposure(n, last) > engine.get_expected_exposure(largest, last)) largest = n;
+    }
+    std::cout << "Largest 1y EE, netting set " << largest << ": EE " << engine.get_expected_exposure(largest, last)
+              << ", PFE95 " << engine.get_pfe(largest, last, 0.95) << ", PFE99 "
+              << engine.get_pfe(largest, last, 0.99) << "\n";
+    std::cout << "Run " << run_ms << " ms, aggregates " << aggregate_mb << " MB ("
+              << static_cast<double>(buckets) / (engine.num_netting_sets() * engine.num_dates())
+              << " buckets per sketch)\n";
+
+    // Sketch accuracy plus a few standard errors of the Monte Carlo estimate
+    double noise = 1.0 / std::sqrt(static_cast<double>(settings.num_paths));
+    bool ok = worst_ee < settings.relative_accuracy + noise && worst_pfe < settings.relative_accuracy + 2.0 * noise;
+    std::cout << (ok ? "PASS" : "FAIL") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+// Nested simulation: inner Monte Carlo vs regression proxy on outer nodes
+// Usage: nestedSimulation [outer_paths] [inner_paths]  (default 1,000 x 256)
+// Simulates outer paths to 3m and 6m, then values a one-year call, an Asian
+// put and an up-and-out call on every node. The call alone, and a call on
+// a second, EUR asset, are checked against Black-Scholes at each node on
+// their own currency's rate; the whole book is valued by full
+// nesting and by least-squares regression, and the two exposure profiles
+// (mean and 99th percentile of the node values) are compared. Fails if
+// either call's RMSE reaches 0.5 or the mean exposures differ by 5%.
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "../include/nestedSimulation.hh"
+
+constexpr double kMaxCallRmse = 0.5;   // Inner Monte Carlo noise at 256 paths is ~0.2-0.4
+constexpr double kMaxMeanDiff = 0.05;  // Regression vs nested mean exposure, relative
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double percentile(std::vector<double> values, double q) {
+    size_t index = static_cast<size_t>(q * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+int main(int argc, char* argv[]) {
+    NestedSimulationSettings settings;
+    settings.outer_paths = argc > 1 ? std::stoul(argv[1]) : 1000;
+    settings.inner_paths = argc > 2 ? std::stoul(argv[2]) : 256;
+    settings.horizons = {0.25, 0.5};
+
+    const double rate = 0.03, eur_rate = 0.01, vol = 0.25;
+    MarketEnvironment env;
+    env.set_yield_curve("USD", YieldCurve(rate));
+    env.set_yield_curve("EUR", YieldCurve(eur_rate));
+    env.set_spot("ACME", 100.0);
+    env.set_vol_surface("ACME", VolatilitySurface(vol));
+    env.set_spot("EUCO", 100.0);
+    env.set_vol_surface("EUCO", VolatilitySurface(vol));
+    env.set_currency("EUCO", "EUR");
+
+    BlackScholesModel model;
+    auto start = std::chrono::steady_clock::now();
+    NestedSimulator simulator(model, env, {{"ACME", 100.0}, {"EUCO", 100.0}}, settings);
+    double outer_ms = elapsed_ms(start);
+
+    NestedClaim call{"ACME", ClaimPayoff::European, true, 100.0, 1.0, 0.0, 1.0};
+    NestedClaim asian{"ACME", ClaimPayoff::Asian, false, 100.0, 1.0, 0.0, 1.0};
+    NestedClaim barrier{"ACME", ClaimPayoff::KnockOut, true, 100.0, 1.0, 130.0, 1.0};
+    NestedClaim eur_call{"EUCO", ClaimPayoff::European, true, 100.0, 1.0, 0.0, 1.0};
+
+    // A call alone vs closed form at every node, on its own currency's rate
+    auto call_rmse = [&](const NestedClaim& claim, size_t asset, double r) {
+        std::vector<double> values = simulator.value({claim});
+        double sum_sq = 0.0;
+        for (size_t h = 0; h < simulator.num_horizons(); ++h) {
+            double tau = 1.0 - simulator.get_horizon(h);
+            for (size_t p = 0; p < simulator.num_paths(); ++p) {
+                double exact = model.price_option(simulator.get_node(h, p)[asset].spot, 100.0, tau, r, vol, true);
+                double error = values[h * simulator.num_paths() + p] - exact;
+                sum_sq += error * error;
+            }
+        }
+        return std::sqrt(sum_sq / values.size());
+    };
+    double usd_rmse = call_rmse(call, 0, rate);
+    double eur_rmse = call_rmse(eur_call, 1, eur_rate);
+
+    std::vector<NestedClaim> book = {call, asian, barrier};
+    start = std::chrono::steady_clock::now();
+    std::vector<double> nested = simulator.value(book, NestedValuation::InnerMonteCarlo);
+    double nested_ms = elapsed_ms(start);
+    start = std::chrono::steady_clock::now();
+    std::vector<double> regression = simulator.value(book, NestedValuation::Regression);
+    double regression_ms = elapsed_ms(start);
+
+    std::cout << "Outer paths " << settings.outer_paths << ", inner paths " << settings.inner_paths
+              << ", horizons 3m and 6m\n";
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "Call vs Black-Scholes at the nodes: RMSE " << usd_rmse << " (USD), " << eur_rmse << " (EUR)\n";
+    std::cout << "Book (call + Asian put + up-and-out call):\n";
+    double worst_mean_diff = 0.0;
+    for (size_t h = 0; h < simulator.num_horizons(); ++h) {
+        auto begin = [&](const std::vector<double>& v) { return v.begin() + h * simulator.num_paths(); };
+        std::vector<double> a(begin(nested), begin(nested) + simulator.num_paths());
+        std::vector<double> b(begin(regression), begin(regression) + simulator.num_paths());
+        double mean_a = 0.0, mean_b = 0.0;
+        for (size_t p = 0; p < a.size(); ++p) {
+            mean_a += a[p] / a.size();
+            mean_b += b[p] / b.size();
+        }
+        worst_mean_diff = std::max(worst_mean_diff, std::fabs(mean_b / mean_a - 1.0));
+        std::cout << "  T=" << std::setprecision(2) << simulator.get_horizon(h) << std::setprecision(4)
+                  << "  mean " << mean_a << " nested / " << mean_b << " regression, 99% "
+                  << percentile(a, 0.99) << " / " << percentile(b, 0.99) << "\n";
+    }
+    std::cout << std::setprecision(1);
+    std::cout << "Outer simulation " << outer_ms << " ms, nested valuation " << nested_ms
+              << " ms, regression " << regression_ms << " ms\n";
+
+    bool ok = usd_rmse < kMaxCallRmse && eur_rmse < kMaxCallRmse && worst_mean_diff < kMaxMeanDiff;
+    std::cout << (ok ? "PASS" : "FAIL") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+// Accuracy and throughput of the normalMath.hh kernels
+// Usage: normalMath [samples]  (default 2,000,000)
+// Accuracy: max relative error of the array forms (the vectorized path, on
+// the instruction set picked at run time) against long double references
+// over each kernel's useful range (inv_norm_cdf against a Newton-refined
+// long double root). Throughput: array forms vs the libm / <random>
+// equivalents.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/normalMath.hh"
+
+constexpr long double kInvSqrt2PiL = 0.398942280401432677939946059934381868L;
+
+static long double ref_cdf(long double x) { return 0.5L * std::erfc(-x / std::sqrt(2.0L)); }
+static long double ref_pdf(long double x) { return kInvSqrt2PiL * std::exp(-0.5L * x * x); }
+
+static long double ref_inv_cdf(double p) {
+    long double x = inv_norm_cdf(p);
+    for (int i = 0; i < 3; ++i) x -= (ref_cdf(x) - p) / ref_pdf(x);
+    return x;
+}
+
+static double relative_error(double value, long double reference) {
+    return static_cast<double>(std::fabs((value - reference) / reference));
+}
+
+// Max relative error of the array form f against ref over x = draw(),
+// skipping tiny references
+template <typename Draw, typename F, typename Ref>
+static double max_error(size_t samples, Draw draw, F f, Ref ref) {
+    std::vector<double> x(samples), out(samples);
+    for (auto& value : x) value = draw();
+    f(x.data(), out.data(), samples);
+    double worst = 0.0;
+    for (size_t i = 0; i < samples; ++i) {
+        long double expected = ref(x[i]);
+        if (std::fabs(expected) < 1e-300L || std::fabs(expected) > 1e300L) continue;
+        worst = std::max(worst, relative_error(out[i], expected));
+    }
+    return worst;
+}
+
+// Nanoseconds per element of f(in, out, n)
+template <typename F>
+static double time_per_element(const std::vector<double>& in, std::vector<double>& out, F f) {
+    auto start = std::chrono::steady_clock::now();
+    f(in.data(), out.data(), in.size());
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return ns / in.size();
+}
+
+int main(int argc, char* argv[]) {
+    size_t samples = argc > 1 ? std::stoul(argv[1]) : 2000000;
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+
+    std::cout << std::scientific << std::setprecision(2);
+    std::cout << "Array kernels run on: " << array_kernel_target() << "\n";
+    std::cout << "Max relative error (" << samples << " samples each)\n";
+    std::cout << "  exp          [-708, 709]:  "
+              << max_error(samples, [&] { return 708.5 * unit(rng); },
+                           [](const double* a, double* o, size_t n) { fast_exp(a, o, n); },
+                           [](double x) { return std::exp(static_cast<long double>(x)); }) << "\n";
+    std::cout << "  log          [1e-300, 1e300]: "
+              << max_error(samples, [&] { return std::exp(690.0 * unit(rng)); },
+                           [](const double* a, double* o, size_t n) { fast_log(a, o, n); },
+                           [](double x) { return std::log(static_cast<long double>(x)); }) << "\n";
+    std::cout << "  norm_pdf     [-37, 37]:    "
+              << max_error(samples, [&] { return 37.0 * unit(rng); },
+                           [](const double* a, double* o, size_t n) { norm_pdf(a, o, n); }, ref_pdf) << "\n";
+    std::cout << "  norm_cdf     [-37, 8]:     "
+              << max_error(samples, [&] { return 14.5 + 22.5 * (unit(rng) - 1.0); },
+                           [](const double* a, double* o, size_t n) { norm_cdf(a, o, n); }, ref_cdf) << "\n";
+    std::cout << "  inv_norm_cdf p in (1e-300, 1): "
+              << max_error(samples, [&] {
+                               double x = 37.0 * unit(rng);
+                               x = std::fabs(x) < 1e-3 ? 1e-3 : x;  // Relative error undefined at 0
+                               return static_cast<double>(ref_cdf(x));
+                           },
+                           [](const double* a, double* o, size_t n) { inv_norm_cdf(a, o, n); }, ref_inv_cdf) << "\n";
+
+    // Throughput
+    std::vector<double> x(samples), p(samples), out(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        x[i] = 6.0 * unit(rng);
+        p[i] = 0.5 + 0.5 * unit(rng);
+    }
+    auto libm = [](double (*f)(double)) {
+        return [f](const double* in, double* o, size_t n) { for (size_t i = 0; i < n; ++i) o[i] = f(in[i]); };
+    };
+    auto erfc_cdf = [](double v) { return 0.5 * std::erfc(-v * M_SQRT1_2); };
+    auto libm_pdf = [](double v) { return std::exp(-0.5 * v * v) / std::sqrt(2.0 * M_PI); };
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Throughput (ns/element): ours vs libm\n";
+    std::cout << "  exp       " << time_per_element(x, out, [](const double* a, double* o, size_t n) { fast_exp(a, o, n); })
+              << " vs " << time_per_element(x, out, libm([](double v) { return std::exp(v); })) << "\n";
+    std::cout << "  log       " << time_per_element(p, out, [](const double* a, double* o, size_t n) { fast_log(a, o, n); })
+              << " vs " << time_per_element(p, out, libm([](double v) { return std::log(v); })) << "\n";
+    std::cout << "  norm_pdf  " << time_per_element(x, out, [](const double* a, double* o, size_t n) { norm_pdf(a, o, n); })
+              << " vs " << time_per_element(x, out, libm(libm_pdf)) << "\n";
+    std::cout << "  norm_cdf  " << time_per_element(x, out, [](const double* a, double* o, size_t n) { norm_cdf(a, o, n); })
+              << " vs " << time_per_element(x, out, libm(erfc_cdf)) << " (erfc)\n";
+
+    std::mt19937 gen_inversion(11), gen_polar(11);
+    std::normal_distribution<double> polar(0.0, 1.0);
+    double inversion_ns = time_per_element(x, out, [&](const double*, double* o, size_t n) {
+        fill_normals(gen_inversion, o, n);
+    });
+    double polar_ns = time_per_element(x, out, [&](const double*, double* o, size_t n) {
+        for (size_t i = 0; i < n; ++i) o[i] = polar(gen_polar);
+    });
+    std::cout << "  normals   " << inversion_ns << " vs " << polar_ns << " (std::normal_distribution)\n";
+    return 0;
+}
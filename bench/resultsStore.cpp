@@ -0,0 +1,191 @@
+// Results store: concurrent readers against a publishing simulator
+// Usage: resultsStore [readers] [epochs]  (default 4, 20,000)
+// Stress: one writer publishes `epochs` synthetic epochs whose every field
+// encodes the epoch number, while reader threads keep pinning views (some
+// held across later publishes) and check each is internally consistent,
+// unchanged while held, and never older than one already seen. Live: a
+// dashboard thread attaches to a MarketSimulator's store before the first
+// simulated day and reads while it simulates a year; its last view must
+// match the simulating thread's own values.
+
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/marketSimulator.hh"
+
+// Published as epoch e + 1: day e, 1 + e % 8 portfolios valued e + i,
+// P&L -e, totals summed
+static RiskResults synthetic_results(std::uint64_t e) {
+    RiskResults results;
+    results.day = static_cast<unsigned>(e);
+    for (size_t i = 0; i < 1 + e % 8; ++i) {
+        PortfolioResult entry;
+        entry.owner = "P" + std::to_string(i);
+        entry.currency = "USD";
+        entry.value = static_cast<double>(e + i);
+        entry.pnl = -static_cast<double>(e);
+        entry.greeks.delta = static_cast<double>(i);
+        results.total_greeks.delta += entry.greeks.delta;
+        results.portfolios.push_back(std::move(entry));
+    }
+    return results;
+}
+
+static bool consistent(const RiskResults& results) {
+    std::uint64_t e = results.epoch;
+    bool ok = results.day + 1 == e && results.portfolios.size() == 1 + (e - 1) % 8;
+    double delta = 0.0;
+    for (size_t i = 0; ok && i < results.portfolios.size(); ++i) {
+        const PortfolioResult& entry = results.portfolios[i];
+        ok = entry.value == static_cast<double>(e - 1 + i) && entry.pnl == -static_cast<double>(e - 1);
+        delta += entry.greeks.delta;
+    }
+    return ok && delta == results.total_greeks.delta;
+}
+
+struct ReaderStats {
+    size_t reads = 0;
+    size_t epochs_seen = 0;  // Distinct epochs observed
+    size_t errors = 0;
+    double max_read_us = 0.0;
+};
+
+static ReaderStats stress_reader(const ResultsStore& store, std::atomic<size_t>& started,
+                                 const std::atomic<bool>& done) {
+    ReaderStats stats;
+    started.fetch_add(1);
+    std::uint64_t last_epoch = 0;
+    while (!done.load(std::memory_order_acquire)) {
+        auto start = std::chrono::steady_clock::now();
+        ResultsStore::View view = store.read();
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        stats.max_read_us = std::max(stats.max_read_us, us);
+        ++stats.reads;
+        if (!view || view->epoch < last_epoch || !consistent(*view)) {
+            ++stats.errors;
+            continue;
+        }
+        stats.epochs_seen += view->epoch != last_epoch;
+        last_epoch = view->epoch;
+
+        // Every 16th view is held across later publishes: it must neither
+        // change nor be freed under the reader
+        if (stats.reads % 16 == 0) {
+            double value = view->portfolios.back().value;
+            std::this_thread::yield();
+            if (view->portfolios.back().value != value || !consistent(*view)) ++stats.errors;
+        }
+    }
+    return stats;
+}
+
+// Small two-currency book: a few stocks (one in EUR) with options
+static void build_market(MarketSimulator& market) {
+    market.set_market_environment(create_sample_market());
+    auto& registry = market.get_registry();
+    InstrumentId aapl = market.add_stock("AAPL", 150.0);
+    InstrumentId googl = market.add_stock("GOOGL", 140.0);
+    InstrumentId sap = market.add_stock("SAP", 180.0, "EUR");
+    InstrumentId call = registry.add_option("AAPL_C160", 6.0, 160.0, aapl, 0.5, Option::Type::Call);
+    InstrumentId put = registry.add_option("SAP_P170", 8.0, 170.0, sap, 0.75, Option::Type::Put);
+
+    Portfolio& growth = market.get_portfolio(market.create_portfolio("Growth", "USD"));
+    growth.add_position(aapl, 100);
+    growth.add_position(googl, 50);
+    growth.add_position(call, 10);
+    Portfolio& europe = market.get_portfolio(market.create_portfolio("Europe", "EUR"));
+    europe.add_position(sap, 80);
+    europe.add_position(put, 20);
+}
+
+int main(int argc, char* argv[]) {
+    size_t num_readers = argc > 1 ? std::stoul(argv[1]) : 4;
+    size_t epochs = argc > 2 ? std::stoul(argv[2]) : 20000;
+
+    // Stress: synthetic epochs as fast as the writer can publish
+    ResultsStore store;
+    std::atomic<bool> done{false};
+    std::atomic<size_t> started{0};
+    std::vector<ReaderStats> stats(num_readers);
+    std::vector<std::thread> readers;
+    store.publish(synthetic_results(0));  // Readers never see an empty store
+    for (size_t r = 0; r < num_readers; ++r) {
+        readers.emplace_back([&, r] { stats[r] = stress_reader(store, started, done); });
+    }
+    while (started.load() < num_readers) std::this_thread::yield();
+    auto start = std::chrono::steady_clock::now();
+    for (std::uint64_t e = 2; e <= epochs; ++e) {
+        store.publish(synthetic_results(e - 1));
+        if (e % 64 == 0) std::this_thread::yield();
+    }
+    double publish_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    done.store(true, std::memory_order_release);
+    for (auto& reader : readers) reader.join();
+
+    ReaderStats total;
+    for (const auto& s : stats) {
+        total.reads += s.reads;
+        total.errors += s.errors;
+        total.epochs_seen += s.epochs_seen;
+        total.max_read_us = std::max(total.max_read_us, s.max_read_us);
+    }
+    ResultsStore::View last = store.read();
+    bool final_ok = last && last->epoch == epochs && consistent(*last);
+
+    // Live: attach before the first day, read while simulating a year
+    MarketSimulator market;
+    build_market(market);
+    std::shared_ptr<const ResultsStore> live = market.get_results_store();
+    std::atomic<bool> simulating{true};
+    std::atomic<size_t> dashboard_started{0};
+    size_t live_reads = 0, live_errors = 0;
+    unsigned last_day = 0;
+    std::thread dashboard([&] {
+        dashboard_started.fetch_add(1);
+        std::uint64_t last_epoch = 0;
+        while (simulating.load(std::memory_order_acquire)) {
+            ResultsStore::View view = live->read();
+            ++live_reads;
+            if (!view || view->epoch < last_epoch || view->day < last_day || view->portfolios.size() != 2) {
+                ++live_errors;
+                continue;
+            }
+            for (const auto& entry : view->portfolios) live_errors += !std::isfinite(entry.value);
+            last_epoch = view->epoch;
+            last_day = view->day;
+            std::this_thread::yield();
+        }
+    });
+    while (dashboard_started.load() == 0) std::this_thread::yield();
+    for (int day = 0; day < 252; ++day) {
+        market.simulate_daily();
+        std::this_thread::yield();
+    }
+    simulating.store(false, std::memory_order_release);
+    dashboard.join();
+
+    ResultsStore::View final_view = live->read();
+    bool live_match = final_view && final_view->day == market.get_day_count();
+    for (size_t id = 0; live_match && id < market.get_portfolio_count(); ++id) {
+        live_match = final_view->portfolios[id].value == market.get_portfolio_value(id) &&
+                     final_view->portfolios[id].pnl == market.get_portfolio_pnl(id);
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Stress: " << epochs << " epochs, " << num_readers << " readers, " << total.reads
+              << " reads seeing " << total.epochs_seen << " distinct epochs\n";
+    std::cout << "  Publish " << publish_us / epochs << " us/epoch, worst read " << total.max_read_us
+              << " us (includes being descheduled)\n";
+    std::cout << "  Torn, stale or changed views: " << total.errors << "; final epoch consistent: "
+              << (final_ok ? "yes" : "NO") << "\n";
+    std::cout << "Live: attached before day 1, " << live_reads << " dashboard reads over "
+              << market.get_day_count() << " days, errors " << live_errors << "\n";
+    std::cout << "  Last epoch matches the simulator (day " << (final_view ? final_view->day : 0)
+              << "): " << (live_match ? "yes" : "NO") << "\n";
+    return 0;
+}
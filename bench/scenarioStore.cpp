@@ -0,0 +1,132 @@
+// Shared-memory scenario store: one simulation, many consumer processes
+// Usage: scenarioStore [num_paths] [consumers]  (default 5,000, 3)
+// 50 correlated stocks at 12 monthly dates. Simulates the cube in-process,
+// publishes the same seed's cube into a shared-memory segment, then forks
+// consumer processes that map it by name and compute a basket's mean and
+// 1% quantile per date. Checks the published cube is identical to the
+// in-process one (and that a single-date cube matches the terminal
+// prices), that every consumer agrees with the local figures, and compares
+// the consumers' map time with what regenerating the scenarios costs.
+// Fails if any of the three checks does.
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "../include/scenarioStore.hh"
+#include "../include/processShards.hh"
+#include "../include/marketEnvironment.hh"
+
+constexpr size_t kStocks = 50;
+constexpr unsigned kSeed = 7;
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Per date: mean and 1% quantile of the equally weighted basket
+template <typename PathOf>
+static std::vector<double> basket_figures(size_t num_dates, size_t num_paths, size_t num_assets, PathOf&& path_of) {
+    std::vector<double> figures, basket(num_paths);
+    for (size_t d = 0; d < num_dates; ++d) {
+        double mean = 0.0;
+        for (size_t p = 0; p < num_paths; ++p) {
+            const double* prices = path_of(d, p);
+            double value = 0.0;
+            for (size_t a = 0; a < num_assets; ++a) value += prices[a];
+            basket[p] = value / num_assets;
+            mean += basket[p];
+        }
+        auto q = basket.begin() + num_paths / 100;
+        std::nth_element(basket.begin(), q, basket.end());
+        figures.push_back(mean / num_paths);
+        figures.push_back(*q);
+    }
+    return figures;
+}
+
+int main(int argc, char* argv[]) {
+    size_t num_paths = argc > 1 ? std::stoul(argv[1]) : 5000;
+    size_t consumers = argc > 2 ? std::stoul(argv[2]) : 3;
+
+    MarketEnvironment env;
+    env.set_yield_curve("USD", YieldCurve(0.03));
+    std::map<std::string, double> spots;
+    std::vector<std::string> tickers;
+    for (size_t s = 0; s < kStocks; ++s) {
+        std::string ticker = "SHM" + std::to_string(s);
+        spots[ticker] = 50.0 + s;
+        env.set_spot(ticker, spots[ticker]);
+        env.set_vol_surface(ticker, VolatilitySurface(0.15 + 0.005 * s));
+        tickers.push_back(ticker);
+    }
+    std::vector<std::vector<double>> corr(kStocks, std::vector<double>(kStocks, 0.3));
+    for (size_t i = 0; i < kStocks; ++i) corr[i][i] = 1.0;
+    env.set_correlation_matrix(CorrelationMatrix(tickers, corr));
+    std::vector<double> dates;
+    for (int month = 1; month <= 12; ++month) dates.push_back(month / 12.0);
+
+    BlackScholesModel model;
+    auto start = std::chrono::steady_clock::now();
+    MultiAssetSimulator local_sim(model, kSeed);
+    ScenarioCube<double> cube = local_sim.simulate_scenario_cube<double>(spots, dates, num_paths, 252, env);
+    double simulate_ms = elapsed_ms(start);
+
+    // One date: the terminal engine's prices
+    MultiAssetSimulator one_date(model, kSeed), terminal(model, kSeed);
+    ScenarioCube<double> short_cube = one_date.simulate_scenario_cube<double>(spots, {0.25}, 1000, 252, env);
+    ScenarioPaths<double> paths = terminal.simulate_terminal_prices<double>(spots, 0.25, 1000, 252, env);
+    bool terminal_match = short_cube.prices == paths.prices;
+
+    std::string name = "/riskEngine_scenarios_" + std::to_string(::getpid());
+    start = std::chrono::steady_clock::now();
+    MultiAssetSimulator publisher(model, kSeed);
+    SharedScenarioStore store = SharedScenarioStore::publish<double>(name, publisher, spots, dates, num_paths, 252, env);
+    double publish_ms = elapsed_ms(start);
+
+    bool cube_match;
+    {
+        ScenarioStoreView view(name);
+        cube_match = view.get_tickers() == cube.tickers && view.get_dates() == cube.dates &&
+                     view.num_paths() == num_paths &&
+                     std::memcmp(view.get_prices<double>(), cube.prices.data(), cube.prices.size() * sizeof(double)) == 0;
+    }
+
+    std::vector<double> local = basket_figures(cube.num_dates(), num_paths, kStocks,
+                                               [&](size_t d, size_t p) { return cube.get_path(d, p); });
+
+    // Consumers: map by name, compute, send back the figures and map time
+    auto results = run_process_shards(consumers, [&](size_t, SnapshotWriter& out) {
+        auto begin = std::chrono::steady_clock::now();
+        ScenarioStoreView view(name);
+        double map_ms = elapsed_ms(begin);
+        out.write(map_ms);
+        out.write_array(basket_figures(view.num_dates(), view.num_paths(), view.num_assets(),
+                                       [&](size_t d, size_t p) { return view.get_path<double>(d, p); }));
+    });
+    bool consumers_match = true;
+    double worst_map_ms = 0.0;
+    for (const auto& data : results) {
+        SnapshotReader in(data.data(), data.size());
+        worst_map_ms = std::max(worst_map_ms, in.read<double>());
+        consumers_match = consumers_match && in.read_array<double>() == local;
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Cube: " << kStocks << " assets x " << cube.num_dates() << " dates x " << num_paths
+              << " paths, segment " << store.size() / double(1 << 20) << " MB\n";
+    std::cout << "1y basket: mean " << local[local.size() - 2] << ", 1% quantile " << local.back() << "\n";
+    std::cout << "Published cube identical to in-process: " << (cube_match ? "yes" : "NO")
+              << "; single-date cube = terminal prices: " << (terminal_match ? "yes" : "NO") << "\n";
+    std::cout << consumers << " consumers agree with local figures: " << (consumers_match ? "yes" : "NO") << "\n";
+    std::cout << "Simulate " << simulate_ms << " ms, publish " << publish_ms << " ms, consumer map (worst) "
+              << worst_map_ms << " ms\n";
+
+    bool ok = cube_match && terminal_match && consumers_match;
+    std::cout << (ok ? "PASS" : "FAIL") << "\n";
+    return ok ? 0 : 1;
+}
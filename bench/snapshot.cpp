@@ -0,0 +1,259 @@
+// Snapshot save -> restore round trip of a full MarketSimulator
+// Usage: snapshot [positions]  (default 1,000,000)
+// Builds a simulator with stocks, options and bonds in three currencies,
+// term-structure yield curves, smile surfaces, dividend curves, FX spots, a
+// dense correlation matrix, a structured (factor + sector) correlation,
+// two correlation regimes and `positions` positions over 100 portfolios.
+// It then runs a few correlated days, so last prices, last FX and the live
+// regime differ from their defaults. After a save and a restore it checks:
+//   - a re-save of the restored simulator is byte-identical to the file
+//     (so every serialized field survived);
+//   - prices, curves, surfaces, dividends, FX, correlations, Cholesky
+//     factors, regimes, positions and portfolio value/P&L through the
+//     public API.
+// Reports save and restore time and the restore cost per position. Restore
+// rebuilds the registry and portfolios, so it is O(N) (see snapshot.hh).
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/marketSimulator.hh"
+#include "../include/snapshot.hh"
+
+constexpr size_t kStocks = 500;
+constexpr size_t kOptionsPerStock = 4;
+constexpr size_t kBonds = 50;
+constexpr size_t kPortfolios = 100;
+constexpr size_t kRegimeAssets = 100;
+constexpr const char* kCurrencies[] = {"USD", "EUR", "JPY"};
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::vector<char> read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Equicorrelated matrix over `tickers`
+static CorrelationMatrix equicorrelation(const std::vector<std::string>& tickers, double rho) {
+    std::vector<std::vector<double>> c(tickers.size(), std::vector<double>(tickers.size(), rho));
+    for (size_t i = 0; i < tickers.size(); ++i) c[i][i] = 1.0;
+    return CorrelationMatrix(tickers, c);
+}
+
+static void build(MarketSimulator& sim, size_t num_positions) {
+    std::mt19937_64 rng(3);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    MarketEnvironment env;
+    env.set_fx_spot("EUR", 1.08);
+    env.set_fx_spot("JPY", 0.0067);
+    for (size_t c = 0; c < 3; ++c) {
+        double base = 0.01 + 0.015 * c;
+        env.set_yield_curve(kCurrencies[c], YieldCurve({0.25, 1.0, 5.0, 10.0},
+                                                       {base, base + 0.004, base + 0.01, base + 0.012}));
+    }
+
+    InstrumentRegistry& registry = sim.get_registry();
+    std::vector<InstrumentId> ids;
+    std::vector<std::string> tickers;
+    std::vector<std::vector<double>> loadings;
+    std::vector<size_t> sector_of;
+    for (size_t s = 0; s < kStocks; ++s) {
+        std::string ticker = "S" + std::to_string(s);
+        double spot = 20.0 + 200.0 * unit(rng);
+        InstrumentId stock = sim.add_stock(ticker, spot, kCurrencies[s % 3]);
+        ids.push_back(stock);
+        tickers.push_back(ticker);
+        env.set_spot(ticker, spot);
+        double atm = 0.15 + 0.25 * unit(rng);
+        env.set_vol_surface(ticker, VolatilitySurface({0.8 * spot, spot, 1.2 * spot}, {0.25, 1.0},
+                                                      {{atm + 0.04, atm, atm + 0.02},
+                                                       {atm + 0.02, atm + 0.01, atm + 0.015}}));
+        env.set_dividend_curve(ticker, DividendCurve({{0.3, 0.01 * spot}}, 0.005 * (s % 4)));
+        for (size_t k = 0; k < kOptionsPerStock; ++k) {
+            ids.push_back(registry.add_option(ticker + "_O" + std::to_string(k), 0.0, spot * (0.9 + 0.1 * k),
+                                              stock, 0.25 + 0.5 * k,
+                                              k % 2 ? Option::Type::Put : Option::Type::Call));
+        }
+        loadings.push_back({0.4 + 0.2 * unit(rng), 0.3 * unit(rng)});
+        sector_of.push_back(s % 10);  // Ten sectors of equal size
+    }
+    for (size_t b = 0; b < kBonds; ++b) {
+        ids.push_back(registry.add_bond("B" + std::to_string(b), 95.0 + 10.0 * unit(rng), 1.0 + b % 10,
+                                        0.03, kCurrencies[b % 3]));
+    }
+
+    env.set_correlation_matrix(equicorrelation(tickers, 0.3));
+    constexpr size_t kSectors = 10;
+    std::vector<std::vector<std::vector<double>>> sector_blocks(kSectors);
+    for (auto& block : sector_blocks) {
+        block.assign(kStocks / kSectors, std::vector<double>(kStocks / kSectors, 0.1));
+    }
+    env.set_structured_correlation(StructuredCorrelation(tickers, loadings, sector_of, sector_blocks));
+    std::vector<std::string> regime_tickers(tickers.begin(), tickers.begin() + kRegimeAssets);
+    env.set_correlation_regimes(CorrelationRegimes({equicorrelation(regime_tickers, 0.2),
+                                                    equicorrelation(regime_tickers, 0.8)},
+                                                   {{0.9, 0.1}, {0.3, 0.7}}));
+    env.set_valuation_date(0.5);
+    sim.set_market_environment(env);
+
+    std::uniform_int_distribution<size_t> pick(0, ids.size() - 1);
+    for (size_t p = 0; p < kPortfolios; ++p) {
+        size_t id = sim.create_portfolio("Owner" + std::to_string(p), kCurrencies[p % 3]);
+        size_t count = num_positions / kPortfolios + (p < num_positions % kPortfolios);
+        sim.get_portfolio(id).reserve_positions(count);
+        for (size_t i = 0; i < count; ++i) {
+            sim.get_portfolio(id).add_position(ids[pick(rng)], 1.0 + std::floor(100.0 * unit(rng)));
+        }
+    }
+    sim.simulate_days(3);
+}
+
+// Counts mismatches between the original and restored simulators
+struct Checker {
+    size_t failures = 0;
+
+    void expect(bool ok, const std::string& what) {
+        if (!ok && failures++ < 10) std::cout << "  MISMATCH: " << what << "\n";
+    }
+
+    void compare_correlation(const CorrelationMatrix& a, const CorrelationMatrix& b, const std::string& what) {
+        expect(a.get_tickers() == b.get_tickers(), what + " tickers");
+        expect(a.get_cholesky_data() == b.get_cholesky_data(), what + " Cholesky factor");
+        for (const auto& t1 : a.get_tickers()) {
+            expect(a.get_correlation(t1, a.get_tickers()[0]) == b.get_correlation(t1, b.get_tickers()[0]),
+                   what + " correlation " + t1);
+        }
+    }
+
+    void compare(const MarketSimulator& a, const MarketSimulator& b) {
+        const MarketEnvironment& ea = a.get_market_environment();
+        const MarketEnvironment& eb = b.get_market_environment();
+
+        // Instruments, spots, surfaces and dividends
+        const InstrumentRegistry& ra = a.get_registry();
+        const InstrumentRegistry& rb = b.get_registry();
+        expect(ra.size() == rb.size(), "instrument count");
+        ra.visit_all([&](const auto& inst) {
+            InstrumentId id = rb.find(inst.get_ticker());
+            expect(id != kInvalidInstrumentId && rb.get(id).get_price() == inst.get_price(),
+                   "price " + inst.get_ticker());
+        });
+        ra.for_each_stock([&](const Stock& stock) {
+            const std::string& t = stock.get_ticker();
+            expect(ea.get_spot(t) == eb.get_spot(t), "spot " + t);
+            expect(ea.get_currency(t) == eb.get_currency(t), "currency " + t);
+            for (double T : {0.1, 0.25, 0.6, 1.0, 2.0}) {
+                for (double m : {0.7, 0.9, 1.0, 1.15, 1.3}) {
+                    double K = m * stock.get_price();
+                    expect(ea.get_vol(t, K, T) == eb.get_vol(t, K, T), "vol " + t);
+                }
+            }
+            expect(ea.get_dividend_curve(t).get_continuous_yield() == eb.get_dividend_curve(t).get_continuous_yield() &&
+                   ea.get_dividend_curve(t).get_pv_dividends(1.0, ea.get_yield_curve()) ==
+                       eb.get_dividend_curve(t).get_pv_dividends(1.0, eb.get_yield_curve()),
+                   "dividends " + t);
+        });
+
+        // Curves, FX and valuation date
+        for (const char* ccy : kCurrencies) {
+            for (double T : {0.01, 0.25, 0.7, 3.0, 10.0, 30.0}) {
+                expect(ea.get_rate(T, ccy) == eb.get_rate(T, ccy), std::string("rate ") + ccy);
+            }
+            expect(ea.get_fx_spot(ccy) == eb.get_fx_spot(ccy), std::string("FX spot ") + ccy);
+        }
+        expect(ea.get_base_currency() == eb.get_base_currency(), "base currency");
+        expect(ea.get_fx_factors() == eb.get_fx_factors(), "FX factors");
+        expect(ea.get_valuation_date() == eb.get_valuation_date(), "valuation date");
+
+        // Correlation models
+        compare_correlation(ea.get_correlation_matrix(), eb.get_correlation_matrix(), "dense");
+        const StructuredCorrelation& sa = ea.get_structured_correlation();
+        const StructuredCorrelation& sb = eb.get_structured_correlation();
+        expect(sa.get_tickers() == sb.get_tickers() && sa.num_factors() == sb.num_factors() &&
+                   sa.num_sectors() == sb.num_sectors(), "structured shape");
+        for (size_t i = 0; i < sa.size(); i += 7) {
+            const auto& t = sa.get_tickers();
+            expect(sa.get_correlation(t[i], t[0]) == sb.get_correlation(t[i], t[0]), "structured " + t[i]);
+        }
+        const CorrelationRegimes& ga = ea.get_correlation_regimes();
+        const CorrelationRegimes& gb = eb.get_correlation_regimes();
+        expect(ga.size() == gb.size() && ga.get_initial_regime() == gb.get_initial_regime(), "regime count");
+        for (size_t r = 0; r < std::min(ga.size(), gb.size()); ++r) {
+            compare_correlation(ga.get_regime(r), gb.get_regime(r), "regime " + std::to_string(r));
+            for (double u : {0.05, 0.5, 0.85, 0.95}) {
+                expect(ga.next_regime(r, u) == gb.next_regime(r, u), "regime transition");
+            }
+        }
+        expect(a.get_day_count() == b.get_day_count(), "day count");
+
+        // Positions and portfolio aggregates
+        for (size_t p = 0; p < kPortfolios; ++p) {
+            const Portfolio& pa = a.get_portfolio(p);
+            const Portfolio& pb = b.get_portfolio(p);
+            expect(pa.get_owner() == pb.get_owner() && pa.get_currency() == pb.get_currency() &&
+                   pa.get_position_count() == pb.get_position_count(), "portfolio " + pa.get_owner());
+            for (size_t i = 0; i < std::min(pa.get_position_count(), pb.get_position_count()); ++i) {
+                const Position& x = pa.get_position(i);
+                const Position& y = pb.get_position(i);
+                if (x.get_instrument_id() != y.get_instrument_id() || x.get_quantity() != y.get_quantity() ||
+                    x.get_last_price() != y.get_last_price()) {
+                    expect(false, "position " + std::to_string(i) + " of " + pa.get_owner());
+                }
+            }
+            expect(a.get_portfolio_value(p) == b.get_portfolio_value(p), "value " + pa.get_owner());
+            expect(a.get_portfolio_pnl(p) == b.get_portfolio_pnl(p), "P&L " + pa.get_owner());
+        }
+    }
+};
+
+int main(int argc, char* argv[]) {
+    size_t num_positions = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    const std::string path = "snapshot_bench.snap";
+    const std::string resave_path = "snapshot_bench_resave.snap";
+
+    MarketSimulator original;
+    build(original, num_positions);
+    std::cout << "Instruments: " << original.get_registry().size() << ", positions: " << num_positions
+              << " in " << kPortfolios << " portfolios\n";
+
+    auto start = std::chrono::steady_clock::now();
+    original.save_snapshot(path);
+    double save_ms = elapsed_ms(start);
+
+    start = std::chrono::steady_clock::now();
+    MarketSimulator restored = MarketSimulator::load_snapshot(path);
+    double load_ms = elapsed_ms(start);
+
+    restored.save_snapshot(resave_path);
+    std::vector<char> first = read_file(path);
+    bool identical = first == read_file(resave_path);
+
+    Checker checker;
+    checker.compare(original, restored);
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Snapshot size: " << first.size() / (1024.0 * 1024.0) << " MB\n";
+    std::cout << "Save:    " << save_ms << " ms\n";
+    std::cout << "Restore: " << load_ms << " ms (" << 1e6 * load_ms / std::max<size_t>(num_positions, 1)
+              << " ns per position)\n";
+    std::cout << "Re-save byte-identical: " << (identical ? "yes" : "NO") << "\n";
+    std::cout << "Field mismatches: " << checker.failures << "\n";
+
+    std::remove(path.c_str());
+    std::remove(resave_path.c_str());
+
+    bool ok = identical && checker.failures == 0;
+    std::cout << (ok ? "PASS" : "FAIL") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+// Implied vol round trip and vol surface calibration throughput
+// Usage: volCalibration [tickers]  (default 5,000)
+// Each ticker gets a skewed smile (every fifth on the EUR curve); a call and
+// a put are priced at every strike x expiry of its grid with the
+// Black-Scholes model, discounted on the ticker's curve, then the batch
+// solver recovers the vols and the calibrator rebuilds every surface from
+// the premiums alone. Reports the worst vol error of each and the timings.
+// Fails if either error exceeds 1e-6, an out-of-the-money quote is left
+// unsolved or an arbitrage-violating premium is inverted.
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "../include/marketSimulator.hh"
+#include "../include/volCalibration.hh"
+
+constexpr double kStrikes[] = {0.5, 0.6, 0.7, 0.8, 0.85, 0.9, 0.95, 1.0, 1.05, 1.1, 1.15, 1.2, 1.3, 1.5, 2.0};
+constexpr double kExpiries[] = {1.0 / 52, 1.0 / 12, 0.25, 0.5, 1.0, 2.0, 5.0};
+constexpr double kMaxVolError = 1e-6;
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Skew and smile in log-moneyness, flattening with expiry
+static double true_vol(size_t ticker, double moneyness, double expiry) {
+    double base = 0.15 + 0.002 * (ticker % 100);
+    double k = std::log(moneyness) / std::sqrt(std::max(expiry, 0.25));
+    return base - 0.08 * k + 0.12 * k * k;
+}
+
+int main(int argc, char* argv[]) {
+    size_t num_tickers = argc > 1 ? std::stoul(argv[1]) : 5000;
+
+    MarketEnvironment env = create_sample_market();
+    BlackScholesModel model;
+    std::vector<OptionQuote> quotes;
+    std::vector<double> truth;
+    for (size_t t = 0; t < num_tickers; ++t) {
+        std::string ticker = "VOL" + std::to_string(t);
+        double spot = 20.0 + (t % 37) * 5.0;
+        env.set_spot(ticker, spot);
+        if (t % 5 == 4) env.set_currency(ticker, "EUR");  // Quotes leave the currency empty
+        for (double expiry : kExpiries) {
+            double r = env.get_rate(expiry, env.get_currency(ticker));
+            for (double m : kStrikes) {
+                double sigma = true_vol(t, m, expiry);
+                for (bool call : {true, false}) {
+                    double premium = model.price_option(spot, spot * m, expiry, r, sigma, call);
+                    quotes.push_back({ticker, spot * m, expiry, premium, call, ""});
+                    truth.push_back(sigma);
+                }
+            }
+        }
+    }
+
+    // Batch solver round trip
+    size_t n = quotes.size();
+    std::vector<double> S(n), K(n), T(n), r(n), premium(n), vol(n);
+    std::vector<unsigned char> is_call(n);
+    for (size_t i = 0; i < n; ++i) {
+        S[i] = env.get_spot(quotes[i].ticker);
+        K[i] = quotes[i].strike;
+        T[i] = quotes[i].expiry;
+        r[i] = env.get_rate(T[i], env.get_currency(quotes[i].ticker));
+        premium[i] = quotes[i].premium;
+        is_call[i] = quotes[i].is_call;
+    }
+    ImpliedVolSolver solver;
+    auto start = std::chrono::steady_clock::now();
+    solver.solve(S.data(), K.data(), T.data(), r.data(), premium.data(), is_call.data(), vol.data(), n);
+    double solve_ms = elapsed_ms(start);
+
+    // Deep ITM premiums are intrinsic to within rounding and cannot be inverted;
+    // an unsolved OTM quote is a solver failure
+    double worst_solver = 0.0;
+    size_t unsolved = 0, unsolved_otm = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (std::isnan(vol[i])) {
+            double forward = S[i] * std::exp(r[i] * T[i]);
+            ++unsolved;
+            unsolved_otm += is_call[i] ? K[i] >= forward : K[i] <= forward;
+        } else {
+            worst_solver = std::max(worst_solver, std::fabs(vol[i] - truth[i]));
+        }
+    }
+
+    // Arbitrage violations must be rejected, not fitted
+    double below_intrinsic = solver.solve(100.0, 80.0, 0.5, 0.03, 19.0, true);
+    double above_spot = solver.solve(100.0, 80.0, 0.5, 0.03, 101.0, true);
+
+    // Surface calibration from premiums only
+    VolSurfaceCalibrator calibrator;
+    CalibrationReport report;
+    start = std::chrono::steady_clock::now();
+    std::map<std::string, VolatilitySurface> surfaces = calibrator.calibrate(quotes, env, &report);
+    double calibrate_ms = elapsed_ms(start);
+
+    double worst_surface = 0.0;
+    for (size_t t = 0; t < num_tickers; ++t) {
+        std::string ticker = "VOL" + std::to_string(t);
+        const VolatilitySurface& surface = surfaces.at(ticker);
+        double spot = env.get_spot(ticker);
+        for (double expiry : kExpiries) {
+            for (double m : kStrikes) {
+                worst_surface = std::max(worst_surface,
+                                         std::fabs(surface.get_vol(spot * m, expiry) - true_vol(t, m, expiry)));
+            }
+        }
+    }
+
+    std::cout << "Tickers: " << num_tickers << ", quotes: " << n << "\n";
+    std::cout << std::scientific << std::setprecision(2);
+    std::cout << "Solver:     max |vol error| " << worst_solver << ", unsolved " << unsolved
+              << " (out-of-the-money: " << unsolved_otm << ")\n";
+    std::cout << "Calibrator: max |vol error| " << worst_surface << " at grid points, surfaces "
+              << report.tickers << ", rejected quotes " << report.rejected_quotes << "\n";
+    std::cout << "Arbitrage checks: below intrinsic -> " << below_intrinsic
+              << ", above spot -> " << above_spot << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Solve " << solve_ms << " ms (" << solve_ms * 1e6 / n << " ns/option), calibrate "
+              << calibrate_ms << " ms\n";
+
+    bool ok = worst_solver < kMaxVolError && worst_surface < kMaxVolError && unsolved_otm == 0 &&
+              report.tickers == num_tickers && std::isnan(below_intrinsic) && std::isnan(above_spot);
+    std::cout << (ok ? "PASS" : "FAIL") << "\n";
+    return ok ? 0 : 1;
+}
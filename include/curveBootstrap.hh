@@ -0,0 +1,94 @@
+// Header file for yield curve bootstrapping
+// Builds a YieldCurve from deposit, FRA, futures and par swap quotes, and
+// re-bootstraps cheaply when a few quotes tick
+
+#ifndef CURVE_BOOTSTRAP_H
+#define CURVE_BOOTSTRAP_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include "marketEnvironment.hh"
+
+// ============================================================================
+// RATE QUOTES
+// Single-curve conventions, times in years, simple accrual:
+//   deposit  DF(T) = 1 / (1 + r T)
+//   FRA      DF(T) = DF(start) / (1 + r (T - start))
+//   future   as a FRA at rate (100 - price) / 100 - convexity
+//   swap     1 - DF(T) = r * sum tau_i DF(t_i), fixed leg paid `frequency`
+//            times a year backwards from T (short first period)
+// ============================================================================
+
+enum class RateInstrument : std::uint8_t { Deposit, FRA, Future, Swap };
+
+struct RateQuote {
+    RateInstrument type = RateInstrument::Deposit;
+    double start = 0.0;      // FRA / future accrual start
+    double maturity = 0.0;   // The quote's curve pillar
+    double value = 0.0;      // Rate, or futures price
+    unsigned frequency = 1;  // Swap fixed payments per year
+    double convexity = 0.0;  // Futures convexity adjustment (rate units)
+};
+
+// ============================================================================
+// CURVE BOOTSTRAPPER
+// One pillar per quote at its maturity, zero rates linear in between and
+// flat beyond the ends - the interpolation YieldCurve itself uses, so the
+// resulting curve reprices every quote exactly. Pillars are solved in
+// maturity order, each by Newton on its zero rate with all earlier pillars
+// fixed: a quote's cash flows before the previous pillar are discounted
+// once off the partial curve, and only those in the last segment move with
+// the unknown. Cash flow times, their segments and interpolation weights
+// are laid out once at construction; a quote tick only rewrites amounts
+// and re-solves from the earliest changed pillar onwards, warm-started
+// from the previous zero rates (one or two Newton steps per pillar).
+// ============================================================================
+
+struct BootstrapSettings {
+    double tolerance = 1e-14;  // On the zero rate step
+    unsigned max_iterations = 50;
+};
+
+class CurveBootstrapper {
+public:
+    explicit CurveBootstrapper(const std::vector<RateQuote>& quotes, const BootstrapSettings& settings = {});
+
+    // New quote values by index in the constructor's vector; returns the
+    // number of pillars re-solved
+    size_t update_quotes(const std::vector<std::pair<size_t, double>>& changes);
+    size_t update_quote(size_t index, double value) { return update_quotes({{index, value}}); }
+
+    const YieldCurve& get_curve() const { return curve_; }
+    const std::vector<double>& get_pillars() const { return pillars_; }
+    const std::vector<double>& get_zero_rates() const { return zero_rates_; }
+    const RateQuote& get_quote(size_t index) const { return quotes_[index]; }
+    size_t size() const { return quotes_.size(); }
+
+    // Quote value (rate, or futures price) implied by a curve
+    static double implied_value(const RateQuote& quote, const YieldCurve& curve);
+
+private:
+    struct CashFlow {
+        double time;
+        double amount;
+        std::uint32_t segment;  // Pillar index of the interval (pillar[s-1], pillar[s]]
+        double weight;          // Of pillar[segment] in the linear zero rate
+    };
+
+    BootstrapSettings settings_;
+    std::vector<RateQuote> quotes_;     // Constructor order
+    std::vector<size_t> pillar_of_;     // Quote index -> pillar index
+    std::vector<double> pillars_;       // Ascending maturities
+    std::vector<double> zero_rates_;    // Per pillar
+    std::vector<CashFlow> flows_;       // Per pillar, CSR
+    std::vector<size_t> flow_begin_;    // pillars_.size() + 1 offsets
+    YieldCurve curve_;
+
+    void set_amounts(size_t quote_index);
+    double discount(const CashFlow& flow) const;
+    void solve_pillar(size_t k);
+};
+
+#endif
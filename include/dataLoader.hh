@@ -0,0 +1,104 @@
+// Header file for bulk loading of instruments, positions and market data
+// Delimited text (CSV/TSV) and a dictionary-encoded columnar binary format
+
+#ifndef DATA_LOADER_H
+#define DATA_LOADER_H
+
+#include <string>
+#include <map>
+#include <vector>
+#include <cstddef>
+#include "marketTick.hh"
+
+class MarketSimulator;
+class MarketEnvironment;
+class InstrumentRegistry;
+class CorrelationMatrix;
+struct OptionQuote;
+struct RateQuote;
+
+// ============================================================================
+// DELIMITED TEXT FORMAT
+// First line is a header; columns are matched by name, so their order is
+// free and extra columns are ignored. Fields are not quoted (tickers and
+// numbers only); surrounding spaces and CRLF line ends are tolerated.
+// Files are memory-mapped and split into line-aligned chunks that are parsed
+// in parallel straight from the mapping (fields are views, numbers go
+// through std::from_chars - no per-row allocation), then merged in file
+// order into their final storage.
+//
+//   instruments:  type,ticker,price[,currency]
+//                 + options: underlying,strike,expiry,option_type (call/put)
+//                 + bonds:   duration[,coupon]
+//                 type is stock/option/bond; options inherit the underlying's
+//                 currency and may appear before their underlying
+//   positions:    portfolio,ticker,quantity[,currency]
+//                 currency = reporting currency of a new portfolio
+//   spots:        ticker,price
+//   yield curves: currency,tenor,rate
+//   rate quotes:  currency,type,maturity,quote[,start][,frequency][,convexity]
+//                 type is deposit/fra/future/swap; quote is the rate, or
+//                 the futures price; input to CurveBootstrapper
+//   vol surfaces: ticker,expiry,strike,vol (full grid per ticker)
+//   option quotes: ticker,strike,expiry,premium,option_type[,currency]
+//                 input to VolSurfaceCalibrator; any subset of the grid
+//   correlation:  square matrix, header = <label>,T1..Tn, row i = Ti,c_i1..c_in
+//   tick replay:  batch,type,key,value (type spot/vol/rate; consecutive rows
+//                 with the same batch id form one TickBatch)
+// ============================================================================
+
+struct LoadOptions {
+    char delimiter = ',';
+    size_t num_threads = 0;  // 0 = all hardware threads
+};
+
+class DataLoader {
+public:
+    // Adds every instrument to the registry; returns the number added
+    static size_t load_instruments(const std::string& path, InstrumentRegistry& registry,
+                                   const LoadOptions& options = {});
+    // Into the simulator's registry, tagging its env with the stocks' currencies
+    static size_t load_instruments(const std::string& path, MarketSimulator& market,
+                                   const LoadOptions& options = {});
+
+    // Appends positions to the simulator's portfolios, creating a portfolio
+    // per unseen owner (each reserved to its exact size before filling).
+    // Returns owner -> portfolio id
+    static std::map<std::string, size_t> load_positions(const std::string& path, MarketSimulator& market,
+                                                        const LoadOptions& options = {});
+
+    static void load_spots(const std::string& path, MarketEnvironment& env,
+                           const LoadOptions& options = {});
+    static void load_yield_curves(const std::string& path, MarketEnvironment& env,
+                                  const LoadOptions& options = {});
+    // Curve instrument quotes per currency, in file order
+    static std::map<std::string, std::vector<RateQuote>> load_rate_quotes(const std::string& path,
+                                                                         const LoadOptions& options = {});
+    static void load_vol_surfaces(const std::string& path, MarketEnvironment& env,
+                                  const LoadOptions& options = {});
+
+    // Rows are parsed in parallel straight into the column-major buffer
+    // (the matrix is symmetric, so row i is column i), then factored
+    static CorrelationMatrix load_correlation(const std::string& path,
+                                              const LoadOptions& options = {});
+
+    // Quoted premiums in file order, for VolSurfaceCalibrator
+    static std::vector<OptionQuote> load_option_quotes(const std::string& path,
+                                                       const LoadOptions& options = {});
+
+    // Intraday tick replay, batches in file order
+    static std::vector<TickBatch> load_ticks(const std::string& path, const LoadOptions& options = {});
+
+    // ========================================================================
+    // COLUMNAR BINARY POSITIONS
+    // Dictionary-encoded: owner and ticker dictionaries, then one contiguous
+    // column each for portfolio index (u32), ticker index (u32) and quantity
+    // (f64). Tickers are resolved once per dictionary entry, not per row.
+    // ========================================================================
+
+    static void save_positions_columnar(const MarketSimulator& market, const std::string& path);
+    static std::map<std::string, size_t> load_positions_columnar(const std::string& path,
+                                                                 MarketSimulator& market);
+};
+
+#endif
@@ -0,0 +1,87 @@
+// Header file for the DependencyGraph
+// Reverse edges from market inputs to the instruments and portfolio
+// aggregates that depend on them, for targeted recomputation
+
+#ifndef DEPENDENCY_GRAPH_H
+#define DEPENDENCY_GRAPH_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "instrumentRegistry.hh"
+#include "portfolio.hh"
+
+// ============================================================================
+// DEPENDENCY GRAPH
+//   underlying -> options         (maintained by InstrumentRegistry)
+//   currency   -> options, bonds  (curve moves)
+//   instrument -> positions       (CSR per instrument type)
+//   position   -> aggregate bucket: one per (portfolio, currency), so
+//                 incremental aggregates need no FX until they are read
+// The registry and portfolios are append-only, so staleness is detected in
+// O(1) from the registry's book generation (bumped by every instrument and
+// position added) and the portfolio count; rebuild explicitly after editing
+// quantities in place.
+// ============================================================================
+
+class DependencyGraph {
+public:
+    struct Holder {
+        std::uint32_t portfolio;
+        std::uint32_t bucket;  // (portfolio, currency) aggregate
+        double quantity;
+    };
+
+    struct HolderRange {
+        const Holder* first;
+        const Holder* last;
+        const Holder* begin() const { return first; }
+        const Holder* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+    };
+
+    using Bucket = std::pair<const std::string*, std::uint32_t>;  // (interned currency, bucket id)
+
+    void build(const InstrumentRegistry& registry, const std::vector<Portfolio>& portfolios);
+    bool is_stale(const InstrumentRegistry& registry, const std::vector<Portfolio>& portfolios) const;
+
+    // Options/bonds whose curve is `currency` (empty if none)
+    const std::vector<InstrumentId>& get_options_in_currency(const std::string& currency) const;
+    const std::vector<InstrumentId>& get_bonds_in_currency(const std::string& currency) const;
+
+    HolderRange get_holders(InstrumentId id) const {
+        size_t type = static_cast<size_t>(get_instrument_type(id));
+        size_t index = get_instrument_index(id);
+        const Holder* base = holders_[type].data();
+        return {base + holder_offsets_[type][index], base + holder_offsets_[type][index + 1]};
+    }
+
+    size_t get_bucket_count() const { return bucket_count_; }
+    size_t get_generation() const { return generation_; }  // Bumped by every build
+    const std::vector<Bucket>& get_buckets(size_t portfolio) const { return buckets_[portfolio]; }
+
+    // Options depending on any of `underlyings` (stocks), each once
+    std::vector<InstrumentId> get_affected_options(const InstrumentRegistry& registry,
+                                                   const std::vector<InstrumentId>& underlyings) const;
+
+    // Portfolios holding any of `instruments`, sorted, each once
+    std::vector<size_t> get_affected_portfolios(const std::vector<InstrumentId>& instruments) const;
+
+private:
+    std::unordered_map<std::string, std::vector<InstrumentId>> options_by_currency_;
+    std::unordered_map<std::string, std::vector<InstrumentId>> bonds_by_currency_;
+
+    std::vector<std::uint32_t> holder_offsets_[3];  // [type]: index -> range in holders_
+    std::vector<Holder> holders_[3];
+
+    std::vector<std::vector<Bucket>> buckets_;  // Per portfolio
+    size_t bucket_count_ = 0;
+
+    // Book the graph was built for
+    std::uint64_t built_book_generation_ = 0;
+    size_t built_portfolios_ = 0;
+    size_t generation_ = 0;
+};
+
+#endif
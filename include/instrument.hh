@@ -5,6 +5,7 @@
 
 #include <string>
 #include <memory>
+#include <cstdint>
 #include "model.hh"
 
 // Forward declarations
@@ -12,12 +13,41 @@ class Model;
 class InstrumentVisitor;
 class ConstInstrumentVisitor;
 
+// Compact handle to an instrument owned by an InstrumentRegistry
+using InstrumentId = std::uint32_t;
+
+// ============================================================================
+// INSTRUMENT ID ENCODING
+// Top 2 bits = instrument type, low 30 bits = index in that type's pool
+// ============================================================================
+
+enum class InstrumentType : std::uint8_t { Stock = 0, Option = 1, Bond = 2 };
+
+constexpr unsigned kInstrumentIndexBits = 30;
+constexpr InstrumentId kInstrumentIndexMask = (InstrumentId(1) << kInstrumentIndexBits) - 1;
+constexpr InstrumentId kInvalidInstrumentId = ~InstrumentId(0);
+
+constexpr InstrumentId make_instrument_id(InstrumentType type, std::uint32_t index) {
+    return (static_cast<InstrumentId>(type) << kInstrumentIndexBits) | index;
+}
+
+constexpr InstrumentType get_instrument_type(InstrumentId id) {
+    return static_cast<InstrumentType>(id >> kInstrumentIndexBits);
+}
+
+constexpr std::uint32_t get_instrument_index(InstrumentId id) {
+    return id & kInstrumentIndexMask;
+}
+
 // Abstract base class for all tradeable instruments
 // NOTE: Instruments are pure DATA - no simulation logic here (Visitor Pattern)
+// NOTE: The ticker and currency are NOT owned - they point into the registry's
+//       interned TickerTable, so it must outlive the instrument (8 bytes vs a
+//       heap string). Prices are quoted in the instrument's own currency.
 class Instrument {
 public:
-    Instrument(std::string ticker, double price)
-        : ticker_(ticker), current_price_(price) {}
+    Instrument(const std::string* ticker, double price, const std::string* currency)
+        : ticker_(ticker), currency_(currency), current_price_(price) {}
     
     virtual ~Instrument() = default;
 
@@ -31,12 +61,15 @@ public:
     }
     
     // Common interface - pure data accessors
-    const std::string& get_ticker() const { return ticker_; }
+    const std::string& get_ticker() const { return *ticker_; }
+    const std::string& get_currency() const { return *currency_; }
+    const std::string* get_currency_ptr() const { return currency_; }  // Interned: compare by address
     double get_price() const { return current_price_; }
     void set_price(double p) { current_price_ = p; }
 
 protected:
-    std::string ticker_;
+    const std::string* ticker_;    // Interned (see TickerTable)
+    const std::string* currency_;  // Interned (see TickerTable)
     double current_price_;
 };
 
@@ -44,8 +77,8 @@ protected:
 // Pure data - no simulation logic
 class Stock : public Instrument {
 public:
-    Stock(std::string ticker, double price)
-        : Instrument(ticker, price) {}
+    Stock(const std::string* ticker, double price, const std::string* currency)
+        : Instrument(ticker, price, currency) {}
 
     void accept(InstrumentVisitor& visitor) override;
     void accept(ConstInstrumentVisitor& visitor) const override;
@@ -53,13 +86,15 @@ public:
 
 // Option: Non-linear (convex) risk profile
 // Pure data - no pricing logic
+// The underlying lives in the same registry (pool addresses are stable)
+// Premium and strike are in the underlying's currency
 class Option : public Instrument {
 public:
     enum class Type { Call, Put };
 
-    Option(std::string ticker, double premium, double strike, 
-           std::shared_ptr<Stock> underlying, double time_to_expiry, Type type)
-        : Instrument(ticker, premium), strike_(strike), 
+    Option(const std::string* ticker, double premium, double strike, 
+           const Stock* underlying, double time_to_expiry, Type type)
+        : Instrument(ticker, premium, underlying->get_currency_ptr()), strike_(strike), 
           underlying_(underlying), time_to_expiry_(time_to_expiry), type_(type) {}
 
     void accept(InstrumentVisitor& visitor) override;
@@ -74,7 +109,7 @@ public:
 
 private:
     double strike_;
-    std::shared_ptr<Stock> underlying_;
+    const Stock* underlying_;  // Non-owning: owned by the InstrumentRegistry
     double time_to_expiry_;  // In years
     Type type_;
 };
@@ -83,8 +118,9 @@ private:
 // Pure data - no simulation logic
 class Bond : public Instrument {
 public:
-    Bond(std::string ticker, double price, double duration, double coupon_rate = 0.0)
-        : Instrument(ticker, price), duration_(duration), coupon_rate_(coupon_rate) {}
+    Bond(const std::string* ticker, double price, double duration, double coupon_rate,
+         const std::string* currency)
+        : Instrument(ticker, price, currency), duration_(duration), coupon_rate_(coupon_rate) {}
 
     void accept(InstrumentVisitor& visitor) override;
     void accept(ConstInstrumentVisitor& visitor) const override;
@@ -98,4 +134,10 @@ private:
     double coupon_rate_;  // Annual coupon as decimal
 };
 
+// Compile-time InstrumentType of a concrete instrument class
+template <typename T> struct InstrumentTypeOf;
+template <> struct InstrumentTypeOf<Stock> { static constexpr InstrumentType value = InstrumentType::Stock; };
+template <> struct InstrumentTypeOf<Option> { static constexpr InstrumentType value = InstrumentType::Option; };
+template <> struct InstrumentTypeOf<Bond> { static constexpr InstrumentType value = InstrumentType::Bond; };
+
 #endif
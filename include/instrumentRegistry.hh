@@ -0,0 +1,344 @@
+// Header file for the InstrumentRegistry
+// Owns every instrument in type-specific pools, with interned tickers
+
+#ifndef INSTRUMENT_REGISTRY_H
+#define INSTRUMENT_REGISTRY_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <stdexcept>
+#include <cstdint>
+#include <utility>
+#include <variant>
+#include "instrument.hh"
+#include "visitor.hh"
+
+// ============================================================================
+// TICKER TABLE - Interned tickers (one heap string per distinct ticker)
+// ============================================================================
+
+class TickerTable {
+public:
+    TickerTable() = default;
+    TickerTable(const TickerTable&) = delete;
+    TickerTable& operator=(const TickerTable&) = delete;
+
+    // Returns a stable pointer to the interned copy of the ticker
+    const std::string* intern(const std::string& ticker) {
+        auto it = index_.find(ticker);
+        if (it != index_.end()) return &strings_[it->second];
+        strings_.push_back(ticker);  // deque: existing elements never move
+        index_.emplace(strings_.back(), strings_.size() - 1);
+        return &strings_.back();
+    }
+
+    // Returns nullptr if the ticker was never interned (no allocation)
+    const std::string* find(std::string_view ticker) const {
+        auto it = index_.find(ticker);
+        return it != index_.end() ? &strings_[it->second] : nullptr;
+    }
+
+    size_t size() const { return strings_.size(); }
+
+private:
+    std::deque<std::string> strings_;
+    std::unordered_map<std::string_view, size_t> index_;  // Views into strings_
+};
+
+// ============================================================================
+// INSTRUMENT POOL - Chunked storage for one instrument type
+// Chunks are reserved up-front and never grow past kChunkSize, so element
+// addresses are stable (Option can point at its underlying) while each chunk
+// is a contiguous array that can be traversed sequentially.
+// ============================================================================
+
+template <typename T>
+class InstrumentPool {
+public:
+    static constexpr unsigned kChunkBits = 12;
+    static constexpr size_t kChunkSize = size_t(1) << kChunkBits;
+    static constexpr size_t kChunkMask = kChunkSize - 1;
+
+    InstrumentPool() = default;
+    InstrumentPool(const InstrumentPool&) = delete;
+    InstrumentPool& operator=(const InstrumentPool&) = delete;
+
+    // Construct in place, returns the pool index
+    template <typename... Args>
+    std::uint32_t emplace(Args&&... args) {
+        if (size_ > kInstrumentIndexMask) {
+            throw std::length_error("Instrument pool is full");
+        }
+        if (chunks_.empty() || chunks_.back().size() == kChunkSize) {
+            chunks_.emplace_back();
+            chunks_.back().reserve(kChunkSize);
+        }
+        chunks_.back().emplace_back(std::forward<Args>(args)...);
+        return static_cast<std::uint32_t>(size_++);
+    }
+
+    T& operator[](size_t idx) { return chunks_[idx >> kChunkBits][idx & kChunkMask]; }
+    const T& operator[](size_t idx) const { return chunks_[idx >> kChunkBits][idx & kChunkMask]; }
+
+    size_t size() const { return size_; }
+
+    template <typename F>
+    void for_each(F&& f) {
+        for (auto& chunk : chunks_) {
+            for (auto& item : chunk) f(item);
+        }
+    }
+
+    template <typename F>
+    void for_each(F&& f) const {
+        for (const auto& chunk : chunks_) {
+            for (const auto& item : chunk) f(item);
+        }
+    }
+
+    // f(InstrumentSpan) once per chunk - each span is contiguous memory
+    template <typename F>
+    void for_each_span(F&& f) {
+        for (size_t c = 0; c < chunks_.size(); ++c) {
+            f(InstrumentSpan<T>(chunks_[c].data(), chunks_[c].size(),
+                                static_cast<std::uint32_t>(c << kChunkBits)));
+        }
+    }
+
+    template <typename F>
+    void for_each_span(F&& f) const {
+        for (size_t c = 0; c < chunks_.size(); ++c) {
+            f(InstrumentSpan<const T>(chunks_[c].data(), chunks_[c].size(),
+                                      static_cast<std::uint32_t>(c << kChunkBits)));
+        }
+    }
+
+private:
+    std::vector<std::vector<T>> chunks_;
+    size_t size_ = 0;
+};
+
+// ============================================================================
+// INSTRUMENT REGISTRY - Owns all instruments, hands out compact InstrumentIds
+// Portfolios store {InstrumentId, quantity, last price} and resolve here.
+// ============================================================================
+
+class InstrumentRegistry {
+public:
+    InstrumentRegistry() = default;
+    InstrumentRegistry(const InstrumentRegistry&) = delete;
+    InstrumentRegistry& operator=(const InstrumentRegistry&) = delete;
+
+    // ========================================================================
+    // CREATION - Tickers must be unique across the registry
+    // ========================================================================
+
+    // Prices are quoted in `currency`; options inherit their underlying's
+    InstrumentId add_stock(const std::string& ticker, double price,
+                           const std::string& currency = "USD") {
+        const std::string* name = intern_unique(ticker);
+        auto idx = stocks_.emplace(name, price, tickers_.intern(currency));
+        dependent_options_.emplace_back();
+        return register_id(name, make_instrument_id(InstrumentType::Stock, idx));
+    }
+
+    InstrumentId add_option(const std::string& ticker, double premium, double strike,
+                            InstrumentId underlying, double time_to_expiry, Option::Type type) {
+        const Stock& underlying_stock = get_stock(underlying);
+        const std::string* name = intern_unique(ticker);
+        auto idx = options_.emplace(name, premium, strike, &underlying_stock, time_to_expiry, type);
+        InstrumentId id = make_instrument_id(InstrumentType::Option, idx);
+        dependent_options_[get_instrument_index(underlying)].push_back(id);
+        return register_id(name, id);
+    }
+
+    InstrumentId add_bond(const std::string& ticker, double price, double duration,
+                          double coupon_rate = 0.0, const std::string& currency = "USD") {
+        const std::string* name = intern_unique(ticker);
+        auto idx = bonds_.emplace(name, price, duration, coupon_rate, tickers_.intern(currency));
+        return register_id(name, make_instrument_id(InstrumentType::Bond, idx));
+    }
+
+    // ========================================================================
+    // LOOKUP
+    // ========================================================================
+
+    Instrument& get(InstrumentId id) {
+        return const_cast<Instrument&>(static_cast<const InstrumentRegistry&>(*this).get(id));
+    }
+
+    const Instrument& get(InstrumentId id) const {
+        auto idx = get_instrument_index(id);
+        switch (get_instrument_type(id)) {
+            case InstrumentType::Stock:  return checked(stocks_, idx);
+            case InstrumentType::Option: return checked(options_, idx);
+            case InstrumentType::Bond:   return checked(bonds_, idx);
+        }
+        throw std::out_of_range("Invalid instrument id");
+    }
+
+    Stock& get_stock(InstrumentId id) { return checked(stocks_, typed_index(id, InstrumentType::Stock)); }
+    const Stock& get_stock(InstrumentId id) const { return checked(stocks_, typed_index(id, InstrumentType::Stock)); }
+    Option& get_option(InstrumentId id) { return checked(options_, typed_index(id, InstrumentType::Option)); }
+    const Option& get_option(InstrumentId id) const { return checked(options_, typed_index(id, InstrumentType::Option)); }
+    Bond& get_bond(InstrumentId id) { return checked(bonds_, typed_index(id, InstrumentType::Bond)); }
+    const Bond& get_bond(InstrumentId id) const { return checked(bonds_, typed_index(id, InstrumentType::Bond)); }
+
+    // Resolve an id to its concrete type (for std::visit / static visitors)
+    InstrumentRef resolve(InstrumentId id) {
+        switch (get_instrument_type(id)) {
+            case InstrumentType::Stock:  return &get_stock(id);
+            case InstrumentType::Option: return &get_option(id);
+            case InstrumentType::Bond:   return &get_bond(id);
+        }
+        throw std::out_of_range("Invalid instrument id");
+    }
+
+    ConstInstrumentRef resolve(InstrumentId id) const {
+        switch (get_instrument_type(id)) {
+            case InstrumentType::Stock:  return &get_stock(id);
+            case InstrumentType::Option: return &get_option(id);
+            case InstrumentType::Bond:   return &get_bond(id);
+        }
+        throw std::out_of_range("Invalid instrument id");
+    }
+
+    // Find an instrument by ticker (returns kInvalidInstrumentId if unknown)
+    // Allocation-free and safe to call concurrently with other const lookups
+    InstrumentId find(std::string_view ticker) const {
+        const std::string* name = tickers_.find(ticker);
+        if (!name) return kInvalidInstrumentId;
+        auto it = ids_by_ticker_.find(name);
+        return it != ids_by_ticker_.end() ? it->second : kInvalidInstrumentId;
+    }
+
+    size_t size() const { return stocks_.size() + options_.size() + bonds_.size(); }
+    size_t stock_count() const { return stocks_.size(); }
+    size_t option_count() const { return options_.size(); }
+    size_t bond_count() const { return bonds_.size(); }
+
+    // Book generation: bumped by every add_* and by Portfolio::add_position on
+    // the portfolios sharing this registry, so indexes derived from the book
+    // (DependencyGraph) detect staleness in O(1)
+    std::uint64_t get_generation() const { return generation_; }
+    void bump_generation() { ++generation_; }
+
+    // Reverse edge underlying -> options, maintained on add_option
+    const std::vector<InstrumentId>& get_dependent_options(InstrumentId stock) const {
+        return dependent_options_.at(typed_index(stock, InstrumentType::Stock));
+    }
+
+    // ========================================================================
+    // TRAVERSAL - Sequential, type by type (stocks before the options on them)
+    // ========================================================================
+
+    template <typename F> void for_each_stock(F&& f) { stocks_.for_each(std::forward<F>(f)); }
+    template <typename F> void for_each_stock(F&& f) const { stocks_.for_each(std::forward<F>(f)); }
+    template <typename F> void for_each_option(F&& f) { options_.for_each(std::forward<F>(f)); }
+    template <typename F> void for_each_option(F&& f) const { options_.for_each(std::forward<F>(f)); }
+    template <typename F> void for_each_option_span(F&& f) { options_.for_each_span(std::forward<F>(f)); }
+    template <typename F> void for_each_option_span(F&& f) const { options_.for_each_span(std::forward<F>(f)); }
+    template <typename F> void for_each_bond(F&& f) { bonds_.for_each(std::forward<F>(f)); }
+    template <typename F> void for_each_bond(F&& f) const { bonds_.for_each(std::forward<F>(f)); }
+
+    // STATIC DISPATCH: call f with the concrete instrument type (no vtable)
+    template <typename F>
+    decltype(auto) visit(InstrumentId id, F&& f) {
+        return std::visit([&](auto* inst) -> decltype(auto) { return f(*inst); }, resolve(id));
+    }
+
+    template <typename F>
+    decltype(auto) visit(InstrumentId id, F&& f) const {
+        return std::visit([&](const auto* inst) -> decltype(auto) { return f(*inst); }, resolve(id));
+    }
+
+    // STATIC DISPATCH over every instrument: one tight loop per pool, so the
+    // type is known at compile time and f's per-type overload can be inlined
+    template <typename F>
+    void visit_all(F&& f) {
+        stocks_.for_each(f);
+        options_.for_each(f);
+        bonds_.for_each(f);
+    }
+
+    template <typename F>
+    void visit_all(F&& f) const {
+        stocks_.for_each(f);
+        options_.for_each(f);
+        bonds_.for_each(f);
+    }
+
+    // BATCH: hand the visitor contiguous spans - all Stocks, then all Options,
+    // then all Bonds (one virtual call per chunk, not per instrument)
+    void accept_batch(BatchInstrumentVisitor& visitor) {
+        stocks_.for_each_span([&](InstrumentSpan<Stock> span) { visitor.visit(span); });
+        options_.for_each_span([&](InstrumentSpan<Option> span) { visitor.visit(span); });
+        bonds_.for_each_span([&](InstrumentSpan<Bond> span) { visitor.visit(span); });
+    }
+
+    void accept_batch(ConstBatchInstrumentVisitor& visitor) const {
+        stocks_.for_each_span([&](InstrumentSpan<const Stock> span) { visitor.visit(span); });
+        options_.for_each_span([&](InstrumentSpan<const Option> span) { visitor.visit(span); });
+        bonds_.for_each_span([&](InstrumentSpan<const Bond> span) { visitor.visit(span); });
+    }
+
+    // Apply a visitor once to every instrument (no per-position duplicates)
+    // Classic virtual path - prefer visit_all with a final/static visitor
+    void accept(InstrumentVisitor& visitor) {
+        stocks_.for_each([&](Stock& s) { visitor.visit(s); });
+        options_.for_each([&](Option& o) { visitor.visit(o); });
+        bonds_.for_each([&](Bond& b) { visitor.visit(b); });
+    }
+
+    void accept(ConstInstrumentVisitor& visitor) const {
+        stocks_.for_each([&](const Stock& s) { visitor.visit(s); });
+        options_.for_each([&](const Option& o) { visitor.visit(o); });
+        bonds_.for_each([&](const Bond& b) { visitor.visit(b); });
+    }
+
+private:
+    TickerTable tickers_;
+    std::unordered_map<const std::string*, InstrumentId> ids_by_ticker_;
+    InstrumentPool<Stock> stocks_;
+    InstrumentPool<Option> options_;
+    InstrumentPool<Bond> bonds_;
+    std::vector<std::vector<InstrumentId>> dependent_options_;  // By stock index
+    std::uint64_t generation_ = 0;
+
+    const std::string* intern_unique(const std::string& ticker) {
+        if (find(ticker) != kInvalidInstrumentId) {
+            throw std::invalid_argument("Instrument already registered: " + ticker);
+        }
+        return tickers_.intern(ticker);
+    }
+
+    InstrumentId register_id(const std::string* name, InstrumentId id) {
+        ids_by_ticker_.emplace(name, id);
+        ++generation_;
+        return id;
+    }
+
+    static std::uint32_t typed_index(InstrumentId id, InstrumentType expected) {
+        if (get_instrument_type(id) != expected) {
+            throw std::invalid_argument("Instrument id has the wrong instrument type");
+        }
+        return get_instrument_index(id);
+    }
+
+    template <typename T>
+    static T& checked(InstrumentPool<T>& pool, std::uint32_t idx) {
+        if (idx >= pool.size()) throw std::out_of_range("Invalid instrument id");
+        return pool[idx];
+    }
+
+    template <typename T>
+    static const T& checked(const InstrumentPool<T>& pool, std::uint32_t idx) {
+        if (idx >= pool.size()) throw std::out_of_range("Invalid instrument id");
+        return pool[idx];
+    }
+};
+
+#endif
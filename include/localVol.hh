@@ -0,0 +1,167 @@
+// Header file for the local volatility (Dupire) model
+// Derives a local vol grid sigma(S, t) from an implied VolatilitySurface once,
+// then simulates with a table lookup per step
+
+#ifndef LOCAL_VOL_H
+#define LOCAL_VOL_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstddef>
+#include "model.hh"
+#include "marketEnvironment.hh"
+
+// ============================================================================
+// LOCAL VOL GRID
+// Dupire's local variance from implied total variance w(y, T) = sigma^2 T in
+// log-moneyness y = ln(K / F_T):
+//
+//   sigma_loc^2(K, T) = dw/dT / (1 - y/w dw/dy
+//                                + 1/4 (-1/4 - 1/w + y^2/w^2) (dw/dy)^2
+//                                + 1/2 d2w/dy2)
+//
+// with central differences on the surface (dT at fixed y, so the strike
+// rides the forward). Nodes where the surface admits arbitrage (negative
+// numerator or denominator) fall back to the implied vol there; every node
+// is clamped to [min_vol, max_vol].
+// Stored as one flat row-major [time][spot] table on uniform axes in t and
+// S (not log S), so a lookup is two multiplies for the bracket and a
+// bilinear blend - no search, no log. Flat beyond the axes.
+// ============================================================================
+
+struct LocalVolSettings {
+    size_t time_steps = 100;   // Grid intervals in t over [0, max_time]
+    size_t spot_steps = 200;   // Grid intervals in S
+    double max_time = 0.0;     // 0 = the surface's last expiry (1y if flat)
+    double num_std_devs = 5.0; // Spot axis spans S0 exp(+-n sigma_atm sqrt(max_time))
+    double min_vol = 0.01;
+    double max_vol = 3.0;
+};
+
+class LocalVolGrid {
+public:
+    // rate: continuously compounded drift of the underlying (forward F_T = S0 e^{rT})
+    LocalVolGrid(const VolatilitySurface& surface, double spot, double rate, const LocalVolSettings& settings = {});
+
+    double get_vol(double t, double spot) const {
+        double ft = std::min(std::max(t * inv_time_step_, 0.0), max_time_index_);
+        double fs = std::min(std::max((spot - spot_min_) * inv_spot_step_, 0.0), max_spot_index_);
+        size_t i = std::min(static_cast<size_t>(ft), num_times_ - 2);
+        size_t j = std::min(static_cast<size_t>(fs), num_spots_ - 2);
+        double wt = ft - i;
+        double ws = fs - j;
+        const double* row = &vols_[i * num_spots_ + j];
+        const double* next = row + num_spots_;
+        double lo = row[0] + ws * (row[1] - row[0]);
+        double hi = next[0] + ws * (next[1] - next[0]);
+        return lo + wt * (hi - lo);
+    }
+
+    size_t num_times() const { return num_times_; }
+    size_t num_spots() const { return num_spots_; }
+    double get_time(size_t i) const { return i / inv_time_step_; }
+    double get_spot(size_t j) const { return spot_min_ + j / inv_spot_step_; }
+    double get_node(size_t i, size_t j) const { return vols_[i * num_spots_ + j]; }
+    size_t get_fallback_nodes() const { return fallback_nodes_; }
+
+private:
+    size_t num_times_;
+    size_t num_spots_;
+    double inv_time_step_;
+    double spot_min_;
+    double inv_spot_step_;
+    double max_time_index_;
+    double max_spot_index_;
+    std::vector<double> vols_;
+    size_t fallback_nodes_ = 0;  // Arbitrage nodes set to the implied vol
+};
+
+// ============================================================================
+// LOCAL VOL MODEL
+// dS = r S dt + sigma_loc(S, t) S dW, stepped in log space with the vol
+// frozen over each step. MultiAssetSimulator's path engines pick up the
+// grid of each underlying (get_local_vol) and look sigma(S, t) up per path
+// and step. Steps without a path time (the env overloads, as in live
+// single-step simulation) use sigma(S, 0); steps without a ticker, and
+// tickers without a grid, diffuse at a flat vol like BlackScholesModel.
+// Vanillas are priced in closed form at the surface's implied vol, which
+// the local vol reproduces by construction.
+// ============================================================================
+
+class LocalVolModel : public Model {
+public:
+    explicit LocalVolModel(double rate = 0.05, double volatility = 0.20,
+                           const LocalVolSettings& settings = {}, unsigned seed = 42)
+        : Model(ModelKind::LocalVol), rate_(rate), volatility_(volatility), settings_(settings),
+          generator_(seed), normal_dist_(0.0, 1.0) {}
+
+    // Builds the ticker's grid from its surface, spot and drift rate in env
+    void add_underlying(const std::string& ticker, const MarketEnvironment& env);
+    void add_underlying(const std::string& ticker, const VolatilitySurface& surface, double spot, double rate);
+
+    const LocalVolGrid* get_local_vol(const std::string& ticker) const override {
+        auto it = grids_.find(ticker);
+        return it != grids_.end() ? &it->second : nullptr;
+    }
+
+    double simulate_step(double current_price, double dt) override {
+        double z = normal_dist_(generator_);
+        return simulate_step(current_price, dt, z);
+    }
+
+    double simulate_step(double current_price, double dt, double random_z) override {
+        return simulate_step(current_price, dt, random_z, rate_, volatility_);
+    }
+
+    double simulate_step(double current_price, double dt, double random_z,
+                          double rate, double sigma) override {
+        double drift = (rate - 0.5 * sigma * sigma) * dt;
+        double diffusion = sigma * std::sqrt(dt) * random_z;
+        return current_price * std::exp(drift + diffusion);
+    }
+
+    double simulate_step(double current_price, double dt,
+                          const std::string& ticker,
+                          const MarketEnvironment& env) override;
+
+    double simulate_step(double current_price, double dt, double random_z,
+                          const std::string& ticker,
+                          const MarketEnvironment& env) override;
+
+    double price_option(double S, double K, double T, double r, double sigma, bool is_call) const override {
+        return is_call ? BlackScholesKernel<true, kOutputPrice>::evaluate(S, K, T, r, sigma).price
+                       : BlackScholesKernel<false, kOutputPrice>::evaluate(S, K, T, r, sigma).price;
+    }
+
+    double price_option(double S, double K, double T,
+                         const std::string& ticker,
+                         const MarketEnvironment& env,
+                         bool is_call) const override;
+
+    Greeks calculate_greeks(double S, double K, double T, double r, double sigma, bool is_call) const override {
+        return is_call ? BlackScholesKernel<true, kOutputGreeks>::evaluate(S, K, T, r, sigma).greeks
+                       : BlackScholesKernel<false, kOutputGreeks>::evaluate(S, K, T, r, sigma).greeks;
+    }
+
+    Greeks calculate_greeks(double S, double K, double T,
+                             const std::string& ticker,
+                             const MarketEnvironment& env,
+                             bool is_call) const override;
+
+    void set_volatility(double sigma) override { volatility_ = sigma; }
+    void set_rate(double r) override { rate_ = r; }
+    void set_seed(unsigned seed) override { generator_.seed(seed); }
+
+    const LocalVolSettings& get_settings() const { return settings_; }
+
+private:
+    double rate_;
+    double volatility_;
+    LocalVolSettings settings_;
+    std::map<std::string, LocalVolGrid> grids_;
+    mutable std::mt19937 generator_;
+    mutable std::normal_distribution<double> normal_dist_;
+};
+
+#endif
@@ -11,6 +11,10 @@
 #include <stdexcept>
 #include <algorithm>
 #include <random>
+#include <type_traits>
+#include <atomic>
+#include <cstdint>
+#include "parallel.hh"
 
 // ============================================================================
 // CORRELATION MATRIX - For multi-asset simulation
@@ -18,7 +22,12 @@
 // ============================================================================
 
 class CorrelationMatrix {
+    friend class SnapshotCodec;
+
 public:
+    // Block size of the blocked Cholesky (panel width)
+    static constexpr size_t kCholeskyBlock = 96;
+
     // Default: Empty (will treat all assets as uncorrelated)
     CorrelationMatrix() = default;
 
@@ -26,7 +35,7 @@ public:
     // corr_matrix must be symmetric positive semi-definite
     CorrelationMatrix(const std::vector<std::string>& tickers,
                       const std::vector<std::vector<double>>& corr_matrix)
-        : tickers_(tickers), corr_matrix_(corr_matrix) {
+        : tickers_(tickers) {
         
         size_t n = tickers.size();
         if (corr_matrix.size() != n) {
@@ -38,15 +47,35 @@ public:
             }
         }
         
-        // Build ticker index map for O(1) lookup
-        for (size_t i = 0; i < tickers.size(); ++i) {
-            ticker_index_[tickers[i]] = i;
+        // Store flat, column-major (symmetric, so element (i,j) = row i, col j)
+        corr_matrix_.resize(n * n);
+        for (size_t j = 0; j < n; ++j) {
+            for (size_t i = 0; i < n; ++i) {
+                corr_matrix_[j * n + i] = corr_matrix[i][j];
+            }
         }
         
+        build_index();
+        
         // Compute Cholesky decomposition L where Σ = L * L^T
         compute_cholesky();
     }
 
+    // Construct from a flat column-major n*n buffer (no nested-vector copy)
+    static CorrelationMatrix from_column_major(const std::vector<std::string>& tickers,
+                                               std::vector<double> corr_column_major) {
+        size_t n = tickers.size();
+        if (corr_column_major.size() != n * n) {
+            throw std::invalid_argument("Correlation buffer size must be ticker count squared");
+        }
+        CorrelationMatrix corr;
+        corr.tickers_ = tickers;
+        corr.corr_matrix_ = std::move(corr_column_major);
+        corr.build_index();
+        corr.compute_cholesky();
+        return corr;
+    }
+
     // Get correlation between two assets
     double get_correlation(const std::string& ticker1, const std::string& ticker2) const {
         auto it1 = ticker_index_.find(ticker1);
@@ -57,7 +86,7 @@ public:
             return (ticker1 == ticker2) ? 1.0 : 0.0;
         }
         
-        return corr_matrix_[it1->second][it2->second];
+        return corr_matrix_[it2->second * size() + it1->second];
     }
 
     // Generate correlated random numbers from independent standard normals
@@ -65,22 +94,68 @@ public:
     // Output: vector of correlated N(0,1) random variates
     // z_correlated = L * z_independent (where L is Cholesky factor)
     std::vector<double> correlate(const std::vector<double>& independent_z) const {
-        size_t n = cholesky_.size();
+        size_t n = size();
         if (independent_z.size() != n) {
             throw std::invalid_argument("Independent Z vector size must match asset count");
         }
         
+        // Column-oriented: z_corr[j:n] += L[j:n, j] * z[j] (contiguous axpy)
         std::vector<double> correlated_z(n, 0.0);
-        for (size_t i = 0; i < n; ++i) {
-            for (size_t j = 0; j <= i; ++j) {  // L is lower triangular
-                correlated_z[i] += cholesky_[i][j] * independent_z[j];
+        for (size_t j = 0; j < n; ++j) {
+            const double* col = &cholesky_[j * n];
+            double zj = independent_z[j];
+            for (size_t i = j; i < n; ++i) {  // L is lower triangular
+                correlated_z[i] += col[i] * zj;
             }
         }
         return correlated_z;
     }
 
-    // Get the Cholesky factor L (lower triangular)
-    const std::vector<std::vector<double>>& get_cholesky() const { return cholesky_; }
+    // Batched correlate for `count` samples stored row-major [sample][asset]
+    // out must hold count * size() values; L stays hot in cache across samples
+    // Real = float: samples and the cached float copy of L halve the memory
+    // traffic, and the float axpy runs twice as many SIMD lanes (a sample
+    // sums at most n terms of |L| <= 1, so float accumulation costs ~n ulp)
+    template <typename Real>
+    void correlate_batch(const Real* independent_z, Real* out, size_t count) const {
+        static_assert(std::is_floating_point<Real>::value, "correlate_batch takes float or double");
+        size_t n = size();
+        const Real* cholesky;
+        if constexpr (std::is_same<Real, double>::value) {
+            cholesky = cholesky_.data();
+        } else {
+            cholesky = cholesky_float_.data();
+        }
+        for (size_t s = 0; s < count; ++s) {
+            const Real* z = independent_z + s * n;
+            Real* o = out + s * n;
+            std::fill(o, o + n, Real(0));
+            for (size_t j = 0; j < n; ++j) {
+                const Real* col = cholesky + j * n;
+                Real zj = z[j];
+                for (size_t i = j; i < n; ++i) {
+                    o[i] += col[i] * zj;
+                }
+            }
+        }
+    }
+
+    // Get the Cholesky factor L (lower triangular) as nested rows
+    // NOTE: materialized copy for display - use get_cholesky_data() in hot code
+    std::vector<std::vector<double>> get_cholesky() const {
+        size_t n = size();
+        std::vector<std::vector<double>> rows(n, std::vector<double>(n, 0.0));
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j <= i; ++j) {
+                rows[i][j] = cholesky_[j * n + i];
+            }
+        }
+        return rows;
+    }
+
+    // Flat column-major Cholesky factor: L(i,j) = data[j * size() + i]
+    const std::vector<double>& get_cholesky_data() const { return cholesky_; }
+    double get_cholesky(size_t i, size_t j) const { return cholesky_[j * size() + i]; }
 
     // Get asset index for a ticker (throws if not found)
     size_t get_asset_index(const std::string& ticker) const {
@@ -102,41 +177,453 @@ public:
 private:
     std::vector<std::string> tickers_;
     std::map<std::string, size_t> ticker_index_;
-    std::vector<std::vector<double>> corr_matrix_;
-    std::vector<std::vector<double>> cholesky_;  // Lower triangular L where Σ = L * L^T
+    std::vector<double> corr_matrix_;  // Flat column-major n*n
+    std::vector<double> cholesky_;     // Flat column-major lower triangular L where Σ = L * L^T
+    std::vector<float> cholesky_float_;  // L rounded to float, for float batches
+
+    // Build ticker index map for O(log n) lookup
+    void build_index() {
+        ticker_index_.clear();
+        for (size_t i = 0; i < tickers_.size(); ++i) {
+            ticker_index_[tickers_[i]] = i;
+        }
+    }
 
-    // Cholesky-Banachiewicz algorithm for L * L^T decomposition
     void compute_cholesky() {
-        size_t n = corr_matrix_.size();
-        cholesky_.assign(n, std::vector<double>(n, 0.0));
-        
-        for (size_t i = 0; i < n; ++i) {
-            for (size_t j = 0; j <= i; ++j) {
-                double sum = 0.0;
-                
-                if (i == j) {
-                    // Diagonal element: L[i][i] = sqrt(Σ[i][i] - Σ L[i][k]^2)
-                    for (size_t k = 0; k < j; ++k) {
-                        sum += cholesky_[j][k] * cholesky_[j][k];
+        cholesky_ = corr_matrix_;
+        cholesky_in_place(cholesky_.data(), size());
+        cholesky_float_.assign(cholesky_.begin(), cholesky_.end());
+    }
+
+public:
+    // Blocked right-looking Cholesky of a flat column-major n x n SPD buffer,
+    // overwritten with L (strict upper triangle zeroed). For each block column k:
+    //   1. Factor the diagonal block (thread 0, small)
+    //   2. Panel solve L21 = A21 * L11^-T (row chunks split across threads)
+    //   3. Trailing update A22 -= L21 * L21^T (column chunks split across threads)
+    // All block columns run inside one parallel_region: threads are spawned
+    // once and the phases are separated by barriers. Chunks are dealt
+    // round-robin, which balances the triangular trailing update without a
+    // shared counter. Inner loops are unit-stride axpys over columns, so the
+    // compiler vectorizes them.
+    static void cholesky_in_place(double* a, size_t n, size_t num_threads = 0) {
+        constexpr size_t kPanelGrain = 256;
+        constexpr size_t kTrailingGrain = 16;
+        if (num_threads == 0) num_threads = hardware_threads();
+        // No more threads than the widest phase has chunks
+        num_threads = std::max<size_t>(1, std::min(num_threads, n / kTrailingGrain));
+
+        Barrier barrier(num_threads);
+        std::exception_ptr error;
+
+        parallel_region(num_threads, [&](size_t thread, size_t threads) {
+            for (size_t k = 0; k < n; k += kCholeskyBlock) {
+                size_t kb = std::min(kCholeskyBlock, n - k);
+                size_t rest = k + kb;
+
+                if (thread == 0) {
+                    try {
+                        factor_diagonal_block(a, n, k, kb);
+                    } catch (...) {
+                        error = std::current_exception();
                     }
-                    double val = corr_matrix_[i][i] - sum;
-                    if (val < 0) {
-                        throw std::runtime_error("Correlation matrix is not positive semi-definite");
+                }
+                barrier.arrive_and_wait();
+                if (error) return;  // Every thread sees it after the barrier
+
+                for (size_t lo = rest + thread * kPanelGrain; lo < n; lo += threads * kPanelGrain) {
+                    panel_solve(a, n, k, rest, lo, std::min(n, lo + kPanelGrain));
+                }
+                barrier.arrive_and_wait();
+
+                for (size_t lo = rest + thread * kTrailingGrain; lo < n; lo += threads * kTrailingGrain) {
+                    trailing_update(a, n, k, rest, lo, std::min(n, lo + kTrailingGrain));
+                }
+                barrier.arrive_and_wait();
+            }
+        });
+        if (error) std::rethrow_exception(error);
+
+        // Zero the strict upper triangle (left over from the input)
+        for (size_t j = 1; j < n; ++j) {
+            std::fill(a + j * n, a + j * n + j, 0.0);
+        }
+    }
+
+private:
+
+    // Panel-solve kernel for rows [r_lo, r_hi) of panel columns [k, rest):
+    // A[r, c] -= A[r, k:c] * L[c, k:c], then / L[c, c]
+    static void panel_solve(double* a, size_t n, size_t k, size_t rest,
+                            size_t r_lo, size_t r_hi) {
+        for (size_t c = k; c < rest; ++c) {
+            double* col = a + c * n;
+            for (size_t p = k; p < c; ++p) {
+                const double* src = a + p * n;
+                double l_cp = a[p * n + c];
+                for (size_t r = r_lo; r < r_hi; ++r) {
+                    col[r] -= src[r] * l_cp;
+                }
+            }
+            double inv_diag = 1.0 / a[c * n + c];
+            for (size_t r = r_lo; r < r_hi; ++r) {
+                col[r] *= inv_diag;
+            }
+        }
+    }
+
+    // Trailing-update kernel for columns [j_lo, j_hi) against panel columns [k, rest)
+    // Rows are tiled so the destination slice stays in L1 and the panel slice
+    // in L2; panel columns are applied four at a time to cut destination traffic.
+    static void trailing_update(double* a, size_t n, size_t k, size_t rest,
+                                size_t j_lo, size_t j_hi) {
+        constexpr size_t kRowTile = 256;
+        for (size_t i0 = j_lo; i0 < n; i0 += kRowTile) {
+            size_t i1 = std::min(n, i0 + kRowTile);
+            for (size_t j = j_lo; j < j_hi && j < i1; ++j) {
+                double* dst = a + j * n;
+                size_t i_start = std::max(i0, j);
+                size_t p = k;
+                for (; p + 4 <= rest; p += 4) {
+                    const double* s0 = a + p * n;
+                    const double* s1 = s0 + n;
+                    const double* s2 = s1 + n;
+                    const double* s3 = s2 + n;
+                    double l0 = s0[j], l1 = s1[j], l2 = s2[j], l3 = s3[j];
+                    for (size_t i = i_start; i < i1; ++i) {
+                        dst[i] -= s0[i] * l0 + s1[i] * l1 + s2[i] * l2 + s3[i] * l3;
                     }
-                    cholesky_[i][j] = std::sqrt(val);
-                } else {
-                    // Off-diagonal: L[i][j] = (Σ[i][j] - Σ L[i][k]*L[j][k]) / L[j][j]
-                    for (size_t k = 0; k < j; ++k) {
-                        sum += cholesky_[i][k] * cholesky_[j][k];
+                }
+                for (; p < rest; ++p) {
+                    const double* src = a + p * n;
+                    double l_jp = src[j];
+                    for (size_t i = i_start; i < i1; ++i) {
+                        dst[i] -= src[i] * l_jp;
                     }
-                    if (cholesky_[j][j] == 0) {
-                        throw std::runtime_error("Zero diagonal in Cholesky decomposition");
+                }
+            }
+        }
+    }
+
+    // Unblocked left-looking Cholesky of the kb x kb diagonal block at (k, k)
+    // (earlier block columns were already applied by the trailing updates)
+    static void factor_diagonal_block(double* a, size_t n, size_t k, size_t kb) {
+        for (size_t j = k; j < k + kb; ++j) {
+            double* col = a + j * n;
+            for (size_t p = k; p < j; ++p) {
+                const double* src = a + p * n;
+                double l_jp = src[j];
+                for (size_t i = j; i < k + kb; ++i) {
+                    col[i] -= src[i] * l_jp;
+                }
+            }
+            
+            // Diagonal element: L[j][j] = sqrt(Σ[j][j] - Σ L[j][p]^2)
+            double val = col[j];
+            if (val < 0) {
+                throw std::runtime_error("Correlation matrix is not positive semi-definite");
+            }
+            col[j] = std::sqrt(val);
+            
+            if (j + 1 < n && col[j] == 0) {
+                throw std::runtime_error("Zero diagonal in Cholesky decomposition");
+            }
+            for (size_t i = j + 1; i < k + kb; ++i) {
+                col[i] /= col[j];
+            }
+        }
+    }
+};
+
+// ============================================================================
+// STRUCTURED CORRELATION - Global factors + sector blocks + idiosyncratic
+// C = B * B^T + blockdiag(S_1..S_m) + D
+//   B: n x k global factor loadings
+//   S_s: dense residual correlation among the members of sector s
+//   D: idiosyncratic variances, implied so that diag(C) = 1
+// Only B and one Cholesky factor per sector block (of S_s + D_s) are stored,
+// so memory and correlate() cost O(n*k + sum of block^2) instead of O(n^2).
+// ============================================================================
+
+class StructuredCorrelation {
+    friend class SnapshotCodec;
+
+public:
+    StructuredCorrelation() = default;
+
+    // factor_loadings: n rows of k loadings (k may be 0)
+    // sector_of: sector id per asset (0..num_sectors-1)
+    // sector_blocks[s]: b_s x b_s residual block among the members of sector s,
+    //   in the order they appear in tickers (empty = no within-sector term)
+    StructuredCorrelation(const std::vector<std::string>& tickers,
+                          const std::vector<std::vector<double>>& factor_loadings,
+                          const std::vector<size_t>& sector_of,
+                          const std::vector<std::vector<std::vector<double>>>& sector_blocks)
+        : tickers_(tickers) {
+        
+        size_t n = tickers.size();
+        if (factor_loadings.size() != n || sector_of.size() != n) {
+            throw std::invalid_argument("Loadings and sector assignment must match ticker count");
+        }
+        num_factors_ = n > 0 ? factor_loadings[0].size() : 0;
+        
+        // Global loadings, flat row-major n x k
+        loadings_.reserve(n * num_factors_);
+        for (const auto& row : factor_loadings) {
+            if (row.size() != num_factors_) {
+                throw std::invalid_argument("Every asset needs the same number of factor loadings");
+            }
+            loadings_.insert(loadings_.end(), row.begin(), row.end());
+        }
+        
+        // Group assets by sector (member order = ticker order)
+        sector_members_.assign(sector_blocks.size(), {});
+        for (size_t i = 0; i < n; ++i) {
+            if (sector_of[i] >= sector_blocks.size()) {
+                throw std::invalid_argument("Sector id out of range for: " + tickers[i]);
+            }
+            sector_members_[sector_of[i]].push_back(i);
+        }
+        
+        // Per-sector residual R_s = S_s + D_s, with D_s making the full diagonal 1
+        sector_cholesky_.resize(sector_blocks.size());
+        for (size_t s = 0; s < sector_blocks.size(); ++s) {
+            const auto& members = sector_members_[s];
+            const auto& block = sector_blocks[s];
+            size_t b = members.size();
+            if (!block.empty() && block.size() != b) {
+                throw std::invalid_argument("Sector block size must match its member count");
+            }
+            
+            std::vector<double>& r = sector_cholesky_[s];
+            r.assign(b * b, 0.0);
+            for (size_t col = 0; col < b; ++col) {
+                for (size_t row = 0; row < b; ++row) {
+                    if (!block.empty()) {
+                        if (block[row].size() != b) {
+                            throw std::invalid_argument("Sector block must be square");
+                        }
+                        r[col * b + row] = block[row][col];
+                    }
+                }
+                
+                // Idiosyncratic variance: whatever the factors and block leave of 1
+                size_t asset = members[col];
+                double systematic = r[col * b + col];
+                for (size_t f = 0; f < num_factors_; ++f) {
+                    double l = loadings_[asset * num_factors_ + f];
+                    systematic += l * l;
+                }
+                if (systematic > 1.0 + 1e-12) {
+                    throw std::invalid_argument("Factor + sector variance exceeds 1 for: " + tickers[asset]);
+                }
+                r[col * b + col] = 1.0 - (systematic - r[col * b + col]);
+            }
+            CorrelationMatrix::cholesky_in_place(r.data(), b);
+        }
+        
+        for (size_t i = 0; i < n; ++i) {
+            ticker_index_[tickers[i]] = i;
+        }
+    }
+
+    // Independent N(0,1) inputs needed by correlate(): k factors + n residuals
+    size_t num_random_inputs() const { return num_factors_ + size(); }
+
+    // z = B * g + blockdiag(L_s) * u, with independent_z = [g (k), u (n)]
+    // u is laid out sector by sector, in member order
+    std::vector<double> correlate(const std::vector<double>& independent_z) const {
+        if (independent_z.size() != num_random_inputs()) {
+            throw std::invalid_argument("Independent Z vector size must be factors + asset count");
+        }
+        std::vector<double> correlated_z(size());
+        correlate_batch(independent_z.data(), correlated_z.data(), 1);
+        return correlated_z;
+    }
+
+    // Batched correlate for `count` samples: inputs [sample][num_random_inputs()],
+    // out [sample][asset] (count * size() values). No allocation per sample;
+    // float samples are accumulated in double (the loadings are only kept
+    // in double)
+    template <typename Real>
+    void correlate_batch(const Real* independent_z, Real* out, size_t count) const {
+        static_assert(std::is_floating_point<Real>::value, "correlate_batch takes float or double");
+        size_t n = size();
+        size_t m = num_random_inputs();
+        std::vector<double> accum(std::is_same<Real, double>::value ? 0 : n);
+        for (size_t s = 0; s < count; ++s) {
+            const Real* g = independent_z + s * m;
+            double* o;
+            if constexpr (std::is_same<Real, double>::value) {
+                o = out + s * n;
+            } else {
+                o = accum.data();
+            }
+            
+            // Global factors: O(n * k)
+            for (size_t i = 0; i < n; ++i) {
+                const double* row = &loadings_[i * num_factors_];
+                double sum = 0.0;
+                for (size_t f = 0; f < num_factors_; ++f) {
+                    sum += row[f] * g[f];
+                }
+                o[i] = sum;
+            }
+            
+            // Sector blocks (idiosyncratic folded in): O(sum of block^2)
+            const Real* u = g + num_factors_;
+            for (size_t sector = 0; sector < sector_members_.size(); ++sector) {
+                const auto& members = sector_members_[sector];
+                const double* l = sector_cholesky_[sector].data();
+                size_t b = members.size();
+                for (size_t col = 0; col < b; ++col) {
+                    double uc = u[col];
+                    for (size_t row = col; row < b; ++row) {
+                        o[members[row]] += l[col * b + row] * uc;
                     }
-                    cholesky_[i][j] = (corr_matrix_[i][j] - sum) / cholesky_[j][j];
                 }
+                u += b;
+            }
+            if constexpr (!std::is_same<Real, double>::value) {
+                std::copy(accum.begin(), accum.end(), out + s * n);
             }
         }
     }
+
+    // Implied pairwise correlation
+    double get_correlation(const std::string& ticker1, const std::string& ticker2) const {
+        auto it1 = ticker_index_.find(ticker1);
+        auto it2 = ticker_index_.find(ticker2);
+        if (it1 == ticker_index_.end() || it2 == ticker_index_.end()) {
+            return (ticker1 == ticker2) ? 1.0 : 0.0;
+        }
+        size_t i = it1->second, j = it2->second;
+        
+        double corr = 0.0;
+        for (size_t f = 0; f < num_factors_; ++f) {
+            corr += loadings_[i * num_factors_ + f] * loadings_[j * num_factors_ + f];
+        }
+        
+        // Same sector: add (L_s * L_s^T)[ri, rj]
+        for (size_t s = 0; s < sector_members_.size(); ++s) {
+            const auto& members = sector_members_[s];
+            auto pi = std::find(members.begin(), members.end(), i);
+            auto pj = std::find(members.begin(), members.end(), j);
+            if (pi == members.end() || pj == members.end()) continue;
+            size_t b = members.size();
+            size_t ri = pi - members.begin(), rj = pj - members.begin();
+            const double* l = sector_cholesky_[s].data();
+            for (size_t c = 0; c <= std::min(ri, rj); ++c) {
+                corr += l[c * b + ri] * l[c * b + rj];
+            }
+        }
+        return corr;
+    }
+
+    size_t get_asset_index(const std::string& ticker) const {
+        auto it = ticker_index_.find(ticker);
+        if (it == ticker_index_.end()) {
+            throw std::runtime_error("Asset not in structured correlation: " + ticker);
+        }
+        return it->second;
+    }
+
+    bool has_ticker(const std::string& ticker) const {
+        return ticker_index_.find(ticker) != ticker_index_.end();
+    }
+
+    size_t size() const { return tickers_.size(); }
+    size_t num_factors() const { return num_factors_; }
+    size_t num_sectors() const { return sector_members_.size(); }
+    const std::vector<std::string>& get_tickers() const { return tickers_; }
+
+private:
+    std::vector<std::string> tickers_;
+    std::map<std::string, size_t> ticker_index_;
+    size_t num_factors_ = 0;
+    std::vector<double> loadings_;                     // Flat row-major n x k
+    std::vector<std::vector<size_t>> sector_members_;  // Asset indices per sector
+    std::vector<std::vector<double>> sector_cholesky_; // Column-major L_s per sector
+};
+
+// ============================================================================
+// CORRELATION REGIMES - Markov regime-switching correlation
+// A small set of correlation matrices (e.g. calm / stressed where
+// correlations go to 1), each Cholesky-factored once at construction, plus a
+// per-step transition matrix. Each simulated path carries its own regime.
+// ============================================================================
+
+class CorrelationRegimes {
+    friend class SnapshotCodec;
+
+public:
+    CorrelationRegimes() = default;
+
+    // regimes: all over the same tickers, in the same order
+    // transition_matrix[from][to]: probability per simulation step (rows sum to 1)
+    CorrelationRegimes(const std::vector<CorrelationMatrix>& regimes,
+                       const std::vector<std::vector<double>>& transition_matrix,
+                       size_t initial_regime = 0)
+        : regimes_(regimes), initial_regime_(initial_regime) {
+        
+        size_t m = regimes.size();
+        if (m == 0) {
+            throw std::invalid_argument("At least one correlation regime is required");
+        }
+        if (initial_regime >= m) {
+            throw std::invalid_argument("Initial regime out of range");
+        }
+        for (const auto& regime : regimes) {
+            if (regime.get_tickers() != regimes[0].get_tickers()) {
+                throw std::invalid_argument("All correlation regimes must share the same tickers");
+            }
+        }
+        if (transition_matrix.size() != m) {
+            throw std::invalid_argument("Transition matrix size must match regime count");
+        }
+        
+        // Store cumulative rows for O(m) sampling
+        cumulative_.resize(m * m);
+        for (size_t from = 0; from < m; ++from) {
+            if (transition_matrix[from].size() != m) {
+                throw std::invalid_argument("Transition matrix must be square");
+            }
+            double sum = 0.0;
+            for (size_t to = 0; to < m; ++to) {
+                if (transition_matrix[from][to] < 0) {
+                    throw std::invalid_argument("Transition probabilities must be non-negative");
+                }
+                sum += transition_matrix[from][to];
+                cumulative_[from * m + to] = sum;
+            }
+            if (std::abs(sum - 1.0) > 1e-9) {
+                throw std::invalid_argument("Transition matrix rows must sum to 1");
+            }
+            cumulative_[from * m + m - 1] = 1.0;  // Guard against rounding
+        }
+    }
+
+    // Next regime given a uniform draw u in [0, 1)
+    size_t next_regime(size_t current, double u) const {
+        size_t m = regimes_.size();
+        const double* row = &cumulative_[current * m];
+        size_t to = 0;
+        while (to + 1 < m && u >= row[to]) ++to;
+        return to;
+    }
+
+    size_t size() const { return regimes_.size(); }
+    size_t get_initial_regime() const { return initial_regime_; }
+    const CorrelationMatrix& get_regime(size_t r) const { return regimes_[r]; }
+    const std::vector<std::string>& get_tickers() const {
+        static const std::vector<std::string> empty;
+        return regimes_.empty() ? empty : regimes_[0].get_tickers();
+    }
+
+private:
+    std::vector<CorrelationMatrix> regimes_;  // Each already Cholesky-factored
+    std::vector<double> cumulative_;          // Flat m x m cumulative transition rows
+    size_t initial_regime_ = 0;
 };
 
 // ============================================================================
@@ -144,6 +631,8 @@ private:
 // ============================================================================
 
 class YieldCurve {
+    friend class SnapshotCodec;
+
 public:
     // Flat curve constructor
     explicit YieldCurve(double flat_rate = 0.05) : flat_rate_(flat_rate) {}
@@ -211,9 +700,11 @@ private:
 // ============================================================================
 
 class VolatilitySurface {
+    friend class SnapshotCodec;
+
 public:
     // Flat surface constructor
-    explicit VolatilitySurface(double flat_vol = 0.20) : flat_vol_(flat_vol) {}
+    explicit VolatilitySurface(double flat_vol = 0.20) : flat_vol_(flat_vol), revision_(next_revision()) {}
 
     // Surface from grid points
     // strikes: vector of strike prices (or moneyness K/S)
@@ -222,7 +713,7 @@ public:
     VolatilitySurface(const std::vector<double>& strikes,
                       const std::vector<double>& expiries,
                       const std::vector<std::vector<double>>& vols)
-        : strikes_(strikes), expiries_(expiries), vols_(vols), flat_vol_(0.20) {
+        : strikes_(strikes), expiries_(expiries), vols_(vols), flat_vol_(0.20), revision_(next_revision()) {
         if (!vols.empty() && !vols[0].empty()) {
             flat_vol_ = vols[0][vols[0].size() / 2];  // ATM vol as default
         }
@@ -262,6 +753,12 @@ public:
         return get_vol(atm_strike, expiry);
     }
 
+    // ATM total implied variance sigma_atm(T)^2 T
+    double get_atm_total_variance(double expiry) const {
+        double vol = get_atm_vol(expiry);
+        return vol * vol * expiry;
+    }
+
     // Bump entire surface (parallel shift)
     void bump(double delta) {
         flat_vol_ += delta;
@@ -270,15 +767,29 @@ public:
                 v += delta;
             }
         }
+        revision_ = next_revision();
     }
 
     double get_flat_vol() const { return flat_vol_; }
+    const std::vector<double>& get_strikes() const { return strikes_; }
+    const std::vector<double>& get_expiries() const { return expiries_; }
+
+    // Process-wide id of this content: new on construction and on every
+    // bump, carried by copies. Lets callers cache values derived from the
+    // surface (the live market's running variance) and notice replacement
+    std::uint64_t get_revision() const { return revision_; }
 
 private:
     std::vector<double> strikes_;
     std::vector<double> expiries_;
     std::vector<std::vector<double>> vols_;
     double flat_vol_;
+    std::uint64_t revision_;
+
+    static std::uint64_t next_revision() {
+        static std::atomic<std::uint64_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
 
     // Helper: find interpolation indices and parameter
     static double find_interp_indices(const std::vector<double>& vec, double val,
@@ -312,6 +823,8 @@ private:
 // ============================================================================
 
 class DividendCurve {
+    friend class SnapshotCodec;
+
 public:
     explicit DividendCurve(double continuous_yield = 0.0) : yield_(continuous_yield) {}
 
@@ -337,11 +850,63 @@ private:
     double yield_;
 };
 
+// ============================================================================
+// FX RATES - One FX scenario: units of base currency per unit of each currency
+// A handful of currencies, so a flat vector with linear lookup beats a map.
+// ============================================================================
+
+class FxRates {
+    friend class SnapshotCodec;
+
+public:
+    explicit FxRates(std::string base_currency = "USD")
+        : base_currency_(std::move(base_currency)) {}
+
+    void set_rate(const std::string& currency, double base_per_unit) {
+        if (currency == base_currency_) return;  // Always 1
+        for (auto& [ccy, rate] : rates_) {
+            if (ccy == currency) { rate = base_per_unit; return; }
+        }
+        rates_.emplace_back(currency, base_per_unit);
+    }
+
+    // Units of base currency per unit of `currency`
+    double get_rate(const std::string& currency) const {
+        if (currency == base_currency_) return 1.0;
+        for (const auto& [ccy, rate] : rates_) {
+            if (ccy == currency) return rate;
+        }
+        throw std::runtime_error("FX rate not found for: " + currency);
+    }
+
+    bool has_rate(const std::string& currency) const {
+        if (currency == base_currency_) return true;
+        for (const auto& [ccy, rate] : rates_) {
+            if (ccy == currency) return true;
+        }
+        return false;
+    }
+
+    // Multiply an amount in `from` by this to express it in `to`
+    double get_conversion(const std::string& from, const std::string& to) const {
+        if (from == to) return 1.0;
+        return get_rate(from) / get_rate(to);
+    }
+
+    const std::string& get_base_currency() const { return base_currency_; }
+
+private:
+    std::string base_currency_;
+    std::vector<std::pair<std::string, double>> rates_;
+};
+
 // ============================================================================
 // MARKET ENVIRONMENT - Container for all market data
 // ============================================================================
 
 class MarketEnvironment {
+    friend class SnapshotCodec;
+
 public:
     MarketEnvironment() = default;
 
@@ -363,6 +928,85 @@ public:
         return spots_.find(ticker) != spots_.end();
     }
 
+    // Reference to a spot for hot update loops (created at 0 if absent).
+    // Map nodes never move, so it stays valid until the environment is
+    // replaced
+    double& get_spot_slot(const std::string& ticker) { return spots_[ticker]; }
+
+    // ========================================================================
+    // FX SPOTS - Simulated as factors (e.g. "EURUSD") alongside equity spots
+    // Quoted as units of base currency per unit of foreign currency
+    // ========================================================================
+
+    void set_base_currency(const std::string& currency) {
+        if (!fx_currencies_.empty() || !ticker_currencies_.empty()) {
+            throw std::logic_error("Set the base currency before adding FX spots or currency tags");
+        }
+        base_currency_ = currency;
+    }
+    const std::string& get_base_currency() const { return base_currency_; }
+
+    // Factor ticker of a currency against the base, e.g. "EUR" -> "EURUSD"
+    std::string get_fx_ticker(const std::string& currency) const {
+        return currency + base_currency_;
+    }
+
+    void set_fx_spot(const std::string& currency, double base_per_unit) {
+        if (currency == base_currency_) {
+            throw std::invalid_argument("FX spot of the base currency is always 1");
+        }
+        std::string ticker = get_fx_ticker(currency);
+        fx_currencies_[ticker] = currency;
+        spots_[ticker] = base_per_unit;
+    }
+
+    double get_fx_spot(const std::string& currency) const {
+        if (currency == base_currency_) return 1.0;
+        return get_spot(get_fx_ticker(currency));
+    }
+
+    // Quote currency of a spot (untagged tickers are in the base currency)
+    // MarketSimulator tags its registry's stocks; the scenario engines read
+    // the tags set here
+    void set_currency(const std::string& ticker, const std::string& currency) {
+        if (currency == base_currency_) {
+            ticker_currencies_.erase(ticker);
+        } else {
+            ticker_currencies_[ticker] = currency;
+        }
+    }
+    const std::string& get_currency(const std::string& ticker) const {
+        auto it = ticker_currencies_.find(ticker);
+        return it != ticker_currencies_.end() ? it->second : base_currency_;
+    }
+
+    // FX factor ticker -> currency (e.g. "EURUSD" -> "EUR")
+    const std::map<std::string, std::string>& get_fx_factors() const { return fx_currencies_; }
+
+    bool is_fx_factor(const std::string& ticker) const {
+        return fx_currencies_.find(ticker) != fx_currencies_.end();
+    }
+
+    // Current FX vector
+    FxRates get_fx_rates() const {
+        FxRates fx(base_currency_);
+        for (const auto& [ticker, currency] : fx_currencies_) {
+            fx.set_rate(currency, spots_.at(ticker));
+        }
+        return fx;
+    }
+
+    // FX vector of one simulated scenario (FX factor prices taken from the
+    // scenario where present, current spots otherwise)
+    FxRates get_fx_rates(const std::map<std::string, double>& scenario_prices) const {
+        FxRates fx(base_currency_);
+        for (const auto& [ticker, currency] : fx_currencies_) {
+            auto it = scenario_prices.find(ticker);
+            fx.set_rate(currency, it != scenario_prices.end() ? it->second : spots_.at(ticker));
+        }
+        return fx;
+    }
+
     // ========================================================================
     // YIELD CURVES
     // ========================================================================
@@ -371,19 +1015,40 @@ public:
         yield_curves_[currency] = curve;
     }
 
-    const YieldCurve& get_yield_curve(const std::string& currency = "USD") const {
+    const YieldCurve& get_yield_curve(const std::string& currency) const {
         auto it = yield_curves_.find(currency);
         if (it != yield_curves_.end()) return it->second;
         return default_yield_curve_;
     }
 
-    double get_rate(double T, const std::string& currency = "USD") const {
+    // Base-currency curve
+    const YieldCurve& get_yield_curve() const { return get_yield_curve(base_currency_); }
+
+    // Parallel shift of one currency's curve (copied from the default if absent)
+    void bump_yield_curve(const std::string& currency, double delta) {
+        yield_curves_.try_emplace(currency, default_yield_curve_).first->second.bump(delta);
+    }
+
+    double get_rate(double T, const std::string& currency) const {
         return get_yield_curve(currency).get_rate(T);
     }
+    double get_rate(double T) const { return get_rate(T, base_currency_); }
 
-    double get_discount_factor(double T, const std::string& currency = "USD") const {
+    double get_discount_factor(double T, const std::string& currency) const {
         return get_yield_curve(currency).get_discount_factor(T);
     }
+    double get_discount_factor(double T) const { return get_discount_factor(T, base_currency_); }
+
+    // Risk-neutral drift for simulating a factor: the short rate of the
+    // ticker's own currency for equities (the same curve its options are
+    // priced on), rate differential r_base - r_foreign for FX factors.
+    // No quanto term: a foreign equity drifts under its own currency's
+    // measure and is converted at the simulated FX in the aggregation pass
+    double get_drift_rate(const std::string& ticker) const {
+        auto it = fx_currencies_.find(ticker);
+        if (it == fx_currencies_.end()) return get_yield_curve(get_currency(ticker)).get_short_rate();
+        return get_yield_curve().get_short_rate() - get_yield_curve(it->second).get_short_rate();
+    }
 
     // ========================================================================
     // VOLATILITY SURFACES
@@ -399,6 +1064,17 @@ public:
         return default_vol_surface_;
     }
 
+    // The ticker's own surface (copied from the default if absent); a stable
+    // reference, like get_spot_slot
+    VolatilitySurface& get_vol_surface_slot(const std::string& ticker) {
+        return vol_surfaces_.try_emplace(ticker, default_vol_surface_).first->second;
+    }
+
+    // Parallel shift of one ticker's surface (copied from the default if absent)
+    void bump_vol_surface(const std::string& ticker, double delta) {
+        get_vol_surface_slot(ticker).bump(delta);
+    }
+
     double get_vol(const std::string& ticker, double strike, double expiry) const {
         return get_vol_surface(ticker).get_vol(strike, expiry);
     }
@@ -471,18 +1147,52 @@ public:
     }
 
     double get_correlation(const std::string& ticker1, const std::string& ticker2) const {
+        if (structured_correlation_.size() > 0) {
+            return structured_correlation_.get_correlation(ticker1, ticker2);
+        }
         return correlation_matrix_.get_correlation(ticker1, ticker2);
     }
 
+    // Structured (factor + sector block) correlation - takes precedence over
+    // the dense matrix in MultiAssetSimulator when set
+    void set_structured_correlation(const StructuredCorrelation& corr) {
+        structured_correlation_ = corr;
+    }
+
+    const StructuredCorrelation& get_structured_correlation() const {
+        return structured_correlation_;
+    }
+
+    // Regime-switching correlation - takes precedence over the static
+    // models in MultiAssetSimulator when set
+    void set_correlation_regimes(const CorrelationRegimes& regimes) {
+        correlation_regimes_ = regimes;
+    }
+
+    const CorrelationRegimes& get_correlation_regimes() const {
+        return correlation_regimes_;
+    }
+
+    // True if any correlation model (dense, structured or regimes) is set
+    bool has_correlation() const {
+        return correlation_matrix_.size() > 0 || structured_correlation_.size() > 0 ||
+               correlation_regimes_.size() > 0;
+    }
+
     // Generate correlated random numbers for all assets in the correlation matrix
     std::vector<double> generate_correlated_z(const std::vector<double>& independent_z) const {
         return correlation_matrix_.correlate(independent_z);
     }
 
 private:
-    // Spot prices by ticker
+    // Spot prices by ticker (FX factors included, e.g. "EURUSD")
     std::map<std::string, double> spots_;
 
+    // Reporting/base currency and FX factor ticker -> currency
+    std::string base_currency_ = "USD";
+    std::map<std::string, std::string> fx_currencies_;
+    std::map<std::string, std::string> ticker_currencies_;  // Non-base spots only
+
     // Yield curves by currency
     std::map<std::string, YieldCurve> yield_curves_;
     YieldCurve default_yield_curve_{0.05};
@@ -497,6 +1207,8 @@ private:
 
     // Correlation matrix for multi-asset simulation
     CorrelationMatrix correlation_matrix_;
+    StructuredCorrelation structured_correlation_;
+    CorrelationRegimes correlation_regimes_;
 
     // Current valuation date (in years from start)
     double valuation_date_ = 0.0;
@@ -555,6 +1267,13 @@ inline MarketEnvironment create_sample_market() {
     env.set_spot("GOOGL", 140.0);
     env.set_spot("TSLA", 250.0);
 
+    // EUR equity, simulated on the EUR curve and converted at EURUSD
+    env.set_spot("SAP", 180.0);
+    env.set_currency("SAP", "EUR");
+    env.set_vol_surface("SAP", VolatilitySurface(0.24));
+    env.set_fx_spot("EUR", 1.08);
+    env.set_vol_surface(env.get_fx_ticker("EUR"), VolatilitySurface(0.08));
+
     return env;
 }
 
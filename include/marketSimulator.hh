@@ -10,20 +10,28 @@
 #include <memory>
 #include <set>
 #include "portfolio.hh"
+#include "instrumentRegistry.hh"
 #include "model.hh"
 #include "visitor.hh"
 #include "marketEnvironment.hh"
+#include "pricingContext.hh"
+#include "dependencyGraph.hh"
+#include "resultsStore.hh"
 
 class MarketSimulator {
+    friend class SnapshotCodec;
+
 public:
     // Constructor takes a model for simulation
     explicit MarketSimulator(std::unique_ptr<Model> model)
-        : model_(std::move(model)), 
+        : registry_(std::make_shared<InstrumentRegistry>()),
+          model_(std::move(model)), 
           multi_asset_sim_(std::make_unique<MultiAssetSimulator>(*model_)) {}
 
     // Default constructor with Black-Scholes model
     MarketSimulator() 
-        : model_(std::make_unique<BlackScholesModel>()),
+        : registry_(std::make_shared<InstrumentRegistry>()),
+          model_(std::make_unique<BlackScholesModel>()),
           multi_asset_sim_(std::make_unique<MultiAssetSimulator>(*model_)) {}
 
     MarketSimulator(const MarketSimulator&) = delete;
@@ -31,18 +39,47 @@ public:
     MarketSimulator(MarketSimulator&&) = default;
     MarketSimulator& operator=(MarketSimulator&&) = default;
 
-    // Create a portfolio in-place, returns its ID
+    // Create a portfolio in-place (sharing the simulator's registry), returns its ID
     template <typename... Args>
     size_t create_portfolio(Args&&... args) {
-        portfolios_.emplace_back(std::forward<Args>(args)...);
+        portfolios_.emplace_back(registry_, std::forward<Args>(args)...);
         return portfolios_.size() - 1;
     }
 
+    // Instrument registry shared by all portfolios of this simulator
+    InstrumentRegistry& get_registry() { return *registry_; }
+    const InstrumentRegistry& get_registry() const { return *registry_; }
+
+    // Adds a stock and tags the env with its currency
+    InstrumentId add_stock(const std::string& ticker, double price, const std::string& currency = "USD") {
+        InstrumentId id = registry_->add_stock(ticker, price, currency);
+        tag_stock_currencies();
+        return id;
+    }
+
+    // Tags the env with the currency of each stock not yet tagged. add_stock,
+    // DataLoader::load_instruments and restore do this; call it after adding
+    // stocks straight through get_registry(). Stocks are only ever appended,
+    // so each is tagged once
+    void tag_stock_currencies() {
+        for (; tagged_stock_count_ < registry_->stock_count(); ++tagged_stock_count_) {
+            const Stock& stock = registry_->get_stock(
+                make_instrument_id(InstrumentType::Stock, static_cast<std::uint32_t>(tagged_stock_count_)));
+            market_env_.set_currency(stock.get_ticker(), stock.get_currency());
+        }
+    }
+
     // Reserve capacity (HPC best practice)
     void reserve_portfolios(size_t n) { portfolios_.reserve(n); }
 
     // Access portfolios by ID
-    double get_portfolio_value(size_t id) const { return portfolios_[id].get_total_value(); }
+    // Value / P&L in the portfolio's reporting currency at current FX spots
+    double get_portfolio_value(size_t id) const {
+        return portfolios_[id].get_total_value(market_env_.get_fx_rates());
+    }
+    double get_portfolio_pnl(size_t id) const {
+        return portfolios_[id].get_total_pnl(market_env_.get_fx_rates());
+    }
     const Portfolio& get_portfolio(size_t id) const { return portfolios_[id]; }
     Portfolio& get_portfolio(size_t id) { return portfolios_[id]; }
 
@@ -54,8 +91,26 @@ public:
         multi_asset_sim_ = std::make_unique<MultiAssetSimulator>(*model_);
     }
 
+    // ========================================================================
+    // SNAPSHOTS - Binary save/restore of the full simulation state
+    // Environment (with Cholesky factors), registry, portfolios and day count.
+    // The model is configuration, not state: pass it back in on restore.
+    // Restore rebuilds the registry and portfolios: O(N), see snapshot.hh.
+    // ========================================================================
+
+    void save_snapshot(const std::string& path) const;
+    static MarketSimulator load_snapshot(const std::string& path,
+                                         std::unique_ptr<Model> model = std::make_unique<BlackScholesModel>());
+
     // Market environment access (for correlated simulation)
-    void set_market_environment(const MarketEnvironment& env) { market_env_ = env; }
+    // The env is tagged with each registry stock's currency, once per stock,
+    // so env-based drift (ForwardVolTable) and pricing use its own curve.
+    // Replace the env through set_market_environment, which re-tags
+    void set_market_environment(const MarketEnvironment& env) {
+        market_env_ = env;
+        tagged_stock_count_ = 0;
+        tag_stock_currencies();
+    }
     MarketEnvironment& get_market_environment() { return market_env_; }
     const MarketEnvironment& get_market_environment() const { return market_env_; }
 
@@ -68,82 +123,87 @@ public:
     void simulate_daily() {
         constexpr double dt = 1.0 / 252.0;
         
-        // Step 1: Collect all unique stock tickers and their current prices
-        std::map<std::string, double> current_prices;
-        std::map<std::string, Stock*> stock_ptrs;  // To update prices after simulation
+        // Step 1: Snapshot for P&L tracking, then collect every stock once
+        // (sequential walk over the registry's stock pool)
+        snapshot_portfolios();
+        tag_stock_currencies();
         
-        for (auto& portfolio : portfolios_) {
-            portfolio.snapshot_prices();  // For P&L tracking
-            collect_stocks(portfolio, current_prices, stock_ptrs);
-        }
+        std::map<std::string, double> current_prices;
+        registry_->for_each_stock([&](const Stock& stock) {
+            current_prices[stock.get_ticker()] = stock.get_price();
+        });
         
         // Step 2: If we have stocks and a correlation matrix, do correlated simulation
-        if (!current_prices.empty() && market_env_.get_correlation_matrix().size() > 0) {
+        if (!current_prices.empty() && market_env_.has_correlation()) {
+            // FX factors are simulated jointly with the equities, so the
+            // correlation model can tie e.g. EURUSD to European stocks
+            for (const auto& [fx_ticker, currency] : market_env_.get_fx_factors()) {
+                current_prices[fx_ticker] = market_env_.get_spot(fx_ticker);
+            }
+            
             // Simulate all stocks together (CORRELATED)
-            auto new_prices = multi_asset_sim_->simulate_market_step(current_prices, dt, market_env_);
+            auto new_prices = multi_asset_sim_->simulate_market_step(current_prices, dt, market_env_,
+                                                                      simulation_day_count_);
             
-            // Update stock prices
-            for (auto& [ticker, new_price] : new_prices) {
-                if (stock_ptrs.count(ticker)) {
-                    stock_ptrs[ticker]->set_price(new_price);
-                }
+            // Update stock prices and FX spots
+            registry_->for_each_stock([&](Stock& stock) {
+                stock.set_price(new_prices[stock.get_ticker()]);
+            });
+            for (const auto& [fx_ticker, currency] : market_env_.get_fx_factors()) {
+                market_env_.set_spot(fx_ticker, new_prices[fx_ticker]);
             }
             
             // Update options (re-price based on new underlying + decay time)
-            for (auto& portfolio : portfolios_) {
-                update_options(portfolio, dt);
-            }
+            update_options(dt);
         } else {
             // Fallback: uncorrelated simulation (legacy behavior)
-            MonteCarloSimulationVisitor mc_visitor(*model_, dt);
-            for (auto& portfolio : portfolios_) {
-                portfolio.accept(mc_visitor);
-            }
+            PricingContext context(market_env_, *registry_, dt);
+            MonteCarloSimulationVisitor mc_visitor(*model_, dt, context);
+            registry_->accept_batch(mc_visitor);
         }
         
         ++simulation_day_count_;
+        publish_if_subscribed();
     }
 
     // LEGACY: Uncorrelated simulation (explicitly named to discourage use)
     void simulate_daily_uncorrelated() {
         constexpr double dt = 1.0 / 252.0;
-        MonteCarloSimulationVisitor mc_visitor(*model_, dt);
+        PricingContext context(market_env_, *registry_, dt);
+        MonteCarloSimulationVisitor mc_visitor(*model_, dt, context);
         
-        for (auto& portfolio : portfolios_) {
-            portfolio.snapshot_prices();
-            portfolio.accept(mc_visitor);
-        }
+        snapshot_portfolios();
+        registry_->accept_batch(mc_visitor);
         ++simulation_day_count_;
+        publish_if_subscribed();
     }
 
     // Historical simulation
     void simulate_daily_historical(const std::vector<double>& returns) {
         HistoricalSimulationVisitor hist_visitor(returns, simulation_day_count_);
         
-        for (auto& portfolio : portfolios_) {
-            portfolio.snapshot_prices();
-            portfolio.accept(hist_visitor);
-        }
+        snapshot_portfolios();
+        registry_->accept_batch(hist_visitor);
         ++simulation_day_count_;
+        publish_if_subscribed();
     }
 
     // Stress test
     void apply_stress_test(double price_shock, double vol_shock, double rate_shock) {
-        StressTestVisitor stress_visitor(price_shock, vol_shock, rate_shock);
+        PricingContext context(market_env_, *registry_);
+        StressTestVisitor stress_visitor(price_shock, vol_shock, rate_shock, context);
         
-        for (auto& portfolio : portfolios_) {
-            portfolio.snapshot_prices();
-            portfolio.accept(stress_visitor);
-        }
+        snapshot_portfolios();
+        registry_->accept_batch(stress_visitor);
+        publish_if_subscribed();
     }
 
-    // Custom visitor
+    // Custom visitor (applied once per instrument, stocks before options)
     void simulate_with_visitor(InstrumentVisitor& visitor) {
-        for (auto& portfolio : portfolios_) {
-            portfolio.snapshot_prices();
-            portfolio.accept(visitor);
-        }
+        snapshot_portfolios();
+        registry_->accept(visitor);
         ++simulation_day_count_;
+        publish_if_subscribed();
     }
 
     // Simulate multiple days
@@ -156,23 +216,122 @@ public:
     unsigned get_day_count() const { return simulation_day_count_; }
     size_t get_portfolio_count() const { return portfolios_.size(); }
 
+    // ========================================================================
+    // PUBLISHED RESULTS - Safe to read from other threads while simulating
+    // Instruments are mutated in place, so the accessors above must only be
+    // called from the simulating thread. Once a store has been requested,
+    // every simulation step ends by publishing a new immutable epoch of
+    // values, P&L and Greeks for all portfolios; readers call read() on the
+    // store and hold the returned view as long as they need a consistent set.
+    // ========================================================================
+
+    std::shared_ptr<const ResultsStore> get_results_store() {
+        if (!results_store_) {
+            results_store_ = std::make_shared<ResultsStore>();
+            publish_results();
+        }
+        return results_store_;
+    }
+
+    // Computes and publishes the current epoch (simulating thread only)
+    void publish_results() {
+        if (!results_store_) results_store_ = std::make_shared<ResultsStore>();
+        tag_stock_currencies();
+
+        PricingContext context(market_env_, *registry_);
+        GreeksVisitor instrument_greeks(get_model(), context);
+        registry_->accept_batch(instrument_greeks);
+
+        RiskResults results;
+        results.day = simulation_day_count_;
+        results.portfolios.reserve(portfolios_.size());
+        FxRates fx = market_env_.get_fx_rates();
+        for (const auto& portfolio : portfolios_) {
+            PortfolioGreeksVisitor greeks_visitor(get_model(), context);
+            greeks_visitor.visit(portfolio, instrument_greeks);
+
+            PortfolioResult entry;
+            entry.owner = portfolio.get_owner();
+            entry.currency = portfolio.get_currency();
+            entry.value = portfolio.get_total_value(fx);
+            entry.pnl = portfolio.get_total_pnl(fx);
+            entry.greeks = greeks_visitor.get_total_greeks();
+
+            results.total_greeks.delta += entry.greeks.delta;
+            results.total_greeks.gamma += entry.greeks.gamma;
+            results.total_greeks.vega += entry.greeks.vega;
+            results.total_greeks.theta += entry.greeks.theta;
+            results.total_greeks.rho += entry.greeks.rho;
+            results.portfolios.push_back(std::move(entry));
+        }
+        results_store_->publish(std::move(results));
+    }
+
+    // ========================================================================
+    // TARGETED UPDATES - Reprice only what depends on the moved inputs
+    // Each returns the ids of the portfolios whose value changed (sorted),
+    // so callers re-aggregate those books only. Daily simulation stays a
+    // full pass, since time decay touches every option.
+    // ========================================================================
+
+    // Built lazily; rebuilt when instruments, portfolios or positions were added
+    const DependencyGraph& get_dependency_graph() {
+        if (dependency_graph_.is_stale(*registry_, portfolios_)) {
+            dependency_graph_.build(*registry_, portfolios_);
+        }
+        return dependency_graph_;
+    }
+
+    // Call after editing position quantities in place
+    void rebuild_dependency_graph() { dependency_graph_.build(*registry_, portfolios_); }
+
+    std::vector<size_t> update_spots(const std::map<std::string, double>& spots) {
+        std::vector<InstrumentId> moved;
+        for (const auto& [ticker, price] : spots) {
+            market_env_.set_spot(ticker, price);
+            InstrumentId id = registry_->find(ticker);
+            if (id == kInvalidInstrumentId || get_instrument_type(id) != InstrumentType::Stock) continue;
+            registry_->get_stock(id).set_price(price);
+            moved.push_back(id);
+        }
+        return reprice_dependents(moved, moved);
+    }
+
+    std::vector<size_t> update_vol_surfaces(const std::map<std::string, VolatilitySurface>& surfaces) {
+        std::vector<InstrumentId> underlyings;
+        for (const auto& [ticker, surface] : surfaces) {
+            market_env_.set_vol_surface(ticker, surface);
+            InstrumentId id = registry_->find(ticker);
+            if (id != kInvalidInstrumentId && get_instrument_type(id) == InstrumentType::Stock) {
+                underlyings.push_back(id);
+            }
+        }
+        return reprice_dependents(underlyings, {});
+    }
+
     // ========================================================================
     // ANALYTICS - Use const visitors
     // ========================================================================
 
     // Get aggregate Greeks for a portfolio
     Greeks get_portfolio_greeks(size_t id) const {
-        PortfolioGreeksVisitor greeks_visitor(get_model());
+        PricingContext context(market_env_);
+        PortfolioGreeksVisitor greeks_visitor(get_model(), context);
         greeks_visitor.visit(portfolios_[id]);
         return greeks_visitor.get_total_greeks();
     }
 
     // Get aggregate Greeks across all portfolios
+    // Instrument Greeks are computed once in batch, then aggregated per portfolio
     Greeks get_total_greeks() const {
+        PricingContext context(market_env_, *registry_);
+        GreeksVisitor instrument_greeks(get_model(), context);
+        registry_->accept_batch(instrument_greeks);
+        
         Greeks total;
         for (const auto& portfolio : portfolios_) {
-            PortfolioGreeksVisitor greeks_visitor(get_model());
-            greeks_visitor.visit(portfolio);
+            PortfolioGreeksVisitor greeks_visitor(get_model(), context);
+            greeks_visitor.visit(portfolio, instrument_greeks);
             Greeks g = greeks_visitor.get_total_greeks();
             total.delta += g.delta;
             total.gamma += g.gamma;
@@ -184,81 +343,63 @@ public:
     }
 
 private:
+    std::shared_ptr<InstrumentRegistry> registry_;  // Shared with every portfolio
     std::vector<Portfolio> portfolios_;
     std::unique_ptr<Model> model_;
     std::unique_ptr<MultiAssetSimulator> multi_asset_sim_;
     MarketEnvironment market_env_;
     unsigned simulation_day_count_ = 0;
+    DependencyGraph dependency_graph_;
+    std::shared_ptr<ResultsStore> results_store_;  // Null until requested
+    size_t tagged_stock_count_ = 0;  // Stock pool prefix tagged in market_env_
 
-    // Helper: Collect all stocks from a portfolio
-    void collect_stocks(Portfolio& portfolio, 
-                        std::map<std::string, double>& prices,
-                        std::map<std::string, Stock*>& stock_ptrs) {
-        for (size_t i = 0; i < portfolio.get_position_count(); ++i) {
-            Position& pos = portfolio.get_position(i);
-            Instrument& inst = pos.get_instrument();
-            
-            // Check if it's a Stock
-            if (auto* stock = dynamic_cast<Stock*>(&inst)) {
-                const std::string& ticker = stock->get_ticker();
-                if (prices.find(ticker) == prices.end()) {
-                    prices[ticker] = stock->get_price();
-                    stock_ptrs[ticker] = stock;
-                }
-            }
-            // Check if it's an Option (need to get underlying)
-            else if (auto* option = dynamic_cast<Option*>(&inst)) {
-                const Stock& underlying = option->get_underlying();
-                const std::string& ticker = underlying.get_ticker();
-                if (prices.find(ticker) == prices.end()) {
-                    prices[ticker] = underlying.get_price();
-                    // Note: underlying is const, but the shared_ptr may be modifiable
-                    // We'll update via the stock_ptrs we already collected
-                }
-            }
+    void publish_if_subscribed() {
+        if (results_store_) publish_results();
+    }
+
+    // Helper: Snapshot prices (and current FX) of every portfolio for P&L
+    void snapshot_portfolios() {
+        FxRates fx = market_env_.get_fx_rates();
+        for (auto& portfolio : portfolios_) {
+            portfolio.snapshot_prices(fx);
         }
     }
 
+    // Helper: Re-mark the options on `underlyings`; returns the portfolios
+    // holding them or any of the already-moved `changed` instruments
+    std::vector<size_t> reprice_dependents(const std::vector<InstrumentId>& underlyings,
+                                           std::vector<InstrumentId> changed) {
+        const DependencyGraph& graph = get_dependency_graph();
+        PricingContext context(market_env_);
+        OptionPricer<kOutputPrice> pricer(*model_, context);
+        std::vector<InstrumentId> options = graph.get_affected_options(*registry_, underlyings);
+        pricer.evaluate_batch(
+            options.size(), [&](size_t i) -> const Option& { return registry_->get_option(options[i]); },
+            [&](size_t i, const PricingResult& result) { registry_->get_option(options[i]).set_price(result.price); });
+        changed.insert(changed.end(), options.begin(), options.end());
+        return graph.get_affected_portfolios(changed);
+    }
+
     // Helper: Update options after underlying prices change
-    void update_options(Portfolio& portfolio, double dt) {
-        for (size_t i = 0; i < portfolio.get_position_count(); ++i) {
-            Position& pos = portfolio.get_position(i);
-            Instrument& inst = pos.get_instrument();
-            
-            if (auto* option = dynamic_cast<Option*>(&inst)) {
-                // Decay time to expiry
-                double new_tte = option->get_time_to_expiry() - dt;
-                option->set_time_to_expiry(std::max(0.0, new_tte));
-                
-                // Re-price option based on new underlying price
-                const Stock& underlying = option->get_underlying();
-                if (option->get_time_to_expiry() > 0) {
-                    double S = underlying.get_price();
-                    double K = option->get_strike();
-                    double T = option->get_time_to_expiry();
-                    bool is_call = (option->get_type() == Option::Type::Call);
-                    
-                    // Get vol/rate from market environment or model
-                    double new_price;
-                    if (market_env_.get_correlation_matrix().size() > 0) {
-                        new_price = model_->price_option(S, K, T, 
-                            underlying.get_ticker(), market_env_, is_call);
-                    } else {
-                        double r = dynamic_cast<BlackScholesModel*>(model_.get())->get_rate();
-                        double sigma = dynamic_cast<BlackScholesModel*>(model_.get())->get_volatility();
-                        new_price = model_->price_option(S, K, T, r, sigma, is_call);
-                    }
-                    option->set_price(new_price);
-                } else {
-                    // At expiry - intrinsic value only
-                    double S = underlying.get_price();
-                    double K = option->get_strike();
-                    bool is_call = (option->get_type() == Option::Type::Call);
-                    double intrinsic = is_call ? std::max(0.0, S - K) : std::max(0.0, K - S);
-                    option->set_price(intrinsic);
-                }
-            }
-        }
+    // Walks the option pool once, so options held by several portfolios
+    // are decayed and re-priced exactly once per step
+    void update_options(double dt) {
+        // Decay time to expiry first, so the shared context caches the
+        // curve rate at each new expiry
+        registry_->for_each_option([&](Option& option) {
+            double new_tte = option.get_time_to_expiry() - dt;
+            option.set_time_to_expiry(std::max(0.0, new_tte));
+        });
+        PricingContext context(market_env_, *registry_);
+        OptionPricer<kOutputPrice> pricer(*model_, context);
+        
+        // Re-price on the new underlying price: vol from the underlying's
+        // surface, rate from the curve, intrinsic value at expiry
+        registry_->for_each_option_span([&](InstrumentSpan<Option> options) {
+            pricer.evaluate_batch(
+                options.size(), [&](size_t i) -> const Option& { return options[i]; },
+                [&](size_t i, const PricingResult& result) { options[i].set_price(result.price); });
+        });
     }
 };
 
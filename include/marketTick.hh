@@ -0,0 +1,27 @@
+// Header file for intraday market data ticks
+
+#ifndef MARKET_TICK_H
+#define MARKET_TICK_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// ============================================================================
+// TICKS
+// Spot ticks are absolute prices (equities, or FX factors such as "EURUSD");
+// vol and rate ticks are parallel shifts of a ticker's surface / a
+// currency's curve (the same bump the stress tests use).
+// ============================================================================
+
+enum class TickType : std::uint8_t { Spot, Vol, Rate };
+
+struct MarketTick {
+    TickType type;
+    std::string key;  // Ticker (spot/vol) or currency (rate)
+    double value;     // Price (spot) or shift (vol/rate)
+};
+
+using TickBatch = std::vector<MarketTick>;
+
+#endif
@@ -9,9 +9,15 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <type_traits>
+#include <algorithm>
+#include <cstdint>
+#include "normalMath.hh"
 
-// Forward declaration
+// Forward declarations
 class MarketEnvironment;
+class LocalVolGrid;
+class VolatilitySurface;
 
 // Greeks structure - sensitivities to market parameters
 struct Greeks {
@@ -22,11 +28,39 @@ struct Greeks {
     double rho = 0.0;     // dV/dr - sensitivity to interest rate
 };
 
+// ============================================================================
+// PRICING OUTPUTS - Compile-time selection of what a kernel computes
+// ============================================================================
+
+enum PricingOutput : unsigned {
+    kOutputPrice = 1u << 0,
+    kOutputDelta = 1u << 1,
+    kOutputGamma = 1u << 2,
+    kOutputVega  = 1u << 3,
+    kOutputTheta = 1u << 4,
+    kOutputRho   = 1u << 5,
+    kOutputGreeks = kOutputDelta | kOutputGamma | kOutputVega | kOutputTheta | kOutputRho,
+    kOutputAll = kOutputPrice | kOutputGreeks
+};
+
+struct PricingResult {
+    double price = 0.0;
+    Greeks greeks;  // Only the requested fields are filled
+};
+
+// Concrete model family, fixed by each model's constructor. Batch pricers and
+// path engines switch on it once per batch to select their compiled kernels
+// instead of probing the hierarchy with dynamic_cast.
+enum class ModelKind : std::uint8_t { BlackScholes, JumpDiffusion, LocalVol, Custom };
+
 // Abstract base class for pricing models
 class Model {
 public:
+    explicit Model(ModelKind kind = ModelKind::Custom) : kind_(kind) {}
     virtual ~Model() = default;
 
+    ModelKind get_kind() const { return kind_; }
+
     // ========================================================================
     // SIMULATION - Two interfaces:
     // 1. Legacy: generates random internally (DANGER: uncorrelated!)
@@ -40,7 +74,15 @@ public:
     // This allows correlated simulation via Cholesky decomposition
     virtual double simulate_step(double current_price, double dt, double random_z) = 0;
 
+    // Simulate with externally provided random number, drift rate and
+    // diffusion vol (e.g. a step's forward vol from a ForwardVolTable)
+    virtual double simulate_step(double current_price, double dt, double random_z,
+                                  double rate, double sigma) = 0;
+
     // Simulate with market environment (uses appropriate vol/rate from curves)
+    // The env overloads take no step index: they diffuse at the FIRST step's
+    // forward vol (the ATM vol at dt). Multi-step paths must go through
+    // MultiAssetSimulator, which uses ForwardVolTable::get_forward_vol per step
     virtual double simulate_step(double current_price, double dt, 
                                   const std::string& ticker,
                                   const MarketEnvironment& env) = 0;
@@ -68,10 +110,21 @@ public:
                                      const MarketEnvironment& env,
                                      bool is_call) const = 0;
 
+    // State-dependent vol sigma(S, t) of an underlying, looked up per path
+    // and step by the path engines instead of the ATM term structure;
+    // nullptr for models whose vol does not depend on the spot
+    virtual const LocalVolGrid* get_local_vol(const std::string& ticker) const {
+        (void)ticker;
+        return nullptr;
+    }
+
     // Setters for model parameters (fallback when no market env)
     virtual void set_volatility(double sigma) = 0;
     virtual void set_rate(double r) = 0;
     virtual void set_seed(unsigned seed) = 0;
+
+private:
+    ModelKind kind_;
 };
 
 // Black-Scholes Model: Geometric Brownian Motion
@@ -79,7 +132,8 @@ public:
 class BlackScholesModel : public Model {
 public:
     BlackScholesModel(double rate = 0.05, double volatility = 0.20, unsigned seed = 42)
-        : rate_(rate), volatility_(volatility), generator_(seed), normal_dist_(0.0, 1.0) {}
+        : Model(ModelKind::BlackScholes), rate_(rate), volatility_(volatility), generator_(seed),
+          normal_dist_(0.0, 1.0) {}
 
     // LEGACY: GBM simulation step with internal RNG (UNCORRELATED!)
     double simulate_step(double current_price, double dt) override {
@@ -89,9 +143,14 @@ public:
 
     // CORRECT: GBM simulation step with external random number
     double simulate_step(double current_price, double dt, double random_z) override {
+        return simulate_step(current_price, dt, random_z, rate_, volatility_);
+    }
+
+    double simulate_step(double current_price, double dt, double random_z,
+                          double rate, double sigma) override {
         // S(t+dt) = S(t) * exp((r - 0.5*σ²)dt + σ√dt * Z)
-        double drift = (rate_ - 0.5 * volatility_ * volatility_) * dt;
-        double diffusion = volatility_ * std::sqrt(dt) * random_z;
+        double drift = (rate - 0.5 * sigma * sigma) * dt;
+        double diffusion = sigma * std::sqrt(dt) * random_z;
         return current_price * std::exp(drift + diffusion);
     }
 
@@ -106,19 +165,37 @@ public:
                           const MarketEnvironment& env) override;
 
     // Black-Scholes closed-form option price
-    double price_option(double S, double K, double T, double r, double sigma, bool is_call) const override {
-        if (T <= 0) {
-            // At expiry
-            return is_call ? std::max(0.0, S - K) : std::max(0.0, K - S);
-        }
-
-        double d1 = (std::log(S / K) + (r + 0.5 * sigma * sigma) * T) / (sigma * std::sqrt(T));
-        double d2 = d1 - sigma * std::sqrt(T);
-
-        if (is_call) {
-            return S * norm_cdf(d1) - K * std::exp(-r * T) * norm_cdf(d2);
-        } else {
-            return K * std::exp(-r * T) * norm_cdf(-d2) - S * norm_cdf(-d1);
+    double price_option(double S, double K, double T, double r, double sigma, bool is_call) const override;
+
+    // Batch Black-Scholes over structure-of-arrays inputs (scenario
+    // revaluation). Evaluated entirely in Real: float doubles the SIMD width
+    // and halves the bandwidth; callers accumulate P&L in double. Branch-free
+    // (w = +1 call / -1 put, expiry picked by select), and in double through
+    // the vectorizable kernels of normalMath.hh
+    template <typename Real>
+    static void price_batch(const Real* S, const Real* K, const Real* T, const Real* r,
+                            const Real* sigma, const unsigned char* is_call, Real* out, size_t n) {
+        static_assert(std::is_floating_point<Real>::value, "price_batch takes float or double");
+        const Real half(0.5);
+        for (size_t i = 0; i < n; ++i) {
+            Real w = is_call[i] ? Real(1) : Real(-1);
+            Real vol_sqrt_t = sigma[i] * std::sqrt(T[i]);
+            Real value;
+            if constexpr (std::is_same<Real, double>::value) {
+                double d1 = (fast_log(S[i] / K[i]) + (r[i] + half * sigma[i] * sigma[i]) * T[i]) / vol_sqrt_t;
+                double d2 = d1 - vol_sqrt_t;
+                double discounted_strike = K[i] * fast_exp(-r[i] * T[i]);
+                value = w * (S[i] * ::norm_cdf(w * d1) - discounted_strike * ::norm_cdf(w * d2));
+            } else {
+                // N(x) = erfc(-x/sqrt2)/2
+                const Real rsqrt2 = static_cast<Real>(M_SQRT1_2);
+                Real d1 = (std::log(S[i] / K[i]) + (r[i] + half * sigma[i] * sigma[i]) * T[i]) / vol_sqrt_t;
+                Real d2 = d1 - vol_sqrt_t;
+                Real discounted_strike = K[i] * std::exp(-r[i] * T[i]);
+                value = w * half * (S[i] * std::erfc(-w * d1 * rsqrt2) - discounted_strike * std::erfc(-w * d2 * rsqrt2));
+            }
+            Real intrinsic = std::max(Real(0), w * (S[i] - K[i]));
+            out[i] = T[i] > Real(0) ? value : intrinsic;
         }
     }
 
@@ -129,54 +206,7 @@ public:
                          bool is_call) const override;
 
     // Analytical Greeks from Black-Scholes
-    Greeks calculate_greeks(double S, double K, double T, double r, double sigma, bool is_call) const override {
-        Greeks g;
-        
-        if (T <= 0) {
-            // At expiry - only delta matters
-            if (is_call) {
-                g.delta = (S > K) ? 1.0 : 0.0;
-            } else {
-                g.delta = (S < K) ? -1.0 : 0.0;
-            }
-            return g;
-        }
-
-        double sqrt_T = std::sqrt(T);
-        double d1 = (std::log(S / K) + (r + 0.5 * sigma * sigma) * T) / (sigma * sqrt_T);
-        double d2 = d1 - sigma * sqrt_T;
-        double nd1 = norm_cdf(d1);
-        double nd2 = norm_cdf(d2);
-        double pdf_d1 = norm_pdf(d1);
-
-        // Delta: dV/dS
-        g.delta = is_call ? nd1 : (nd1 - 1.0);
-
-        // Gamma: d²V/dS² (same for call and put)
-        g.gamma = pdf_d1 / (S * sigma * sqrt_T);
-
-        // Vega: dV/dσ (same for call and put)
-        g.vega = S * pdf_d1 * sqrt_T;
-
-        // Theta: dV/dt
-        double discount = std::exp(-r * T);
-        if (is_call) {
-            g.theta = -(S * pdf_d1 * sigma) / (2.0 * sqrt_T) 
-                      - r * K * discount * nd2;
-        } else {
-            g.theta = -(S * pdf_d1 * sigma) / (2.0 * sqrt_T) 
-                      + r * K * discount * norm_cdf(-d2);
-        }
-
-        // Rho: dV/dr
-        if (is_call) {
-            g.rho = K * T * discount * nd2;
-        } else {
-            g.rho = -K * T * discount * norm_cdf(-d2);
-        }
-
-        return g;
-    }
+    Greeks calculate_greeks(double S, double K, double T, double r, double sigma, bool is_call) const override;
 
     // Calculate Greeks using market environment
     Greeks calculate_greeks(double S, double K, double T,
@@ -198,17 +228,140 @@ private:
     mutable std::normal_distribution<double> normal_dist_;
 
 public:
-    // Standard normal CDF (approximation) - public for use by visitors
-    static double norm_cdf(double x) {
-        return 0.5 * std::erfc(-x * M_SQRT1_2);
+    // Standard normal CDF/PDF (normalMath.hh) - public for use by visitors
+    static double norm_cdf(double x) { return ::norm_cdf(x); }
+    static double norm_pdf(double x) { return ::norm_pdf(x); }
+};
+
+// ============================================================================
+// BLACK-SCHOLES KERNEL - Specialized on option type and requested outputs
+// Each instantiation is straight-line code: no call/put branches, and every
+// quantity not needed by Outputs (d2, the pdf, the discount factor, a Greek)
+// is compiled out. BlackScholesModel's scalar entry points dispatch here;
+// batch loops pick the instantiation once (see OptionPricer).
+// ============================================================================
+
+template <bool IsCall, unsigned Outputs>
+struct BlackScholesKernel {
+    static_assert(Outputs != 0 && (Outputs & ~static_cast<unsigned>(kOutputAll)) == 0,
+                  "Outputs must be a non-empty PricingOutput mask");
+
+    static constexpr bool kNeedsD2 = (Outputs & (kOutputPrice | kOutputTheta | kOutputRho)) != 0;
+    static constexpr bool kNeedsPdf = (Outputs & (kOutputGamma | kOutputVega | kOutputTheta)) != 0;
+
+    static PricingResult evaluate(double S, double K, double T, double r, double sigma) {
+        double discount = 0.0;
+        if constexpr (kNeedsD2) discount = fast_exp(-r * T);
+        return evaluate(S, K, T, r, sigma, discount);
     }
 
-    // Standard normal PDF
-    static double norm_pdf(double x) {
-        return std::exp(-0.5 * x * x) / std::sqrt(2.0 * M_PI);
+    // Same, with the discount factor exp(-r T) supplied by the caller (e.g.
+    // cached per expiry in a PricingContext)
+    static PricingResult evaluate(double S, double K, double T, double r, double sigma, double discount) {
+        PricingResult out;
+
+        if (T <= 0) {
+            // At expiry - intrinsic value, only delta matters
+            if constexpr ((Outputs & kOutputPrice) != 0) {
+                out.price = IsCall ? std::max(0.0, S - K) : std::max(0.0, K - S);
+            }
+            if constexpr ((Outputs & kOutputDelta) != 0) {
+                out.greeks.delta = IsCall ? ((S > K) ? 1.0 : 0.0) : ((S < K) ? -1.0 : 0.0);
+            }
+            return out;
+        }
+
+        double sqrt_T = std::sqrt(T);
+        double d1 = (fast_log(S / K) + (r + 0.5 * sigma * sigma) * T) / (sigma * sqrt_T);
+        double d2 = 0.0, pdf_d1 = 0.0;
+        double nd2 = 0.0;  // N(d2) for calls, N(-d2) for puts
+        if constexpr (kNeedsD2) {
+            d2 = d1 - sigma * sqrt_T;
+            nd2 = BlackScholesModel::norm_cdf(IsCall ? d2 : -d2);
+        }
+        if constexpr (kNeedsPdf) pdf_d1 = BlackScholesModel::norm_pdf(d1);
+
+        if constexpr ((Outputs & kOutputPrice) != 0) {
+            out.price = IsCall ? S * BlackScholesModel::norm_cdf(d1) - K * discount * nd2
+                               : K * discount * nd2 - S * BlackScholesModel::norm_cdf(-d1);
+        }
+        if constexpr ((Outputs & kOutputDelta) != 0) {
+            double nd1 = BlackScholesModel::norm_cdf(d1);
+            out.greeks.delta = IsCall ? nd1 : (nd1 - 1.0);
+        }
+        if constexpr ((Outputs & kOutputGamma) != 0) {
+            out.greeks.gamma = pdf_d1 / (S * sigma * sqrt_T);
+        }
+        if constexpr ((Outputs & kOutputVega) != 0) {
+            out.greeks.vega = S * pdf_d1 * sqrt_T;
+        }
+        if constexpr ((Outputs & kOutputTheta) != 0) {
+            double decay = -(S * pdf_d1 * sigma) / (2.0 * sqrt_T);
+            out.greeks.theta = IsCall ? decay - r * K * discount * nd2 : decay + r * K * discount * nd2;
+        }
+        if constexpr ((Outputs & kOutputRho) != 0) {
+            out.greeks.rho = IsCall ? K * T * discount * nd2 : -K * T * discount * nd2;
+        }
+        return out;
+    }
+
+    // Array form over structure-of-arrays inputs (discount[i] = exp(-r T)):
+    // the same outputs as evaluate(), with log, the normal cdf and pdf taken
+    // by normalMath's array kernels, so they run vectorized (AVX2 picked at
+    // run time on portable builds). work must hold 3n doubles
+    static void evaluate_batch(size_t n, const double* S, const double* K, const double* T, const double* r,
+                               const double* sigma, const double* discount, double* work, PricingResult* out) {
+        constexpr double w = IsCall ? 1.0 : -1.0;
+        double* d1 = work;        // log(S/K), then d1, then N(w d1)
+        double* d2 = work + n;    // N(w d2)
+        double* pdf = work + 2 * n;
+
+        for (size_t i = 0; i < n; ++i) d1[i] = S[i] / K[i];
+        fast_log(d1, d1, n);
+        for (size_t i = 0; i < n; ++i) {
+            double Tc = T[i] > 0 ? T[i] : 1.0;  // Expired: selected out below
+            double vol_sqrt_t = sigma[i] * std::sqrt(Tc);
+            d1[i] = (d1[i] + (r[i] + 0.5 * sigma[i] * sigma[i]) * Tc) / vol_sqrt_t;
+            d2[i] = w * (d1[i] - vol_sqrt_t);
+        }
+        if constexpr (kNeedsPdf) norm_pdf(d1, pdf, n);
+        for (size_t i = 0; i < n; ++i) d1[i] *= w;
+        norm_cdf(d1, d1, n);
+        if constexpr (kNeedsD2) norm_cdf(d2, d2, n);
+
+        for (size_t i = 0; i < n; ++i) {
+            if (T[i] <= 0) {
+                out[i] = evaluate(S[i], K[i], T[i], r[i], sigma[i], discount[i]);
+                continue;
+            }
+            double sqrt_T = std::sqrt(T[i]);
+            PricingResult& result = out[i];
+            if constexpr ((Outputs & kOutputPrice) != 0) {
+                result.price = w * (S[i] * d1[i] - K[i] * discount[i] * d2[i]);
+            }
+            if constexpr ((Outputs & kOutputDelta) != 0) result.greeks.delta = w * d1[i];
+            if constexpr ((Outputs & kOutputGamma) != 0) result.greeks.gamma = pdf[i] / (S[i] * sigma[i] * sqrt_T);
+            if constexpr ((Outputs & kOutputVega) != 0) result.greeks.vega = S[i] * pdf[i] * sqrt_T;
+            if constexpr ((Outputs & kOutputTheta) != 0) {
+                result.greeks.theta = -(S[i] * pdf[i] * sigma[i]) / (2.0 * sqrt_T) - w * r[i] * K[i] * discount[i] * d2[i];
+            }
+            if constexpr ((Outputs & kOutputRho) != 0) result.greeks.rho = w * K[i] * T[i] * discount[i] * d2[i];
+        }
     }
 };
 
+inline double BlackScholesModel::price_option(double S, double K, double T, double r, double sigma,
+                                              bool is_call) const {
+    return is_call ? BlackScholesKernel<true, kOutputPrice>::evaluate(S, K, T, r, sigma).price
+                   : BlackScholesKernel<false, kOutputPrice>::evaluate(S, K, T, r, sigma).price;
+}
+
+inline Greeks BlackScholesModel::calculate_greeks(double S, double K, double T, double r, double sigma,
+                                                  bool is_call) const {
+    return is_call ? BlackScholesKernel<true, kOutputGreeks>::evaluate(S, K, T, r, sigma).greeks
+                   : BlackScholesKernel<false, kOutputGreeks>::evaluate(S, K, T, r, sigma).greeks;
+}
+
 // Monte Carlo Pricer - uses any Model for path simulation
 class MonteCarloPricer {
 public:
@@ -272,7 +425,7 @@ public:
     JumpDiffusionModel(double rate = 0.05, double volatility = 0.20, 
                        double jump_intensity = 1.0, double jump_mean = -0.05, 
                        double jump_vol = 0.10, unsigned seed = 42)
-        : rate_(rate), volatility_(volatility), 
+        : Model(ModelKind::JumpDiffusion), rate_(rate), volatility_(volatility),
           jump_intensity_(jump_intensity), jump_mean_(jump_mean), jump_vol_(jump_vol),
           generator_(seed), normal_dist_(0.0, 1.0), 
           poisson_dist_(jump_intensity), jump_size_dist_(jump_mean, jump_vol) {}
@@ -285,10 +438,15 @@ public:
 
     // CORRECT: simulate with external random number (allows correlation)
     double simulate_step(double current_price, double dt, double random_z) override {
+        return simulate_step(current_price, dt, random_z, rate_, volatility_);
+    }
+
+    double simulate_step(double current_price, double dt, double random_z,
+                          double rate, double sigma) override {
         // GBM component
         double k = std::exp(jump_mean_ + 0.5 * jump_vol_ * jump_vol_) - 1.0;
-        double drift = (rate_ - jump_intensity_ * k - 0.5 * volatility_ * volatility_) * dt;
-        double diffusion = volatility_ * std::sqrt(dt) * random_z;
+        double drift = (rate - jump_intensity_ * k - 0.5 * sigma * sigma) * dt;
+        double diffusion = sigma * std::sqrt(dt) * random_z;
         
         // Jump component (Poisson process) - note: jumps are idiosyncratic (independent)
         int num_jumps = poisson_dist_(generator_);
@@ -310,13 +468,11 @@ public:
                           const std::string& ticker,
                           const MarketEnvironment& env) override;
 
-    // Use Monte Carlo for option pricing (no closed form for jump-diffusion)
+    // Black-Scholes approximation at the given vol (no closed form for
+    // jump-diffusion; a proper price would need Monte Carlo)
     double price_option(double S, double K, double T, double r, double sigma, bool is_call) const override {
-        (void)sigma; // Uses internal volatility
-        // Simplified - would need Monte Carlo in practice
-        // Fall back to BS approximation
-        BlackScholesModel bs(r, volatility_);
-        return bs.price_option(S, K, T, r, volatility_, is_call);
+        return is_call ? BlackScholesKernel<true, kOutputPrice>::evaluate(S, K, T, r, sigma).price
+                       : BlackScholesKernel<false, kOutputPrice>::evaluate(S, K, T, r, sigma).price;
     }
 
     // Price option using market environment
@@ -325,10 +481,10 @@ public:
                          const MarketEnvironment& env,
                          bool is_call) const override;
 
+    // Black-Scholes approximation for Greeks
     Greeks calculate_greeks(double S, double K, double T, double r, double sigma, bool is_call) const override {
-        // Use BS approximation for Greeks
-        BlackScholesModel bs(r, volatility_);
-        return bs.calculate_greeks(S, K, T, r, sigma, is_call);
+        return is_call ? BlackScholesKernel<true, kOutputGreeks>::evaluate(S, K, T, r, sigma).greeks
+                       : BlackScholesKernel<false, kOutputGreeks>::evaluate(S, K, T, r, sigma).greeks;
     }
 
     // Calculate Greeks using market environment
@@ -354,6 +510,74 @@ private:
     mutable std::normal_distribution<double> jump_size_dist_;
 };
 
+// Terminal prices of a flat path simulation, row-major [path][asset]
+template <typename Real>
+struct ScenarioPaths {
+    std::vector<std::string> tickers;  // Asset order (sorted, as in the input map)
+    std::vector<Real> prices;
+
+    size_t num_assets() const { return tickers.size(); }
+    size_t num_paths() const { return tickers.empty() ? 0 : prices.size() / tickers.size(); }
+    const Real* get_path(size_t path) const { return &prices[path * tickers.size()]; }
+};
+
+// Prices of a flat path simulation at several dates, [date][path][asset]
+template <typename Real>
+struct ScenarioCube {
+    std::vector<std::string> tickers;  // Asset order (sorted, as in the input map)
+    std::vector<double> dates;         // Years, on the step grid
+    size_t num_paths = 0;
+    std::vector<Real> prices;
+
+    size_t num_assets() const { return tickers.size(); }
+    size_t num_dates() const { return dates.size(); }
+    const Real* get_path(size_t date, size_t path) const {
+        return &prices[(date * num_paths + path) * tickers.size()];
+    }
+};
+
+// ============================================================================
+// FORWARD VOL TABLE - Per-step diffusion vols from the ATM term structure
+// Step i spans [i dt, (i+1) dt] and diffuses at the forward vol implied by
+// the ATM total variance w(T) = sigma_atm(T)^2 T over that interval, so the
+// variance a path accumulates up to any step matches the surface's term
+// structure instead of repeating the one-step (shortest expiry) vol.
+// Built once per simulation, [step][asset] with the per-asset drift rates,
+// so the step loop does no surface or curve lookups. Decreasing total
+// variance (calendar arbitrage) gives zero forward variance.
+// ============================================================================
+
+class ForwardVolTable {
+public:
+    ForwardVolTable(const std::vector<std::string>& tickers, double dt, size_t num_steps,
+                    const MarketEnvironment& env);
+
+    double get_vol(size_t step, size_t asset) const { return vols_[step * num_assets_ + asset]; }
+    const double* get_step(size_t step) const { return &vols_[step * num_assets_]; }
+    double get_drift_rate(size_t asset) const { return drift_rates_[asset]; }
+    size_t num_steps() const { return num_assets_ ? vols_.size() / num_assets_ : 0; }
+    size_t num_assets() const { return num_assets_; }
+
+    // Forward vol of one step [step dt, (step+1) dt] without building a
+    // table. Carries the same running max as the table, so it costs O(step)
+    // surface lookups; a stepping caller should advance its own running
+    // variance with accumulate_variance instead (as the live market does)
+    static double get_forward_vol(const VolatilitySurface& surface, double dt, size_t step);
+
+    // Total variance reached at time t given `variance` so far. The running
+    // max keeps it non-decreasing, so a calendar arbitrage dip is a
+    // zero-variance stretch rather than a later over-shoot of the surface
+    static double accumulate_variance(const VolatilitySurface& surface, double variance, double t);
+
+    // Running total variance after `steps` steps of dt
+    static double get_total_variance(const VolatilitySurface& surface, double dt, size_t steps);
+
+private:
+    size_t num_assets_;
+    std::vector<double> vols_;
+    std::vector<double> drift_rates_;
+};
+
 // ============================================================================
 // MULTI-ASSET SIMULATOR - Generates correlated market moves
 // Uses Cholesky decomposition: Z_correlated = L * Z_independent
@@ -362,7 +586,7 @@ private:
 class MultiAssetSimulator {
 public:
     MultiAssetSimulator(Model& model, unsigned seed = 42)
-        : model_(model), generator_(seed), normal_dist_(0.0, 1.0) {}
+        : model_(model), generator_(seed), normal_dist_(0.0, 1.0), uniform_dist_(0.0, 1.0) {}
 
     // Generate correlated random numbers for a set of assets
     // Returns map: ticker -> correlated Z
@@ -371,11 +595,18 @@ public:
         const MarketEnvironment& env);
 
     // Simulate one market-wide step for all assets (CORRELATED)
+    // With correlation regimes, the live market's regime advances one step first
+    // `step` is the live market's step count: the step spans
+    // [step dt, (step+1) dt] and diffuses at the ATM forward vol over it, or
+    // at the model's local vol sigma(S, step dt), as in the flat engine.
+    // Each ticker's running total variance is kept between calls, so
+    // consecutive steps cost one surface lookup each
     // Returns map: ticker -> new price
     std::map<std::string, double> simulate_market_step(
         const std::map<std::string, double>& current_prices,
         double dt,
-        const MarketEnvironment& env);
+        const MarketEnvironment& env,
+        size_t step = 0);
 
     // Simulate multiple paths for portfolio-wide VaR
     // Returns: [path_idx][ticker] -> final price
@@ -386,12 +617,85 @@ public:
         size_t steps_per_year,
         const MarketEnvironment& env);
 
+    // Flat step-major path engine for large scenario sets (VaR on 1M paths):
+    // shocks for all paths of a step are drawn (by inversion, fill_normals)
+    // and correlated in one batch, with regime switching, dense or
+    // structured correlation. Steps diffuse at the ATM forward vol
+    // (ForwardVolTable), or at the model's local vol sigma(S, t) for
+    // underlyings it has one for.
+    // Real sets the precision of the path state and shocks: float normals
+    // are drawn in single precision. A dense correlation multiplies them by
+    // its cached float L and accumulates in float; a structured correlation
+    // keeps its loadings in double and accumulates in double. GBM models
+    // (Black-Scholes, local vol) are stepped inline over the Real arrays,
+    // other models per element through the model's scalar step.
+    // Instantiated for float and double.
+    template <typename Real>
+    ScenarioPaths<Real> simulate_terminal_prices(
+        const std::map<std::string, double>& initial_prices,
+        double T,
+        size_t num_paths,
+        size_t steps_per_year,
+        const MarketEnvironment& env);
+
+    // Same engine, keeping every path at each of several dates (ascending,
+    // snapped to the step grid of the last one): for one date, the same
+    // prices as simulate_terminal_prices. The overload taking `out` writes
+    // the [date][path][asset] cube straight into caller-owned memory (a
+    // SharedScenarioStore segment) and returns the snapped dates.
+    template <typename Real>
+    ScenarioCube<Real> simulate_scenario_cube(
+        const std::map<std::string, double>& initial_prices,
+        const std::vector<double>& dates,
+        size_t num_paths,
+        size_t steps_per_year,
+        const MarketEnvironment& env);
+
+    template <typename Real>
+    std::vector<double> simulate_scenario_cube(
+        const std::map<std::string, double>& initial_prices,
+        const std::vector<double>& dates,
+        size_t num_paths,
+        size_t steps_per_year,
+        const MarketEnvironment& env,
+        Real* out);
+
     void set_seed(unsigned seed) { generator_.seed(seed); }
 
+    // Current regime of the live market (simulate_market_step)
+    static constexpr size_t kNoRegime = static_cast<size_t>(-1);
+    size_t get_current_regime() const { return current_regime_; }
+    void set_current_regime(size_t regime) { current_regime_ = regime; }
+
 private:
     Model& model_;
     mutable std::mt19937 generator_;
     mutable std::normal_distribution<double> normal_dist_;
+    mutable std::uniform_real_distribution<double> uniform_dist_;
+    size_t current_regime_ = kNoRegime;  // kNoRegime = start from the env's initial regime
+
+    // Live market's running ATM total variance per ticker after `steps`
+    // steps of dt. Rebuilt from step 0 when the surface (its revision), dt
+    // or the step count no longer match, e.g. after a vol tick or a restore
+    struct LiveVariance {
+        std::uint64_t surface_revision;
+        double dt;
+        size_t steps;
+        double variance;
+    };
+    std::map<std::string, LiveVariance> live_variance_;
+
+    // Forward vol of step `step` for the live market, advancing its variance
+    double advance_live_variance(const std::string& ticker, const VolatilitySurface& surface,
+                                 double dt, size_t step);
+
+    // Flat engine behind simulate_terminal_prices and simulate_scenario_cube:
+    // runs num_steps steps of dt on prices [path][asset], copying the state
+    // into checkpoints [k][path][asset] after step checkpoint_steps[k]
+    template <typename Real>
+    void simulate_flat(const std::map<std::string, double>& initial_prices, double dt, size_t num_steps,
+                       size_t num_paths, const MarketEnvironment& env, Real* prices,
+                       const std::vector<size_t>& checkpoint_steps, Real* checkpoints);
 };
 
 #endif
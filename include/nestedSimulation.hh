@@ -0,0 +1,127 @@
+// Header file for nested (multi-horizon) simulation
+// Outer scenario paths to one or more horizons, then revaluation of
+// path-dependent claims on every outer node - by inner Monte Carlo or by a
+// least-squares regression proxy - for margin and CVA-style exposure
+
+#ifndef NESTED_SIMULATION_H
+#define NESTED_SIMULATION_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <cstdint>
+#include <cstddef>
+#include "model.hh"
+#include "marketEnvironment.hh"
+
+// ============================================================================
+// CLAIMS - Payoffs fixed on the simulation's step grid
+// ============================================================================
+
+enum class ClaimPayoff : std::uint8_t {
+    European,  // max(w (S_T - K), 0)
+    Asian,     // Arithmetic average of the step fixings since today vs K
+    KnockOut   // European, void once the path touches the barrier (up-and-out
+               // for calls, down-and-out for puts), monitored at every step
+};
+
+struct NestedClaim {
+    std::string ticker;
+    ClaimPayoff payoff = ClaimPayoff::European;
+    bool is_call = true;
+    double strike = 0.0;
+    double maturity = 0.0;  // Years from today
+    double barrier = 0.0;   // KnockOut only
+    double quantity = 1.0;
+};
+
+// Checkpointed state of one asset on one outer node: enough to carry any
+// ClaimPayoff forward from the node
+struct NodeState {
+    double spot;
+    double fixing_sum;  // Sum of the step fixings since today
+    double path_min;    // Running extremes since today
+    double path_max;
+};
+
+// ============================================================================
+// NESTED SIMULATOR
+// The constructor runs the outer simulation once - correlated, step-major,
+// at the ATM forward vol or the model's local vol, like MultiAssetSimulator
+// - and checkpoints every path's NodeState at each horizon into one flat
+// [horizon][path][asset] array. value() then prices claims on every node:
+//   InnerMonteCarlo  inner paths from the node to each maturity. All nodes
+//                    (and all horizons) draw the same pool of correlated,
+//                    antithetic inner shocks, generated once per call: no
+//                    RNG in the inner loop, and common random numbers make
+//                    node values smooth in the node state.
+//   Regression       least-squares Monte Carlo: one inner path per node (the
+//                    pool rotated across nodes), then per claim and horizon
+//                    a polynomial regression of the discounted payoff on the
+//                    node's spot (and running average for Asians) over the
+//                    nodes where the claim is alive. The fit is the node
+//                    value; inner_paths times cheaper than full nesting.
+// Nodes are valued in parallel over outer paths. The model's explicit
+// step (rate and sigma given) is called from several threads: models that
+// draw inside a step (JumpDiffusionModel's jumps) need num_threads = 1.
+// Claims are discounted on their underlying's currency curve and valued in
+// that currency. Claims maturing at or before a horizon are worth nothing
+// there (settled).
+// Correlation regimes are not supported; the market environment must
+// outlive the simulator.
+// ============================================================================
+
+enum class NestedValuation : std::uint8_t { InnerMonteCarlo, Regression };
+
+struct NestedSimulationSettings {
+    std::vector<double> horizons;  // Outer checkpoints, years, ascending
+    size_t outer_paths = 1000;
+    size_t inner_paths = 256;      // Inner shock pool, shared by every node
+    size_t steps_per_year = 252;
+    size_t regression_degree = 3;  // Polynomial degree in the node spot
+    size_t num_threads = 0;        // 0 = all hardware threads
+    unsigned seed = 42;
+};
+
+class NestedSimulator {
+public:
+    NestedSimulator(Model& model, const MarketEnvironment& env,
+                    const std::map<std::string, double>& initial_prices,
+                    const NestedSimulationSettings& settings);
+
+    // Portfolio value sum quantity * value on each node, [horizon][path]
+    std::vector<double> value(const std::vector<NestedClaim>& claims,
+                              NestedValuation method = NestedValuation::InnerMonteCarlo) const;
+
+    const NodeState* get_node(size_t horizon, size_t path) const {
+        return &states_[(horizon * settings_.outer_paths + path) * tickers_.size()];
+    }
+    double get_horizon(size_t horizon) const { return horizon_steps_[horizon] * dt_; }  // On the step grid
+    size_t num_horizons() const { return horizon_steps_.size(); }
+    size_t num_paths() const { return settings_.outer_paths; }
+    const std::vector<std::string>& get_tickers() const { return tickers_; }
+    const NestedSimulationSettings& get_settings() const { return settings_; }
+
+private:
+    static constexpr size_t kUnmodelled = static_cast<size_t>(-1);
+
+    Model& model_;
+    const MarketEnvironment& env_;
+    NestedSimulationSettings settings_;
+    double dt_;
+    std::vector<std::string> tickers_;
+    std::vector<double> initial_;
+    std::vector<size_t> horizon_steps_;
+    std::vector<NodeState> states_;  // [horizon][path][asset]
+
+    // Correlation layout: correlated index per asset (kUnmodelled = independent)
+    bool use_structured_ = false;
+    std::vector<size_t> corr_index_;
+    size_t corr_outputs_ = 0;
+    size_t corr_inputs_ = 0;
+
+    void draw_shocks(std::mt19937& generator, size_t count, std::vector<double>& out) const;
+};
+
+#endif
@@ -0,0 +1,506 @@
+// Header file for the normal-distribution math kernels
+// exp, log, normal pdf/cdf and inverse cdf, accurate to a few ulp and
+// written branch-free so array loops over them auto-vectorize
+
+#ifndef NORMAL_MATH_H
+#define NORMAL_MATH_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <limits>
+#include <random>
+
+// ============================================================================
+// DESIGN
+// Every scalar kernel is straight-line code: range reduction through bit
+// manipulation instead of libm calls, every region of a piecewise
+// approximation evaluated, and the result picked with selects. The compiler
+// can then if-convert and vectorize the array forms (bottom of the file).
+// Accuracy (see bench/normalMath): exp/log ~1 ulp; norm_pdf, norm_cdf and
+// inv_norm_cdf below 1e-15 relative across the double range, including
+// the tails (x^2 is split so exp(-x^2/2) does not amplify rounding).
+// Evaluating every region only pays off with wide vectors, so every scalar
+// kernel takes a BranchFree parameter. It defaults to the branch-free form
+// under RISK_NATIVE_ARCH; otherwise (SSE2, two doubles per register) the
+// piecewise kernels branch to the one region they need, and exp, log and
+// exp(-x^2/2) are libm's, which beats the scalar bit-level forms there
+// (norm_pdf then loses ~x^2/2 ulp in the tails). Scalar callers - the
+// per-option pricing kernels - therefore use libm on default builds.
+// The array forms are the vectorized path on every build: src/normalMath.cpp
+// also compiles their loops over the branch-free kernels for AVX2+FMA and
+// picks that version at run time when the CPU has it. The two forms agree
+// to an ulp or two (the same regions, libm vs bit-level exp/log).
+// ============================================================================
+
+#ifdef RISK_NATIVE_ARCH
+constexpr bool kBranchFreeKernels = true;
+#else
+constexpr bool kBranchFreeKernels = false;
+#endif
+
+// Bit-level helpers for range reduction
+inline std::uint64_t double_to_bits(double x) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &x, sizeof bits);
+    return bits;
+}
+
+inline double bits_to_double(std::uint64_t bits) {
+    double x;
+    std::memcpy(&x, &bits, sizeof x);
+    return x;
+}
+
+// Exact double of a small non-negative integer held in the low bits of
+// `bits` (2^52 magic: no int64 -> double conversion, which SSE2 lacks)
+inline double small_uint_to_double(std::uint64_t bits) {
+    return bits_to_double(0x4330000000000000ULL | bits) - 4503599627370496.0;
+}
+
+// ============================================================================
+// EXP / LOG
+// ============================================================================
+
+// exp(hi + lo) for |lo| small next to rounding of hi + lo: x = k ln2 + r
+// with |r| <= ln2/2 (Cody-Waite split of ln2, lo folded into r), degree-13
+// Taylor polynomial in r evaluated by Estrin's scheme (short dependency
+// chains). k is rounded with the 1.5 * 2^52 shifter, so it sits in the low
+// mantissa bits of kd and 2^k is assembled by an integer add and shift;
+// results below the normal range are scaled in two steps.
+inline double fast_exp_sum(double hi, double lo) {
+    constexpr double kLog2e = 1.4426950408889634074;
+    constexpr double kLn2Hi = 6.93147180369123816490e-01;
+    constexpr double kLn2Lo = 1.90821492927058770002e-10;
+    constexpr double kShifter = 6755399441055744.0;
+
+    double x = hi + lo;
+    double xc = x < -745.5 ? -745.5 : x;
+    xc = xc > 709.8 ? 709.8 : xc;
+    double kd = xc * kLog2e + kShifter;
+    std::uint64_t kbits = double_to_bits(kd);
+    kd -= kShifter;
+    double r = ((hi - kd * kLn2Hi) + lo) - kd * kLn2Lo;
+
+    double r2 = r * r;
+    double r4 = r2 * r2;
+    double r8 = r4 * r4;
+    double p01 = 1.0 + r;
+    double p23 = 1.0 / 2.0 + r * (1.0 / 6.0);
+    double p45 = 1.0 / 24.0 + r * (1.0 / 120.0);
+    double p67 = 1.0 / 720.0 + r * (1.0 / 5040.0);
+    double p89 = 1.0 / 40320.0 + r * (1.0 / 362880.0);
+    double p1011 = 1.0 / 3628800.0 + r * (1.0 / 39916800.0);
+    double p1213 = 1.0 / 479001600.0 + r * (1.0 / 6227020800.0);
+    double p03 = p01 + r2 * p23;
+    double p47 = p45 + r2 * p67;
+    double p811 = p89 + r2 * p1011;
+    double p07 = p03 + r4 * p47;
+    double p813 = p811 + r4 * p1213;
+    double p = p07 + r8 * p813;
+
+    // Shifting by 52 keeps only the 12 low bits: (k + bias) mod 2^12
+    double normal = p * bits_to_double((kbits + 1023) << 52);
+    double subnormal = (p * bits_to_double((kbits + 1023 + 64) << 52)) * 5.421010862427522e-20;  // 2^-64
+    double result = kd < -1022.0 ? subnormal : normal;
+    result = x > 709.782712893384 ? std::numeric_limits<double>::infinity() : result;
+    result = x < -745.1332191019412 ? 0.0 : result;
+    return x != x ? x : result;
+}
+
+template <bool BranchFree = kBranchFreeKernels>
+inline double fast_exp(double x) {
+    if constexpr (!BranchFree) return std::exp(x);
+    return fast_exp_sum(x, 0.0);
+}
+
+// log(x): x = 2^e m with m in [sqrt(1/2), sqrt(2)), then
+// log(m) = 2 atanh(s), s = (m-1)/(m+1), |s| < 0.172, as an odd series in s
+template <bool BranchFree = kBranchFreeKernels>
+inline double fast_log(double x) {
+    if constexpr (!BranchFree) return std::log(x);
+    constexpr double kLn2Hi = 6.93147180369123816490e-01;
+    constexpr double kLn2Lo = 1.90821492927058770002e-10;
+
+    // Subnormals: rescale by 2^54 first
+    bool tiny = x < std::numeric_limits<double>::min();
+    double xs = tiny ? x * 18014398509481984.0 : x;
+    std::uint64_t bits = double_to_bits(xs);
+    double e = small_uint_to_double((bits >> 52) & 0x7FF) - (tiny ? 1077.0 : 1023.0);
+    double m = bits_to_double((bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL);
+    bool high = m > 1.4142135623730951;
+    m = high ? 0.5 * m : m;
+    e = high ? e + 1.0 : e;
+
+    double f = m - 1.0;
+    double s = f / (2.0 + f);
+    double z = s * s;
+    double z2 = z * z;
+    double z4 = z2 * z2;
+    double z8 = z4 * z4;
+    // series = sum_{j=0..10} z^j / (2j + 3), by Estrin's scheme
+    double s01 = 1.0 / 3.0 + z * (1.0 / 5.0);
+    double s23 = 1.0 / 7.0 + z * (1.0 / 9.0);
+    double s45 = 1.0 / 11.0 + z * (1.0 / 13.0);
+    double s67 = 1.0 / 15.0 + z * (1.0 / 17.0);
+    double s89 = 1.0 / 19.0 + z * (1.0 / 21.0);
+    double s03 = s01 + z2 * s23;
+    double s47 = s45 + z2 * s67;
+    double s810 = s89 + z2 * (1.0 / 23.0);
+    double series = (s03 + z4 * s47) + z8 * s810;
+    // log(m) = f - f^2/2 + s (f^2/2 + 2 z series): small correction to f
+    double half_f2 = 0.5 * f * f;
+    double log_m = f - (half_f2 - s * (half_f2 + 2.0 * z * series));
+
+    double result = e * kLn2Hi + (e * kLn2Lo + log_m);
+    result = x == std::numeric_limits<double>::infinity() ? x : result;
+    result = x == 0.0 ? -std::numeric_limits<double>::infinity() : result;
+    return (x < 0.0 || x != x) ? std::numeric_limits<double>::quiet_NaN() : result;
+}
+
+// Single precision, for float path state: the same reductions with float
+// polynomials, about 1 float ulp, so SSE2 runs four lanes per instruction.
+// Results below the normal float range flush to zero
+inline std::uint32_t float_to_bits(float x) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &x, sizeof bits);
+    return bits;
+}
+
+inline float bits_to_float(std::uint32_t bits) {
+    float x;
+    std::memcpy(&x, &bits, sizeof x);
+    return x;
+}
+
+inline float fast_expf(float x) {
+    constexpr float kLog2e = 1.44269504f;
+    constexpr float kLn2Hi = 0.693145751953125f;
+    constexpr float kLn2Lo = 1.428606765330187e-6f;
+    constexpr float kShifter = 12582912.0f;  // 1.5 * 2^23
+
+    float xc = x < -87.0f ? -87.0f : x;
+    xc = xc > 88.0f ? 88.0f : xc;
+    float kd = xc * kLog2e + kShifter;
+    std::uint32_t kbits = float_to_bits(kd);
+    kd -= kShifter;
+    float r = (xc - kd * kLn2Hi) - kd * kLn2Lo;
+
+    float p = 1.0f / 5040.0f;
+    p = p * r + 1.0f / 720.0f;
+    p = p * r + 1.0f / 120.0f;
+    p = p * r + 1.0f / 24.0f;
+    p = p * r + 1.0f / 6.0f;
+    p = p * r + 0.5f;
+    p = p * r + 1.0f;
+    p = p * r + 1.0f;
+
+    // Shifting by 23 keeps only the 9 low bits: (k + bias) mod 2^9
+    float result = p * bits_to_float((kbits + 127) << 23);
+    result = x > 88.72283f ? std::numeric_limits<float>::infinity() : result;
+    result = x < -87.33654f ? 0.0f : result;
+    return x != x ? x : result;
+}
+
+// log(x) for normal positive floats (zero gives -inf; negative, NaN or
+// subnormal inputs are not supported)
+inline float fast_logf(float x) {
+    constexpr float kLn2Hi = 0.693145751953125f;
+    constexpr float kLn2Lo = 1.428606765330187e-6f;
+
+    std::uint32_t bits = float_to_bits(x);
+    float e = static_cast<float>(static_cast<std::int32_t>(bits >> 23)) - 127.0f;
+    float m = bits_to_float((bits & 0x007FFFFFu) | 0x3F800000u);
+    bool high = m > 1.41421356f;
+    m = high ? 0.5f * m : m;
+    e = high ? e + 1.0f : e;
+
+    // log(m) = 2 atanh(s), s = (m-1)/(m+1), |s| < 0.172: odd series in s
+    float f = m - 1.0f;
+    float s = f / (2.0f + f);
+    float z = s * s;
+    float series = ((z * (1.0f / 9.0f) + 1.0f / 7.0f) * z + 1.0f / 5.0f) * z + 1.0f / 3.0f;
+    float log_m = f - s * (f - z * series * 2.0f);
+
+    float result = e * kLn2Hi + (e * kLn2Lo + log_m);
+    return x == 0.0f ? -std::numeric_limits<float>::infinity() : result;
+}
+
+// exp(-y^2 / 2) for y >= 0 without amplifying the rounding of y^2:
+// y = ys + (y - ys) with ys on a 1/16 grid (rounded with the 2^52 shifter,
+// y clamped where the result underflows anyway), so ys^2 is exact and only
+// the small remainder carries rounding into the reduced argument
+// Branchy form: y^2 = hi + lo exactly (Dekker's product),
+// then exp(-hi/2) (1 - lo/2) with libm's exp, lo being below an ulp of hi
+template <bool BranchFree = kBranchFreeKernels>
+inline double exp_half_square(double y) {
+    if constexpr (!BranchFree) {
+        constexpr double kSplit = 134217729.0;  // 2^27 + 1
+        y = y < 40.0 ? y : 40.0;
+        double ys = y * kSplit;
+        double yh = ys - (ys - y);
+        double yl = y - yh;
+        double hi = y * y;
+        double lo = ((yh * yh - hi) + 2.0 * yh * yl) + yl * yl;
+        return std::exp(-0.5 * hi) * (1.0 - 0.5 * lo);
+    }
+    double yc = y < 40.0 ? y : 40.0;
+    double ys = ((yc * 16.0 + 4503599627370496.0) - 4503599627370496.0) / 16.0;
+    double del = (yc - ys) * (yc + ys);
+    return fast_exp_sum(-0.5 * ys * ys, -0.5 * del);
+}
+
+// ============================================================================
+// NORMAL DISTRIBUTION
+// ============================================================================
+
+constexpr double kInvSqrt2Pi = 0.39894228040143267794;
+
+template <bool BranchFree = kBranchFreeKernels>
+inline double norm_pdf(double x) {
+    if constexpr (!BranchFree) return kInvSqrt2Pi * std::exp(-0.5 * x * x);
+    double pdf = kInvSqrt2Pi * exp_half_square<BranchFree>(std::fabs(x));
+    return x != x ? x : pdf;
+}
+
+// Standard normal CDF, computed directly in x (no x/sqrt2 rounding) with
+// Cody's rational approximations (as in W. J. Cody, ACM TOMS 715):
+// |x| <= 0.674 central, <= sqrt(32) mid tail, beyond asymptotic tail
+
+// Central region: 0.5 + x R(x^2)
+inline double norm_cdf_central(double x) {
+    double xsq = x * x;
+    double num = 0.065682337918207449113 * xsq;
+    double den = xsq;
+    num = (num + 2.2352520354606839287) * xsq;
+    den = (den + 47.20258190468824187) * xsq;
+    num = (num + 161.02823106855587881) * xsq;
+    den = (den + 976.09855173777669322) * xsq;
+    num = (num + 1067.6894854603709582) * xsq;
+    den = (den + 10260.932208618978205) * xsq;
+    return 0.5 + x * (num + 18154.981253343561249) / (den + 45507.789335026729956);
+}
+
+// Mid tail, y = |x|: R(y), times exp(-y^2/2) by the caller
+inline double norm_cdf_mid_tail(double y) {
+    double mnum = 1.0765576773720192317e-8 * y;
+    double mden = y;
+    mnum = (mnum + 0.39894151208813466764) * y;
+    mden = (mden + 22.266688044328115691) * y;
+    mnum = (mnum + 8.8831497943883759412) * y;
+    mden = (mden + 235.38790178262499861) * y;
+    mnum = (mnum + 93.506656132177855979) * y;
+    mden = (mden + 1519.377599407554805) * y;
+    mnum = (mnum + 597.27027639480026226) * y;
+    mden = (mden + 6485.558298266760755) * y;
+    mnum = (mnum + 2494.5375852903726711) * y;
+    mden = (mden + 18615.571640885098091) * y;
+    mnum = (mnum + 6848.1904505362823326) * y;
+    mden = (mden + 34900.952721145977266) * y;
+    mnum = (mnum + 11602.651437647350124) * y;
+    mden = (mden + 38912.003286093271411) * y;
+    return (mnum + 9842.7148383839780218) / (mden + 19685.429676859990727);
+}
+
+// Far tail: (1/sqrt(2 pi) - R(1/y^2) / y^2) / y, times exp(-y^2/2) by the caller
+inline double norm_cdf_far_tail(double y) {
+    double ysq = 1.0 / (y * y);
+    double fnum = 0.02307344176494017303 * ysq;
+    double fden = ysq;
+    fnum = (fnum + 0.21589853405795699) * ysq;
+    fden = (fden + 1.28426009614491121) * ysq;
+    fnum = (fnum + 0.1274011611602473639) * ysq;
+    fden = (fden + 0.468238212480865118) * ysq;
+    fnum = (fnum + 0.022235277870649807) * ysq;
+    fden = (fden + 0.0659881378689285515) * ysq;
+    fnum = (fnum + 0.001421619193227893466) * ysq;
+    fden = (fden + 0.00378239633202758244) * ysq;
+    return (kInvSqrt2Pi - ysq * (fnum + 2.9112874951168792e-5) / (fden + 7.29751555083966205e-5)) / y;
+}
+
+template <bool BranchFree = kBranchFreeKernels>
+inline double norm_cdf(double x) {
+    constexpr double kCentral = 0.67448975;
+    constexpr double kMidTail = 5.656854249492380195;
+    double y = std::fabs(x);
+    if constexpr (!BranchFree) {
+        if (y <= kCentral) return norm_cdf_central(x);
+        double lower_tail = exp_half_square<BranchFree>(y) * (y <= kMidTail ? norm_cdf_mid_tail(y) : norm_cdf_far_tail(y));
+        return x > 0.0 ? 1.0 - lower_tail : lower_tail;
+    }
+    double central = norm_cdf_central(x);
+    double mid = norm_cdf_mid_tail(y);
+    double far = norm_cdf_far_tail(y);
+    double lower_tail = exp_half_square<BranchFree>(y) * (y <= kMidTail ? mid : far);
+    double tail = x > 0.0 ? 1.0 - lower_tail : lower_tail;
+    return y <= kCentral ? central : tail;
+}
+
+// Inverse standard normal CDF (Wichura, AS241 PPND16): rational
+// approximations in q = p - 0.5 for |q| <= 0.425, else in sqrt(-log(tail))
+// with two segments; relative accuracy about 1e-16
+
+// Central region, |q| <= 0.425
+inline double inv_norm_cdf_central(double q) {
+    double r = 0.180625 - q * q;
+    double cnum = 2509.0809287301226727;
+    cnum = cnum * r + 33430.575583588128105;
+    cnum = cnum * r + 67265.770927008700853;
+    cnum = cnum * r + 45921.953931549871457;
+    cnum = cnum * r + 13731.693765509461125;
+    cnum = cnum * r + 1971.5909503065514427;
+    cnum = cnum * r + 133.14166789178437745;
+    cnum = cnum * r + 3.387132872796366608;
+    double cden = 5226.495278852545925;
+    cden = cden * r + 28729.085735721942674;
+    cden = cden * r + 39307.89580009271061;
+    cden = cden * r + 21213.794301586595867;
+    cden = cden * r + 5394.1960214247511077;
+    cden = cden * r + 687.1870074920579083;
+    cden = cden * r + 42.313330701600911252;
+    cden = cden * r + 1.0;
+    return q * cnum / cden;
+}
+
+// Tail segments in t = sqrt(-log(tail)): t <= 5 and beyond
+inline double inv_norm_cdf_near_tail(double t) {
+    double u = t - 1.6;
+    double nnum = 7.7454501427834140764e-4;
+    nnum = nnum * u + 0.0227238449892691845833;
+    nnum = nnum * u + 0.24178072517745061177;
+    nnum = nnum * u + 1.27045825245236838258;
+    nnum = nnum * u + 3.64784832476320460504;
+    nnum = nnum * u + 5.7694972214606914055;
+    nnum = nnum * u + 4.6303378461565452959;
+    nnum = nnum * u + 1.42343711074968357734;
+    double nden = 1.05075007164441684324e-9;
+    nden = nden * u + 5.475938084995344946e-4;
+    nden = nden * u + 0.0151986665636164571966;
+    nden = nden * u + 0.14810397642748007459;
+    nden = nden * u + 0.68976733498510000455;
+    nden = nden * u + 1.6763848301838038494;
+    nden = nden * u + 2.05319162663775882187;
+    nden = nden * u + 1.0;
+    return nnum / nden;
+}
+
+inline double inv_norm_cdf_far_tail(double t) {
+    double v = t - 5.0;
+    double fnum = 2.01033439929228813265e-7;
+    fnum = fnum * v + 2.71155556874348757815e-5;
+    fnum = fnum * v + 0.0012426609473880784386;
+    fnum = fnum * v + 0.026532189526576123093;
+    fnum = fnum * v + 0.29656057182850489123;
+    fnum = fnum * v + 1.7848265399172913358;
+    fnum = fnum * v + 5.4637849111641143699;
+    fnum = fnum * v + 6.6579046435011037772;
+    double fden = 2.04426310338993978564e-15;
+    fden = fden * v + 1.4215117583164458887e-7;
+    fden = fden * v + 1.8463183175100546818e-5;
+    fden = fden * v + 7.868691311456132591e-4;
+    fden = fden * v + 0.0148753612908506148525;
+    fden = fden * v + 0.13692988092273580531;
+    fden = fden * v + 0.59983220655588793769;
+    fden = fden * v + 1.0;
+    return fnum / fden;
+}
+
+template <bool BranchFree = kBranchFreeKernels>
+inline double inv_norm_cdf(double p) {
+    double q = p - 0.5;
+    if constexpr (!BranchFree) {
+        if (std::fabs(q) <= 0.425) return inv_norm_cdf_central(q);
+        double t = std::sqrt(-fast_log<BranchFree>(q < 0.0 ? p : 1.0 - p));
+        double tail = t <= 5.0 ? inv_norm_cdf_near_tail(t) : inv_norm_cdf_far_tail(t);
+        return q < 0.0 ? -tail : tail;
+    }
+    double central = inv_norm_cdf_central(q);
+    double t = std::sqrt(-fast_log<BranchFree>(q < 0.0 ? p : 1.0 - p));
+    double near_tail = inv_norm_cdf_near_tail(t);
+    double far_tail = inv_norm_cdf_far_tail(t);
+    double tail = t <= 5.0 ? near_tail : far_tail;
+    tail = q < 0.0 ? -tail : tail;
+    return std::fabs(q) <= 0.425 ? central : tail;
+}
+
+// Single-precision inverse CDF (Wichura, AS241 PPND7: the same regions with
+// degree 3/2 rationals, about 1e-7 relative) for float paths. Takes
+// v = p for p < 1/2 and v = -(1 - p) otherwise, so both tails keep full
+// float precision. All float, so the array loop runs four lanes wide
+inline float inv_norm_cdf_from_tail(float v) {
+    bool upper = v < 0.0f;
+    float tail_p = upper ? -v : v;
+    float q = upper ? 0.5f + v : v - 0.5f;
+
+    float r = 0.180625f - q * q;
+    float cnum = ((59.109374720f * r + 159.29113202f) * r + 50.434271938f) * r + 3.3871327179f;
+    float cden = ((67.187563600f * r + 78.757757664f) * r + 17.895169469f) * r + 1.0f;
+    float central = q * cnum / cden;
+
+    float t = std::sqrt(-fast_logf(tail_p));
+    float u = t - 1.6f;
+    float near_tail = (((0.17023821103f * u + 1.3067284816f) * u + 2.7568153900f) * u + 1.4234372777f) /
+                      ((0.12021132975f * u + 0.73700164250f) * u + 1.0f);
+    float w = t - 5.0f;
+    float far_tail = (((0.017337203997f * w + 0.42868294337f) * w + 3.0812263860f) * w + 6.6579051150f) /
+                     ((0.012258202635f * w + 0.24197894225f) * w + 1.0f);
+
+    float tail = t <= 5.0f ? near_tail : far_tail;
+    tail = upper ? tail : -tail;
+    return std::fabs(q) <= 0.425f ? central : tail;
+}
+
+// ============================================================================
+// ARRAY FORMS - out may alias x (src/normalMath.cpp)
+// Branch-free and vectorized wherever the CPU allows: RISK_NATIVE_ARCH
+// builds compile them for the build machine, portable x86-64 builds pick an
+// AVX2+FMA version at run time and fall back to the default scalar forms
+// ============================================================================
+
+void fast_exp(const double* x, double* out, size_t n);
+void fast_log(const double* x, double* out, size_t n);
+void norm_pdf(const double* x, double* out, size_t n);
+void norm_cdf(const double* x, double* out, size_t n);
+void inv_norm_cdf(const double* p, double* out, size_t n);
+
+// Instruction set the array forms run on ("native", "avx2+fma" or "baseline")
+const char* array_kernel_target();
+
+// ============================================================================
+// NORMAL GENERATION BY INVERSION
+// 53-bit uniforms strictly inside (0, 1) from two 32-bit draws, mapped through
+// inv_norm_cdf in one array pass. Monotone in the uniform (unlike Box-Muller
+// or ziggurat), so it also suits antithetic and quasi-random inputs.
+// ============================================================================
+
+template <typename Engine>
+void fill_normals(Engine& generator, double* out, size_t n) {
+    static_assert(Engine::max() - Engine::min() >= 0xFFFFFFFFULL, "fill_normals needs a 32-bit engine");
+    constexpr double kInv2To53 = 1.0 / 9007199254740992.0;
+    for (size_t i = 0; i < n; ++i) {
+        std::uint64_t hi = static_cast<std::uint64_t>(generator() - Engine::min()) & 0xFFFFFFFFULL;
+        std::uint64_t lo = static_cast<std::uint64_t>(generator() - Engine::min()) & 0xFFFFFFFFULL;
+        std::uint64_t bits53 = ((hi >> 5) << 26) | (lo >> 6);
+        out[i] = (static_cast<double>(bits53) + 0.5) * kInv2To53;
+    }
+    inv_norm_cdf(out, out, n);
+}
+
+// Float normals from the same uniforms (same draws, to float precision),
+// inverted in single precision without a double buffer
+template <typename Engine>
+void fill_normals(Engine& generator, float* out, size_t n) {
+    static_assert(Engine::max() - Engine::min() >= 0xFFFFFFFFULL, "fill_normals needs a 32-bit engine");
+    constexpr double kInv2To53 = 1.0 / 9007199254740992.0;
+    for (size_t i = 0; i < n; ++i) {
+        std::uint64_t hi = static_cast<std::uint64_t>(generator() - Engine::min()) & 0xFFFFFFFFULL;
+        std::uint64_t lo = static_cast<std::uint64_t>(generator() - Engine::min()) & 0xFFFFFFFFULL;
+        std::uint64_t bits53 = ((hi >> 5) << 26) | (lo >> 6);
+        double p = (static_cast<double>(bits53) + 0.5) * kInv2To53;
+        out[i] = static_cast<float>(p < 0.5 ? p : p - 1.0);
+    }
+    for (size_t i = 0; i < n; ++i) out[i] = inv_norm_cdf_from_tail(out[i]);
+}
+
+#endif
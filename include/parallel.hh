@@ -0,0 +1,131 @@
+// Header file for lightweight parallel helpers
+// Plain std::thread fork/join - no external threading runtime required
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <algorithm>
+#include <cstddef>
+
+// Number of hardware threads (at least 1)
+inline size_t hardware_threads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+// Dynamically scheduled parallel loop over [begin, end)
+// f(chunk_begin, chunk_end) is called for chunks of `grain` indices; threads
+// pull the next chunk from a shared counter, so uneven chunk costs balance
+// out. The calling thread participates. Worker exceptions are rethrown here.
+template <typename F>
+void parallel_for(size_t begin, size_t end, size_t grain, F&& f, size_t num_threads = 0) {
+    if (end <= begin) return;
+    if (grain == 0) grain = 1;
+
+    size_t num_chunks = (end - begin + grain - 1) / grain;
+    if (num_threads == 0) num_threads = hardware_threads();
+    num_threads = std::min(num_threads, num_chunks);
+
+    if (num_threads <= 1) {
+        f(begin, end);
+        return;
+    }
+
+    std::atomic<size_t> next_chunk{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&]() {
+        try {
+            for (size_t c = next_chunk++; c < num_chunks; c = next_chunk++) {
+                size_t lo = begin + c * grain;
+                f(lo, std::min(end, lo + grain));
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) error = std::current_exception();
+            next_chunk = num_chunks;  // Stop handing out work
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (size_t t = 1; t < num_threads; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& th : threads) th.join();
+
+    if (error) std::rethrow_exception(error);
+}
+
+// Reusable barrier for the threads of one parallel_region
+// Blocks (no spinning), so oversubscribed or single-core hosts do not burn
+// the time slice the other threads need to reach the barrier.
+class Barrier {
+public:
+    explicit Barrier(size_t count) : count_(count) {}
+
+    void arrive_and_wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        size_t generation = generation_;
+        if (++waiting_ == count_) {
+            waiting_ = 0;
+            ++generation_;
+            cv_.notify_all();
+            return;
+        }
+        cv_.wait(lock, [&] { return generation != generation_; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t count_;
+    size_t waiting_ = 0;
+    size_t generation_ = 0;
+};
+
+// Run f(thread_index, num_threads) once on each of num_threads threads
+// (the caller is thread 0). Threads are spawned once for the whole region, so
+// algorithms with many dependent phases synchronize with a Barrier instead
+// of paying a parallel_for fork/join per phase. f must not throw past a
+// barrier the other threads still wait on; exceptions that escape f are
+// rethrown here once every thread has returned.
+template <typename F>
+void parallel_region(size_t num_threads, F&& f) {
+    if (num_threads == 0) num_threads = hardware_threads();
+    if (num_threads <= 1) {
+        f(size_t(0), size_t(1));
+        return;
+    }
+
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto worker = [&](size_t index) {
+        try {
+            f(index, num_threads);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) error = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (size_t t = 1; t < num_threads; ++t) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto& th : threads) th.join();
+
+    if (error) std::rethrow_exception(error);
+}
+
+#endif
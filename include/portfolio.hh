@@ -7,7 +7,10 @@
 #include <vector>
 #include <stdexcept>
 #include <memory>
+#include <utility>
 #include "position.hh"
+#include "instrumentRegistry.hh"
+#include "marketEnvironment.hh"
 
 // Forward declarations
 class InstrumentVisitor;
@@ -17,25 +20,44 @@ class Auditor;
 
 // Portfolio: A container of Positions belonging to an owner
 // Pure DATA - no simulation logic (Visitor Pattern)
+// Instruments live in a (usually shared) InstrumentRegistry; the portfolio
+// only stores compact Position records that reference them by id.
 class Portfolio {
     friend Auditor;
+    friend class SnapshotCodec;
 
 public:
+    Portfolio(std::shared_ptr<InstrumentRegistry> registry, std::string owner, std::string currency)
+        : owner_(owner), currency_(currency), registry_(std::move(registry)) {
+        if (!registry_) {
+            throw std::invalid_argument("Portfolio requires an instrument registry");
+        }
+    }
+
+    explicit Portfolio(std::shared_ptr<InstrumentRegistry> registry)
+        : Portfolio(std::move(registry), "Unknown", "USD") {}
+
+    // Standalone portfolio with its own private registry
     Portfolio(std::string owner, std::string currency)
-        : owner_(owner), currency_(currency) {}
+        : Portfolio(std::make_shared<InstrumentRegistry>(), owner, currency) {}
 
     explicit Portfolio() : Portfolio("Unknown", "USD") {}
 
-    // Add a position to the portfolio
-    void add_position(std::shared_ptr<Instrument> instrument, double quantity) {
-        positions_.emplace_back(instrument, quantity);
+    // Add a position to the portfolio (instrument must be in this portfolio's registry)
+    void add_position(InstrumentId instrument, double quantity) {
+        double price = registry_->get(instrument).get_price();  // Validates the id
+        positions_.emplace_back(instrument, quantity, price);
+        registry_->bump_generation();
     }
 
+    // Reserve capacity (HPC best practice)
+    void reserve_positions(size_t n) { positions_.reserve(n); }
+
     // Calculate total market value across all positions
     double get_total_value() const {
         double total = 0.0;
         for (const auto& pos : positions_) {
-            total += pos.get_market_value();
+            total += pos.get_market_value(price_of(pos));
         }
         return total;
     }
@@ -44,7 +66,7 @@ public:
     double get_total_pnl() const {
         double total_pnl = 0.0;
         for (const auto& pos : positions_) {
-            total_pnl += pos.get_pnl();
+            total_pnl += pos.get_pnl(price_of(pos));
         }
         return total_pnl;
     }
@@ -52,20 +74,83 @@ public:
     // Snapshot all positions for P&L tracking
     void snapshot_prices() {
         for (auto& pos : positions_) {
-            pos.snapshot_price();
+            pos.snapshot_price(price_of(pos));
         }
     }
 
+    // ========================================================================
+    // MULTI-CURRENCY - Values in the portfolio's reporting currency
+    // Positions are aggregated per currency first, so each currency is
+    // converted once rather than once per position.
+    // ========================================================================
+
+    // Local-currency market value per (interned) instrument currency
+    std::vector<std::pair<const std::string*, double>> get_value_by_currency() const {
+        return aggregate_by_currency([this](const Position& pos) {
+            return pos.get_market_value(price_of(pos));
+        });
+    }
+
+    double get_total_value(const FxRates& fx) const {
+        double total = 0.0;
+        for (const auto& [ccy, value] : get_value_by_currency()) {
+            total += value * fx.get_conversion(*ccy, currency_);
+        }
+        return total;
+    }
+
+    // P&L in the reporting currency since the last FX-aware snapshot:
+    // captures both local price moves and FX moves. A currency the snapshot
+    // has no rate for (none taken yet, or first held since) converts at
+    // today's rates on both sides, so it contributes its local move only
+    double get_total_pnl(const FxRates& fx) const {
+        auto last_values = aggregate_by_currency([](const Position& pos) {
+            return pos.get_market_value(pos.get_last_price());
+        });
+        double total_pnl = 0.0;
+        for (const auto& [ccy, value] : get_value_by_currency()) {
+            total_pnl += value * fx.get_conversion(*ccy, currency_);
+        }
+        for (const auto& [ccy, value] : last_values) {
+            bool snapped = last_fx_.has_rate(*ccy) && last_fx_.has_rate(currency_);
+            total_pnl -= value * (snapped ? last_fx_ : fx).get_conversion(*ccy, currency_);
+        }
+        return total_pnl;
+    }
+
+    // Snapshot prices and the FX rates they convert at
+    void snapshot_prices(const FxRates& fx) {
+        snapshot_prices();
+        last_fx_ = fx;
+    }
+
     // Apply a visitor to all instruments
+    // NOTE: an instrument held twice is visited twice - use
+    //       InstrumentRegistry::accept to visit each instrument exactly once
     void accept(InstrumentVisitor& visitor) {
-        for (auto& pos : positions_) {
-            pos.get_instrument().accept(visitor);
+        for (const auto& pos : positions_) {
+            registry_->get(pos.get_instrument_id()).accept(visitor);
         }
     }
 
     void accept(ConstInstrumentVisitor& visitor) const {
         for (const auto& pos : positions_) {
-            pos.get_instrument().accept(visitor);
+            registry_->get(pos.get_instrument_id()).accept(visitor);
+        }
+    }
+
+    // STATIC DISPATCH: f(instrument, position) with the concrete instrument type
+    template <typename F>
+    void visit_positions(F&& f) {
+        for (auto& pos : positions_) {
+            registry_->visit(pos.get_instrument_id(), [&](auto& inst) { f(inst, pos); });
+        }
+    }
+
+    template <typename F>
+    void visit_positions(F&& f) const {
+        for (const auto& pos : positions_) {
+            registry_->visit(pos.get_instrument_id(), [&](const auto& inst) { f(inst, pos); });
         }
     }
 
@@ -77,10 +162,40 @@ public:
     const Position& get_position(size_t idx) const { return positions_[idx]; }
     Position& get_position(size_t idx) { return positions_[idx]; }
 
+    // Resolve the instrument held by a position
+    const Instrument& get_instrument(size_t idx) const { return registry_->get(positions_[idx].get_instrument_id()); }
+    Instrument& get_instrument(size_t idx) { return registry_->get(positions_[idx].get_instrument_id()); }
+
+    const InstrumentRegistry& get_registry() const { return *registry_; }
+    InstrumentRegistry& get_registry() { return *registry_; }
+
 private:
     std::string owner_;
     std::string currency_;
     std::vector<Position> positions_;
+    std::shared_ptr<InstrumentRegistry> registry_;
+    FxRates last_fx_;  // FX at the last snapshot (empty: none taken yet)
+
+    // Sums value(pos) per instrument currency (few currencies: linear scan)
+    template <typename F>
+    std::vector<std::pair<const std::string*, double>> aggregate_by_currency(F&& value) const {
+        std::vector<std::pair<const std::string*, double>> totals;
+        for (const auto& pos : positions_) {
+            const std::string* ccy = registry_->get(pos.get_instrument_id()).get_currency_ptr();
+            auto it = totals.begin();
+            while (it != totals.end() && it->first != ccy) ++it;
+            if (it == totals.end()) {
+                totals.emplace_back(ccy, value(pos));
+            } else {
+                it->second += value(pos);
+            }
+        }
+        return totals;
+    }
+
+    double price_of(const Position& pos) const {
+        return registry_->get(pos.get_instrument_id()).get_price();
+    }
 };
 
 class Auditor {};
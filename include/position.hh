@@ -3,51 +3,48 @@
 #ifndef POSITION_H
 #define POSITION_H
 
-#include <memory>
 #include "instrument.hh"
 
-// Forward declarations
-class InstrumentVisitor;
-class ConstInstrumentVisitor;
-class Model;
-struct Greeks;
-
 // A Position = Quantity of an Instrument
 // Pure data container - no simulation logic
+// Compact record (24 bytes): the instrument is referenced by id and resolved
+// through the owning Portfolio's InstrumentRegistry
 class Position {
 public:
-    Position(std::shared_ptr<Instrument> instrument, double quantity)
-        : instrument_(instrument), quantity_(quantity), 
-          last_price_(instrument->get_price()) {}
+    Position(InstrumentId instrument_id, double quantity, double last_price)
+        : instrument_id_(instrument_id), quantity_(quantity), 
+          last_price_(last_price) {}
 
-    // Calculate total market value of this position
-    double get_market_value() const {
-        return quantity_ * instrument_->get_price();
+    // Calculate market value of this position at the given instrument price
+    double get_market_value(double price) const {
+        return quantity_ * price;
     }
 
     // Record current price for P&L tracking
-    void snapshot_price() {
-        last_price_ = instrument_->get_price();
+    void snapshot_price(double price) {
+        last_price_ = price;
     }
 
-    // Get P&L since last snapshot
-    double get_pnl() const {
-        return quantity_ * (instrument_->get_price() - last_price_);
+    // Get P&L since last snapshot at the given instrument price
+    double get_pnl(double price) const {
+        return quantity_ * (price - last_price_);
     }
 
     // Accessors
-    const Instrument& get_instrument() const { return *instrument_; }
-    Instrument& get_instrument() { return *instrument_; }
+    InstrumentId get_instrument_id() const { return instrument_id_; }
     double get_quantity() const { return quantity_; }
+    double get_last_price() const { return last_price_; }
     
     // Modify position
     void adjust_quantity(double delta) { quantity_ += delta; }
     void set_quantity(double q) { quantity_ = q; }
 
 private:
-    std::shared_ptr<Instrument> instrument_;
+    InstrumentId instrument_id_;
     double quantity_;
     double last_price_;  // For P&L tracking
 };
 
+static_assert(sizeof(Position) <= 24, "Position must stay a compact 24-byte record");
+
 #endif
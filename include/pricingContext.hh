@@ -0,0 +1,318 @@
+// Header file for the PricingContext
+// Shared, precomputed market inputs for option repricing in all visitors
+
+#ifndef PRICING_CONTEXT_H
+#define PRICING_CONTEXT_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include "model.hh"
+#include "instrument.hh"
+#include "marketEnvironment.hh"
+
+// Forward declaration
+class InstrumentRegistry;
+
+// ============================================================================
+// PRICING CONTEXT - Vol surface handles + curve, resolved once per batch
+// Every option visitor (simulation, stress, Greeks) reprices through the same
+// context, so they all see the same surface/curve, and the string-keyed
+// environment lookups happen once per underlying / expiry instead of once
+// per option. The zero rate and discount factor of each expiry are cached
+// together, so the kernels never re-evaluate exp(-r T) per option.
+// Built per step (cheap); holds references into the environment, which must
+// outlive it.
+// ============================================================================
+
+// Zero rate and discount factor exp(-r T) to one expiry
+struct CurvePoint {
+    double rate;
+    double discount_factor;
+};
+
+// Market inputs of one option resolved by the caller (e.g. kept across tick
+// batches by TickIngestor instead of re-resolved from a PricingContext)
+struct OptionInputs {
+    CurvePoint curve;
+    double vol;
+};
+
+class PricingContext {
+public:
+    // Flat rate/vol (no market environment)
+    PricingContext(double flat_rate, double flat_vol)
+        : flat_rate_(flat_rate), flat_vol_(flat_vol) {}
+
+    // Environment-driven: surfaces/rates looked up on demand.
+    // get_rate(T) uses the curve of `currency` (default: the base currency);
+    // options are always discounted on the curve of their own currency.
+    explicit PricingContext(const MarketEnvironment& env)
+        : PricingContext(env, env.get_base_currency()) {}
+
+    PricingContext(const MarketEnvironment& env, const std::string& currency)
+        : env_(&env), curve_(&env.get_yield_curve(currency)), currency_(currency) {}
+
+    // Environment-driven with the surface handle of every option underlying and
+    // the rate of every option expiry precomputed from the registry.
+    // time_shift: decay about to be applied (expiries cached at T - time_shift)
+    PricingContext(const MarketEnvironment& env, const InstrumentRegistry& registry,
+                   double time_shift = 0.0);
+
+    // Same, for only `options` (e.g. the options a tick batch made dirty)
+    PricingContext(const MarketEnvironment& env, const InstrumentRegistry& registry,
+                   const std::vector<InstrumentId>& options);
+
+    // Flat context from a model's own parameters (Black-Scholes), else 5% / 20%
+    static PricingContext from_model(const Model& model) {
+        if (model.get_kind() != ModelKind::BlackScholes) return PricingContext(0.05, 0.20);
+        const auto& bs = static_cast<const BlackScholesModel&>(model);
+        return PricingContext(bs.get_rate(), bs.get_volatility());
+    }
+
+    // Vol surface for a ticker (nullptr in flat mode)
+    // O(1) hash on the interned ticker pointer when precomputed
+    const VolatilitySurface* get_surface(const std::string& ticker) const {
+        if (!env_) return nullptr;
+        auto it = surfaces_.find(&ticker);
+        return it != surfaces_.end() ? it->second : &env_->get_vol_surface(ticker);
+    }
+
+    // Implied vol for an option at expiry T (strike-dependent via the surface)
+    double get_vol(const Option& option, double T) const {
+        const VolatilitySurface* surface = get_surface(option.get_underlying().get_ticker());
+        return surface ? surface->get_vol(option.get_strike(), T) : flat_vol_;
+    }
+
+    // Zero rate and discount factor to expiry T (cached per precomputed expiry)
+    CurvePoint get_curve_point(double T) const {
+        if (!curve_) return {flat_rate_, std::exp(-flat_rate_ * T)};
+        auto it = rates_by_expiry_.find(T);
+        return it != rates_by_expiry_.end() ? it->second : make_curve_point(curve_->get_rate(T), T);
+    }
+
+    // Same, on the curve of the option's currency
+    CurvePoint get_curve_point(const Option& option, double T) const {
+        if (!curve_ || option.get_currency_ptr() == currency_ptr_ || option.get_currency() == currency_) {
+            return get_curve_point(T);
+        }
+        auto it = foreign_rates_.find(option.get_currency_ptr());
+        if (it != foreign_rates_.end()) {
+            auto point = it->second.find(T);
+            if (point != it->second.end()) return point->second;
+        }
+        return make_curve_point(env_->get_rate(T, option.get_currency()), T);
+    }
+
+    // Zero rate to expiry T
+    double get_rate(double T) const { return get_curve_point(T).rate; }
+    double get_discount_factor(double T) const { return get_curve_point(T).discount_factor; }
+
+    // Zero rate to expiry T on the curve of the option's currency
+    double get_rate(const Option& option, double T) const { return get_curve_point(option, T).rate; }
+
+    // Reprice an option with any model at expiry T
+    double price_option(const Model& model, const Option& option, double T,
+                        double vol_shift = 0.0, double rate_shift = 0.0) const {
+        bool is_call = (option.get_type() == Option::Type::Call);
+        return model.price_option(option.get_underlying().get_price(), option.get_strike(), T,
+                                  get_rate(option, T) + rate_shift, get_vol(option, T) + vol_shift, is_call);
+    }
+
+    // Mark an option at its current time to expiry (intrinsic value at expiry)
+    double mark_option(const Model& model, const Option& option) const {
+        double T = option.get_time_to_expiry();
+        if (T > 0) return price_option(model, option, T);
+        double S = option.get_underlying().get_price();
+        double K = option.get_strike();
+        return option.get_type() == Option::Type::Call ? std::max(0.0, S - K) : std::max(0.0, K - S);
+    }
+
+    Greeks calculate_greeks(const Model& model, const Option& option) const {
+        double T = option.get_time_to_expiry();
+        bool is_call = (option.get_type() == Option::Type::Call);
+        return model.calculate_greeks(option.get_underlying().get_price(), option.get_strike(), T,
+                                      get_rate(option, T), get_vol(option, T), is_call);
+    }
+
+    bool has_environment() const { return env_ != nullptr; }
+
+private:
+    const MarketEnvironment* env_ = nullptr;
+    const YieldCurve* curve_ = nullptr;
+    std::string currency_;  // Currency of curve_
+    const std::string* currency_ptr_ = nullptr;  // Interned currency_ (first precomputed option's)
+    double flat_rate_ = 0.05;
+    double flat_vol_ = 0.20;
+
+    // Keyed by interned ticker pointer (see TickerTable)
+    std::unordered_map<const std::string*, const VolatilitySurface*> surfaces_;
+    std::unordered_map<double, CurvePoint> rates_by_expiry_;
+    // Expiry rates of options in other currencies, by interned currency pointer
+    std::unordered_map<const std::string*, std::unordered_map<double, CurvePoint>> foreign_rates_;
+
+    static CurvePoint make_curve_point(double rate, double T) { return {rate, std::exp(-rate * T)}; }
+
+    void precompute(const Option& option, double time_shift);
+};
+
+// ============================================================================
+// OPTION PRICER - Kernel selected once per batch
+// Resolves the model kind when constructed. For Black-Scholes, evaluate_batch
+// splits a batch by option type once and runs the call and put kernels
+// instantiated for exactly `Outputs` in two monomorphic loops: no model
+// dispatch, no indirect call and no is_call branch per option, and a
+// price-only run (simulation, stress, VaR) never computes a Greek. Other
+// models go through the virtual Model interface.
+// Build one per batch loop, next to the PricingContext it reads.
+// ============================================================================
+
+template <unsigned Outputs>
+class OptionPricer {
+public:
+    OptionPricer(const Model& model, const PricingContext& context)
+        : model_(model), context_(context), black_scholes_(model.get_kind() == ModelKind::BlackScholes) {}
+
+    PricingResult evaluate(const Option& option, double T,
+                           double vol_shift = 0.0, double rate_shift = 0.0) const {
+        if (!black_scholes_) return evaluate_model(option, T, vol_shift, rate_shift);
+        return option.get_type() == Option::Type::Call ? evaluate_kernel<true>(option, T, vol_shift, rate_shift)
+                                                       : evaluate_kernel<false>(option, T, vol_shift, rate_shift);
+    }
+
+    // Every option of a batch at its current time to expiry:
+    // sink(i, result) for i in [0, count), option_at(i) -> const Option&.
+    // Black-Scholes batches are split by type first, so sink sees all calls
+    // and then all puts
+    template <typename OptionAt, typename Sink>
+    void evaluate_batch(size_t count, OptionAt&& option_at, Sink&& sink,
+                        double vol_shift = 0.0, double rate_shift = 0.0) const {
+        if (!black_scholes_) {
+            for (size_t i = 0; i < count; ++i) {
+                const Option& option = option_at(i);
+                sink(i, evaluate_model(option, option.get_time_to_expiry(), vol_shift, rate_shift));
+            }
+            return;
+        }
+        std::vector<std::uint32_t> calls, puts;
+        calls.reserve(count);
+        puts.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            (option_at(i).get_type() == Option::Type::Call ? calls : puts).push_back(static_cast<std::uint32_t>(i));
+        }
+        for (auto i : calls) {
+            const Option& option = option_at(i);
+            sink(size_t(i), evaluate_kernel<true>(option, option.get_time_to_expiry(), vol_shift, rate_shift));
+        }
+        for (auto i : puts) {
+            const Option& option = option_at(i);
+            sink(size_t(i), evaluate_kernel<false>(option, option.get_time_to_expiry(), vol_shift, rate_shift));
+        }
+    }
+
+    // Same as evaluate_batch, at the caller's inputs: inputs_at(i) -> OptionInputs
+    // at the option's current time to expiry (the context is not read).
+    // Black-Scholes runs the kernels' array form over blocks of each type
+    template <typename OptionAt, typename InputsAt, typename Sink>
+    void evaluate_batch_at(size_t count, OptionAt&& option_at, InputsAt&& inputs_at, Sink&& sink) const {
+        if (!black_scholes_) {
+            for (size_t i = 0; i < count; ++i) sink(i, evaluate_model_at(option_at(i), inputs_at(i)));
+            return;
+        }
+        std::vector<std::uint32_t> calls, puts;
+        calls.reserve(count);
+        puts.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            (option_at(i).get_type() == Option::Type::Call ? calls : puts).push_back(static_cast<std::uint32_t>(i));
+        }
+        evaluate_block_at<true>(calls, option_at, inputs_at, sink);
+        evaluate_block_at<false>(puts, option_at, inputs_at, sink);
+    }
+
+    double price(const Option& option, double T, double vol_shift = 0.0, double rate_shift = 0.0) const {
+        static_assert((Outputs & kOutputPrice) != 0, "OptionPricer was not built for prices");
+        return evaluate(option, T, vol_shift, rate_shift).price;
+    }
+
+    // Mark at the option's current time to expiry (intrinsic value at expiry)
+    double mark(const Option& option) const {
+        double T = option.get_time_to_expiry();
+        if (T > 0) return price(option, T);
+        double S = option.get_underlying().get_price();
+        double K = option.get_strike();
+        return option.get_type() == Option::Type::Call ? std::max(0.0, S - K) : std::max(0.0, K - S);
+    }
+
+    Greeks greeks(const Option& option) const {
+        static_assert((Outputs & kOutputGreeks) != 0, "OptionPricer was not built for Greeks");
+        return evaluate(option, option.get_time_to_expiry()).greeks;
+    }
+
+private:
+    const Model& model_;
+    const PricingContext& context_;
+    bool black_scholes_;  // Else the virtual model path
+
+    // Unshifted rates use the context's cached discount factor
+    template <bool IsCall>
+    PricingResult evaluate_kernel(const Option& option, double T, double vol_shift, double rate_shift) const {
+        using Kernel = BlackScholesKernel<IsCall, Outputs>;
+        double S = option.get_underlying().get_price();
+        double sigma = context_.get_vol(option, T) + vol_shift;
+        CurvePoint point = context_.get_curve_point(option, T);
+        if (rate_shift != 0.0) return Kernel::evaluate(S, option.get_strike(), T, point.rate + rate_shift, sigma);
+        return Kernel::evaluate(S, option.get_strike(), T, point.rate, sigma, point.discount_factor);
+    }
+
+    // Gathers blocks of one option type into stack arrays for the array kernel
+    template <bool IsCall, typename OptionAt, typename InputsAt, typename Sink>
+    void evaluate_block_at(const std::vector<std::uint32_t>& indices, OptionAt& option_at, InputsAt& inputs_at,
+                           Sink& sink) const {
+        constexpr size_t kBlock = 256;
+        double S[kBlock], K[kBlock], T[kBlock], r[kBlock], sigma[kBlock], discount[kBlock], work[3 * kBlock];
+        PricingResult results[kBlock];
+        for (size_t first = 0; first < indices.size(); first += kBlock) {
+            size_t n = std::min(kBlock, indices.size() - first);
+            for (size_t j = 0; j < n; ++j) {
+                const Option& option = option_at(size_t(indices[first + j]));
+                OptionInputs inputs = inputs_at(size_t(indices[first + j]));
+                S[j] = option.get_underlying().get_price();
+                K[j] = option.get_strike();
+                T[j] = option.get_time_to_expiry();
+                r[j] = inputs.curve.rate;
+                sigma[j] = inputs.vol;
+                discount[j] = inputs.curve.discount_factor;
+            }
+            BlackScholesKernel<IsCall, Outputs>::evaluate_batch(n, S, K, T, r, sigma, discount, work, results);
+            for (size_t j = 0; j < n; ++j) sink(size_t(indices[first + j]), results[j]);
+        }
+    }
+
+    PricingResult evaluate_model_at(const Option& option, const OptionInputs& inputs) const {
+        double S = option.get_underlying().get_price();
+        double K = option.get_strike();
+        double T = option.get_time_to_expiry();
+        bool is_call = (option.get_type() == Option::Type::Call);
+        PricingResult out;
+        if constexpr ((Outputs & kOutputPrice) != 0) out.price = model_.price_option(S, K, T, inputs.curve.rate, inputs.vol, is_call);
+        if constexpr ((Outputs & kOutputGreeks) != 0) out.greeks = model_.calculate_greeks(S, K, T, inputs.curve.rate, inputs.vol, is_call);
+        return out;
+    }
+
+    PricingResult evaluate_model(const Option& option, double T, double vol_shift, double rate_shift) const {
+        double S = option.get_underlying().get_price();
+        double K = option.get_strike();
+        double r = context_.get_rate(option, T) + rate_shift;
+        double sigma = context_.get_vol(option, T) + vol_shift;
+        bool is_call = (option.get_type() == Option::Type::Call);
+        PricingResult out;
+        if constexpr ((Outputs & kOutputPrice) != 0) out.price = model_.price_option(S, K, T, r, sigma, is_call);
+        if constexpr ((Outputs & kOutputGreeks) != 0) out.greeks = model_.calculate_greeks(S, K, T, r, sigma, is_call);
+        return out;
+    }
+};
+
+#endif
@@ -0,0 +1,42 @@
+// Header file for multi-process sharding
+// Runs shards of a job in local worker processes and collects their
+// serialized partial results over pipes - no external services
+
+#ifndef PROCESS_SHARDS_H
+#define PROCESS_SHARDS_H
+
+#include <vector>
+#include <functional>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include "snapshot.hh"
+
+// ============================================================================
+// PROCESS SHARDS
+// run_process_shards forks one worker per shard (POSIX). Each worker
+// inherits the caller's state copy-on-write - market, portfolios, models -
+// so nothing has to be shipped in; it runs work(shard, out) and streams the
+// SnapshotWriter buffer back over its own pipe. The coordinator drains all
+// pipes concurrently (a worker never blocks on a full pipe), reaps the
+// workers and returns the buffers in shard order, so the caller merges them
+// deterministically whatever order the workers finished in.
+// A worker that throws, or dies, makes the whole call throw with its
+// message; results are all or nothing. Fork only from a single-threaded
+// point (no parallel_for in flight). Without fork (non-POSIX) the shards
+// run one after another in this process.
+// ============================================================================
+
+using ShardWork = std::function<void(size_t shard, SnapshotWriter& out)>;
+
+std::vector<std::vector<char>> run_process_shards(size_t num_shards, const ShardWork& work);
+
+// Contiguous range [begin, end) of `count` items for one of `num_shards`
+// shards (earlier shards take the remainder)
+inline std::pair<size_t, size_t> shard_range(size_t count, size_t num_shards, size_t shard) {
+    size_t base = count / num_shards, extra = count % num_shards;
+    size_t begin = shard * base + std::min(shard, extra);
+    return {begin, begin + base + (shard < extra ? 1 : 0)};
+}
+
+#endif
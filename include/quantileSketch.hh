@@ -0,0 +1,242 @@
+// Header file for the mergeable quantile sketch
+// Streams values into bounded memory and answers quantiles within a fixed
+// relative error; sketches built on separate threads or processes merge
+// exactly
+
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
+#include <utility>
+#include "normalMath.hh"
+
+// ============================================================================
+// QUANTILE SKETCH - Logarithmic buckets (DDSketch)
+// Bucket i counts magnitudes in (gamma^(i-1), gamma^i], gamma = (1+a)/(1-a),
+// and reports 2 gamma^i / (gamma + 1): within relative error a of every
+// value it holds, so any quantile comes back within a of the exact order
+// statistic. Positive and negative values have separate stores, zeros a
+// counter. A store is a dense counter array over the span of indices seen.
+// Merging adds counters, so it is exact, associative and commutative:
+// merging per-thread or per-shard sketches in any order gives the same
+// sketch as adding every value to one.
+// Memory is bounded by max_buckets per store: past that, the smallest
+// magnitudes are folded into the lowest kept bucket (they lose their
+// accuracy guarantee, the tails - what VaR and PFE read - keep theirs).
+// The fold depends only on the largest index seen, so merging stays exact.
+// quantile_bounds() gives the interval the exact order statistic is
+// guaranteed to lie in (open at zero for buckets that took folded values),
+// so a VaR read off a sketch comes with an explicit error bound.
+// ============================================================================
+
+class QuantileSketch {
+    friend class SnapshotCodec;
+
+public:
+    explicit QuantileSketch(double relative_accuracy = 0.01, size_t max_buckets = 2048)
+        : relative_accuracy_(relative_accuracy), max_buckets_(max_buckets) {
+        if (!(relative_accuracy > 0.0 && relative_accuracy < 1.0)) {
+            throw std::invalid_argument("QuantileSketch: relative accuracy must be in (0, 1)");
+        }
+        if (max_buckets < 1) throw std::invalid_argument("QuantileSketch: need at least one bucket");
+        gamma_ = (1.0 + relative_accuracy) / (1.0 - relative_accuracy);
+        inv_log_gamma_ = 1.0 / std::log(gamma_);
+    }
+
+    void add(double value, std::uint64_t count = 1) {
+        if (value > kMinIndexable) {
+            positive_.add(index_of(value), count, max_buckets_);
+        } else if (value < -kMinIndexable) {
+            negative_.add(index_of(-value), count, max_buckets_);
+        } else {
+            zero_count_ += count;
+        }
+        count_ += count;
+    }
+
+    void merge(const QuantileSketch& other) {
+        if (other.gamma_ != gamma_) throw std::invalid_argument("QuantileSketch: merging different accuracies");
+        positive_.merge(other.positive_, max_buckets_);
+        negative_.merge(other.negative_, max_buckets_);
+        zero_count_ += other.zero_count_;
+        count_ += other.count_;
+    }
+
+    // Value at rank q (count - 1), q in [0, 1]; NaN when empty
+    double quantile(double q) const {
+        if (count_ == 0) return std::numeric_limits<double>::quiet_NaN();
+        Bucket bucket = locate(rank_of(q));
+        return bucket.sign == 0 ? 0.0 : bucket.sign * value_of(bucket.index);
+    }
+
+    // [lower, upper] holding the exact value at rank q (count - 1): the
+    // reported quantile is within the relative accuracy of both ends unless
+    // the bucket took folded values (lower end then 0); NaNs when empty
+    std::pair<double, double> quantile_bounds(double q) const {
+        if (count_ == 0) {
+            double nan = std::numeric_limits<double>::quiet_NaN();
+            return {nan, nan};
+        }
+        Bucket bucket = locate(rank_of(q));
+        if (bucket.sign == 0) return {-kMinIndexable, kMinIndexable};
+        const Store& store = bucket.sign > 0 ? positive_ : negative_;
+        double upper = std::pow(gamma_, bucket.index);
+        double lower = bucket.index <= store.folded_top ? 0.0 : upper / gamma_;
+        if (bucket.sign > 0) return {lower, upper};
+        return {-upper, -lower};
+    }
+
+    // Mean of the lowest max(1, floor(q count)) values - the expected
+    // shortfall of a P&L sketch at confidence 1 - q is -lower_tail_mean(q).
+    // Every value is represented within the relative accuracy, so the mean
+    // is within it of the exact tail mean when the tail has one sign; NaN
+    // when empty
+    double lower_tail_mean(double q) const {
+        if (count_ == 0) return std::numeric_limits<double>::quiet_NaN();
+        q = std::min(std::max(q, 0.0), 1.0);
+        auto tail = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(q * count_));
+
+        std::uint64_t remaining = tail;
+        double sum = 0.0;
+        auto take = [&](std::uint64_t count, double value) {
+            std::uint64_t n = std::min(count, remaining);
+            sum += static_cast<double>(n) * value;
+            remaining -= n;
+        };
+        for (size_t k = negative_.counts.size(); k-- > 0 && remaining > 0;) {
+            take(negative_.counts[k], -value_of(negative_.offset + static_cast<int>(k)));
+        }
+        take(zero_count_, 0.0);
+        for (size_t k = 0; k < positive_.counts.size() && remaining > 0; ++k) {
+            take(positive_.counts[k], value_of(positive_.offset + static_cast<int>(k)));
+        }
+        return sum / static_cast<double>(tail);
+    }
+
+    std::uint64_t count() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    double get_relative_accuracy() const { return relative_accuracy_; }
+    size_t get_max_buckets() const { return max_buckets_; }
+    size_t num_buckets() const { return positive_.counts.size() + negative_.counts.size(); }
+
+    void clear() {
+        positive_ = Store{};
+        negative_ = Store{};
+        zero_count_ = 0;
+        count_ = 0;
+    }
+
+private:
+    // Below this magnitude values count as zero (keeps indices in int range)
+    static constexpr double kMinIndexable = 1e-300;
+    static constexpr int kNoFold = std::numeric_limits<int>::min();
+
+    // Counters for bucket indices [offset, offset + counts.size())
+    struct Store {
+        int offset = 0;
+        int folded_top = kNoFold;  // Highest bucket that took folded values
+        std::vector<std::uint64_t> counts;
+
+        void add(int index, std::uint64_t count, size_t max_buckets) {
+            if (counts.empty()) {
+                offset = index;
+                counts.assign(1, count);
+                return;
+            }
+            int top = offset + static_cast<int>(counts.size()) - 1;
+            if (index > top) {
+                counts.resize(counts.size() + (index - top), 0);
+                fold(max_buckets);
+            } else if (index < offset) {
+                if (counts.size() < max_buckets) {
+                    size_t grow = std::min<size_t>(offset - index, max_buckets - counts.size());
+                    counts.insert(counts.begin(), grow, 0);
+                    offset -= static_cast<int>(grow);
+                }
+                if (index < offset) {  // Below the kept span: lowest bucket
+                    index = offset;
+                    folded_top = std::max(folded_top, offset);
+                }
+            }
+            counts[index - offset] += count;
+        }
+
+        void merge(const Store& other, size_t max_buckets) {
+            if (other.counts.empty()) return;
+            // Highest bucket first, so the span (and the fold) is set once
+            for (size_t k = other.counts.size(); k-- > 0;) {
+                if (other.counts[k] != 0 || k + 1 == other.counts.size()) {
+                    add(other.offset + static_cast<int>(k), other.counts[k], max_buckets);
+                }
+            }
+            if (other.folded_top != kNoFold) {
+                folded_top = std::max(folded_top, std::max(other.folded_top, offset));
+            }
+        }
+
+        // Keep the top max_buckets indices, fold the rest into the lowest kept
+        void fold(size_t max_buckets) {
+            if (counts.size() <= max_buckets) return;
+            size_t excess = counts.size() - max_buckets;
+            std::uint64_t folded = 0;
+            for (size_t k = 0; k <= excess; ++k) folded += counts[k];
+            counts.erase(counts.begin(), counts.begin() + excess);
+            counts[0] = folded;
+            offset += static_cast<int>(excess);
+            folded_top = std::max(folded_top, offset);
+        }
+    };
+
+    // Bucket holding a rank: sign of the values (0: the zero counter) and index
+    struct Bucket {
+        int sign;
+        int index;
+    };
+
+    double relative_accuracy_;
+    size_t max_buckets_;
+    double gamma_;
+    double inv_log_gamma_;
+    Store positive_;
+    Store negative_;
+    std::uint64_t zero_count_ = 0;
+    std::uint64_t count_ = 0;
+
+    std::uint64_t rank_of(double q) const {
+        q = std::min(std::max(q, 0.0), 1.0);
+        return static_cast<std::uint64_t>(q * (count_ - 1));
+    }
+
+    // Most negative first: negative store from its largest magnitude down
+    Bucket locate(std::uint64_t rank) const {
+        std::uint64_t seen = 0;
+        for (size_t k = negative_.counts.size(); k-- > 0;) {
+            seen += negative_.counts[k];
+            if (seen > rank) return {-1, negative_.offset + static_cast<int>(k)};
+        }
+        seen += zero_count_;
+        if (seen > rank || positive_.counts.empty()) return {0, 0};
+        size_t k = 0;
+        for (; k + 1 < positive_.counts.size(); ++k) {
+            seen += positive_.counts[k];
+            if (seen > rank) break;
+        }
+        return {1, positive_.offset + static_cast<int>(k)};
+    }
+
+    int index_of(double magnitude) const {
+        return static_cast<int>(std::ceil(fast_log(magnitude) * inv_log_gamma_));
+    }
+
+    double value_of(int index) const {
+        return 2.0 * std::pow(gamma_, index) / (gamma_ + 1.0);
+    }
+};
+
+#endif
@@ -0,0 +1,100 @@
+// Header file for the published risk results store
+// Lets reporting threads read portfolio values and Greeks while the
+// simulator keeps running, without locks and without torn reads
+
+#ifndef RESULTS_STORE_H
+#define RESULTS_STORE_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include "model.hh"
+
+// One immutable epoch of results, produced by MarketSimulator::publish_results
+struct PortfolioResult {
+    std::string owner;
+    std::string currency;  // Reporting currency of value and pnl
+    double value = 0.0;
+    double pnl = 0.0;
+    Greeks greeks;
+};
+
+struct RiskResults {
+    std::uint64_t epoch = 0;  // Strictly increasing per publish
+    unsigned day = 0;         // Simulation day the results were taken at
+    std::vector<PortfolioResult> portfolios;
+    Greeks total_greeks;
+};
+
+// ============================================================================
+// RESULTS STORE - RCU-style publication
+// The writer builds each epoch off to the side, then swaps a single atomic
+// pointer; an epoch is never modified once published. Readers pin the
+// current epoch in a hazard slot (a CAS to claim a free slot, then a
+// load/store/re-check loop that only retries if a publish raced it), so
+// reads never take a lock and never wait for the simulator.
+// Retired epochs are freed by the writer once no slot pins them.
+// ============================================================================
+
+class ResultsStore {
+public:
+    static constexpr size_t kMaxReaders = 64;  // Concurrently held views
+
+    // Pinned, consistent view of one epoch; release by destruction
+    class View {
+    public:
+        View() = default;
+        View(View&& other) noexcept;
+        View& operator=(View&& other) noexcept;
+        View(const View&) = delete;
+        View& operator=(const View&) = delete;
+        ~View() { release(); }
+
+        explicit operator bool() const { return results_ != nullptr; }
+        const RiskResults& operator*() const { return *results_; }
+        const RiskResults* operator->() const { return results_; }
+
+        void release();
+
+    private:
+        friend class ResultsStore;
+        View(std::atomic<const RiskResults*>* slot, const RiskResults* results)
+            : slot_(slot), results_(results) {}
+
+        std::atomic<const RiskResults*>* slot_ = nullptr;
+        const RiskResults* results_ = nullptr;
+    };
+
+    ResultsStore() = default;
+    ~ResultsStore();
+
+    ResultsStore(const ResultsStore&) = delete;
+    ResultsStore& operator=(const ResultsStore&) = delete;
+
+    // Lock-free; empty view if nothing was published yet.
+    // Throws if kMaxReaders views are already held
+    View read() const;
+
+    // Takes ownership; stamps the epoch. Writers serialize among themselves
+    void publish(RiskResults results);
+
+    std::uint64_t get_epoch() const { return epoch_.load(std::memory_order_acquire); }
+
+private:
+    struct alignas(64) Slot {  // One cache line each, so readers don't false-share
+        std::atomic<const RiskResults*> pinned{nullptr};
+    };
+
+    std::atomic<const RiskResults*> current_{nullptr};
+    std::atomic<std::uint64_t> epoch_{0};
+    mutable Slot slots_[kMaxReaders];
+
+    std::mutex writer_mutex_;                // Writers only
+    std::vector<const RiskResults*> retired_;
+
+    void reclaim();
+};
+
+#endif
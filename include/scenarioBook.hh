@@ -0,0 +1,112 @@
+// Header file for portfolios flattened for scenario revaluation
+// Shared by the engines that revalue many portfolios on simulated paths
+// (exposure profiles, scenario VaR)
+
+#ifndef SCENARIO_BOOK_H
+#define SCENARIO_BOOK_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstddef>
+#include "model.hh"
+#include "marketEnvironment.hh"
+#include "portfolio.hh"
+
+// ============================================================================
+// SCENARIO BOOK
+// Collects the factors to simulate - every underlying, and the FX factor of
+// every non-base currency involved (instrument or reporting), at today's
+// spots - and flattens the portfolios: one revaluation row per distinct
+// instrument, however many portfolios hold it, and per portfolio its
+// (row, quantity) terms. Option vols and rates are looked up once per
+// (option, date), so revaluation does no surface or curve lookups.
+// Factors are indexed in ticker order, the order of get_initial_prices()
+// and of the simulators' path state.
+// Revaluation at a date, in the base currency at the path's FX:
+//   stock   price * S_t / S_0
+//   option  Black-Scholes at the path spot, the remaining time to expiry
+//           and the surface's vol and the underlying's curve's rate for it;
+//           0 once expired
+//   bond    held at today's price (rates are not simulated)
+// ============================================================================
+
+class ScenarioBook {
+public:
+    static constexpr std::uint32_t kNone = ~std::uint32_t(0);
+
+    struct Term {
+        std::uint32_t instrument;
+        double quantity;
+    };
+
+    // Dates in years from today (0 values the book at today's spots)
+    ScenarioBook(const std::vector<Portfolio>& portfolios, const MarketEnvironment& env,
+                 const std::vector<double>& dates);
+
+    // Instrument value in the base currency on one path; spot(f) returns
+    // the simulated spot of factor f
+    template <typename SpotOf>
+    double value(size_t instrument, size_t date, const SpotOf& spot) const {
+        const Revaluation& row = instruments_[instrument];
+        double local;
+        if (row.factor == kNone) {
+            local = row.strike;
+        } else if (row.option == kNone) {
+            local = spot(row.factor) * row.scale;
+        } else {
+            const OptionParams& option = option_params_[row.option * dates_.size() + date];
+            if (option.tau <= 0.0) {
+                local = 0.0;
+            } else {
+                double S = spot(row.factor) * row.scale;
+                local = row.is_call
+                    ? BlackScholesKernel<true, kOutputPrice>::evaluate(S, row.strike, option.tau, option.rate, option.vol).price
+                    : BlackScholesKernel<false, kOutputPrice>::evaluate(S, row.strike, option.tau, option.rate, option.vol).price;
+            }
+        }
+        return row.fx == kNone ? local : local * spot(row.fx);
+    }
+
+    const Term* terms_begin(size_t portfolio) const { return terms_.data() + term_begin_[portfolio]; }
+    const Term* terms_end(size_t portfolio) const { return terms_.data() + term_begin_[portfolio + 1]; }
+
+    // FX factor of the portfolio's reporting currency: base currency values
+    // are divided by its spot (kNone: reports in the base currency)
+    std::uint32_t get_reporting_fx(size_t portfolio) const { return reporting_fx_[portfolio]; }
+
+    const std::map<std::string, double>& get_initial_prices() const { return initial_; }
+    size_t num_factors() const { return initial_.size(); }
+    size_t num_instruments() const { return instruments_.size(); }
+    size_t num_portfolios() const { return reporting_fx_.size(); }
+    size_t num_dates() const { return dates_.size(); }
+    double get_date(size_t date) const { return dates_[date]; }
+
+private:
+    // One distinct instrument
+    struct Revaluation {
+        std::uint32_t factor;  // Simulated spot driving the value (kNone: constant)
+        std::uint32_t fx;      // FX factor of the instrument's currency (kNone: base)
+        std::uint32_t option;  // Options: row of the per-date vol/rate table (else kNone)
+        bool is_call;
+        double scale;          // Instrument price per unit of simulated spot
+        double strike;         // Options: strike; constants: value
+    };
+
+    struct OptionParams {
+        double tau;
+        double rate;
+        double vol;
+    };
+
+    std::vector<double> dates_;
+    std::map<std::string, double> initial_;
+    std::vector<Revaluation> instruments_;
+    std::vector<OptionParams> option_params_;  // [option][date]
+    std::vector<Term> terms_;                  // Per portfolio (CSR)
+    std::vector<size_t> term_begin_;
+    std::vector<std::uint32_t> reporting_fx_;
+};
+
+#endif
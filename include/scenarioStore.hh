@@ -0,0 +1,159 @@
+// Header file for the shared-memory scenario store
+// One process simulates a scenario cube into a POSIX shared-memory segment;
+// any number of analytics processes map it read-only, without copying or
+// regenerating the scenarios
+
+#ifndef SCENARIO_STORE_H
+#define SCENARIO_STORE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include "model.hh"
+
+class MarketEnvironment;
+
+// ============================================================================
+// SEGMENT LAYOUT
+// Self-describing, so a reader needs nothing but the segment name:
+//   header   ScenarioStoreHeader (magic, version, byte-order mark, element
+//            size, layout, counts, section offsets, ready flag)
+//   tickers  per asset: uint32 length, then the characters
+//   dates    num_dates doubles (years, on the simulation's step grid)
+//   prices   the [date][path][asset] cube of float or double, 64-byte aligned
+// The publisher fills the segment, then sets `ready` (release); readers
+// check it (acquire), so a segment is never read half-written. Bump
+// kScenarioStoreVersion on ANY layout change - old segments are rejected.
+// ============================================================================
+
+constexpr char kScenarioStoreMagic[8] = {'R', 'S', 'K', 'S', 'C', 'E', 'N', '\0'};
+constexpr std::uint32_t kScenarioStoreVersion = 1;
+constexpr std::uint32_t kScenarioStoreByteOrderMark = 0x01020304;
+
+enum class ScenarioLayout : std::uint32_t { DatePathAsset = 0 };
+
+struct ScenarioStoreHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint32_t element_size;   // 4 (float) or 8 (double)
+    ScenarioLayout layout;
+    std::uint64_t num_assets;
+    std::uint64_t num_dates;
+    std::uint64_t num_paths;
+    std::uint64_t tickers_offset;
+    std::uint64_t dates_offset;
+    std::uint64_t prices_offset;
+    std::uint64_t total_size;
+    std::atomic<std::uint32_t> ready;
+};
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free,
+              "The ready flag must be lock-free to live in shared memory");
+
+// ============================================================================
+// SHARED SCENARIO STORE - Publisher side
+// Owns the segment: creates it (failing if the name is taken), and unlinks
+// it on destruction unless detach() was called. Processes that already
+// mapped it keep their view after the unlink.
+// Names follow shm_open: a leading '/', no other slashes.
+// ============================================================================
+
+class SharedScenarioStore {
+public:
+    // Simulates a cube of `num_paths` paths at `dates` straight into a new
+    // segment (no private copy of the cube) and publishes it
+    template <typename Real>
+    static SharedScenarioStore publish(const std::string& name, MultiAssetSimulator& simulator,
+                                       const std::map<std::string, double>& initial_prices,
+                                       const std::vector<double>& dates, size_t num_paths,
+                                       size_t steps_per_year, const MarketEnvironment& env);
+
+    // Copies an already simulated cube into a new segment and publishes it
+    template <typename Real>
+    static SharedScenarioStore publish(const std::string& name, const ScenarioCube<Real>& cube);
+
+    SharedScenarioStore(SharedScenarioStore&& other) noexcept;
+    SharedScenarioStore& operator=(SharedScenarioStore&& other) noexcept;
+    SharedScenarioStore(const SharedScenarioStore&) = delete;
+    SharedScenarioStore& operator=(const SharedScenarioStore&) = delete;
+    ~SharedScenarioStore() { release(); }
+
+    const std::string& get_name() const { return name_; }
+    size_t size() const { return size_; }
+
+    // Leave the segment for consumers started later; remove it with remove()
+    void detach() { owned_ = false; }
+    static void remove(const std::string& name);
+
+private:
+    std::string name_;
+    void* base_ = nullptr;
+    size_t size_ = 0;
+    bool owned_ = true;
+
+    SharedScenarioStore(const std::string& name, const std::vector<std::string>& tickers,
+                        size_t num_dates, size_t num_paths, size_t element_size);
+
+    ScenarioStoreHeader& header() const { return *static_cast<ScenarioStoreHeader*>(base_); }
+    void* prices() const { return static_cast<char*>(base_) + header().prices_offset; }
+    void set_ready(const std::vector<double>& dates);
+    void release();
+};
+
+// ============================================================================
+// SCENARIO STORE VIEW - Reader side
+// Maps a published segment read-only and validates its header; prices are
+// read in place (zero-copy). Tickers and dates are decoded once.
+// ============================================================================
+
+class ScenarioStoreView {
+public:
+    explicit ScenarioStoreView(const std::string& name);
+
+    ScenarioStoreView(ScenarioStoreView&& other) noexcept;
+    ScenarioStoreView& operator=(ScenarioStoreView&& other) noexcept;
+    ScenarioStoreView(const ScenarioStoreView&) = delete;
+    ScenarioStoreView& operator=(const ScenarioStoreView&) = delete;
+    ~ScenarioStoreView() { release(); }
+
+    const std::vector<std::string>& get_tickers() const { return tickers_; }
+    const std::vector<double>& get_dates() const { return dates_; }
+    size_t num_assets() const { return tickers_.size(); }
+    size_t num_dates() const { return dates_.size(); }
+    size_t num_paths() const { return num_paths_; }
+    size_t get_element_size() const { return element_size_; }
+    size_t get_asset_index(const std::string& ticker) const;  // Throws if absent
+
+    // Whole cube, [date][path][asset]; Real must match the stored precision
+    template <typename Real>
+    const Real* get_prices() const {
+        static_assert(std::is_same<Real, float>::value || std::is_same<Real, double>::value,
+                      "Scenario stores hold float or double");
+        if (sizeof(Real) != element_size_) throw std::invalid_argument("ScenarioStoreView: precision mismatch");
+        return static_cast<const Real*>(prices_);
+    }
+
+    template <typename Real>
+    const Real* get_path(size_t date, size_t path) const {
+        return get_prices<Real>() + (date * num_paths_ + path) * tickers_.size();
+    }
+
+private:
+    const void* base_ = nullptr;
+    size_t size_ = 0;
+    const void* prices_ = nullptr;
+    size_t element_size_ = 0;
+    size_t num_paths_ = 0;
+    std::vector<std::string> tickers_;
+    std::vector<double> dates_;
+
+    void release();
+};
+
+#endif
@@ -0,0 +1,115 @@
+// Header file for the streaming scenario VaR engine
+// VaR and expected shortfall per portfolio over simulated scenarios, from
+// mergeable quantile sketches instead of the sorted P&L vector
+
+#ifndef SCENARIO_VAR_H
+#define SCENARIO_VAR_H
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include "model.hh"
+#include "marketEnvironment.hh"
+#include "portfolio.hh"
+#include "quantileSketch.hh"
+#include "scenarioBook.hh"
+
+// ============================================================================
+// SCENARIO VAR ENGINE
+// Scenarios are the correlated terminal prices of simulate_terminal_prices
+// at the horizon, generated in blocks: block b is seeded seed + b, so any
+// block (or range of blocks) can be evaluated anywhere and gives the same
+// P&L. Each portfolio's P&L - horizon value less today's, both revalued as
+// in ScenarioBook, in its reporting currency - streams into a
+// QuantileSketch; nothing per scenario is kept, so memory is independent of
+// the scenario count.
+// Blocks run in parallel, each thread adding into its own partial sketches,
+// merged at the end. Merging is exact and order-independent, so the
+// results depend on the seed and block size only - not on the thread count,
+// nor on how blocks were split across run() calls, engines or processes
+// (merge() adds a shard's sketches). run_sharded() splits the blocks over
+// forked worker processes and merges their sketches back in shard order:
+// the same results as run(), with each worker's memory its own.
+// VaR and ES are within the sketch's relative accuracy of the exact
+// order-statistic figures on the same scenarios; get_var_bounds() gives
+// the interval the exact VaR lies in.
+// The model's explicit step is called from several threads: models that
+// draw inside a step (JumpDiffusionModel's jumps) need num_threads = 1.
+// The market environment must outlive the engine.
+// ============================================================================
+
+struct ScenarioVaRSettings {
+    double horizon = 10.0 / 252.0;    // Years
+    size_t num_scenarios = 100000;
+    size_t block_scenarios = 4096;    // Scenarios per block: one seed each
+    size_t steps_per_year = 252;
+    double relative_accuracy = 0.01;  // Of VaR and ES
+    size_t max_buckets = 2048;        // Per sketch
+    size_t num_threads = 0;           // 0 = all hardware threads
+    unsigned seed = 42;
+};
+
+class ScenarioVaREngine {
+public:
+    ScenarioVaREngine(Model& model, const MarketEnvironment& env,
+                      const std::vector<Portfolio>& portfolios, const ScenarioVaRSettings& settings);
+
+    size_t num_blocks() const {
+        return (settings_.num_scenarios + settings_.block_scenarios - 1) / settings_.block_scenarios;
+    }
+
+    // Evaluates blocks [block_begin, block_end) into the sketches
+    void run(size_t block_begin, size_t block_end);
+    void run() { run(0, num_blocks()); }
+
+    // All blocks across num_processes local worker processes (contiguous
+    // block ranges); each worker gets an equal share of the threads unless
+    // num_threads is set
+    void run_sharded(size_t num_processes);
+
+    // Adds a shard's results: same portfolios and settings, disjoint blocks
+    void merge(const ScenarioVaREngine& other);
+    void merge(size_t portfolio, const QuantileSketch& partial);
+    void reset();
+
+    // P&L of every scenario of one block, [portfolio][scenario] - the
+    // scenarios behind the sketches, for drill-down and validation
+    void block_pnl(size_t block, std::vector<double>& pnl) const;
+
+    // VaR: loss not exceeded with the given confidence (positive = loss)
+    double get_var(size_t portfolio, double confidence = 0.99) const {
+        return -sketches_[portfolio].quantile(1.0 - confidence);
+    }
+
+    // [lower, upper] holding the exact order-statistic VaR
+    std::pair<double, double> get_var_bounds(size_t portfolio, double confidence = 0.99) const {
+        auto [lower, upper] = sketches_[portfolio].quantile_bounds(1.0 - confidence);
+        return {-upper, -lower};
+    }
+
+    // ES: mean loss over the worst (1 - confidence) of the scenarios
+    double get_expected_shortfall(size_t portfolio, double confidence = 0.99) const {
+        return -sketches_[portfolio].lower_tail_mean(1.0 - confidence);
+    }
+
+    const QuantileSketch& get_pnl_sketch(size_t portfolio) const { return sketches_[portfolio]; }
+    std::uint64_t num_scenarios_run() const { return sketches_.empty() ? 0 : sketches_[0].count(); }
+    double get_base_value(size_t portfolio) const { return base_values_[portfolio]; }  // Reporting currency
+    size_t num_portfolios() const { return sketches_.size(); }
+    const ScenarioVaRSettings& get_settings() const { return settings_; }
+
+private:
+    Model& model_;
+    const MarketEnvironment& env_;
+    ScenarioVaRSettings settings_;
+    ScenarioBook book_;                     // Dates: today, horizon
+    std::vector<double> base_values_;       // [portfolio]
+    std::vector<QuantileSketch> sketches_;  // [portfolio]
+
+    // f(portfolio, scenario, pnl) for every scenario of the block
+    template <typename F>
+    void evaluate_block(size_t block, F&& f) const;
+};
+
+#endif
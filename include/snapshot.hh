@@ -0,0 +1,217 @@
+// Header file for binary snapshots of the simulator state
+// Versioned, little-endian flat format: fast restart and forking of intraday
+// jobs from a common market/portfolio state
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+class MarketSimulator;
+class MarketEnvironment;
+class CorrelationMatrix;
+class StructuredCorrelation;
+class CorrelationRegimes;
+class YieldCurve;
+class VolatilitySurface;
+class DividendCurve;
+class InstrumentRegistry;
+class Portfolio;
+class QuantileSketch;
+
+// ============================================================================
+// FORMAT
+// Header: magic, version, byte-order mark. Then the sections in fixed order:
+// environment, registry, portfolios, simulator state. Arrays of doubles
+// (correlation matrices, Cholesky factors, curves) are stored as raw blocks,
+// so restoring them is a single memcpy out of the mapped file. Bump
+// kSnapshotVersion on ANY layout change - old snapshots are rejected, never
+// reinterpreted.
+//
+// LIMITATION: restore is O(N) in instruments and positions, not a mapping.
+// Instruments hold interned ticker pointers and options point at their
+// underlying Stock, so the registry is rebuilt by re-adding every instrument
+// (ticker interning, id index, dependent-option lists). Positions are
+// re-validated and copied one by one. Only the double blocks are bulk
+// copies. Pool memory is never mapped in place. bench/snapshot measures
+// ~25 ns per position for 1M positions.
+// ============================================================================
+
+constexpr char kSnapshotMagic[8] = {'R', 'S', 'K', 'S', 'N', 'A', 'P', '\0'};
+constexpr std::uint32_t kSnapshotVersion = 2;
+constexpr std::uint32_t kSnapshotByteOrderMark = 0x01020304;
+
+// Append-only binary buffer
+class SnapshotWriter {
+public:
+    template <typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "write() takes trivially copyable values");
+        write_bytes(&value, sizeof(T));
+    }
+
+    void write_size(size_t n) { write(static_cast<std::uint64_t>(n)); }
+
+    void write_string(const std::string& s) {
+        write_size(s.size());
+        write_bytes(s.data(), s.size());
+    }
+
+    // Length-prefixed raw block
+    template <typename T>
+    void write_array(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "write_array() takes trivially copyable values");
+        write_size(values.size());
+        write_bytes(values.data(), values.size() * sizeof(T));
+    }
+
+    void write_strings(const std::vector<std::string>& values) {
+        write_size(values.size());
+        for (const auto& s : values) write_string(s);
+    }
+
+    void write_bytes(const void* data, size_t n) {
+        const char* p = static_cast<const char*>(data);
+        buffer_.insert(buffer_.end(), p, p + n);
+    }
+
+    const std::vector<char>& get_buffer() const { return buffer_; }
+
+    // Writes to a temporary file and renames it over `path`, so a crash
+    // mid-write never leaves a truncated snapshot behind
+    void save(const std::string& path) const;
+
+private:
+    std::vector<char> buffer_;
+};
+
+// Bounds-checked cursor over a snapshot image (usually memory-mapped)
+class SnapshotReader {
+public:
+    SnapshotReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable<T>::value, "read() returns trivially copyable values");
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    size_t read_size() {
+        auto n = read<std::uint64_t>();
+        if (n > size_) throw std::runtime_error("Corrupt snapshot: bad length");
+        return static_cast<size_t>(n);
+    }
+
+    std::string read_string() {
+        size_t n = read_size();
+        return std::string(take(n), n);
+    }
+
+    template <typename T>
+    std::vector<T> read_array() {
+        size_t n = read_size();
+        std::vector<T> values(n);
+        if (n > 0) std::memcpy(values.data(), take(n * sizeof(T)), n * sizeof(T));
+        return values;
+    }
+
+    std::vector<std::string> read_strings() {
+        std::vector<std::string> values(read_size());
+        for (auto& s : values) s = read_string();
+        return values;
+    }
+
+    bool at_end() const { return pos_ == size_; }
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t pos_ = 0;
+
+    const char* take(size_t n) {
+        if (n > size_ - pos_) throw std::runtime_error("Corrupt snapshot: truncated");
+        const char* p = data_ + pos_;
+        pos_ += n;
+        return p;
+    }
+};
+
+// Read-only view of a whole file: mmap on POSIX, buffered read elsewhere
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<char> fallback_;
+};
+
+// ============================================================================
+// SNAPSHOT CODEC - (De)serialization of every snapshotted class
+// Friend of those classes, so the format lives in one place (snapshot.cpp)
+// instead of being spread across the market data headers.
+// ============================================================================
+
+class SnapshotCodec {
+public:
+    static void write(SnapshotWriter& out, const MarketSimulator& sim);
+    static void read(SnapshotReader& in, MarketSimulator& sim);
+
+    static void write(SnapshotWriter& out, const MarketEnvironment& env);
+    static void read(SnapshotReader& in, MarketEnvironment& env);
+
+    static void write(SnapshotWriter& out, const InstrumentRegistry& registry);
+    static void read(SnapshotReader& in, InstrumentRegistry& registry);
+
+    static void write(SnapshotWriter& out, const Portfolio& portfolio);
+    static void read(SnapshotReader& in, Portfolio& portfolio);
+
+    // Also the wire format of partial risk results between processes
+    static void write(SnapshotWriter& out, const QuantileSketch& sketch);
+    static void read(SnapshotReader& in, QuantileSketch& sketch);
+
+private:
+    static void write(SnapshotWriter& out, const CorrelationMatrix& corr);
+    static void read(SnapshotReader& in, CorrelationMatrix& corr);
+
+    static void write(SnapshotWriter& out, const StructuredCorrelation& corr);
+    static void read(SnapshotReader& in, StructuredCorrelation& corr);
+
+    static void write(SnapshotWriter& out, const CorrelationRegimes& regimes);
+    static void read(SnapshotReader& in, CorrelationRegimes& regimes);
+
+    static void write(SnapshotWriter& out, const YieldCurve& curve);
+    static void read(SnapshotReader& in, YieldCurve& curve);
+
+    static void write(SnapshotWriter& out, const VolatilitySurface& surface);
+    static void read(SnapshotReader& in, VolatilitySurface& surface);
+
+    static void write(SnapshotWriter& out, const DividendCurve& curve);
+    static void read(SnapshotReader& in, DividendCurve& curve);
+
+    // std::map<std::string, V> with any codec-supported V
+    template <typename V>
+    static void write_map(SnapshotWriter& out, const std::map<std::string, V>& values);
+    template <typename V>
+    static void read_map(SnapshotReader& in, std::map<std::string, V>& values);
+};
+
+#endif
@@ -0,0 +1,133 @@
+// Header file for intraday tick ingestion
+// Applies batches of spot/vol/rate updates to a MarketSimulator and
+// incrementally reprices only what depends on them
+
+#ifndef TICK_INGESTOR_H
+#define TICK_INGESTOR_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "marketSimulator.hh"
+#include "marketTick.hh"
+
+struct TickBatchStats {
+    size_t ticks = 0;
+    size_t instruments_updated = 0;    // Stocks and bonds moved directly by ticks
+    size_t options_repriced = 0;
+    size_t options_rate_adjusted = 0;  // First-order (rho) moves from rate ticks
+    size_t positions_touched = 0;      // Aggregate updates
+    double elapsed_us = 0.0;
+};
+
+// ============================================================================
+// TICK INGESTOR - Dependency-driven incremental updates
+// Walks the simulator's DependencyGraph: a batch reprices only the options
+// whose underlying, vol surface or curve moved, and folds each instrument's
+// price change into live per-(portfolio, currency) aggregates
+// (value += quantity * dP) instead of revaluing books - a tight sparse
+// matrix-vector update over the graph's CSR holder lists.
+// Rate ticks move a whole currency's option book, so inside a batch they
+// are applied to first order: price += rho * shift, from the rho cached at
+// each option's last full repricing, and each bucket of that currency moves
+// by shift * (its quantity-weighted rho) without walking any holders. Those
+// options are left stale until reprice_stale() (or a later spot/vol tick on
+// them) reprices them exactly; prices are exact only after the refresh, so
+// bench/tickReplay counts it in the batch latency.
+// Nothing string-keyed is looked up per option or per holder: each tick key
+// resolves once to its stock id and environment slots, every option keeps
+// its vol and (currency, expiry) curve point across batches - refreshed by
+// the vol/rate ticks that move them - and changed prices are folded into
+// per-task bucket accumulators in parallel, then reduced.
+// Live values and cached inputs are re-seeded whenever the graph is rebuilt
+// (instruments, portfolios or positions added); call rebuild() after
+// editing quantities in place or replacing the environment, its surfaces
+// or curves other than through ticks.
+// ============================================================================
+
+class TickIngestor {
+public:
+    explicit TickIngestor(MarketSimulator& market);
+
+    TickIngestor(const TickIngestor&) = delete;
+    TickIngestor& operator=(const TickIngestor&) = delete;
+
+    TickBatchStats apply(const TickBatch& batch);
+
+    // Full repricing of the options last moved by a first-order rate update
+    TickBatchStats reprice_stale();
+    size_t get_stale_count() const { return num_stale_; }
+
+    // Live value in the portfolio's reporting currency (FX at current spots)
+    double get_portfolio_value(size_t id) const;
+
+    // Rebuilds the dependency graph and recomputes live values from scratch
+    void rebuild();
+
+private:
+    MarketSimulator& market_;
+    const DependencyGraph* graph_ = nullptr;
+    size_t graph_generation_ = 0;
+
+    // Live aggregates: local-currency value and option rho per graph bucket
+    std::vector<double> live_values_;
+    std::vector<double> live_rho_;
+    std::vector<const std::string*> bucket_currency_;
+
+    // Tick key -> what it moves, resolved on first sight (slots lazily, so
+    // a vol-only key never creates a spot)
+    struct TickTarget {
+        InstrumentId stock = kInvalidInstrumentId;
+        double* spot = nullptr;
+        VolatilitySurface* surface = nullptr;
+    };
+    std::unordered_map<std::string, TickTarget> targets_;
+
+    // Pricing inputs kept across batches: vol per option (by pool index) and
+    // curve point per distinct (currency, expiry)
+    struct CurveNode {
+        const std::string* currency;
+        double expiry;
+        CurvePoint point;
+    };
+    std::vector<double> option_vol_;
+    std::vector<std::uint32_t> option_curve_node_;
+    std::vector<CurveNode> curve_nodes_;
+
+    // Per-batch scratch, reused to stay allocation-free in steady state
+    std::vector<char> changed_flag_[3];
+    std::vector<std::pair<InstrumentId, double>> changed_;  // (id, price before the batch)
+    std::vector<InstrumentId> dirty_options_;
+    std::vector<char> option_dirty_flag_;
+    std::vector<std::pair<std::string, double>> rate_shifts_;  // (currency, shift) this batch
+
+    // Price and rho moves to fold, and per-task bucket accumulators
+    struct InstrumentMove {
+        InstrumentId id;
+        double move;
+        double rho_move;
+    };
+    std::vector<InstrumentMove> moves_;
+    std::vector<double> fold_scratch_;
+
+    // Per option, by pool index: rho folded into live_rho_, rho from the
+    // last full repricing (not yet folded), and whether the price is a
+    // first-order approximation since
+    std::vector<double> option_rho_;
+    std::vector<double> option_new_rho_;
+    std::vector<char> option_stale_flag_;
+    std::vector<InstrumentId> stale_options_;  // May hold since-repriced ids
+    size_t num_stale_ = 0;
+
+    void sync_with_graph();
+    TickTarget& resolve(const std::string& key);
+    void refresh_curve_nodes(const std::string& currency);
+    void record_change(InstrumentId id, double old_price);
+    void mark_option_dirty(InstrumentId option);
+    void reprice_dirty_options(TickBatchStats& stats);
+    void fold_changes(TickBatchStats& stats);
+    void fold_moves(size_t begin, size_t end, double* values, double* rho) const;
+};
+
+#endif
@@ -7,12 +7,15 @@
 #include <vector>
 #include <algorithm>
 #include <numeric>
+#include <variant>
+#include <cstdint>
+#include <type_traits>
+#include <stdexcept>
 #include "model.hh"  // For Greeks struct
+#include "instrument.hh"
+#include "pricingContext.hh"
 
 // Forward declarations
-class Stock;
-class Option;
-class Bond;
 class Position;
 class Portfolio;
 class Model;
@@ -37,34 +40,174 @@ public:
     virtual void visit(const Bond& bond) = 0;
 };
 
+// ============================================================================
+// BATCH VISITORS - Visit contiguous spans of one instrument type at a time
+// The registry hands over all Stocks, then all Options, then all Bonds, so
+// a visitor can run a tight loop over homogeneous data (hoisting lookups,
+// letting the compiler vectorize) instead of one virtual call per object.
+// ============================================================================
+
+// Contiguous run of instruments of one type inside a registry pool
+// first_index = pool index of data[0], so id(i) recovers the InstrumentId
+template <typename T>
+class InstrumentSpan {
+public:
+    InstrumentSpan(T* data, size_t size, std::uint32_t first_index)
+        : data_(data), size_(size), first_index_(first_index) {}
+
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+    T& operator[](size_t i) const { return data_[i]; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    std::uint32_t get_first_index() const { return first_index_; }
+    InstrumentId id(size_t i) const {
+        return make_instrument_id(InstrumentTypeOf<std::remove_const_t<T>>::value,
+                                  first_index_ + static_cast<std::uint32_t>(i));
+    }
+
+private:
+    T* data_;
+    size_t size_;
+    std::uint32_t first_index_;
+};
+
+// A type may be delivered as several spans (one per pool chunk)
+class BatchInstrumentVisitor {
+public:
+    virtual ~BatchInstrumentVisitor() = default;
+
+    virtual void visit(InstrumentSpan<Stock> stocks) = 0;
+    virtual void visit(InstrumentSpan<Option> options) = 0;
+    virtual void visit(InstrumentSpan<Bond> bonds) = 0;
+};
+
+class ConstBatchInstrumentVisitor {
+public:
+    virtual ~ConstBatchInstrumentVisitor() = default;
+
+    virtual void visit(InstrumentSpan<const Stock> stocks) = 0;
+    virtual void visit(InstrumentSpan<const Option> options) = 0;
+    virtual void visit(InstrumentSpan<const Bond> bonds) = 0;
+};
+
+// ============================================================================
+// STATIC DISPATCH - Compile-time alternative to accept()/visit()
+// A static visitor is any callable with operator()(Stock&), (Option&) and
+// (Bond&). It works with std::visit on an InstrumentRef and with
+// InstrumentRegistry::visit / visit_all, which resolve the concrete type
+// without virtual calls, so the per-instrument math can be inlined.
+// ============================================================================
+
+using InstrumentRef = std::variant<Stock*, Option*, Bond*>;
+using ConstInstrumentRef = std::variant<const Stock*, const Option*, const Bond*>;
+
+// Build an ad-hoc static visitor from lambdas
+template <typename... Fs>
+struct Overloaded : Fs... { using Fs::operator()...; };
+template <typename... Fs>
+Overloaded(Fs...) -> Overloaded<Fs...>;
+
+// CRTP bridge: Derived implements operator() once, and the classic virtual
+// interface forwards to it - so every static visitor can still be passed to
+// accept() (compatibility layer for existing callers).
+// The batch interface defaults to a statically dispatched loop over the
+// span; visitors override it where whole-batch work can be hoisted.
+template <typename Derived>
+class StaticInstrumentVisitor : public InstrumentVisitor, public BatchInstrumentVisitor {
+public:
+    void visit(Stock& stock) final { derived()(stock); }
+    void visit(Option& option) final { derived()(option); }
+    void visit(Bond& bond) final { derived()(bond); }
+
+    void visit(InstrumentSpan<Stock> stocks) override { for (auto& s : stocks) derived()(s); }
+    void visit(InstrumentSpan<Option> options) override { for (auto& o : options) derived()(o); }
+    void visit(InstrumentSpan<Bond> bonds) override { for (auto& b : bonds) derived()(b); }
+
+private:
+    Derived& derived() { return static_cast<Derived&>(*this); }
+};
+
+template <typename Derived>
+class StaticConstInstrumentVisitor : public ConstInstrumentVisitor, public ConstBatchInstrumentVisitor {
+public:
+    void visit(const Stock& stock) final { derived()(stock); }
+    void visit(const Option& option) final { derived()(option); }
+    void visit(const Bond& bond) final { derived()(bond); }
+
+    void visit(InstrumentSpan<const Stock> stocks) override { for (auto& s : stocks) derived()(s); }
+    void visit(InstrumentSpan<const Option> options) override { for (auto& o : options) derived()(o); }
+    void visit(InstrumentSpan<const Bond> bonds) override { for (auto& b : bonds) derived()(b); }
+
+private:
+    Derived& derived() { return static_cast<Derived&>(*this); }
+};
+
 // ============================================================================
 // SIMULATION VISITORS - Different methods to evolve prices
+// Kernels are inline so static dispatch can inline them into the pool loops
 // ============================================================================
 
 // Monte Carlo simulation using GBM (or any stochastic model)
-class MonteCarloSimulationVisitor : public InstrumentVisitor {
+// Options are repriced from the shared PricingContext (surface + curve)
+class MonteCarloSimulationVisitor final
+    : public StaticInstrumentVisitor<MonteCarloSimulationVisitor> {
 public:
-    MonteCarloSimulationVisitor(Model& model, double dt)
-        : model_(model), dt_(dt) {}
-
-    void visit(Stock& stock) override;
-    void visit(Option& option) override;
-    void visit(Bond& bond) override;
+    MonteCarloSimulationVisitor(Model& model, double dt, const PricingContext& context)
+        : model_(model), dt_(dt), pricer_(model, context) {}
+
+    using StaticInstrumentVisitor::visit;
+
+    void operator()(Stock& stock) {
+        double new_price = model_.simulate_step(stock.get_price(), dt_);
+        stock.set_price(new_price);
+    }
+
+    void operator()(Option& option) {
+        // Reduce time to expiry
+        double tte = option.get_time_to_expiry() - dt_;
+        if (tte < 0) tte = 0;
+        option.set_time_to_expiry(tte);
+
+        // Re-price using model with surface vol / curve rate at the new expiry
+        option.set_price(pricer_.price(option, tte));
+    }
+
+    // Batch: decay the whole span, then reprice it call/put-split
+    void visit(InstrumentSpan<Option> options) override {
+        for (auto& option : options) option.set_time_to_expiry(std::max(0.0, option.get_time_to_expiry() - dt_));
+        pricer_.evaluate_batch(
+            options.size(), [&](size_t i) -> const Option& { return options[i]; },
+            [&](size_t i, const PricingResult& result) { options[i].set_price(result.price); });
+    }
+
+    void operator()(Bond& bond) {
+        // Simulate small rate change
+        double rate_change = (model_.simulate_step(1.0, dt_) - 1.0) * 0.1;
+        double new_price = bond.get_price() * (1.0 - bond.get_duration() * rate_change);
+        
+        // Add accrued interest
+        new_price += bond.get_coupon_rate() * dt_ * 100.0;
+        bond.set_price(new_price);
+    }
 
 private:
     Model& model_;
     double dt_;
+    OptionPricer<kOutputPrice> pricer_;  // Prices only - no Greeks
 };
 
 // Historical simulation - uses historical returns
-class HistoricalSimulationVisitor : public InstrumentVisitor {
+class HistoricalSimulationVisitor final
+    : public StaticInstrumentVisitor<HistoricalSimulationVisitor> {
 public:
     HistoricalSimulationVisitor(const std::vector<double>& historical_returns, size_t day_index)
         : historical_returns_(historical_returns), day_index_(day_index % historical_returns.size()) {}
 
-    void visit(Stock& stock) override;
-    void visit(Option& option) override;
-    void visit(Bond& bond) override;
+    void operator()(Stock& stock);
+    void operator()(Option& option);
+    void operator()(Bond& bond);
 
 private:
     const std::vector<double>& historical_returns_;
@@ -72,19 +215,36 @@ private:
 };
 
 // Stress test simulation - applies a fixed shock
-class StressTestVisitor : public InstrumentVisitor {
+// Options are repriced off the shared PricingContext with shocked vol/rate,
+// using one Black-Scholes pricer for the whole run
+class StressTestVisitor final
+    : public StaticInstrumentVisitor<StressTestVisitor> {
 public:
-    StressTestVisitor(double price_shock, double vol_shock, double rate_shock)
-        : price_shock_(price_shock), vol_shock_(vol_shock), rate_shock_(rate_shock) {}
+    StressTestVisitor(double price_shock, double vol_shock, double rate_shock,
+                      const PricingContext& context)
+        : price_shock_(price_shock), vol_shock_(vol_shock), rate_shock_(rate_shock),
+          option_pricer_(pricer_, context) {}
+
+    using StaticInstrumentVisitor::visit;
+
+    void operator()(Stock& stock);
+    void operator()(Option& option);
+    void operator()(Bond& bond);
 
-    void visit(Stock& stock) override;
-    void visit(Option& option) override;
-    void visit(Bond& bond) override;
+    // Batch: shocked repricing of the whole span, call/put-split
+    void visit(InstrumentSpan<Option> options) override {
+        option_pricer_.evaluate_batch(
+            options.size(), [&](size_t i) -> const Option& { return options[i]; },
+            [&](size_t i, const PricingResult& result) { options[i].set_price(result.price); },
+            vol_shock_, rate_shock_);
+    }
 
 private:
     double price_shock_;  // e.g., -0.20 for 20% crash
     double vol_shock_;    // e.g., +0.30 for vol spike
     double rate_shock_;   // e.g., +0.01 for 100bp rate hike
+    BlackScholesModel pricer_;
+    OptionPricer<kOutputPrice> option_pricer_;
 };
 
 // ============================================================================
@@ -92,30 +252,101 @@ private:
 // ============================================================================
 
 // Greeks calculation visitor
-class GreeksVisitor : public ConstInstrumentVisitor {
+// Single-instrument visits leave the result in get_result(); batch visits
+// (registry.accept_batch) fill a per-instrument table read via get_result(id)
+class GreeksVisitor final
+    : public StaticConstInstrumentVisitor<GreeksVisitor> {
 public:
-    explicit GreeksVisitor(const Model& model) : model_(model) {}
-
-    void visit(const Stock& stock) override;
-    void visit(const Option& option) override;
-    void visit(const Bond& bond) override;
+    GreeksVisitor(const Model& model, const PricingContext& context)
+        : model_(model), context_(context) {}
+
+    using StaticConstInstrumentVisitor::visit;
+
+    void operator()(const Stock& stock) {
+        (void)stock;
+        result_.delta = 1.0;
+        result_.gamma = 0.0;
+        result_.vega = 0.0;
+        result_.theta = 0.0;
+        result_.rho = 0.0;
+    }
+
+    void operator()(const Option& option) {
+        result_ = context_.calculate_greeks(model_, option);
+    }
+
+    void operator()(const Bond& bond) {
+        result_.delta = 0.0;
+        result_.gamma = 0.0;
+        result_.vega = 0.0;
+        result_.theta = bond.get_coupon_rate() / 365.0;
+        result_.rho = -bond.get_duration() * bond.get_price();
+    }
+
+    // Batch: Greeks for every instrument of the span, stored by pool index
+    void visit(InstrumentSpan<const Stock> stocks) override {
+        auto* out = table_slice(InstrumentType::Stock, stocks.get_first_index(), stocks.size());
+        for (size_t i = 0; i < stocks.size(); ++i) {
+            (*this)(stocks[i]);
+            out[i] = result_;
+        }
+    }
+
+    void visit(InstrumentSpan<const Option> options) override {
+        auto* out = table_slice(InstrumentType::Option, options.get_first_index(), options.size());
+        OptionPricer<kOutputGreeks> pricer(model_, context_);  // Greeks only - no price
+        pricer.evaluate_batch(
+            options.size(), [&](size_t i) -> const Option& { return options[i]; },
+            [&](size_t i, const PricingResult& result) { out[i] = result.greeks; });
+    }
+
+    void visit(InstrumentSpan<const Bond> bonds) override {
+        auto* out = table_slice(InstrumentType::Bond, bonds.get_first_index(), bonds.size());
+        for (size_t i = 0; i < bonds.size(); ++i) {
+            (*this)(bonds[i]);
+            out[i] = result_;
+        }
+    }
 
     Greeks get_result() const { return result_; }
-    void reset() { result_ = Greeks{}; }
+
+    // Per-instrument Greeks from a previous batch visit
+    const Greeks& get_result(InstrumentId id) const {
+        const auto& table = tables_[static_cast<size_t>(get_instrument_type(id))];
+        size_t idx = get_instrument_index(id);
+        if (idx >= table.size()) {
+            throw std::out_of_range("No batch Greeks computed for instrument");
+        }
+        return table[idx];
+    }
+
+    void reset() {
+        result_ = Greeks{};
+        for (auto& table : tables_) table.clear();
+    }
 
 private:
     const Model& model_;
+    const PricingContext& context_;
     Greeks result_{};
+    std::vector<Greeks> tables_[3];  // Indexed by InstrumentType, then pool index
+
+    Greeks* table_slice(InstrumentType type, size_t first, size_t count) {
+        auto& table = tables_[static_cast<size_t>(type)];
+        if (table.size() < first + count) table.resize(first + count);
+        return table.data() + first;
+    }
 };
 
 // Market value visitor
-class MarketValueVisitor : public ConstInstrumentVisitor {
+class MarketValueVisitor final
+    : public StaticConstInstrumentVisitor<MarketValueVisitor> {
 public:
     MarketValueVisitor() = default;
 
-    void visit(const Stock& stock) override;
-    void visit(const Option& option) override;
-    void visit(const Bond& bond) override;
+    void operator()(const Stock& stock) { value_ = stock.get_price(); }
+    void operator()(const Option& option) { value_ = option.get_price(); }
+    void operator()(const Bond& bond) { value_ = bond.get_price(); }
 
     double get_value() const { return value_; }
     void reset() { value_ = 0.0; }
@@ -143,14 +374,21 @@ private:
 // Portfolio Greeks aggregator
 class PortfolioGreeksVisitor {
 public:
-    explicit PortfolioGreeksVisitor(const Model& model) : model_(model) {}
+    PortfolioGreeksVisitor(const Model& model, const PricingContext& context)
+        : model_(model), context_(context) {}
 
     void visit(const Portfolio& portfolio);
+
+    // Aggregate from per-instrument Greeks already computed in batch
+    // (each instrument priced once, however many portfolios hold it)
+    void visit(const Portfolio& portfolio, const GreeksVisitor& instrument_greeks);
+
     Greeks get_total_greeks() const { return total_greeks_; }
     void reset() { total_greeks_ = Greeks{}; }
 
 private:
     const Model& model_;
+    const PricingContext& context_;
     Greeks total_greeks_{};
 };
 
@@ -164,9 +402,18 @@ public:
 
     double calculate_var(Portfolio& portfolio);
 
+    // Multi-currency: P&L in the portfolio's reporting currency, revalued
+    // at each scenario's FX rates (one FxRates per historical scenario)
+    double calculate_var(Portfolio& portfolio, const FxRates& current_fx,
+                         const std::vector<FxRates>& fx_scenarios);
+
 private:
     const std::vector<std::vector<double>>& historical_returns_;
     double confidence_level_;
+
+    // value_of(day) values the portfolio with scenario `day` applied
+    template <typename ScenarioValue>
+    double calculate_var(Portfolio& portfolio, double initial_value, ScenarioValue&& value_of);
 };
 
 #endif
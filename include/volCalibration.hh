@@ -0,0 +1,103 @@
+// Header file for implied volatility and vol surface calibration
+// Turns quoted option premiums into Black-Scholes implied vols (batched,
+// structure of arrays) and builds per-ticker VolatilitySurface grids from
+// them, many tickers in parallel
+
+#ifndef VOL_CALIBRATION_H
+#define VOL_CALIBRATION_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstddef>
+#include "marketEnvironment.hh"
+
+// One quoted European option premium
+struct OptionQuote {
+    std::string ticker;
+    double strike = 0.0;
+    double expiry = 0.0;   // Years
+    double premium = 0.0;  // In the underlying's currency
+    bool is_call = true;
+    std::string currency;  // Discounting curve; empty = the ticker's (env.get_currency), as pricers use
+};
+
+// ============================================================================
+// IMPLIED VOL SOLVER
+// Initial guess from the Corrado-Miller rational approximation (falling back
+// to the inflection-point vol sqrt(2|ln(F/K)|/T) where it has no real root),
+// then safeguarded Halley steps: each step is clamped to the running
+// [lo, hi] bracket and replaced by bisection when it leaves it, so the
+// iteration cannot diverge on deep ITM/OTM quotes where vega vanishes.
+// The batch form works in rounds over the whole array rather than one
+// option at a time: each round is a flat, branch-free loop the compiler
+// vectorizes, after which converged options drop out of the working set.
+// Premiums outside the no-arbitrage bounds yield NaN, as do ITM premiums
+// whose time value is lost in their rounding.
+// ============================================================================
+
+struct ImpliedVolSettings {
+    double tolerance = 1e-10;  // Converged once a step moves the vol by less, relative
+    unsigned max_iterations = 20;
+    double min_vol = 1e-4;
+    double max_vol = 5.0;
+};
+
+class ImpliedVolSolver {
+public:
+    explicit ImpliedVolSolver(const ImpliedVolSettings& settings = {}) : settings_(settings) {}
+
+    double solve(double S, double K, double T, double r, double premium, bool is_call) const;
+
+    // vol_out[i] for each of n options; r is the continuously compounded rate
+    void solve(const double* S, const double* K, const double* T, const double* r,
+               const double* premium, const unsigned char* is_call, double* vol_out, size_t n) const;
+
+    const ImpliedVolSettings& get_settings() const { return settings_; }
+
+private:
+    ImpliedVolSettings settings_;
+};
+
+// ============================================================================
+// VOL SURFACE CALIBRATOR
+// Quotes are grouped by ticker and each ticker is calibrated independently
+// (parallel_for over tickers). Per ticker: implied vols through the batch
+// solver with the ticker's spot and the rate of its curve at each expiry,
+// then a grid over the distinct quoted strikes x expiries. Where a call and
+// a put share a cell the out-of-the-money quote wins (it carries the time
+// value; the ITM premium is mostly intrinsic). Cells without a usable quote
+// are filled along the strike axis - linear between neighbours, flat beyond
+// the ends - and expiries with no usable quote at all are dropped.
+// ============================================================================
+
+struct CalibrationOptions {
+    ImpliedVolSettings solver;
+    size_t num_threads = 0;     // 0 = all hardware threads
+    size_t min_quotes = 1;      // Tickers with fewer usable quotes are skipped
+};
+
+struct CalibrationReport {
+    size_t tickers = 0;           // Surfaces built
+    size_t quotes = 0;            // Quotes given
+    size_t rejected_quotes = 0;   // Arbitrage-violating or unsolvable
+    std::vector<std::string> skipped_tickers;  // No spot, or too few usable quotes
+};
+
+class VolSurfaceCalibrator {
+public:
+    explicit VolSurfaceCalibrator(const CalibrationOptions& options = {}) : options_(options) {}
+
+    // Calibrated surface per ticker; spots and curves come from env
+    std::map<std::string, VolatilitySurface> calibrate(const std::vector<OptionQuote>& quotes,
+                                                       const MarketEnvironment& env,
+                                                       CalibrationReport* report = nullptr) const;
+
+    // Calibrates and installs every surface into env
+    CalibrationReport calibrate_into(const std::vector<OptionQuote>& quotes, MarketEnvironment& env) const;
+
+private:
+    CalibrationOptions options_;
+};
+
+#endif
@@ -0,0 +1,193 @@
+// Implementation of the yield curve bootstrapper
+
+#include "../include/curveBootstrap.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+// ============================================================================
+// QUOTE CASH FLOWS - Unit notional, PV = sum amount * DF(time) = 0 at par
+// ============================================================================
+
+static double quoted_rate(const RateQuote& quote) {
+    if (quote.type == RateInstrument::Future) return (100.0 - quote.value) / 100.0 - quote.convexity;
+    return quote.value;
+}
+
+// Fixed leg payment times, ascending, ending at maturity
+static std::vector<double> swap_schedule(double maturity, unsigned frequency) {
+    double period = 1.0 / frequency;
+    size_t payments = static_cast<size_t>(std::ceil(maturity * frequency - 1e-9));
+    std::vector<double> times;
+    times.reserve(payments);
+    for (size_t j = payments; j-- > 0;) times.push_back(maturity - j * period);
+    return times;
+}
+
+static std::vector<std::pair<double, double>> quote_cash_flows(const RateQuote& quote) {
+    double rate = quoted_rate(quote);
+    switch (quote.type) {
+        case RateInstrument::Deposit:
+            return {{0.0, -1.0}, {quote.maturity, 1.0 + rate * quote.maturity}};
+        case RateInstrument::FRA:
+        case RateInstrument::Future:
+            return {{quote.start, -1.0}, {quote.maturity, 1.0 + rate * (quote.maturity - quote.start)}};
+        case RateInstrument::Swap: {
+            std::vector<std::pair<double, double>> flows{{0.0, -1.0}};
+            double previous = 0.0;
+            for (double t : swap_schedule(quote.maturity, quote.frequency)) {
+                flows.emplace_back(t, rate * (t - previous));
+                previous = t;
+            }
+            flows.back().second += 1.0;
+            return flows;
+        }
+    }
+    return {};
+}
+
+static void validate(const RateQuote& quote) {
+    if (!(quote.maturity > 0.0)) {
+        throw std::invalid_argument("CurveBootstrapper: maturity must be positive");
+    }
+    bool forward = quote.type == RateInstrument::FRA || quote.type == RateInstrument::Future;
+    if (forward && !(quote.start >= 0.0 && quote.start < quote.maturity)) {
+        throw std::invalid_argument("CurveBootstrapper: FRA/future start must be in [0, maturity)");
+    }
+    if (quote.type == RateInstrument::Swap && quote.frequency == 0) {
+        throw std::invalid_argument("CurveBootstrapper: swap frequency must be positive");
+    }
+}
+
+double CurveBootstrapper::implied_value(const RateQuote& quote, const YieldCurve& curve) {
+    double df = curve.get_discount_factor(quote.maturity);
+    switch (quote.type) {
+        case RateInstrument::Deposit:
+            return (1.0 / df - 1.0) / quote.maturity;
+        case RateInstrument::FRA:
+            return (curve.get_discount_factor(quote.start) / df - 1.0) / (quote.maturity - quote.start);
+        case RateInstrument::Future: {
+            double forward = (curve.get_discount_factor(quote.start) / df - 1.0) / (quote.maturity - quote.start);
+            return 100.0 * (1.0 - (forward + quote.convexity));
+        }
+        case RateInstrument::Swap: {
+            double annuity = 0.0, previous = 0.0;
+            for (double t : swap_schedule(quote.maturity, quote.frequency)) {
+                annuity += (t - previous) * curve.get_discount_factor(t);
+                previous = t;
+            }
+            return (1.0 - df) / annuity;
+        }
+    }
+    return 0.0;
+}
+
+// ============================================================================
+// CURVE BOOTSTRAPPER
+// ============================================================================
+
+CurveBootstrapper::CurveBootstrapper(const std::vector<RateQuote>& quotes, const BootstrapSettings& settings)
+    : settings_(settings), quotes_(quotes) {
+    if (quotes_.empty()) throw std::invalid_argument("CurveBootstrapper: no quotes");
+    for (const auto& quote : quotes_) validate(quote);
+
+    std::vector<size_t> order(quotes_.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&](size_t a, size_t b) { return quotes_[a].maturity < quotes_[b].maturity; });
+
+    size_t n = order.size();
+    pillar_of_.resize(n);
+    pillars_.reserve(n);
+    for (size_t k = 0; k < n; ++k) {
+        double maturity = quotes_[order[k]].maturity;
+        if (k > 0 && maturity == pillars_.back()) {
+            throw std::invalid_argument("CurveBootstrapper: two quotes mature at T=" + std::to_string(maturity));
+        }
+        pillars_.push_back(maturity);
+        pillar_of_[order[k]] = k;
+    }
+
+    // Cash flow layout: times, segments and weights never change
+    flow_begin_.reserve(n + 1);
+    for (size_t k = 0; k < n; ++k) {
+        flow_begin_.push_back(flows_.size());
+        for (const auto& [time, amount] : quote_cash_flows(quotes_[order[k]])) {
+            auto s = static_cast<std::uint32_t>(std::lower_bound(pillars_.begin(), pillars_.end(), time) -
+                                                pillars_.begin());
+            double weight = s == 0 ? 1.0 : (time - pillars_[s - 1]) / (pillars_[s] - pillars_[s - 1]);
+            flows_.push_back({time, amount, s, weight});
+        }
+    }
+    flow_begin_.push_back(flows_.size());
+
+    zero_rates_.assign(n, 0.0);
+    for (size_t k = 0; k < n; ++k) {
+        if (k > 0) zero_rates_[k] = zero_rates_[k - 1];  // Initial guess
+        solve_pillar(k);
+    }
+    curve_ = YieldCurve(pillars_, zero_rates_);
+}
+
+size_t CurveBootstrapper::update_quotes(const std::vector<std::pair<size_t, double>>& changes) {
+    size_t first = pillars_.size();
+    for (const auto& [index, value] : changes) {
+        if (index >= quotes_.size()) throw std::out_of_range("CurveBootstrapper: no quote " + std::to_string(index));
+        quotes_[index].value = value;
+        set_amounts(index);
+        first = std::min(first, pillar_of_[index]);
+    }
+    if (first == pillars_.size()) return 0;
+
+    // Later pillars discount off the changed ones: re-solve the tail,
+    // each starting from its previous zero rate
+    for (size_t k = first; k < pillars_.size(); ++k) solve_pillar(k);
+    curve_ = YieldCurve(pillars_, zero_rates_);
+    return pillars_.size() - first;
+}
+
+void CurveBootstrapper::set_amounts(size_t quote_index) {
+    size_t k = pillar_of_[quote_index];
+    CashFlow* flow = flows_.data() + flow_begin_[k];
+    for (const auto& [time, amount] : quote_cash_flows(quotes_[quote_index])) (flow++)->amount = amount;
+}
+
+double CurveBootstrapper::discount(const CashFlow& flow) const {
+    size_t s = flow.segment;
+    double z = s == 0 ? zero_rates_[0] : zero_rates_[s - 1] + flow.weight * (zero_rates_[s] - zero_rates_[s - 1]);
+    return std::exp(-z * flow.time);
+}
+
+void CurveBootstrapper::solve_pillar(size_t k) {
+    const CashFlow* begin = flows_.data() + flow_begin_[k];
+    const CashFlow* end = flows_.data() + flow_begin_[k + 1];
+
+    // Flows up to the previous pillar are already priced by the partial curve
+    double fixed = 0.0;
+    for (const CashFlow* flow = begin; flow != end; ++flow) {
+        if (flow->segment < k) fixed += flow->amount * discount(*flow);
+    }
+
+    double z_previous = k > 0 ? zero_rates_[k - 1] : 0.0;
+    double z = zero_rates_[k];
+    for (unsigned iteration = 0; iteration < settings_.max_iterations; ++iteration) {
+        double pv = fixed;
+        double slope = 0.0;
+        for (const CashFlow* flow = begin; flow != end; ++flow) {
+            if (flow->segment < k) continue;
+            double zt = k > 0 ? z_previous + flow->weight * (z - z_previous) : z;
+            double value = flow->amount * std::exp(-zt * flow->time);
+            pv += value;
+            slope -= value * flow->time * flow->weight;
+        }
+        double step = pv / slope;
+        z -= step;
+        if (std::fabs(step) <= settings_.tolerance) {
+            zero_rates_[k] = z;
+            return;
+        }
+    }
+    throw std::runtime_error("CurveBootstrapper: no convergence at pillar T=" + std::to_string(pillars_[k]));
+}
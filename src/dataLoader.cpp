@@ -0,0 +1,752 @@
+// Implementation of the bulk data loader
+
+#include "../include/dataLoader.hh"
+#include "../include/marketSimulator.hh"
+#include "../include/snapshot.hh"
+#include "../include/parallel.hh"
+#include "../include/volCalibration.hh"
+#include "../include/curveBootstrap.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+
+// ============================================================================
+// DELIMITED FILE - Memory-mapped, header-indexed, split for parallel parsing
+// ============================================================================
+
+constexpr size_t kMaxCsvColumns = 32;       // Row tables (the correlation matrix is parsed per line)
+constexpr size_t kCsvChunkBytes = 1 << 20;  // ~1 MB of text per parallel task
+constexpr size_t kNoColumn = ~size_t(0);
+
+static std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+    return s;
+}
+
+// Splits the next field off `line`; the remainder stays in `line`
+static std::string_view next_field(std::string_view& line, char delimiter) {
+    size_t pos = line.find(delimiter);
+    std::string_view field = line.substr(0, pos);
+    line = (pos == std::string_view::npos) ? std::string_view() : line.substr(pos + 1);
+    return trim(field);
+}
+
+static bool equals_ignore_case(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        char x = a[i], y = b[i];
+        if (x >= 'A' && x <= 'Z') x = static_cast<char>(x - 'A' + 'a');
+        if (y >= 'A' && y <= 'Z') y = static_cast<char>(y - 'A' + 'a');
+        if (x != y) return false;
+    }
+    return true;
+}
+
+// One parsed row: views into the mapped file, valid for the file's lifetime
+struct CsvRow {
+    const std::string_view* fields;
+    size_t size;
+    const char* line;  // For error positions
+
+    // Empty view for absent columns
+    std::string_view operator[](size_t col) const { return col < size ? fields[col] : std::string_view(); }
+};
+
+class DelimitedFile {
+public:
+    DelimitedFile(const std::string& path, const LoadOptions& options)
+        : path_(path), options_(options), file_(path) {
+        const char* begin = file_.data();
+        const char* end = begin + file_.size();
+        if (file_.size() == 0) throw std::runtime_error(path + ": empty file (missing header)");
+
+        // Header
+        const char* nl = static_cast<const char*>(std::memchr(begin, '\n', file_.size()));
+        const char* body = nl ? nl + 1 : end;
+        std::string_view header(begin, static_cast<size_t>((nl ? nl : end) - begin));
+        while (!header.empty()) header_.push_back(next_field(header, options_.delimiter));
+
+        // Line-aligned chunks
+        size_t body_size = static_cast<size_t>(end - body);
+        size_t num_chunks = std::max<size_t>(1, body_size / kCsvChunkBytes);
+        chunks_.push_back(body);
+        for (size_t i = 1; i < num_chunks; ++i) {
+            const char* p = std::max(body + i * (body_size / num_chunks), chunks_.back());
+            const char* q = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            chunks_.push_back(q ? q + 1 : end);
+        }
+        chunks_.push_back(end);
+    }
+
+    const std::string& get_path() const { return path_; }
+    const std::vector<std::string_view>& get_header() const { return header_; }
+    size_t num_chunks() const { return chunks_.size() - 1; }
+
+    size_t find_column(std::string_view name) const {
+        for (size_t i = 0; i < header_.size(); ++i) {
+            if (equals_ignore_case(header_[i], name)) {
+                if (i >= kMaxCsvColumns) fail(file_.data(), "column '" + std::string(name) + "' is too far right");
+                return i;
+            }
+        }
+        return kNoColumn;
+    }
+
+    size_t column(std::string_view name) const {
+        size_t col = find_column(name);
+        if (col == kNoColumn) fail(file_.data(), "missing column '" + std::string(name) + "'");
+        return col;
+    }
+
+    // f(chunk, line) for every non-blank line; chunks run in parallel
+    template <typename F>
+    void parse_lines(F&& f) const {
+        parallel_for(0, num_chunks(), 1, [&](size_t lo, size_t hi) {
+            for (size_t c = lo; c < hi; ++c) {
+                const char* p = chunks_[c];
+                const char* end = chunks_[c + 1];
+                while (p < end) {
+                    const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+                    const char* line_end = nl ? nl : end;
+                    std::string_view line = trim(std::string_view(p, static_cast<size_t>(line_end - p)));
+                    if (!line.empty()) f(c, line);
+                    p = line_end + 1;
+                }
+            }
+        }, options_.num_threads);
+    }
+
+    // f(chunk, row) for every non-blank row; chunks run in parallel
+    template <typename F>
+    void parse(F&& f) const {
+        parse_lines([&](size_t chunk, std::string_view line) {
+            std::string_view fields[kMaxCsvColumns];
+            const char* start = line.data();
+            size_t n = 0;
+            while (!line.empty() && n < kMaxCsvColumns) fields[n++] = next_field(line, options_.delimiter);
+            f(chunk, CsvRow{fields, n, start});
+        });
+    }
+
+    double parse_double(std::string_view field, const char* at, std::string_view what) const {
+        double value = 0.0;
+        auto [ptr, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+        if (field.empty() || ec != std::errc() || ptr != field.data() + field.size()) {
+            fail(at, "invalid " + std::string(what) + " '" + std::string(field) + "'");
+        }
+        return value;
+    }
+
+    double parse_double(const CsvRow& row, size_t col, std::string_view what) const {
+        if (col == kNoColumn) fail(row.line, "missing column '" + std::string(what) + "'");
+        return parse_double(row[col], row.line, what);
+    }
+
+    // Throws "path:line: message" for an error at a position in the mapping
+    [[noreturn]] void fail(const char* at, const std::string& message) const {
+        size_t line = 1 + static_cast<size_t>(std::count(file_.data(), at, '\n'));
+        throw std::runtime_error(path_ + ":" + std::to_string(line) + ": " + message);
+    }
+
+private:
+    std::string path_;
+    LoadOptions options_;
+    MappedFile file_;
+    std::vector<std::string_view> header_;
+    std::vector<const char*> chunks_;  // num_chunks + 1 boundaries
+};
+
+// ============================================================================
+// PORTFOLIO ASSEMBLY - Shared by the text and columnar position loaders
+// ============================================================================
+
+// owner -> id of the first existing portfolio with that owner
+static std::map<std::string, size_t> portfolios_by_owner(const MarketSimulator& market) {
+    std::map<std::string, size_t> by_owner;
+    for (size_t id = 0; id < market.get_portfolio_count(); ++id) {
+        by_owner.emplace(market.get_portfolio(id).get_owner(), id);
+    }
+    return by_owner;
+}
+
+static size_t portfolio_for(MarketSimulator& market, std::map<std::string, size_t>& by_owner,
+                            const std::string& owner, const std::string& currency) {
+    auto it = by_owner.find(owner);
+    if (it != by_owner.end()) return it->second;
+    size_t id = market.create_portfolio(owner, currency.empty() ? std::string("USD") : currency);
+    by_owner.emplace(owner, id);
+    return id;
+}
+
+// Reserves every portfolio to its final size, then appends in input order.
+// rows(f) must call f(portfolio id, instrument id, quantity) for each row
+template <typename Rows>
+static void append_positions(MarketSimulator& market, Rows&& rows) {
+    std::vector<size_t> added(market.get_portfolio_count(), 0);
+    rows([&](size_t portfolio, InstrumentId, double) { ++added[portfolio]; });
+    for (size_t id = 0; id < added.size(); ++id) {
+        if (added[id] == 0) continue;
+        Portfolio& portfolio = market.get_portfolio(id);
+        portfolio.reserve_positions(portfolio.get_position_count() + added[id]);
+    }
+    rows([&](size_t portfolio, InstrumentId instrument, double quantity) {
+        market.get_portfolio(portfolio).add_position(instrument, quantity);
+    });
+}
+
+// ============================================================================
+// INSTRUMENTS
+// ============================================================================
+
+struct InstrumentRow {
+    InstrumentType type;
+    Option::Type option_type;
+    std::string_view ticker;
+    std::string_view currency;
+    std::string_view underlying;
+    double price;
+    double strike;
+    double expiry;
+    double duration;
+    double coupon;
+    const char* line;
+};
+
+size_t DataLoader::load_instruments(const std::string& path, InstrumentRegistry& registry,
+                                    const LoadOptions& options) {
+    DelimitedFile file(path, options);
+    size_t type_col = file.column("type");
+    size_t ticker_col = file.column("ticker");
+    size_t price_col = file.column("price");
+    size_t currency_col = file.find_column("currency");
+    size_t underlying_col = file.find_column("underlying");
+    size_t strike_col = file.find_column("strike");
+    size_t expiry_col = file.find_column("expiry");
+    size_t option_type_col = file.find_column("option_type");
+    size_t duration_col = file.find_column("duration");
+    size_t coupon_col = file.find_column("coupon");
+
+    std::vector<std::vector<InstrumentRow>> chunks(file.num_chunks());
+    file.parse([&](size_t chunk, const CsvRow& row) {
+        InstrumentRow r{};
+        r.ticker = row[ticker_col];
+        r.currency = row[currency_col];
+        r.price = file.parse_double(row, price_col, "price");
+        r.line = row.line;
+        if (r.ticker.empty()) file.fail(row.line, "empty ticker");
+
+        std::string_view type = row[type_col];
+        if (equals_ignore_case(type, "stock")) {
+            r.type = InstrumentType::Stock;
+        } else if (equals_ignore_case(type, "option")) {
+            r.type = InstrumentType::Option;
+            r.underlying = row[underlying_col];
+            r.strike = file.parse_double(row, strike_col, "strike");
+            r.expiry = file.parse_double(row, expiry_col, "expiry");
+            std::string_view option_type = row[option_type_col];
+            if (equals_ignore_case(option_type, "call")) {
+                r.option_type = Option::Type::Call;
+            } else if (equals_ignore_case(option_type, "put")) {
+                r.option_type = Option::Type::Put;
+            } else {
+                file.fail(row.line, "invalid option_type '" + std::string(option_type) + "'");
+            }
+        } else if (equals_ignore_case(type, "bond")) {
+            r.type = InstrumentType::Bond;
+            r.duration = file.parse_double(row, duration_col, "duration");
+            r.coupon = row[coupon_col].empty() ? 0.0 : file.parse_double(row, coupon_col, "coupon");
+        } else {
+            file.fail(row.line, "invalid instrument type '" + std::string(type) + "'");
+        }
+        chunks[chunk].push_back(r);
+    });
+
+    // Stocks first so every option finds its underlying; file order within a type
+    auto currency_of = [](const InstrumentRow& r) {
+        return r.currency.empty() ? std::string("USD") : std::string(r.currency);
+    };
+    auto add = [&](InstrumentType type, auto&& add_one) {
+        for (const auto& rows : chunks) {
+            for (const auto& r : rows) {
+                if (r.type != type) continue;
+                try {
+                    add_one(r);
+                } catch (const std::invalid_argument& e) {
+                    file.fail(r.line, e.what());
+                }
+            }
+        }
+    };
+
+    size_t before = registry.size();
+    add(InstrumentType::Stock, [&](const InstrumentRow& r) {
+        registry.add_stock(std::string(r.ticker), r.price, currency_of(r));
+    });
+    add(InstrumentType::Option, [&](const InstrumentRow& r) {
+        InstrumentId underlying = registry.find(r.underlying);
+        if (underlying == kInvalidInstrumentId) {
+            file.fail(r.line, "unknown underlying '" + std::string(r.underlying) + "'");
+        }
+        registry.add_option(std::string(r.ticker), r.price, r.strike, underlying, r.expiry, r.option_type);
+    });
+    add(InstrumentType::Bond, [&](const InstrumentRow& r) {
+        registry.add_bond(std::string(r.ticker), r.price, r.duration, r.coupon, currency_of(r));
+    });
+    return registry.size() - before;
+}
+
+size_t DataLoader::load_instruments(const std::string& path, MarketSimulator& market,
+                                    const LoadOptions& options) {
+    try {
+        size_t added = load_instruments(path, market.get_registry(), options);
+        market.tag_stock_currencies();
+        return added;
+    } catch (...) {
+        market.tag_stock_currencies();  // Stocks added before a failing row
+        throw;
+    }
+}
+
+// ============================================================================
+// POSITIONS
+// Owners are resolved to chunk-local indices while parsing (rows are 16
+// bytes), then mapped to portfolios once per distinct owner per chunk.
+// ============================================================================
+
+struct PositionRow {
+    std::uint32_t owner;  // Chunk-local owner index
+    InstrumentId instrument;
+    double quantity;
+};
+
+struct PositionChunk {
+    std::vector<std::string_view> owners;
+    std::vector<std::string_view> currencies;  // Of each owner's first row
+    std::unordered_map<std::string_view, std::uint32_t> owner_index;
+    std::vector<PositionRow> rows;
+};
+
+std::map<std::string, size_t> DataLoader::load_positions(const std::string& path, MarketSimulator& market,
+                                                         const LoadOptions& options) {
+    DelimitedFile file(path, options);
+    size_t owner_col = file.column("portfolio");
+    size_t ticker_col = file.column("ticker");
+    size_t quantity_col = file.column("quantity");
+    size_t currency_col = file.find_column("currency");
+    const InstrumentRegistry& registry = market.get_registry();
+
+    std::vector<PositionChunk> chunks(file.num_chunks());
+    file.parse([&](size_t c, const CsvRow& row) {
+        PositionChunk& chunk = chunks[c];
+        std::string_view owner = row[owner_col];
+        std::uint32_t owner_idx;
+        if (!chunk.owners.empty() && chunk.owners.back() == owner) {
+            owner_idx = static_cast<std::uint32_t>(chunk.owners.size() - 1);  // Rows grouped by owner
+        } else {
+            auto [it, inserted] = chunk.owner_index.emplace(owner, static_cast<std::uint32_t>(chunk.owners.size()));
+            if (inserted) {
+                chunk.owners.push_back(owner);
+                chunk.currencies.push_back(row[currency_col]);
+            }
+            owner_idx = it->second;
+        }
+
+        std::string_view ticker = row[ticker_col];
+        InstrumentId instrument = registry.find(ticker);
+        if (instrument == kInvalidInstrumentId) {
+            file.fail(row.line, "unknown instrument '" + std::string(ticker) + "'");
+        }
+        chunk.rows.push_back({owner_idx, instrument, file.parse_double(row, quantity_col, "quantity")});
+    });
+
+    auto by_owner = portfolios_by_owner(market);
+    std::vector<std::vector<size_t>> portfolio_of(chunks.size());
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        for (size_t i = 0; i < chunks[c].owners.size(); ++i) {
+            portfolio_of[c].push_back(portfolio_for(market, by_owner, std::string(chunks[c].owners[i]),
+                                                    std::string(chunks[c].currencies[i])));
+        }
+    }
+
+    append_positions(market, [&](auto&& f) {
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            for (const auto& r : chunks[c].rows) f(portfolio_of[c][r.owner], r.instrument, r.quantity);
+        }
+    });
+    return by_owner;
+}
+
+// ============================================================================
+// MARKET DATA
+// ============================================================================
+
+void DataLoader::load_spots(const std::string& path, MarketEnvironment& env, const LoadOptions& options) {
+    DelimitedFile file(path, options);
+    size_t ticker_col = file.column("ticker");
+    size_t price_col = file.column("price");
+
+    std::vector<std::vector<std::pair<std::string_view, double>>> chunks(file.num_chunks());
+    file.parse([&](size_t chunk, const CsvRow& row) {
+        chunks[chunk].emplace_back(row[ticker_col], file.parse_double(row, price_col, "price"));
+    });
+    for (const auto& rows : chunks) {
+        for (const auto& [ticker, price] : rows) env.set_spot(std::string(ticker), price);
+    }
+}
+
+void DataLoader::load_yield_curves(const std::string& path, MarketEnvironment& env, const LoadOptions& options) {
+    DelimitedFile file(path, options);
+    size_t currency_col = file.column("currency");
+    size_t tenor_col = file.column("tenor");
+    size_t rate_col = file.column("rate");
+
+    struct Pillar { std::string_view currency; double tenor, rate; };
+    std::vector<std::vector<Pillar>> chunks(file.num_chunks());
+    file.parse([&](size_t chunk, const CsvRow& row) {
+        chunks[chunk].push_back({row[currency_col], file.parse_double(row, tenor_col, "tenor"),
+                                 file.parse_double(row, rate_col, "rate")});
+    });
+
+    std::map<std::string, std::vector<std::pair<double, double>>> pillars;
+    for (const auto& rows : chunks) {
+        for (const auto& p : rows) pillars[std::string(p.currency)].emplace_back(p.tenor, p.rate);
+    }
+
+    for (auto& [currency, points] : pillars) {
+        std::sort(points.begin(), points.end());
+        std::vector<double> tenors, rates;
+        for (const auto& [tenor, rate] : points) {
+            if (!tenors.empty() && tenor == tenors.back()) {
+                throw std::runtime_error(path + ": duplicate tenor " + std::to_string(tenor) + " for " + currency);
+            }
+            tenors.push_back(tenor);
+            rates.push_back(rate);
+        }
+        env.set_yield_curve(currency, YieldCurve(tenors, rates));
+    }
+}
+
+std::map<std::string, std::vector<RateQuote>> DataLoader::load_rate_quotes(const std::string& path,
+                                                                         const LoadOptions& options) {
+    DelimitedFile file(path, options);
+    size_t currency_col = file.column("currency");
+    size_t type_col = file.column("type");
+    size_t maturity_col = file.column("maturity");
+    size_t quote_col = file.column("quote");
+    size_t start_col = file.find_column("start");
+    size_t frequency_col = file.find_column("frequency");
+    size_t convexity_col = file.find_column("convexity");
+
+    std::vector<std::vector<std::pair<std::string_view, RateQuote>>> chunks(file.num_chunks());
+    file.parse([&](size_t chunk, const CsvRow& row) {
+        RateQuote q;
+        std::string_view type = row[type_col];
+        if (equals_ignore_case(type, "deposit")) {
+            q.type = RateInstrument::Deposit;
+        } else if (equals_ignore_case(type, "fra")) {
+            q.type = RateInstrument::FRA;
+        } else if (equals_ignore_case(type, "future")) {
+            q.type = RateInstrument::Future;
+        } else if (equals_ignore_case(type, "swap")) {
+            q.type = RateInstrument::Swap;
+        } else {
+            file.fail(row.line, "invalid rate instrument type '" + std::string(type) + "'");
+        }
+        q.maturity = file.parse_double(row, maturity_col, "maturity");
+        q.value = file.parse_double(row, quote_col, "quote");
+        q.start = row[start_col].empty() ? 0.0 : file.parse_double(row, start_col, "start");
+        q.convexity = row[convexity_col].empty() ? 0.0 : file.parse_double(row, convexity_col, "convexity");
+        if (!row[frequency_col].empty()) {
+            double frequency = file.parse_double(row, frequency_col, "frequency");
+            if (!(frequency >= 1.0 && frequency <= 365.0) || frequency != std::floor(frequency)) {
+                file.fail(row.line, "invalid frequency '" + std::string(row[frequency_col]) + "'");
+            }
+            q.frequency = static_cast<unsigned>(frequency);
+        }
+        chunks[chunk].emplace_back(row[currency_col], q);
+    });
+
+    std::map<std::string, std::vector<RateQuote>> quotes;
+    for (const auto& rows : chunks) {
+        for (const auto& [currency, q] : rows) quotes[std::string(currency)].push_back(q);
+    }
+    return quotes;
+}
+
+void DataLoader::load_vol_surfaces(const std::string& path, MarketEnvironment& env, const LoadOptions& options) {
+    DelimitedFile file(path, options);
+    size_t ticker_col = file.column("ticker");
+    size_t expiry_col = file.column("expiry");
+    size_t strike_col = file.column("strike");
+    size_t vol_col = file.column("vol");
+
+    struct VolPoint { double expiry, strike, vol; };
+    std::vector<std::vector<std::pair<std::string_view, VolPoint>>> chunks(file.num_chunks());
+    file.parse([&](size_t chunk, const CsvRow& row) {
+        chunks[chunk].emplace_back(row[ticker_col], VolPoint{file.parse_double(row, expiry_col, "expiry"),
+                                                             file.parse_double(row, strike_col, "strike"),
+                                                             file.parse_double(row, vol_col, "vol")});
+    });
+
+    std::map<std::string_view, std::vector<VolPoint>> points_by_ticker;
+    for (const auto& rows : chunks) {
+        for (const auto& [ticker, point] : rows) points_by_ticker[ticker].push_back(point);
+    }
+
+    // Each ticker's points must cover the full expiry x strike grid
+    for (const auto& [ticker, points] : points_by_ticker) {
+        std::vector<double> expiries, strikes;
+        for (const auto& p : points) {
+            expiries.push_back(p.expiry);
+            strikes.push_back(p.strike);
+        }
+        for (auto* axis : {&expiries, &strikes}) {
+            std::sort(axis->begin(), axis->end());
+            axis->erase(std::unique(axis->begin(), axis->end()), axis->end());
+        }
+
+        std::vector<std::vector<double>> vols(expiries.size(),
+                                              std::vector<double>(strikes.size(), std::nan("")));
+        for (const auto& p : points) {
+            size_t e = static_cast<size_t>(std::lower_bound(expiries.begin(), expiries.end(), p.expiry) - expiries.begin());
+            size_t k = static_cast<size_t>(std::lower_bound(strikes.begin(), strikes.end(), p.strike) - strikes.begin());
+            vols[e][k] = p.vol;
+        }
+        for (const auto& row : vols) {
+            if (std::any_of(row.begin(), row.end(), [](double v) { return std::isnan(v); })) {
+                throw std::runtime_error(path + ": incomplete vol grid for " + std::string(ticker));
+            }
+        }
+        env.set_vol_surface(std::string(ticker), VolatilitySurface(strikes, expiries, vols));
+    }
+}
+
+std::vector<OptionQuote> DataLoader::load_option_quotes(const std::string& path, const LoadOptions& options) {
+    DelimitedFile file(path, options);
+    size_t ticker_col = file.column("ticker");
+    size_t strike_col = file.column("strike");
+    size_t expiry_col = file.column("expiry");
+    size_t premium_col = file.column("premium");
+    size_t option_type_col = file.column("option_type");
+    size_t currency_col = file.find_column("currency");
+
+    // Tickers and currencies stay views into the mapping until the merge
+    struct QuoteRow { std::string_view ticker, currency; OptionQuote quote; };
+    std::vector<std::vector<QuoteRow>> chunks(file.num_chunks());
+    file.parse([&](size_t chunk, const CsvRow& row) {
+        QuoteRow q;
+        q.ticker = row[ticker_col];
+        q.currency = row[currency_col];
+        q.quote.strike = file.parse_double(row, strike_col, "strike");
+        q.quote.expiry = file.parse_double(row, expiry_col, "expiry");
+        q.quote.premium = file.parse_double(row, premium_col, "premium");
+        std::string_view option_type = row[option_type_col];
+        if (equals_ignore_case(option_type, "put")) {
+            q.quote.is_call = false;
+        } else if (!equals_ignore_case(option_type, "call")) {
+            file.fail(row.line, "invalid option_type '" + std::string(option_type) + "'");
+        }
+        chunks[chunk].push_back(std::move(q));
+    });
+
+    std::vector<OptionQuote> quotes;
+    size_t total = 0;
+    for (const auto& rows : chunks) total += rows.size();
+    quotes.reserve(total);
+    for (auto& rows : chunks) {
+        for (auto& q : rows) {
+            quotes.push_back(std::move(q.quote));
+            quotes.back().ticker = std::string(q.ticker);
+            quotes.back().currency = std::string(q.currency);
+        }
+    }
+    return quotes;
+}
+
+CorrelationMatrix DataLoader::load_correlation(const std::string& path, const LoadOptions& options) {
+    DelimitedFile file(path, options);
+    const auto& header = file.get_header();
+    if (header.size() < 2) throw std::runtime_error(path + ": correlation header has no tickers");
+
+    size_t n = header.size() - 1;
+    std::vector<std::string> tickers;
+    std::unordered_map<std::string_view, size_t> index;
+    tickers.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        tickers.emplace_back(header[i + 1]);
+        if (!index.emplace(header[i + 1], i).second) {
+            throw std::runtime_error(path + ": duplicate ticker " + tickers.back());
+        }
+    }
+
+    // Symmetric: the row of ticker j is written as column j
+    std::vector<double> corr(n * n);
+    std::vector<std::atomic<bool>> seen(n);
+    for (auto& s : seen) s.store(false, std::memory_order_relaxed);
+
+    file.parse_lines([&](size_t, std::string_view line) {
+        const char* at = line.data();
+        std::string_view ticker = next_field(line, options.delimiter);
+        auto it = index.find(ticker);
+        if (it == index.end()) file.fail(at, "ticker '" + std::string(ticker) + "' is not in the header");
+        size_t j = it->second;
+        if (seen[j].exchange(true)) file.fail(at, "duplicate row for " + std::string(ticker));
+
+        double* column = corr.data() + j * n;
+        size_t i = 0;
+        while (!line.empty()) {
+            if (i == n) file.fail(at, "too many values in row " + std::string(ticker));
+            column[i++] = file.parse_double(next_field(line, options.delimiter), at, "correlation");
+        }
+        if (i != n) file.fail(at, "too few values in row " + std::string(ticker));
+    });
+
+    for (size_t j = 0; j < n; ++j) {
+        if (!seen[j]) throw std::runtime_error(path + ": missing row for " + tickers[j]);
+        for (size_t i = j + 1; i < n; ++i) {
+            if (std::abs(corr[j * n + i] - corr[i * n + j]) > 1e-9) {
+                throw std::runtime_error(path + ": matrix is not symmetric at (" + tickers[i] + ", " + tickers[j] + ")");
+            }
+        }
+    }
+    return CorrelationMatrix::from_column_major(tickers, std::move(corr));
+}
+
+std::vector<TickBatch> DataLoader::load_ticks(const std::string& path, const LoadOptions& options) {
+    DelimitedFile file(path, options);
+    size_t batch_col = file.column("batch");
+    size_t type_col = file.column("type");
+    size_t key_col = file.column("key");
+    size_t value_col = file.column("value");
+
+    struct TickRow { std::string_view batch; TickType type; std::string_view key; double value; };
+    std::vector<std::vector<TickRow>> chunks(file.num_chunks());
+    file.parse([&](size_t chunk, const CsvRow& row) {
+        std::string_view type = row[type_col];
+        TickRow r{row[batch_col], TickType::Spot, row[key_col], file.parse_double(row, value_col, "value")};
+        if (equals_ignore_case(type, "vol")) {
+            r.type = TickType::Vol;
+        } else if (equals_ignore_case(type, "rate")) {
+            r.type = TickType::Rate;
+        } else if (!equals_ignore_case(type, "spot")) {
+            file.fail(row.line, "invalid tick type '" + std::string(type) + "'");
+        }
+        chunks[chunk].push_back(r);
+    });
+
+    std::vector<TickBatch> batches;
+    std::string_view current;
+    for (const auto& rows : chunks) {
+        for (const auto& r : rows) {
+            if (batches.empty() || r.batch != current) {
+                batches.emplace_back();
+                current = r.batch;
+            }
+            batches.back().push_back({r.type, std::string(r.key), r.value});
+        }
+    }
+    return batches;
+}
+
+// ============================================================================
+// COLUMNAR BINARY POSITIONS
+// ============================================================================
+
+constexpr char kPositionsMagic[8] = {'R', 'S', 'K', 'C', 'O', 'L', 'S', '\0'};
+constexpr std::uint32_t kPositionsVersion = 1;
+
+void DataLoader::save_positions_columnar(const MarketSimulator& market, const std::string& path) {
+    const InstrumentRegistry& registry = market.get_registry();
+    std::vector<std::string> owners, currencies, tickers;
+    std::unordered_map<InstrumentId, std::uint32_t> ticker_index;
+    std::vector<std::uint32_t> portfolio_column, ticker_column;
+    std::vector<double> quantity_column;
+
+    for (size_t id = 0; id < market.get_portfolio_count(); ++id) {
+        const Portfolio& portfolio = market.get_portfolio(id);
+        owners.push_back(portfolio.get_owner());
+        currencies.push_back(portfolio.get_currency());
+        for (size_t i = 0; i < portfolio.get_position_count(); ++i) {
+            const Position& pos = portfolio.get_position(i);
+            auto [it, inserted] = ticker_index.emplace(pos.get_instrument_id(), static_cast<std::uint32_t>(tickers.size()));
+            if (inserted) tickers.push_back(registry.get(pos.get_instrument_id()).get_ticker());
+            portfolio_column.push_back(static_cast<std::uint32_t>(id));
+            ticker_column.push_back(it->second);
+            quantity_column.push_back(pos.get_quantity());
+        }
+    }
+
+    SnapshotWriter out;
+    out.write_bytes(kPositionsMagic, sizeof(kPositionsMagic));
+    out.write(kPositionsVersion);
+    out.write(kSnapshotByteOrderMark);
+    out.write_strings(owners);
+    out.write_strings(currencies);
+    out.write_strings(tickers);
+    out.write_array(portfolio_column);
+    out.write_array(ticker_column);
+    out.write_array(quantity_column);
+    out.save(path);
+}
+
+std::map<std::string, size_t> DataLoader::load_positions_columnar(const std::string& path, MarketSimulator& market) {
+    MappedFile file(path);
+    SnapshotReader in(file.data(), file.size());
+
+    char magic[sizeof(kPositionsMagic)];
+    for (auto& c : magic) c = in.read<char>();
+    if (std::memcmp(magic, kPositionsMagic, sizeof(kPositionsMagic)) != 0) {
+        throw std::runtime_error("Not a columnar positions file: " + path);
+    }
+    if (in.read<std::uint32_t>() != kPositionsVersion) {
+        throw std::runtime_error("Unsupported columnar positions version: " + path);
+    }
+    if (in.read<std::uint32_t>() != kSnapshotByteOrderMark) {
+        throw std::runtime_error("Columnar positions written with a different byte order: " + path);
+    }
+
+    auto owners = in.read_strings();
+    auto currencies = in.read_strings();
+    auto tickers = in.read_strings();
+    auto portfolio_column = in.read_array<std::uint32_t>();
+    auto ticker_column = in.read_array<std::uint32_t>();
+    auto quantity_column = in.read_array<double>();
+    if (currencies.size() != owners.size() || ticker_column.size() != portfolio_column.size() ||
+        quantity_column.size() != portfolio_column.size() || !in.at_end()) {
+        throw std::runtime_error("Corrupt columnar positions file: " + path);
+    }
+
+    // Dictionaries are resolved once
+    std::vector<InstrumentId> instruments;
+    instruments.reserve(tickers.size());
+    for (const auto& ticker : tickers) {
+        instruments.push_back(market.get_registry().find(ticker));
+        if (instruments.back() == kInvalidInstrumentId) {
+            throw std::runtime_error(path + ": unknown instrument '" + ticker + "'");
+        }
+    }
+    auto by_owner = portfolios_by_owner(market);
+    std::vector<size_t> portfolios;
+    portfolios.reserve(owners.size());
+    for (size_t i = 0; i < owners.size(); ++i) {
+        portfolios.push_back(portfolio_for(market, by_owner, owners[i], currencies[i]));
+    }
+
+    for (size_t r = 0; r < portfolio_column.size(); ++r) {
+        if (portfolio_column[r] >= portfolios.size() || ticker_column[r] >= instruments.size()) {
+            throw std::runtime_error("Corrupt columnar positions file: " + path);
+        }
+    }
+    append_positions(market, [&](auto&& f) {
+        for (size_t r = 0; r < portfolio_column.size(); ++r) {
+            f(portfolios[portfolio_column[r]], instruments[ticker_column[r]], quantity_column[r]);
+        }
+    });
+    return by_owner;
+}
@@ -0,0 +1,105 @@
+// Implementation of the DependencyGraph
+
+#include "../include/dependencyGraph.hh"
+
+#include <algorithm>
+
+bool DependencyGraph::is_stale(const InstrumentRegistry& registry, const std::vector<Portfolio>& portfolios) const {
+    return generation_ == 0 || registry.get_generation() != built_book_generation_ ||
+           portfolios.size() != built_portfolios_;
+}
+
+void DependencyGraph::build(const InstrumentRegistry& registry, const std::vector<Portfolio>& portfolios) {
+    // Curve edges
+    options_by_currency_.clear();
+    bonds_by_currency_.clear();
+    std::uint32_t index = 0;
+    registry.for_each_option([&](const Option& option) {
+        options_by_currency_[option.get_currency()].push_back(make_instrument_id(InstrumentType::Option, index++));
+    });
+    index = 0;
+    registry.for_each_bond([&](const Bond& bond) {
+        bonds_by_currency_[bond.get_currency()].push_back(make_instrument_id(InstrumentType::Bond, index++));
+    });
+
+    // Holders, CSR by instrument: count, prefix-sum, fill
+    size_t counts[3] = {registry.stock_count(), registry.option_count(), registry.bond_count()};
+    for (size_t type = 0; type < 3; ++type) holder_offsets_[type].assign(counts[type] + 1, 0);
+    for (const auto& portfolio : portfolios) {
+        for (size_t i = 0; i < portfolio.get_position_count(); ++i) {
+            InstrumentId id = portfolio.get_position(i).get_instrument_id();
+            ++holder_offsets_[static_cast<size_t>(get_instrument_type(id))][get_instrument_index(id) + 1];
+        }
+    }
+    std::vector<std::uint32_t> fill[3];
+    for (size_t type = 0; type < 3; ++type) {
+        auto& offsets = holder_offsets_[type];
+        for (size_t i = 1; i < offsets.size(); ++i) offsets[i] += offsets[i - 1];
+        holders_[type].resize(offsets.back());
+        fill[type].assign(offsets.begin(), offsets.end() - 1);
+    }
+
+    buckets_.assign(portfolios.size(), {});
+    bucket_count_ = 0;
+    for (size_t p = 0; p < portfolios.size(); ++p) {
+        auto& buckets = buckets_[p];
+        const Portfolio& portfolio = portfolios[p];
+        for (size_t i = 0; i < portfolio.get_position_count(); ++i) {
+            const Position& pos = portfolio.get_position(i);
+            InstrumentId id = pos.get_instrument_id();
+            const std::string* currency = registry.get(id).get_currency_ptr();
+
+            // Few currencies per portfolio: linear scan
+            auto it = std::find_if(buckets.begin(), buckets.end(),
+                                   [&](const Bucket& b) { return b.first == currency; });
+            if (it == buckets.end()) {
+                buckets.emplace_back(currency, static_cast<std::uint32_t>(bucket_count_++));
+                it = buckets.end() - 1;
+            }
+
+            size_t type = static_cast<size_t>(get_instrument_type(id));
+            holders_[type][fill[type][get_instrument_index(id)]++] =
+                {static_cast<std::uint32_t>(p), it->second, pos.get_quantity()};
+        }
+    }
+
+    built_book_generation_ = registry.get_generation();
+    built_portfolios_ = portfolios.size();
+    ++generation_;
+}
+
+const std::vector<InstrumentId>& DependencyGraph::get_options_in_currency(const std::string& currency) const {
+    static const std::vector<InstrumentId> kNone;
+    auto it = options_by_currency_.find(currency);
+    return it != options_by_currency_.end() ? it->second : kNone;
+}
+
+const std::vector<InstrumentId>& DependencyGraph::get_bonds_in_currency(const std::string& currency) const {
+    static const std::vector<InstrumentId> kNone;
+    auto it = bonds_by_currency_.find(currency);
+    return it != bonds_by_currency_.end() ? it->second : kNone;
+}
+
+std::vector<InstrumentId> DependencyGraph::get_affected_options(const InstrumentRegistry& registry,
+                                                                const std::vector<InstrumentId>& underlyings) const {
+    std::vector<InstrumentId> options;
+    for (InstrumentId stock : underlyings) {
+        const auto& dependents = registry.get_dependent_options(stock);
+        options.insert(options.end(), dependents.begin(), dependents.end());
+    }
+    std::sort(options.begin(), options.end());
+    options.erase(std::unique(options.begin(), options.end()), options.end());
+    return options;
+}
+
+std::vector<size_t> DependencyGraph::get_affected_portfolios(const std::vector<InstrumentId>& instruments) const {
+    std::vector<char> hit(buckets_.size(), 0);
+    for (InstrumentId id : instruments) {
+        for (const auto& holder : get_holders(id)) hit[holder.portfolio] = 1;
+    }
+    std::vector<size_t> portfolios;
+    for (size_t p = 0; p < hit.size(); ++p) {
+        if (hit[p]) portfolios.push_back(p);
+    }
+    return portfolios;
+}
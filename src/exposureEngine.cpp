@@ -0,0 +1,87 @@
+// Implementation of the counterparty exposure engine
+
+#include "../include/exposureEngine.hh"
+#include "../include/nestedSimulation.hh"
+#include "../include/scenarioBook.hh"
+#include "../include/parallel.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+ExposureEngine::ExposureEngine(Model& model, const MarketEnvironment& env, const ExposureSettings& settings)
+    : model_(model), env_(env), settings_(settings) {
+    if (settings_.dates.empty()) throw std::invalid_argument("ExposureEngine: no exposure dates");
+    if (settings_.num_paths == 0 || settings_.block_paths == 0 || settings_.steps_per_year == 0) {
+        throw std::invalid_argument("ExposureEngine: paths, block size and steps per year must be positive");
+    }
+    // Same snapping as the path simulation
+    for (double t : settings_.dates) {
+        double steps = std::max(1.0, static_cast<double>(std::llround(t * settings_.steps_per_year)));
+        dates_.push_back(steps / settings_.steps_per_year);
+    }
+}
+
+void ExposureEngine::run(const std::vector<Portfolio>& netting_sets) {
+    size_t num_dates = dates_.size();
+    num_netting_sets_ = netting_sets.size();
+    paths_run_ = 0;
+    exposure_sums_.assign(num_netting_sets_ * num_dates, 0.0);
+    sketches_.assign(num_netting_sets_ * num_dates, QuantileSketch(settings_.relative_accuracy, settings_.max_buckets));
+    if (netting_sets.empty()) return;
+
+    ScenarioBook book(netting_sets, env_, dates_);
+    size_t num_instruments = book.num_instruments();
+
+    // Blocks of paths: simulate, revalue every instrument, then stream each
+    // netting set's exposures
+    NestedSimulationSettings path_settings;
+    path_settings.horizons = dates_;
+    path_settings.steps_per_year = settings_.steps_per_year;
+    path_settings.inner_paths = 1;  // Outer paths only
+    std::vector<double> values;     // [date][instrument][path], base currency
+    for (size_t block = 0; paths_run_ < settings_.num_paths; ++block) {
+        size_t num_paths = std::min(settings_.block_paths, settings_.num_paths - paths_run_);
+        path_settings.outer_paths = num_paths;
+        path_settings.seed = settings_.seed + static_cast<unsigned>(block);
+        NestedSimulator paths(model_, env_, book.get_initial_prices(), path_settings);
+
+        values.resize(num_dates * num_instruments * num_paths);
+        parallel_for(0, num_instruments, 16, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                for (size_t d = 0; d < num_dates; ++d) {
+                    double* out = &values[(d * num_instruments + i) * num_paths];
+                    for (size_t p = 0; p < num_paths; ++p) {
+                        const NodeState* node = paths.get_node(d, p);
+                        out[p] = book.value(i, d, [node](std::uint32_t f) { return node[f].spot; });
+                    }
+                }
+            }
+        }, settings_.num_threads);
+
+        parallel_for(0, num_netting_sets_, 8, [&](size_t lo, size_t hi) {
+            std::vector<double> netted(num_paths);
+            for (size_t s = lo; s < hi; ++s) {
+                std::uint32_t reporting_fx = book.get_reporting_fx(s);
+                for (size_t d = 0; d < num_dates; ++d) {
+                    std::fill(netted.begin(), netted.end(), 0.0);
+                    for (const auto* term = book.terms_begin(s); term != book.terms_end(s); ++term) {
+                        const double* row = &values[(d * num_instruments + term->instrument) * num_paths];
+                        for (size_t p = 0; p < num_paths; ++p) netted[p] += term->quantity * row[p];
+                    }
+                    QuantileSketch& sketch = sketches_[s * num_dates + d];
+                    double sum = 0.0;
+                    for (size_t p = 0; p < num_paths; ++p) {
+                        double to_reporting = reporting_fx == ScenarioBook::kNone ? 1.0
+                                            : 1.0 / paths.get_node(d, p)[reporting_fx].spot;
+                        double exposure = std::max(netted[p] * to_reporting, 0.0);
+                        sum += exposure;
+                        sketch.add(exposure);
+                    }
+                    exposure_sums_[s * num_dates + d] += sum;
+                }
+            }
+        }, settings_.num_threads);
+        paths_run_ += num_paths;
+    }
+}
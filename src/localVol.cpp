@@ -0,0 +1,116 @@
+// Implementation of the local volatility (Dupire) model
+
+#include "../include/localVol.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// ============================================================================
+// LOCAL VOL GRID
+// ============================================================================
+
+LocalVolGrid::LocalVolGrid(const VolatilitySurface& surface, double spot, double rate,
+                           const LocalVolSettings& settings)
+    : num_times_(settings.time_steps + 1), num_spots_(settings.spot_steps + 1) {
+    if (settings.time_steps < 1 || settings.spot_steps < 1) {
+        throw std::invalid_argument("LocalVolGrid: need at least one time and one spot interval");
+    }
+    if (!(spot > 0.0)) throw std::invalid_argument("LocalVolGrid: spot must be positive");
+
+    double max_time = settings.max_time;
+    if (!(max_time > 0.0)) max_time = surface.get_expiries().empty() ? 1.0 : surface.get_expiries().back();
+    double time_step = max_time / settings.time_steps;
+    double width = settings.num_std_devs * surface.get_atm_vol(max_time) * std::sqrt(max_time);
+    spot_min_ = spot * std::exp(-width);
+    double spot_step = (spot * std::exp(width) - spot_min_) / settings.spot_steps;
+    inv_time_step_ = 1.0 / time_step;
+    inv_spot_step_ = 1.0 / spot_step;
+    max_time_index_ = static_cast<double>(num_times_ - 1);
+    max_spot_index_ = static_cast<double>(num_spots_ - 1);
+
+    // Total variance at log-moneyness y off the forward at expiry T
+    auto total_variance = [&](double y, double T) {
+        double vol = surface.get_vol(spot * std::exp(rate * T + y), T);
+        return vol * vol * T;
+    };
+
+    // Differences span about one grid cell, so kinks of the surface's
+    // bilinear interpolation are smoothed over the cell rather than
+    // producing spikes at the nodes next to them
+    double h_time = 0.5 * time_step;
+    vols_.resize(num_times_ * num_spots_);
+    for (size_t i = 0; i < num_times_; ++i) {
+        double T = std::max(i * time_step, h_time);  // t = 0: the shortest differenced expiry
+        double forward = spot * std::exp(rate * T);
+        for (size_t j = 0; j < num_spots_; ++j) {
+            double S = spot_min_ + j * spot_step;
+            double y = std::log(S / forward);
+            double h_y = 0.5 * std::log((S + spot_step) / std::max(S - spot_step, 0.5 * S));
+
+            double w = total_variance(y, T);
+            double w_up = total_variance(y + h_y, T);
+            double w_down = total_variance(y - h_y, T);
+            double dw_dt = (total_variance(y, T + h_time) - total_variance(y, T - 0.5 * h_time)) / (1.5 * h_time);
+            double dw_dy = (w_up - w_down) / (2.0 * h_y);
+            double d2w_dy2 = (w_up - 2.0 * w + w_down) / (h_y * h_y);
+
+            double denominator = 1.0 - y / w * dw_dy
+                               + 0.25 * (-0.25 - 1.0 / w + y * y / (w * w)) * dw_dy * dw_dy
+                               + 0.5 * d2w_dy2;
+            double vol;
+            if (dw_dt > 0.0 && denominator > 0.0) {
+                vol = std::sqrt(dw_dt / denominator);
+            } else {
+                vol = std::sqrt(w / T);
+                ++fallback_nodes_;
+            }
+            vols_[i * num_spots_ + j] = std::min(std::max(vol, settings.min_vol), settings.max_vol);
+        }
+    }
+}
+
+// ============================================================================
+// LOCAL VOL MODEL
+// ============================================================================
+
+void LocalVolModel::add_underlying(const std::string& ticker, const MarketEnvironment& env) {
+    add_underlying(ticker, env.get_vol_surface(ticker), env.get_spot(ticker), env.get_drift_rate(ticker));
+}
+
+void LocalVolModel::add_underlying(const std::string& ticker, const VolatilitySurface& surface,
+                                   double spot, double rate) {
+    grids_.insert_or_assign(ticker, LocalVolGrid(surface, spot, rate, settings_));
+}
+
+double LocalVolModel::simulate_step(double current_price, double dt,
+                                    const std::string& ticker,
+                                    const MarketEnvironment& env) {
+    double z = normal_dist_(generator_);
+    return simulate_step(current_price, dt, z, ticker, env);
+}
+
+double LocalVolModel::simulate_step(double current_price, double dt, double random_z,
+                                    const std::string& ticker,
+                                    const MarketEnvironment& env) {
+    double r = env.get_drift_rate(ticker);
+    const LocalVolGrid* grid = get_local_vol(ticker);
+    double sigma = grid ? grid->get_vol(0.0, current_price)
+                        : ForwardVolTable::get_forward_vol(env.get_vol_surface(ticker), dt, 0);
+    return simulate_step(current_price, dt, random_z, r, sigma);
+}
+
+double LocalVolModel::price_option(double S, double K, double T,
+                                   const std::string& ticker,
+                                   const MarketEnvironment& env,
+                                   bool is_call) const {
+    return price_option(S, K, T, env.get_rate(T, env.get_currency(ticker)), env.get_vol(ticker, K, T), is_call);
+}
+
+Greeks LocalVolModel::calculate_greeks(double S, double K, double T,
+                                       const std::string& ticker,
+                                       const MarketEnvironment& env,
+                                       bool is_call) const {
+    return calculate_greeks(S, K, T, env.get_rate(T, env.get_currency(ticker)), env.get_vol(ticker, K, T),
+                            is_call);
+}
@@ -74,9 +74,15 @@ int main() {
         };
         VolatilitySurface googl_surface(strikes_googl, expiries, googl_vols);
         
+        // EUR curve: discounts EUR options and drifts EUR stocks
+        YieldCurve eur_curve({0.25, 0.5, 1.0, 2.0, 5.0, 10.0},
+                             {0.025, 0.026, 0.027, 0.029, 0.031, 0.033});
+        
         // Assemble market environment
         MarketEnvironment market_env;
         market_env.set_yield_curve("USD", usd_curve);
+        market_env.set_yield_curve("EUR", eur_curve);
+        market_env.set_vol_surface("SAP", VolatilitySurface(0.24));
         market_env.set_vol_surface("AAPL", aapl_surface);
         market_env.set_vol_surface("TSLA", tsla_surface);
         market_env.set_vol_surface("GOOGL", googl_surface);
@@ -85,6 +91,12 @@ int main() {
         market_env.set_spot("AAPL", 150.0);
         market_env.set_spot("TSLA", 250.0);
         market_env.set_spot("GOOGL", 140.0);
+        market_env.set_spot("SAP", 180.0);  // EUR
+
+        // FX factor: EURUSD is simulated jointly with the equities, and EUR
+        // positions are converted at its simulated rate
+        market_env.set_fx_spot("EUR", 1.08);
+        market_env.set_vol_surface(market_env.get_fx_ticker("EUR"), VolatilitySurface(0.08));
 
         // ====================================================================
         // CORRELATION MATRIX - Critical for realistic risk simulation!
@@ -93,13 +105,16 @@ int main() {
         // ====================================================================
         
         // Realistic equity correlations (based on historical data)
-        // In a crash, correlations converge to ~1.0 (not modeled here - would need DCC-GARCH)
-        std::vector<std::string> corr_tickers = {"AAPL", "GOOGL", "TSLA"};
+        // In a crash, correlations converge to ~1.0 (static here - see CorrelationRegimes
+        // for Markov regime-switching between calm and stressed matrices)
+        std::vector<std::string> corr_tickers = {"AAPL", "GOOGL", "TSLA", "SAP", "EURUSD"};
         std::vector<std::vector<double>> corr_matrix = {
-            //   AAPL  GOOGL  TSLA
-            {   1.00,  0.65,  0.45},  // AAPL: High correlation with GOOGL (both big tech)
-            {   0.65,  1.00,  0.40},  // GOOGL: Moderate correlation with TSLA
-            {   0.45,  0.40,  1.00}   // TSLA: Lower correlation (more idiosyncratic)
+            //   AAPL  GOOGL  TSLA   SAP  EURUSD
+            {   1.00,  0.65,  0.45,  0.50,  0.10},  // AAPL: High correlation with GOOGL (both big tech)
+            {   0.65,  1.00,  0.40,  0.45,  0.10},  // GOOGL: Moderate correlation with TSLA
+            {   0.45,  0.40,  1.00,  0.30,  0.05},  // TSLA: Lower correlation (more idiosyncratic)
+            {   0.50,  0.45,  0.30,  1.00,  0.25},  // SAP: European tech, tied to EURUSD
+            {   0.10,  0.10,  0.05,  0.25,  1.00}   // EURUSD
         };
         CorrelationMatrix equity_corr(corr_tickers, corr_matrix);
         market_env.set_correlation_matrix(equity_corr);
@@ -113,20 +128,23 @@ int main() {
         // Wire market environment into simulator for CORRELATED simulation
         market.set_market_environment(market_env);
 
-        // Create shared instruments (pure DATA - no logic)
-        auto apple = std::make_shared<Stock>("AAPL", 150.0);
-        auto google = std::make_shared<Stock>("GOOGL", 140.0);
-        auto tesla = std::make_shared<Stock>("TSLA", 250.0);
+        // Create shared instruments (pure DATA - no logic) in the simulator's
+        // pooled registry; portfolios reference them by compact InstrumentId
+        InstrumentRegistry& registry = market.get_registry();
+        InstrumentId apple = market.add_stock("AAPL", 150.0);
+        InstrumentId google = market.add_stock("GOOGL", 140.0);
+        InstrumentId tesla = market.add_stock("TSLA", 250.0);
+        InstrumentId sap = market.add_stock("SAP", 180.0, "EUR");
         
         // Options need reference to underlying stock + time to expiry
-        auto tesla_call = std::make_shared<Option>(
+        InstrumentId tesla_call = registry.add_option(
             "TSLA-C-300", 15.0, 300.0, tesla, 0.5, Option::Type::Call
         );
-        auto apple_put = std::make_shared<Option>(
+        InstrumentId apple_put = registry.add_option(
             "AAPL-P-140", 8.0, 140.0, apple, 0.25, Option::Type::Put
         );
         
-        auto treasury = std::make_shared<Bond>("T-10Y", 98.5, 8.5, 0.04);
+        InstrumentId treasury = registry.add_bond("T-10Y", 98.5, 8.5, 0.04);
 
         // Portfolio 1: Conservative (Grandfather) - mostly bonds
         size_t id_retirement = market.create_portfolio("Grandfather", "USD");
@@ -139,6 +157,7 @@ int main() {
         market.get_portfolio(id_savings).add_position(google, 150);
         market.get_portfolio(id_savings).add_position(apple_put, 50);
         market.get_portfolio(id_savings).add_position(treasury, 30);
+        market.get_portfolio(id_savings).add_position(sap, 40);  // Valued in USD at EURUSD
 
         // Portfolio 3: Aggressive (Nephew) - stocks + call options
         size_t id_aggressive = market.create_portfolio("Nephew", "USD");
@@ -162,15 +181,23 @@ int main() {
         std::cout << "    AAPL: " << (market_env.get_vol("AAPL", 150, 0.5) * 100) << "%" << std::endl;
         std::cout << "    TSLA: " << (market_env.get_vol("TSLA", 250, 0.5) * 100) << "%" << std::endl;
         std::cout << "    GOOGL: " << (market_env.get_vol("GOOGL", 140, 0.5) * 100) << "%" << std::endl;
+        std::cout << "    SAP:   " << (market_env.get_vol("SAP", 180, 0.5) * 100) << "% (EUR)" << std::endl;
+        std::cout << "  EURUSD: " << std::setprecision(4) << market_env.get_fx_spot("EUR") << std::endl;
         std::cout << std::endl;
 
         // Display correlation matrix
         std::cout << "  Correlation Matrix:" << std::endl;
-        std::cout << "           AAPL   GOOGL   TSLA" << std::endl;
-        std::cout << "    AAPL   1.00   0.65    0.45" << std::endl;
-        std::cout << "    GOOGL  0.65   1.00    0.40" << std::endl;
-        std::cout << "    TSLA   0.45   0.40    1.00" << std::endl;
-        std::cout << std::endl;
+        std::cout << "          ";
+        for (const auto& ticker : corr_tickers) std::cout << std::setw(8) << ticker;
+        std::cout << std::endl << std::fixed << std::setprecision(2);
+        for (const auto& row_ticker : corr_tickers) {
+            std::cout << "    " << std::left << std::setw(6) << row_ticker << std::right;
+            for (const auto& col_ticker : corr_tickers) {
+                std::cout << std::setw(8) << market_env.get_correlation_matrix().get_correlation(row_ticker, col_ticker);
+            }
+            std::cout << std::endl;
+        }
+        std::cout << std::defaultfloat << std::endl;
 
         // Show Cholesky factor (lower triangular L where Σ = L*L^T)
         const auto& L = market_env.get_correlation_matrix().get_cholesky();
@@ -179,7 +206,7 @@ int main() {
         for (size_t i = 0; i < L.size(); ++i) {
             std::cout << "    ";
             for (size_t j = 0; j < L[i].size(); ++j) {
-                std::cout << std::setw(8) << L[i][j];
+                std::cout << std::setw(10) << L[i][j];
             }
             std::cout << std::endl;
         }
@@ -211,9 +238,11 @@ int main() {
         std::cout << "    (Using Cholesky decomposition - assets move together)" << std::endl;
         
         // Store pre-simulation prices for comparison
-        double aapl_start = apple->get_price();
-        double googl_start = google->get_price();
-        double tsla_start = tesla->get_price();
+        double aapl_start = registry.get(apple).get_price();
+        double googl_start = registry.get(google).get_price();
+        double tsla_start = registry.get(tesla).get_price();
+        double sap_start = registry.get(sap).get_price();
+        double eurusd_start = market.get_market_environment().get_fx_spot("EUR");
         
         market.simulate_days(252);
         
@@ -224,14 +253,17 @@ int main() {
         std::cout << std::endl;
         
         // Show how correlation affected price moves
-        double aapl_return = (apple->get_price() - aapl_start) / aapl_start * 100;
-        double googl_return = (google->get_price() - googl_start) / googl_start * 100;
-        double tsla_return = (tesla->get_price() - tsla_start) / tsla_start * 100;
+        double aapl_return = (registry.get(apple).get_price() - aapl_start) / aapl_start * 100;
+        double googl_return = (registry.get(google).get_price() - googl_start) / googl_start * 100;
+        double tsla_return = (registry.get(tesla).get_price() - tsla_start) / tsla_start * 100;
+        double sap_return = (registry.get(sap).get_price() - sap_start) / sap_start * 100;
+        double eurusd_return = (market.get_market_environment().get_fx_spot("EUR") - eurusd_start) / eurusd_start * 100;
         
         std::cout << "  Simulated Returns (correlated):" << std::endl;
         std::cout << "    AAPL:  " << std::showpos << std::setprecision(1) << aapl_return << "%" << std::endl;
         std::cout << "    GOOGL: " << googl_return << "%" << std::endl;
-        std::cout << "    TSLA:  " << tsla_return << "%" << std::noshowpos << std::endl;
+        std::cout << "    TSLA:  " << tsla_return << "%" << std::endl;
+        std::cout << "    SAP:   " << sap_return << "% (EUR), EURUSD " << eurusd_return << "%" << std::noshowpos << std::endl;
         
         // Check if correlation is visible (AAPL and GOOGL should tend to move together)
         bool aapl_googl_same_dir = (aapl_return > 0) == (googl_return > 0);
@@ -259,13 +291,16 @@ int main() {
 
         // Show instrument prices
         std::cout << "=== Final Instrument Prices ===" << std::endl;
-        std::cout << "AAPL:  $" << apple->get_price() << std::endl;
-        std::cout << "GOOGL: $" << google->get_price() << std::endl;
-        std::cout << "TSLA:  $" << tesla->get_price() << std::endl;
-        std::cout << "TSLA Call: $" << tesla_call->get_price() 
-                  << " (TTE: " << tesla_call->get_time_to_expiry() << "y)" << std::endl;
-        std::cout << "AAPL Put:  $" << apple_put->get_price()
-                  << " (TTE: " << apple_put->get_time_to_expiry() << "y)" << std::endl;
+        std::cout << "AAPL:  $" << registry.get(apple).get_price() << std::endl;
+        std::cout << "GOOGL: $" << registry.get(google).get_price() << std::endl;
+        std::cout << "TSLA:  $" << registry.get(tesla).get_price() << std::endl;
+        std::cout << "SAP:   EUR " << registry.get(sap).get_price() << " (EURUSD "
+                  << std::setprecision(4) << market.get_market_environment().get_fx_spot("EUR") << ")"
+                  << std::setprecision(2) << std::endl;
+        std::cout << "TSLA Call: $" << registry.get(tesla_call).get_price() 
+                  << " (TTE: " << registry.get_option(tesla_call).get_time_to_expiry() << "y)" << std::endl;
+        std::cout << "AAPL Put:  $" << registry.get(apple_put).get_price()
+                  << " (TTE: " << registry.get_option(apple_put).get_time_to_expiry() << "y)" << std::endl;
         std::cout << std::endl;
 
         // Final Greeks
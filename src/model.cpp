@@ -2,6 +2,7 @@
 
 #include "../include/model.hh"
 #include "../include/marketEnvironment.hh"
+#include "../include/localVol.hh"
 
 // ============================================================================
 // BlackScholesModel - Market Environment implementations
@@ -19,24 +20,21 @@ double BlackScholesModel::simulate_step(double current_price, double dt,
 double BlackScholesModel::simulate_step(double current_price, double dt, double random_z,
                                          const std::string& ticker,
                                          const MarketEnvironment& env) {
-    // Get rate from yield curve (short rate for simulation)
-    double r = env.get_yield_curve().get_short_rate();
+    // Drift rate: base short rate (rate differential for FX factors)
+    double r = env.get_drift_rate(ticker);
     
-    // Get ATM vol from vol surface
-    double sigma = env.get_vol_surface(ticker).get_atm_vol(dt);
+    // First step's forward vol (= ATM vol at dt); later steps need their index
+    double sigma = ForwardVolTable::get_forward_vol(env.get_vol_surface(ticker), dt, 0);
     
-    double drift = (r - 0.5 * sigma * sigma) * dt;
-    double diffusion = sigma * std::sqrt(dt) * random_z;
-    
-    return current_price * std::exp(drift + diffusion);
+    return simulate_step(current_price, dt, random_z, r, sigma);
 }
 
 double BlackScholesModel::price_option(double S, double K, double T,
                                         const std::string& ticker,
                                         const MarketEnvironment& env,
                                         bool is_call) const {
-    // Get rate from yield curve at option maturity
-    double r = env.get_rate(T);
+    // Get rate from the yield curve of the underlying's currency at option maturity
+    double r = env.get_rate(T, env.get_currency(ticker));
     
     // Get implied vol from vol surface at this strike and expiry
     double sigma = env.get_vol(ticker, K, T);
@@ -48,8 +46,8 @@ Greeks BlackScholesModel::calculate_greeks(double S, double K, double T,
                                             const std::string& ticker,
                                             const MarketEnvironment& env,
                                             bool is_call) const {
-    // Get rate from yield curve
-    double r = env.get_rate(T);
+    // Get rate from the yield curve of the underlying's currency
+    double r = env.get_rate(T, env.get_currency(ticker));
     
     // Get implied vol from vol surface
     double sigma = env.get_vol(ticker, K, T);
@@ -73,48 +71,74 @@ double JumpDiffusionModel::simulate_step(double current_price, double dt,
 double JumpDiffusionModel::simulate_step(double current_price, double dt, double random_z,
                                           const std::string& ticker,
                                           const MarketEnvironment& env) {
-    // Get rate from yield curve
-    double r = env.get_yield_curve().get_short_rate();
-    
-    // Get vol from vol surface
-    double sigma = env.get_vol_surface(ticker).get_atm_vol(dt);
+    // Drift rate: base short rate (rate differential for FX factors)
+    double r = env.get_drift_rate(ticker);
     
-    // GBM component with external random
-    double k = std::exp(jump_mean_ + 0.5 * jump_vol_ * jump_vol_) - 1.0;
-    double drift = (r - jump_intensity_ * k - 0.5 * sigma * sigma) * dt;
-    double diffusion = sigma * std::sqrt(dt) * random_z;
-    
-    // Jump component (Poisson process) - note: jumps are idiosyncratic (independent)
-    int num_jumps = poisson_dist_(generator_);
-    double jump_component = 0.0;
-    for (int i = 0; i < num_jumps; ++i) {
-        jump_component += jump_size_dist_(generator_);
-    }
+    // First step's forward vol (= ATM vol at dt); later steps need their index
+    double sigma = ForwardVolTable::get_forward_vol(env.get_vol_surface(ticker), dt, 0);
     
-    return current_price * std::exp(drift + diffusion + jump_component);
+    // Jumps are idiosyncratic (independent) even with a correlated diffusion
+    return simulate_step(current_price, dt, random_z, r, sigma);
 }
 
 double JumpDiffusionModel::price_option(double S, double K, double T,
                                          const std::string& ticker,
                                          const MarketEnvironment& env,
                                          bool is_call) const {
-    double r = env.get_rate(T);
+    double r = env.get_rate(T, env.get_currency(ticker));
     double sigma = env.get_vol(ticker, K, T);
     
     // Use BS approximation (would need MC for proper jump-diffusion pricing)
-    BlackScholesModel bs(r, sigma);
-    return bs.price_option(S, K, T, r, sigma, is_call);
+    return price_option(S, K, T, r, sigma, is_call);
 }
 
 Greeks JumpDiffusionModel::calculate_greeks(double S, double K, double T,
                                              const std::string& ticker,
                                              const MarketEnvironment& env,
                                              bool is_call) const {
-    double r = env.get_rate(T);
+    double r = env.get_rate(T, env.get_currency(ticker));
     double sigma = env.get_vol(ticker, K, T);
     
-    BlackScholesModel bs(r, sigma);
-    return bs.calculate_greeks(S, K, T, r, sigma, is_call);
+    return calculate_greeks(S, K, T, r, sigma, is_call);
+}
+
+// ============================================================================
+// ForwardVolTable
+// ============================================================================
+
+ForwardVolTable::ForwardVolTable(const std::vector<std::string>& tickers, double dt, size_t num_steps,
+                                 const MarketEnvironment& env)
+    : num_assets_(tickers.size()), vols_(num_steps * tickers.size()) {
+    drift_rates_.reserve(num_assets_);
+    for (size_t a = 0; a < num_assets_; ++a) {
+        drift_rates_.push_back(env.get_drift_rate(tickers[a]));
+        const VolatilitySurface& surface = env.get_vol_surface(tickers[a]);
+        
+        double variance = 0.0;
+        for (size_t step = 0; step < num_steps; ++step) {
+            double next = accumulate_variance(surface, variance, (step + 1) * dt);
+            vols_[step * num_assets_ + a] = std::sqrt((next - variance) / dt);
+            variance = next;
+        }
+    }
+}
+
+double ForwardVolTable::accumulate_variance(const VolatilitySurface& surface, double variance, double t) {
+    return std::max(variance, surface.get_atm_total_variance(t));
+}
+
+double ForwardVolTable::get_total_variance(const VolatilitySurface& surface, double dt, size_t steps) {
+    double variance = 0.0;
+    for (size_t s = 1; s <= steps; ++s) {
+        variance = accumulate_variance(surface, variance, s * dt);
+    }
+    return variance;
+}
+
+double ForwardVolTable::get_forward_vol(const VolatilitySurface& surface, double dt, size_t step) {
+    double start = get_total_variance(surface, dt, step);
+    double end = accumulate_variance(surface, start, (step + 1) * dt);
+    return std::sqrt((end - start) / dt);
 }
 
 // ============================================================================
@@ -125,28 +149,76 @@ std::map<std::string, double> MultiAssetSimulator::generate_correlated_shocks(
     const std::vector<std::string>& tickers,
     const MarketEnvironment& env) {
     
-    const auto& corr_matrix = env.get_correlation_matrix();
     size_t n = tickers.size();
     
-    // Generate independent standard normals
-    std::vector<double> independent_z(n);
-    for (size_t i = 0; i < n; ++i) {
-        independent_z[i] = normal_dist_(generator_);
+    // Regime-switching: correlate with the live market's current regime,
+    // mapping back by asset index
+    const auto& regimes = env.get_correlation_regimes();
+    if (regimes.size() > 0) {
+        if (current_regime_ == kNoRegime) current_regime_ = regimes.get_initial_regime();
+        const CorrelationMatrix& corr = regimes.get_regime(current_regime_);
+        
+        std::vector<double> independent_z(corr.size());
+        for (auto& z : independent_z) {
+            z = normal_dist_(generator_);
+        }
+        std::vector<double> modelled_z = corr.correlate(independent_z);
+        
+        std::map<std::string, double> result;
+        for (const auto& ticker : tickers) {
+            result[ticker] = corr.has_ticker(ticker)
+                ? modelled_z[corr.get_asset_index(ticker)]
+                : normal_dist_(generator_);  // Unmodelled assets are independent
+        }
+        return result;
     }
     
-    // Apply Cholesky transformation if correlation matrix is available
-    std::vector<double> correlated_z;
-    if (corr_matrix.size() == n) {
-        correlated_z = corr_matrix.correlate(independent_z);
-    } else {
-        // Fall back to independent if no correlation defined
-        correlated_z = independent_z;
+    // Structured correlation: draw k factors + one residual per modelled asset,
+    // then map back by asset index (O(n*k + sum of block^2) per step)
+    const auto& structured = env.get_structured_correlation();
+    if (structured.size() > 0) {
+        std::vector<double> independent_z(structured.num_random_inputs());
+        for (auto& z : independent_z) {
+            z = normal_dist_(generator_);
+        }
+        std::vector<double> modelled_z = structured.correlate(independent_z);
+        
+        std::map<std::string, double> result;
+        for (const auto& ticker : tickers) {
+            result[ticker] = structured.has_ticker(ticker)
+                ? modelled_z[structured.get_asset_index(ticker)]
+                : normal_dist_(generator_);  // Unmodelled assets are independent
+        }
+        return result;
+    }
+    
+    const auto& corr_matrix = env.get_correlation_matrix();
+    
+    // Fall back to independent if no correlation defined
+    if (corr_matrix.size() == 0) {
+        std::map<std::string, double> result;
+        for (size_t i = 0; i < n; ++i) {
+            result[tickers[i]] = normal_dist_(generator_);
+        }
+        return result;
+    }
+    
+    // Generate independent standard normals (one per modelled asset)
+    std::vector<double> independent_z(corr_matrix.size());
+    for (auto& z : independent_z) {
+        z = normal_dist_(generator_);
     }
     
-    // Map back to tickers
+    // Apply Cholesky transformation
+    std::vector<double> correlated_z = corr_matrix.correlate(independent_z);
+    
+    // Map back to tickers by asset index (equities and FX factors may come in
+    // any order); unmodelled assets are independent
     std::map<std::string, double> result;
-    for (size_t i = 0; i < n; ++i) {
-        result[tickers[i]] = correlated_z[i];
+    for (const auto& ticker : tickers) {
+        result[ticker] = corr_matrix.has_ticker(ticker)
+            ? correlated_z[corr_matrix.get_asset_index(ticker)]
+            : normal_dist_(generator_);
     }
     
     return result;
@@ -155,7 +227,15 @@ std::map<std::string, double> MultiAssetSimulator::generate_correlated_shocks(
 std::map<std::string, double> MultiAssetSimulator::simulate_market_step(
     const std::map<std::string, double>& current_prices,
     double dt,
-    const MarketEnvironment& env) {
+    const MarketEnvironment& env,
+    size_t step) {
+    
+    // Advance the live market's regime (Markov chain) before drawing shocks
+    const auto& regimes = env.get_correlation_regimes();
+    if (regimes.size() > 0) {
+        if (current_regime_ == kNoRegime) current_regime_ = regimes.get_initial_regime();
+        current_regime_ = regimes.next_regime(current_regime_, uniform_dist_(generator_));
+    }
     
     // Get ordered list of tickers
     std::vector<std::string> tickers;
@@ -166,16 +246,32 @@ std::map<std::string, double> MultiAssetSimulator::simulate_market_step(
     // Generate correlated shocks
     auto correlated_z = generate_correlated_shocks(tickers, env);
     
-    // Apply shocks to each asset
+    // Apply shocks to each asset at this step's forward (or local) vol
     std::map<std::string, double> new_prices;
     for (const auto& [ticker, price] : current_prices) {
         double z = correlated_z[ticker];
-        new_prices[ticker] = model_.simulate_step(price, dt, z, ticker, env);
+        const LocalVolGrid* local_vol = model_.get_local_vol(ticker);
+        double sigma = local_vol ? local_vol->get_vol(step * dt, price)
+                                 : advance_live_variance(ticker, env.get_vol_surface(ticker), dt, step);
+        new_prices[ticker] = model_.simulate_step(price, dt, z, env.get_drift_rate(ticker), sigma);
     }
     
     return new_prices;
 }
 
+double MultiAssetSimulator::advance_live_variance(const std::string& ticker, const VolatilitySurface& surface,
+                                                  double dt, size_t step) {
+    LiveVariance& live = live_variance_[ticker];
+    if (live.surface_revision != surface.get_revision() || live.dt != dt || live.steps != step) {
+        live = {surface.get_revision(), dt, step, ForwardVolTable::get_total_variance(surface, dt, step)};
+    }
+    double next = ForwardVolTable::accumulate_variance(surface, live.variance, (step + 1) * dt);
+    double sigma = std::sqrt((next - live.variance) / dt);
+    live.variance = next;
+    ++live.steps;
+    return sigma;
+}
+
 std::vector<std::map<std::string, double>> MultiAssetSimulator::simulate_portfolio_paths(
     const std::map<std::string, double>& initial_prices,
     double T,
@@ -183,17 +279,49 @@ std::vector<std::map<std::string, double>> MultiAssetSimulator::simulate_portfol
     size_t steps_per_year,
     const MarketEnvironment& env) {
     
+    // Regime switching: every path carries its own regime, so run the
+    // batched flat engine and expand its terminal prices
+    if (env.get_correlation_regimes().size() > 0) {
+        ScenarioPaths<double> flat = simulate_terminal_prices<double>(initial_prices, T, num_paths,
+                                                                      steps_per_year, env);
+        std::vector<std::map<std::string, double>> final_prices(num_paths);
+        for (size_t path = 0; path < num_paths; ++path) {
+            const double* prices = flat.get_path(path);
+            for (size_t a = 0; a < flat.num_assets(); ++a) {
+                final_prices[path][flat.tickers[a]] = prices[a];
+            }
+        }
+        return final_prices;
+    }
+    
     size_t num_steps = static_cast<size_t>(T * steps_per_year);
     if (num_steps < 1) num_steps = 1;
     double dt = T / num_steps;
     
+    std::vector<std::string> tickers;
+    for (const auto& [ticker, price] : initial_prices) {
+        tickers.push_back(ticker);
+    }
+    ForwardVolTable vols(tickers, dt, num_steps, env);
+    std::vector<const LocalVolGrid*> local_vols;
+    for (const auto& ticker : tickers) {
+        local_vols.push_back(model_.get_local_vol(ticker));
+    }
+    
     std::vector<std::map<std::string, double>> final_prices(num_paths);
     
     for (size_t path = 0; path < num_paths; ++path) {
         std::map<std::string, double> prices = initial_prices;
         
         for (size_t step = 0; step < num_steps; ++step) {
-            prices = simulate_market_step(prices, dt, env);
+            auto correlated_z = generate_correlated_shocks(tickers, env);
+            const double* step_vols = vols.get_step(step);
+            size_t a = 0;
+            for (auto& [ticker, price] : prices) {
+                double sigma = local_vols[a] ? local_vols[a]->get_vol(step * dt, price) : step_vols[a];
+                price = model_.simulate_step(price, dt, correlated_z[ticker], vols.get_drift_rate(a), sigma);
+                ++a;
+            }
         }
         
         final_prices[path] = prices;
@@ -201,3 +329,250 @@ std::vector<std::map<std::string, double>> MultiAssetSimulator::simulate_portfol
     
     return final_prices;
 }
+
+template <typename Real>
+ScenarioPaths<Real> MultiAssetSimulator::simulate_terminal_prices(
+    const std::map<std::string, double>& initial_prices,
+    double T,
+    size_t num_paths,
+    size_t steps_per_year,
+    const MarketEnvironment& env) {
+    
+    size_t num_steps = static_cast<size_t>(T * steps_per_year);
+    if (num_steps < 1) num_steps = 1;
+    double dt = T / num_steps;
+    
+    ScenarioPaths<Real> result;
+    for (const auto& [ticker, price] : initial_prices) result.tickers.push_back(ticker);
+    result.prices.resize(num_paths * result.tickers.size());
+    simulate_flat<Real>(initial_prices, dt, num_steps, num_paths, env, result.prices.data(), {}, nullptr);
+    return result;
+}
+
+template <typename Real>
+std::vector<double> MultiAssetSimulator::simulate_scenario_cube(
+    const std::map<std::string, double>& initial_prices,
+    const std::vector<double>& dates,
+    size_t num_paths,
+    size_t steps_per_year,
+    const MarketEnvironment& env,
+    Real* out) {
+    
+    if (dates.empty() || !(dates.front() > 0.0) || !std::is_sorted(dates.begin(), dates.end())) {
+        throw std::invalid_argument("Scenario dates must be positive and ascending");
+    }
+    // Grid of the last date, as simulate_terminal_prices(dates.back())
+    double T = dates.back();
+    size_t num_steps = static_cast<size_t>(T * steps_per_year);
+    if (num_steps < 1) num_steps = 1;
+    double dt = T / num_steps;
+    
+    std::vector<size_t> checkpoint_steps;
+    std::vector<double> snapped;
+    for (double date : dates) {
+        auto step = static_cast<size_t>(std::llround(date / dt));
+        step = std::min(std::max<size_t>(step, 1), num_steps);
+        checkpoint_steps.push_back(step);
+        snapped.push_back(step * dt);
+    }
+    
+    std::vector<Real> state(num_paths * initial_prices.size());
+    simulate_flat(initial_prices, dt, num_steps, num_paths, env, state.data(), checkpoint_steps, out);
+    return snapped;
+}
+
+template <typename Real>
+ScenarioCube<Real> MultiAssetSimulator::simulate_scenario_cube(
+    const std::map<std::string, double>& initial_prices,
+    const std::vector<double>& dates,
+    size_t num_paths,
+    size_t steps_per_year,
+    const MarketEnvironment& env) {
+    
+    ScenarioCube<Real> cube;
+    for (const auto& [ticker, price] : initial_prices) cube.tickers.push_back(ticker);
+    cube.num_paths = num_paths;
+    cube.prices.resize(dates.size() * num_paths * cube.tickers.size());
+    cube.dates = simulate_scenario_cube(initial_prices, dates, num_paths, steps_per_year, env, cube.prices.data());
+    return cube;
+}
+
+// Step-major simulation over flat [path][asset] state. With regimes, every
+// path carries its own regime (Markov chain): at each step paths are bucketed
+// by regime and each bucket is correlated in one batch with that regime's
+// pre-factored Cholesky, so switching costs no more than the static case.
+// Without regimes all paths form one bucket.
+// The state after step k is copied out for every checkpoint at k.
+template <typename Real>
+void MultiAssetSimulator::simulate_flat(
+    const std::map<std::string, double>& initial_prices,
+    double dt,
+    size_t num_steps,
+    size_t num_paths,
+    const MarketEnvironment& env,
+    Real* prices,
+    const std::vector<size_t>& checkpoint_steps,
+    Real* checkpoints) {
+    
+    const auto& regimes = env.get_correlation_regimes();
+    const auto& structured = env.get_structured_correlation();
+    const auto& dense = env.get_correlation_matrix();
+    bool switching = regimes.size() > 0;
+    bool use_structured = !switching && structured.size() > 0;
+    
+    // Flatten: asset order = map order; corr_index maps to the correlation's asset order
+    std::vector<std::string> tickers;
+    std::vector<double> initial;
+    for (const auto& [ticker, price] : initial_prices) {
+        tickers.push_back(ticker);
+        initial.push_back(price);
+    }
+    size_t n = tickers.size();
+    
+    constexpr size_t kUnmodelled = static_cast<size_t>(-1);
+    std::vector<size_t> corr_index(n, kUnmodelled);
+    size_t d = 0;      // Correlated outputs per path
+    size_t d_in = 0;   // Independent inputs per path
+    auto map_assets = [&](const auto& layout) {
+        for (size_t a = 0; a < n; ++a) {
+            if (layout.has_ticker(tickers[a])) corr_index[a] = layout.get_asset_index(tickers[a]);
+        }
+    };
+    if (switching) {
+        map_assets(regimes.get_regime(0));
+        d = d_in = regimes.get_regime(0).size();
+    } else if (use_structured) {
+        map_assets(structured);
+        d = structured.size();
+        d_in = structured.num_random_inputs();
+    } else if (dense.size() > 0) {
+        map_assets(dense);
+        d = d_in = dense.size();
+    }
+    
+    // State: prices [path][asset], regime per path
+    for (size_t path = 0; path < num_paths; ++path) {
+        std::copy(initial.begin(), initial.end(), prices + path * n);
+    }
+    std::vector<size_t> path_regime(num_paths, switching ? regimes.get_initial_regime() : 0);
+    
+    std::vector<std::vector<size_t>> buckets(switching ? regimes.size() : 1);
+    if (!switching) {
+        buckets[0].resize(num_paths);
+        for (size_t path = 0; path < num_paths; ++path) buckets[0][path] = path;
+    }
+    std::vector<Real> independent_z, correlated_z;
+    ForwardVolTable vols(tickers, dt, num_steps, env);
+    std::vector<const LocalVolGrid*> local_vols(n);
+    for (size_t a = 0; a < n; ++a) local_vols[a] = model_.get_local_vol(tickers[a]);
+    
+    // GBM models (Black-Scholes, local vol) are stepped inline over the Real
+    // arrays: log-increments per path, then one exp pass, no virtual call.
+    // When every asset is modelled in order, the shocks are read in place
+    bool gbm = model_.get_kind() == ModelKind::BlackScholes || model_.get_kind() == ModelKind::LocalVol;
+    bool any_local_vol = false;
+    bool in_order = d == n;
+    for (size_t a = 0; a < n; ++a) {
+        any_local_vol = any_local_vol || local_vols[a];
+        in_order = in_order && corr_index[a] == a;
+    }
+    double sqrt_dt = std::sqrt(dt);
+    std::vector<Real> step_drift(n), step_diffusion(n), shocks(n), increments(n);
+    
+    for (size_t step = 0; step < num_steps; ++step) {
+        // 1. Advance every path's regime and bucket paths by regime
+        if (switching) {
+            for (auto& bucket : buckets) bucket.clear();
+            for (size_t path = 0; path < num_paths; ++path) {
+                path_regime[path] = regimes.next_regime(path_regime[path], uniform_dist_(generator_));
+                buckets[path_regime[path]].push_back(path);
+            }
+        }
+        
+        // 2. Correlate each bucket's paths together, then step the prices
+        for (size_t r = 0; r < buckets.size(); ++r) {
+            const auto& bucket = buckets[r];
+            if (bucket.empty()) continue;
+            
+            // Normals by inversion, one array pass per bucket
+            independent_z.resize(bucket.size() * d_in);
+            correlated_z.resize(bucket.size() * d);
+            fill_normals(generator_, independent_z.data(), independent_z.size());
+            if (switching) {
+                regimes.get_regime(r).correlate_batch(independent_z.data(), correlated_z.data(), bucket.size());
+            } else if (use_structured) {
+                structured.correlate_batch(independent_z.data(), correlated_z.data(), bucket.size());
+            } else if (d > 0) {
+                dense.correlate_batch(independent_z.data(), correlated_z.data(), bucket.size());
+            }
+            
+            const double* step_vols = vols.get_step(step);
+            if (!gbm) {
+                for (size_t b = 0; b < bucket.size(); ++b) {
+                    Real* path_prices = prices + bucket[b] * n;
+                    const Real* z = correlated_z.data() + b * d;
+                    for (size_t a = 0; a < n; ++a) {
+                        double shock = corr_index[a] != kUnmodelled ? z[corr_index[a]] : normal_dist_(generator_);
+                        double sigma = local_vols[a] ? local_vols[a]->get_vol(step * dt, path_prices[a]) : step_vols[a];
+                        path_prices[a] = static_cast<Real>(model_.simulate_step(
+                            path_prices[a], dt, shock, vols.get_drift_rate(a), sigma));
+                    }
+                }
+                continue;
+            }
+            
+            // S *= exp((r - sigma^2/2) dt + sigma sqrt(dt) z), as BlackScholesModel::simulate_step
+            for (size_t a = 0; a < n; ++a) {
+                step_drift[a] = static_cast<Real>((vols.get_drift_rate(a) - 0.5 * step_vols[a] * step_vols[a]) * dt);
+                step_diffusion[a] = static_cast<Real>(step_vols[a] * sqrt_dt);
+            }
+            for (size_t b = 0; b < bucket.size(); ++b) {
+                Real* path_prices = prices + bucket[b] * n;
+                const Real* shock = correlated_z.data() + b * d;
+                if (!in_order) {
+                    for (size_t a = 0; a < n; ++a) {
+                        shocks[a] = corr_index[a] != kUnmodelled ? shock[corr_index[a]]
+                                                                 : static_cast<Real>(normal_dist_(generator_));
+                    }
+                    shock = shocks.data();
+                }
+                for (size_t a = 0; a < n; ++a) increments[a] = step_drift[a] + step_diffusion[a] * shock[a];
+                if (any_local_vol) {
+                    for (size_t a = 0; a < n; ++a) {
+                        if (!local_vols[a]) continue;
+                        double sigma = local_vols[a]->get_vol(step * dt, path_prices[a]);
+                        increments[a] = static_cast<Real>((vols.get_drift_rate(a) - 0.5 * sigma * sigma) * dt +
+                                                          sigma * sqrt_dt * shock[a]);
+                    }
+                }
+                // double: std::exp, bit for bit the scalar step; float: the
+                // float fast_expf, four lanes per SSE2 instruction
+                if constexpr (std::is_same<Real, double>::value) {
+                    for (size_t a = 0; a < n; ++a) path_prices[a] *= std::exp(increments[a]);
+                } else {
+                    for (size_t a = 0; a < n; ++a) path_prices[a] *= fast_expf(increments[a]);
+                }
+            }
+        }
+        
+        // 3. Checkpoints at this step
+        for (size_t k = 0; k < checkpoint_steps.size(); ++k) {
+            if (checkpoint_steps[k] == step + 1) {
+                std::copy(prices, prices + num_paths * n, checkpoints + k * num_paths * n);
+            }
+        }
+    }
+}
+
+template ScenarioPaths<float> MultiAssetSimulator::simulate_terminal_prices<float>(
+    const std::map<std::string, double>&, double, size_t, size_t, const MarketEnvironment&);
+template ScenarioPaths<double> MultiAssetSimulator::simulate_terminal_prices<double>(
+    const std::map<std::string, double>&, double, size_t, size_t, const MarketEnvironment&);
+template std::vector<double> MultiAssetSimulator::simulate_scenario_cube<float>(
+    const std::map<std::string, double>&, const std::vector<double>&, size_t, size_t, const MarketEnvironment&, float*);
+template std::vector<double> MultiAssetSimulator::simulate_scenario_cube<double>(
+    const std::map<std::string, double>&, const std::vector<double>&, size_t, size_t, const MarketEnvironment&, double*);
+template ScenarioCube<float> MultiAssetSimulator::simulate_scenario_cube<float>(
+    const std::map<std::string, double>&, const std::vector<double>&, size_t, size_t, const MarketEnvironment&);
+template ScenarioCube<double> MultiAssetSimulator::simulate_scenario_cube<double>(
+    const std::map<std::string, double>&, const std::vector<double>&, size_t, size_t, const MarketEnvironment&);
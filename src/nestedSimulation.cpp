@@ -0,0 +1,322 @@
+// Implementation of nested (multi-horizon) simulation
+
+#include "../include/nestedSimulation.hh"
+#include "../include/localVol.hh"
+#include "../include/parallel.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static size_t to_step(double t, size_t steps_per_year) {
+    return std::max<size_t>(1, static_cast<size_t>(std::llround(t * steps_per_year)));
+}
+
+// A claim laid out on the step grid
+struct GridClaim {
+    const NestedClaim* claim;
+    size_t asset;
+    size_t maturity_step;
+    const YieldCurve* curve;  // The underlying's currency curve
+    double discount;          // Today's discount factor to maturity
+};
+
+static bool knocked_out(const NestedClaim& claim, const NodeState& state) {
+    if (claim.payoff != ClaimPayoff::KnockOut) return false;
+    return claim.is_call ? state.path_max >= claim.barrier : state.path_min <= claim.barrier;
+}
+
+static double claim_payoff(const GridClaim& grid_claim, const NodeState& state) {
+    const NestedClaim& claim = *grid_claim.claim;
+    if (knocked_out(claim, state)) return 0.0;
+    double underlying = claim.payoff == ClaimPayoff::Asian ? state.fixing_sum / grid_claim.maturity_step
+                                                          : state.spot;
+    return std::max(claim.is_call ? underlying - claim.strike : claim.strike - underlying, 0.0);
+}
+
+// Least squares beta for rows x k basis values, via the normal equations
+// (Gaussian elimination with partial pivoting); false when singular
+static bool least_squares(const std::vector<double>& basis, const std::vector<double>& y, size_t k,
+                          std::vector<double>& beta) {
+    std::vector<double> a(k * (k + 1), 0.0);  // [X'X | X'y]
+    for (size_t row = 0; row < y.size(); ++row) {
+        const double* x = &basis[row * k];
+        for (size_t i = 0; i < k; ++i) {
+            for (size_t j = 0; j < k; ++j) a[i * (k + 1) + j] += x[i] * x[j];
+            a[i * (k + 1) + k] += x[i] * y[row];
+        }
+    }
+    for (size_t col = 0; col < k; ++col) {
+        size_t pivot = col;
+        for (size_t i = col + 1; i < k; ++i) {
+            if (std::fabs(a[i * (k + 1) + col]) > std::fabs(a[pivot * (k + 1) + col])) pivot = i;
+        }
+        if (std::fabs(a[pivot * (k + 1) + col]) < 1e-12 * (1.0 + std::fabs(a[0]))) return false;
+        for (size_t j = 0; j <= k; ++j) std::swap(a[col * (k + 1) + j], a[pivot * (k + 1) + j]);
+        for (size_t i = col + 1; i < k; ++i) {
+            double factor = a[i * (k + 1) + col] / a[col * (k + 1) + col];
+            for (size_t j = col; j <= k; ++j) a[i * (k + 1) + j] -= factor * a[col * (k + 1) + j];
+        }
+    }
+    beta.assign(k, 0.0);
+    for (size_t i = k; i-- > 0;) {
+        double sum = a[i * (k + 1) + k];
+        for (size_t j = i + 1; j < k; ++j) sum -= a[i * (k + 1) + j] * beta[j];
+        beta[i] = sum / a[i * (k + 1) + i];
+    }
+    return true;
+}
+
+// ============================================================================
+// NESTED SIMULATOR
+// ============================================================================
+
+NestedSimulator::NestedSimulator(Model& model, const MarketEnvironment& env,
+                                 const std::map<std::string, double>& initial_prices,
+                                 const NestedSimulationSettings& settings)
+    : model_(model), env_(env), settings_(settings) {
+    if (settings_.steps_per_year == 0 || settings_.outer_paths == 0 || settings_.inner_paths == 0) {
+        throw std::invalid_argument("NestedSimulator: paths and steps per year must be positive");
+    }
+    if (settings_.horizons.empty()) throw std::invalid_argument("NestedSimulator: no horizons");
+    if (env.get_correlation_regimes().size() > 0) {
+        throw std::invalid_argument("NestedSimulator: correlation regimes are not supported");
+    }
+    dt_ = 1.0 / settings_.steps_per_year;
+    for (double t : settings_.horizons) {
+        size_t step = to_step(t, settings_.steps_per_year);
+        if (!(t > 0.0) || (!horizon_steps_.empty() && step <= horizon_steps_.back())) {
+            throw std::invalid_argument("NestedSimulator: horizons must be positive, ascending and a step apart");
+        }
+        horizon_steps_.push_back(step);
+    }
+    for (const auto& [ticker, price] : initial_prices) {
+        tickers_.push_back(ticker);
+        initial_.push_back(price);
+    }
+    size_t n = tickers_.size();
+
+    const auto& structured = env.get_structured_correlation();
+    const auto& dense = env.get_correlation_matrix();
+    corr_index_.assign(n, kUnmodelled);
+    auto map_assets = [&](const auto& layout) {
+        for (size_t a = 0; a < n; ++a) {
+            if (layout.has_ticker(tickers_[a])) corr_index_[a] = layout.get_asset_index(tickers_[a]);
+        }
+    };
+    if (structured.size() > 0) {
+        use_structured_ = true;
+        map_assets(structured);
+        corr_outputs_ = structured.size();
+        corr_inputs_ = structured.num_random_inputs();
+    } else if (dense.size() > 0) {
+        map_assets(dense);
+        corr_outputs_ = corr_inputs_ = dense.size();
+    }
+
+    // Outer paths, step-major, checkpointed at each horizon
+    size_t num_paths = settings_.outer_paths;
+    size_t last_step = horizon_steps_.back();
+    ForwardVolTable vols(tickers_, dt_, last_step, env);
+    std::vector<const LocalVolGrid*> local_vols(n);
+    for (size_t a = 0; a < n; ++a) local_vols[a] = model_.get_local_vol(tickers_[a]);
+
+    std::vector<NodeState> live(num_paths * n);
+    for (size_t path = 0; path < num_paths; ++path) {
+        for (size_t a = 0; a < n; ++a) live[path * n + a] = {initial_[a], 0.0, initial_[a], initial_[a]};
+    }
+    states_.resize(horizon_steps_.size() * num_paths * n);
+
+    std::mt19937 generator(settings_.seed);
+    std::vector<double> shocks;
+    size_t horizon = 0;
+    for (size_t step = 0; step < last_step; ++step) {
+        draw_shocks(generator, num_paths, shocks);
+        const double* step_vols = vols.get_step(step);
+        for (size_t i = 0; i < num_paths * n; ++i) {
+            size_t a = i % n;
+            NodeState& state = live[i];
+            double sigma = local_vols[a] ? local_vols[a]->get_vol(step * dt_, state.spot) : step_vols[a];
+            state.spot = model_.simulate_step(state.spot, dt_, shocks[i], vols.get_drift_rate(a), sigma);
+            state.fixing_sum += state.spot;
+            state.path_min = std::min(state.path_min, state.spot);
+            state.path_max = std::max(state.path_max, state.spot);
+        }
+        if (step + 1 == horizon_steps_[horizon]) {
+            std::copy(live.begin(), live.end(), states_.begin() + horizon * num_paths * n);
+            ++horizon;
+        }
+    }
+}
+
+// count correlated shock vectors, [count][asset] in ticker order
+void NestedSimulator::draw_shocks(std::mt19937& generator, size_t count, std::vector<double>& out) const {
+    size_t n = tickers_.size();
+    out.resize(count * n);
+    if (std::find(corr_index_.begin(), corr_index_.end(), kUnmodelled) != corr_index_.end()) {
+        fill_normals(generator, out.data(), out.size());  // Unmodelled assets are independent
+    }
+    if (corr_outputs_ == 0) return;
+
+    std::vector<double> independent(count * corr_inputs_), correlated(count * corr_outputs_);
+    fill_normals(generator, independent.data(), independent.size());
+    if (use_structured_) {
+        env_.get_structured_correlation().correlate_batch(independent.data(), correlated.data(), count);
+    } else {
+        env_.get_correlation_matrix().correlate_batch(independent.data(), correlated.data(), count);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t a = 0; a < n; ++a) {
+            if (corr_index_[a] != kUnmodelled) out[i * n + a] = correlated[i * corr_outputs_ + corr_index_[a]];
+        }
+    }
+}
+
+std::vector<double> NestedSimulator::value(const std::vector<NestedClaim>& claims, NestedValuation method) const {
+    size_t n = tickers_.size();
+    size_t num_paths = settings_.outer_paths;
+    size_t num_claims = claims.size();
+    std::vector<double> values(horizon_steps_.size() * num_paths, 0.0);
+
+    // Claims on the step grid, by maturity, each discounted on its
+    // underlying's curve (as the pricers and the diffusion's drift are)
+    std::vector<GridClaim> grid;
+    size_t last_step = 0;
+    for (const auto& claim : claims) {
+        auto it = std::find(tickers_.begin(), tickers_.end(), claim.ticker);
+        if (it == tickers_.end()) throw std::invalid_argument("NestedSimulator: no simulated asset " + claim.ticker);
+        if (!(claim.maturity > 0.0)) throw std::invalid_argument("NestedSimulator: maturity must be positive");
+        size_t step = to_step(claim.maturity, settings_.steps_per_year);
+        const YieldCurve& curve = env_.get_yield_curve(env_.get_currency(claim.ticker));
+        grid.push_back({&claim, static_cast<size_t>(it - tickers_.begin()), step, &curve,
+                        curve.get_discount_factor(step * dt_)});
+        last_step = std::max(last_step, step);
+    }
+    std::sort(grid.begin(), grid.end(),
+              [](const GridClaim& a, const GridClaim& b) { return a.maturity_step < b.maturity_step; });
+    size_t first_step = horizon_steps_.front();
+    if (last_step <= first_step) return values;  // Everything settles by the first horizon
+
+    // Inner shock pool [inner path][step after the node][asset], shared by
+    // every node and horizon; the second half mirrors the first (antithetic)
+    size_t inner_paths = settings_.inner_paths;
+    size_t inner_steps = last_step - first_step;
+    size_t drawn_paths = (inner_paths + 1) / 2;
+    std::mt19937 generator(settings_.seed + 1);
+    std::vector<double> pool;
+    draw_shocks(generator, drawn_paths * inner_steps, pool);
+    size_t drawn = pool.size();
+    pool.resize(inner_paths * inner_steps * n);
+    std::transform(pool.begin(), pool.begin() + (pool.size() - drawn), pool.begin() + drawn,
+                   [](double z) { return -z; });
+    ForwardVolTable vols(tickers_, dt_, last_step, env_);
+    std::vector<const LocalVolGrid*> local_vols(n);
+    for (size_t a = 0; a < n; ++a) local_vols[a] = model_.get_local_vol(tickers_[a]);
+
+    // One inner path from a node at start_step: discounted (to today) payoff
+    // of each claim in grid order, zero for claims settled by start_step
+    auto run_inner = [&](const NodeState* node, size_t start_step, size_t inner_path,
+                         std::vector<NodeState>& state, double* payoffs) {
+        state.assign(node, node + n);
+        std::fill(payoffs, payoffs + num_claims, 0.0);
+        size_t next = 0;
+        while (next < num_claims && grid[next].maturity_step <= start_step) ++next;
+        const double* z = &pool[inner_path * inner_steps * n];
+        for (size_t step = start_step; next < num_claims; ++step, z += n) {
+            for (size_t a = 0; a < n; ++a) {
+                NodeState& s = state[a];
+                double sigma = local_vols[a] ? local_vols[a]->get_vol(step * dt_, s.spot) : vols.get_vol(step, a);
+                s.spot = model_.simulate_step(s.spot, dt_, z[a], vols.get_drift_rate(a), sigma);
+                s.fixing_sum += s.spot;
+                s.path_min = std::min(s.path_min, s.spot);
+                s.path_max = std::max(s.path_max, s.spot);
+            }
+            for (; next < num_claims && grid[next].maturity_step == step + 1; ++next) {
+                payoffs[next] = grid[next].discount * claim_payoff(grid[next], state[grid[next].asset]);
+            }
+        }
+    };
+
+    for (size_t h = 0; h < horizon_steps_.size(); ++h) {
+        size_t start_step = horizon_steps_[h];
+        std::vector<double> discount(num_claims);  // Today to the horizon, per claim
+        for (size_t c = 0; c < num_claims; ++c) discount[c] = grid[c].curve->get_discount_factor(start_step * dt_);
+        double* horizon_values = &values[h * num_paths];
+
+        if (method == NestedValuation::InnerMonteCarlo) {
+            parallel_for(0, num_paths, 16, [&](size_t lo, size_t hi) {
+                std::vector<NodeState> state;
+                std::vector<double> payoffs(num_claims);
+                for (size_t path = lo; path < hi; ++path) {
+                    double sum = 0.0;
+                    for (size_t j = 0; j < inner_paths; ++j) {
+                        run_inner(get_node(h, path), start_step, j, state, payoffs.data());
+                        for (size_t c = 0; c < num_claims; ++c) {
+                            sum += grid[c].claim->quantity * payoffs[c] / discount[c];
+                        }
+                    }
+                    horizon_values[path] = sum / inner_paths;
+                }
+            }, settings_.num_threads);
+            continue;
+        }
+
+        // Regression: one inner path per node, then a fit per claim
+        std::vector<double> payoffs(num_paths * num_claims);
+        parallel_for(0, num_paths, 16, [&](size_t lo, size_t hi) {
+            std::vector<NodeState> state;
+            for (size_t path = lo; path < hi; ++path) {
+                run_inner(get_node(h, path), start_step, path % inner_paths, state, &payoffs[path * num_claims]);
+            }
+        }, settings_.num_threads);
+
+        size_t degree = settings_.regression_degree;
+        std::vector<size_t> alive;
+        std::vector<double> basis, y, beta;
+        for (size_t c = 0; c < num_claims; ++c) {
+            const GridClaim& claim = grid[c];
+            if (claim.maturity_step <= start_step) continue;
+            bool asian = claim.claim->payoff == ClaimPayoff::Asian;
+            size_t k = degree + 1 + (asian ? 1 : 0);
+            double scale = 1.0 / initial_[claim.asset];
+            auto fill_basis = [&](const NodeState& s, double* x) {
+                double spot = s.spot * scale;
+                x[0] = 1.0;
+                for (size_t d = 1; d <= degree; ++d) x[d] = x[d - 1] * spot;
+                if (asian) x[degree + 1] = s.fixing_sum * scale / start_step;
+            };
+
+            alive.clear();
+            basis.clear();
+            y.clear();
+            for (size_t path = 0; path < num_paths; ++path) {
+                const NodeState& s = get_node(h, path)[claim.asset];
+                if (knocked_out(*claim.claim, s)) continue;
+                alive.push_back(path);
+                basis.resize(basis.size() + k);
+                fill_basis(s, &basis[basis.size() - k]);
+                y.push_back(payoffs[path * num_claims + c] / discount[c]);
+            }
+            if (alive.empty()) continue;
+
+            // Too few nodes for the fit: the mean is the best proxy
+            bool fitted = alive.size() > k && least_squares(basis, y, k, beta);
+            double mean = 0.0;
+            for (double v : y) mean += v;
+            mean /= y.size();
+            for (size_t i = 0; i < alive.size(); ++i) {
+                double v = mean;
+                if (fitted) {
+                    v = 0.0;
+                    for (size_t j = 0; j < k; ++j) v += beta[j] * basis[i * k + j];
+                }
+                horizon_values[alive[i]] += claim.claim->quantity * std::max(v, 0.0);
+            }
+        }
+    }
+    return values;
+}
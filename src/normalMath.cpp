@@ -0,0 +1,62 @@
+// Array forms of the normal-distribution math kernels, with run-time
+// selection of an AVX2+FMA build of the branch-free loops
+
+#include "../include/normalMath.hh"
+
+// Portable x86-64 builds carry a second, AVX2+FMA compilation of each loop
+#if !defined(RISK_NATIVE_ARCH) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define RISK_DISPATCH_AVX2
+#endif
+
+namespace {
+
+template <double (*Kernel)(double)>
+void apply_kernel(const double* x, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = Kernel(x[i]);
+}
+
+#ifdef RISK_DISPATCH_AVX2
+// Four doubles per register: evaluating every region beats branching, so
+// these loops always run the branch-free kernels
+template <double (*Kernel)(double)>
+__attribute__((target("avx2,fma"))) void apply_kernel_avx2(const double* x, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = Kernel(x[i]);
+}
+
+bool cpu_has_avx2() {
+    static const bool has = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return has;
+}
+#endif
+
+template <double (*Kernel)(double), double (*WideKernel)(double)>
+void dispatch(const double* x, double* out, size_t n) {
+#ifdef RISK_DISPATCH_AVX2
+    if (cpu_has_avx2()) return apply_kernel_avx2<WideKernel>(x, out, n);
+#endif
+    apply_kernel<Kernel>(x, out, n);
+}
+
+}  // namespace
+
+void fast_exp(const double* x, double* out, size_t n) { dispatch<fast_exp<>, fast_exp<true>>(x, out, n); }
+
+void fast_log(const double* x, double* out, size_t n) { dispatch<fast_log<>, fast_log<true>>(x, out, n); }
+
+void norm_pdf(const double* x, double* out, size_t n) { dispatch<norm_pdf<>, norm_pdf<true>>(x, out, n); }
+
+void norm_cdf(const double* x, double* out, size_t n) { dispatch<norm_cdf<>, norm_cdf<true>>(x, out, n); }
+
+void inv_norm_cdf(const double* p, double* out, size_t n) {
+    dispatch<inv_norm_cdf<>, inv_norm_cdf<true>>(p, out, n);
+}
+
+const char* array_kernel_target() {
+#if defined(RISK_NATIVE_ARCH)
+    return "native";
+#elif defined(RISK_DISPATCH_AVX2)
+    return cpu_has_avx2() ? "avx2+fma" : "baseline";
+#else
+    return "baseline";
+#endif
+}
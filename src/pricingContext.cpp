@@ -0,0 +1,36 @@
+// Implementation of PricingContext precomputation
+
+#include "../include/pricingContext.hh"
+#include "../include/instrumentRegistry.hh"
+
+PricingContext::PricingContext(const MarketEnvironment& env, const InstrumentRegistry& registry,
+                               double time_shift)
+    : PricingContext(env) {
+    registry.for_each_option([&](const Option& option) { precompute(option, time_shift); });
+}
+
+PricingContext::PricingContext(const MarketEnvironment& env, const InstrumentRegistry& registry,
+                               const std::vector<InstrumentId>& options)
+    : PricingContext(env) {
+    for (auto id : options) precompute(registry.get_option(id), 0.0);
+}
+
+void PricingContext::precompute(const Option& option, double time_shift) {
+    const std::string& ticker = option.get_underlying().get_ticker();
+    if (surfaces_.find(&ticker) == surfaces_.end()) {
+        surfaces_.emplace(&ticker, &env_->get_vol_surface(ticker));
+    }
+
+    double T = std::max(0.0, option.get_time_to_expiry() - time_shift);
+    if (option.get_currency_ptr() == currency_ptr_ || option.get_currency() == currency_) {
+        currency_ptr_ = option.get_currency_ptr();
+        if (rates_by_expiry_.find(T) == rates_by_expiry_.end()) {
+            rates_by_expiry_.emplace(T, make_curve_point(curve_->get_rate(T), T));
+        }
+    } else {
+        auto& rates = foreign_rates_[option.get_currency_ptr()];
+        if (rates.find(T) == rates.end()) {
+            rates.emplace(T, make_curve_point(env_->get_rate(T, option.get_currency()), T));
+        }
+    }
+}
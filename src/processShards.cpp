@@ -0,0 +1,159 @@
+// Implementation of multi-process sharding
+
+#include "../include/processShards.hh"
+
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define RISK_ENGINE_HAS_FORK 1
+#endif
+
+#ifdef RISK_ENGINE_HAS_FORK
+
+// Wire format per worker: one status byte (0 = result, 1 = error message),
+// then the payload up to EOF
+constexpr char kShardOk = 0;
+constexpr char kShardFailed = 1;
+
+static bool write_all(int fd, const char* data, size_t n) {
+    while (n > 0) {
+        ssize_t written = ::write(fd, data, n);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        n -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// Worker side: never returns
+[[noreturn]] static void run_worker(size_t shard, const ShardWork& work, int fd) {
+    char status = kShardOk;
+    std::vector<char> payload;
+    try {
+        SnapshotWriter out;
+        work(shard, out);
+        payload = out.get_buffer();
+    } catch (const std::exception& e) {
+        status = kShardFailed;
+        std::string message = e.what();
+        payload.assign(message.begin(), message.end());
+    } catch (...) {
+        status = kShardFailed;
+        std::string message = "unknown error";
+        payload.assign(message.begin(), message.end());
+    }
+    bool sent = write_all(fd, &status, 1) && write_all(fd, payload.data(), payload.size());
+    ::close(fd);
+    // _exit: no atexit handlers or stdio flushes of the parent's state
+    ::_exit(sent && status == kShardOk ? 0 : 1);
+}
+
+std::vector<std::vector<char>> run_process_shards(size_t num_shards, const ShardWork& work) {
+    std::vector<pid_t> pids;
+    std::vector<int> fds;
+    auto abandon = [&]() {
+        for (int fd : fds) if (fd >= 0) ::close(fd);
+        for (pid_t pid : pids) {
+            ::kill(pid, SIGKILL);
+            ::waitpid(pid, nullptr, 0);
+        }
+    };
+
+    for (size_t shard = 0; shard < num_shards; ++shard) {
+        int pipe_fds[2];
+        if (::pipe(pipe_fds) != 0) {
+            abandon();
+            throw std::runtime_error("run_process_shards: cannot create pipe");
+        }
+        pid_t pid = ::fork();
+        if (pid < 0) {
+            ::close(pipe_fds[0]);
+            ::close(pipe_fds[1]);
+            abandon();
+            throw std::runtime_error("run_process_shards: cannot fork worker " + std::to_string(shard));
+        }
+        if (pid == 0) {
+            ::close(pipe_fds[0]);
+            for (int fd : fds) ::close(fd);  // Earlier workers' read ends
+            run_worker(shard, work, pipe_fds[1]);
+        }
+        ::close(pipe_fds[1]);
+        pids.push_back(pid);
+        fds.push_back(pipe_fds[0]);
+    }
+
+    // Drain every pipe as data arrives, so no worker stalls on a full pipe
+    std::vector<std::vector<char>> received(num_shards);
+    std::vector<char> chunk(1 << 16);
+    size_t open = num_shards;
+    while (open > 0) {
+        std::vector<pollfd> polled;
+        std::vector<size_t> shard_of;
+        for (size_t shard = 0; shard < num_shards; ++shard) {
+            if (fds[shard] < 0) continue;
+            polled.push_back({fds[shard], POLLIN, 0});
+            shard_of.push_back(shard);
+        }
+        if (::poll(polled.data(), polled.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            abandon();
+            throw std::runtime_error("run_process_shards: poll failed");
+        }
+        for (size_t k = 0; k < polled.size(); ++k) {
+            if (!(polled[k].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            size_t shard = shard_of[k];
+            ssize_t n = ::read(fds[shard], chunk.data(), chunk.size());
+            if (n < 0 && errno == EINTR) continue;
+            if (n > 0) {
+                received[shard].insert(received[shard].end(), chunk.data(), chunk.data() + n);
+                continue;
+            }
+            ::close(fds[shard]);  // EOF (or a read error: the status check reports it)
+            fds[shard] = -1;
+            --open;
+        }
+    }
+
+    // Reap everyone before reporting, so no worker is left behind
+    std::string failure;
+    for (size_t shard = 0; shard < num_shards; ++shard) {
+        int status = 0;
+        while (::waitpid(pids[shard], &status, 0) < 0 && errno == EINTR) {}
+        if (!failure.empty()) continue;
+        const auto& data = received[shard];
+        if (!data.empty() && data[0] == kShardFailed) {
+            failure = "worker " + std::to_string(shard) + " failed: " + std::string(data.begin() + 1, data.end());
+        } else if (WIFSIGNALED(status)) {
+            failure = "worker " + std::to_string(shard) + " killed by signal " + std::to_string(WTERMSIG(status));
+        } else if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || data.empty()) {
+            failure = "worker " + std::to_string(shard) + " exited without a result";
+        }
+    }
+    if (!failure.empty()) throw std::runtime_error("run_process_shards: " + failure);
+
+    for (auto& data : received) data.erase(data.begin());  // Status byte
+    return received;
+}
+
+#else
+
+std::vector<std::vector<char>> run_process_shards(size_t num_shards, const ShardWork& work) {
+    std::vector<std::vector<char>> received;
+    for (size_t shard = 0; shard < num_shards; ++shard) {
+        SnapshotWriter out;
+        work(shard, out);
+        received.push_back(out.get_buffer());
+    }
+    return received;
+}
+
+#endif
@@ -0,0 +1,105 @@
+// Implementation of the published risk results store
+
+#include "../include/resultsStore.hh"
+#include <stdexcept>
+#include <algorithm>
+
+// Marks a slot as claimed by a reader that has not pinned an epoch yet
+static const RiskResults kClaimedSlot{};
+
+// ============================================================================
+// VIEW
+// ============================================================================
+
+ResultsStore::View::View(View&& other) noexcept : slot_(other.slot_), results_(other.results_) {
+    other.slot_ = nullptr;
+    other.results_ = nullptr;
+}
+
+ResultsStore::View& ResultsStore::View::operator=(View&& other) noexcept {
+    if (this != &other) {
+        release();
+        slot_ = other.slot_;
+        results_ = other.results_;
+        other.slot_ = nullptr;
+        other.results_ = nullptr;
+    }
+    return *this;
+}
+
+void ResultsStore::View::release() {
+    if (slot_) slot_->store(nullptr, std::memory_order_release);
+    slot_ = nullptr;
+    results_ = nullptr;
+}
+
+// ============================================================================
+// READ - Claim a slot, then pin the current epoch
+// All pin/publish operations are sequentially consistent: if the re-check
+// still sees `results` current, the writer's later scan sees the pin.
+// ============================================================================
+
+ResultsStore::View ResultsStore::read() const {
+    std::atomic<const RiskResults*>* slot = nullptr;
+    for (auto& candidate : slots_) {
+        const RiskResults* expected = nullptr;
+        if (candidate.pinned.compare_exchange_strong(expected, &kClaimedSlot)) {
+            slot = &candidate.pinned;
+            break;
+        }
+    }
+    if (!slot) {
+        throw std::runtime_error("ResultsStore: more than " + std::to_string(kMaxReaders) +
+                                 " concurrent readers");
+    }
+
+    const RiskResults* results = current_.load();
+    while (true) {
+        slot->store(results ? results : &kClaimedSlot);
+        const RiskResults* again = current_.load();
+        if (again == results) break;
+        results = again;
+    }
+
+    if (!results) {
+        slot->store(nullptr, std::memory_order_release);
+        return View();
+    }
+    return View(slot, results);
+}
+
+// ============================================================================
+// PUBLISH - Swap in the new epoch, free whatever no reader still pins
+// ============================================================================
+
+void ResultsStore::publish(RiskResults results) {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    std::uint64_t epoch = epoch_.load(std::memory_order_relaxed) + 1;
+    results.epoch = epoch;
+
+    const RiskResults* previous = current_.exchange(new RiskResults(std::move(results)));
+    epoch_.store(epoch, std::memory_order_release);
+    if (previous) retired_.push_back(previous);
+    reclaim();
+}
+
+void ResultsStore::reclaim() {
+    std::vector<const RiskResults*> pinned;
+    for (const auto& slot : slots_) {
+        const RiskResults* p = slot.pinned.load();
+        if (p && p != &kClaimedSlot) pinned.push_back(p);
+    }
+
+    auto still_pinned = [&](const RiskResults* p) {
+        return std::find(pinned.begin(), pinned.end(), p) != pinned.end();
+    };
+    auto keep = std::partition(retired_.begin(), retired_.end(), still_pinned);
+    for (auto it = keep; it != retired_.end(); ++it) delete *it;
+    retired_.erase(keep, retired_.end());
+}
+
+ResultsStore::~ResultsStore() {
+    // Views must not outlive the store
+    for (const RiskResults* p : retired_) delete p;
+    delete current_.load();
+}
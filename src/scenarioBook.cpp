@@ -0,0 +1,78 @@
+// Implementation of the scenario revaluation book
+
+#include "../include/scenarioBook.hh"
+
+#include <iterator>
+#include <type_traits>
+#include <unordered_map>
+
+ScenarioBook::ScenarioBook(const std::vector<Portfolio>& portfolios, const MarketEnvironment& env,
+                           const std::vector<double>& dates)
+    : dates_(dates) {
+    // Simulated factors, at today's spots
+    const std::string& base = env.get_base_currency();
+    auto add_currency = [&](const std::string& currency) {
+        if (currency != base) initial_.emplace(env.get_fx_ticker(currency), env.get_fx_spot(currency));
+    };
+    auto add_stock = [&](const Stock& stock) {
+        const std::string& ticker = stock.get_ticker();
+        initial_.emplace(ticker, env.has_spot(ticker) ? env.get_spot(ticker) : stock.get_price());
+        add_currency(stock.get_currency());
+    };
+    for (const auto& portfolio : portfolios) {
+        add_currency(portfolio.get_currency());
+        portfolio.visit_positions([&](const auto& inst, const Position&) {
+            using T = std::decay_t<decltype(inst)>;
+            if constexpr (std::is_same_v<T, Stock>) {
+                add_stock(inst);
+            } else if constexpr (std::is_same_v<T, Option>) {
+                add_stock(inst.get_underlying());
+            } else {
+                add_currency(inst.get_currency());
+            }
+        });
+    }
+    auto factor_of = [&](const std::string& ticker) {
+        return static_cast<std::uint32_t>(std::distance(initial_.begin(), initial_.find(ticker)));
+    };
+    auto fx_of = [&](const std::string& currency) {
+        return currency == base ? kNone : factor_of(env.get_fx_ticker(currency));
+    };
+
+    // Distinct instruments, and per portfolio its rows and quantities
+    std::unordered_map<InstrumentId, std::uint32_t> row_of;
+    for (const auto& portfolio : portfolios) {
+        term_begin_.push_back(terms_.size());
+        reporting_fx_.push_back(fx_of(portfolio.get_currency()));
+        portfolio.visit_positions([&](const auto& inst, const Position& pos) {
+            auto [it, added] = row_of.emplace(pos.get_instrument_id(), static_cast<std::uint32_t>(instruments_.size()));
+            terms_.push_back({it->second, pos.get_quantity()});
+            if (!added) return;
+
+            using T = std::decay_t<decltype(inst)>;
+            Revaluation row{kNone, fx_of(inst.get_currency()), kNone, true, 0.0, 0.0};
+            if constexpr (std::is_same_v<T, Stock>) {
+                row.factor = factor_of(inst.get_ticker());
+                row.scale = inst.get_price() / initial_[inst.get_ticker()];
+            } else if constexpr (std::is_same_v<T, Option>) {
+                const Stock& underlying = inst.get_underlying();
+                row.factor = factor_of(underlying.get_ticker());
+                row.scale = underlying.get_price() / initial_[underlying.get_ticker()];
+                row.strike = inst.get_strike();
+                row.is_call = inst.get_type() == Option::Type::Call;
+                row.option = static_cast<std::uint32_t>(dates_.empty() ? 0 : option_params_.size() / dates_.size());
+                // Discounted on the underlying's curve, as every other pricer does
+                const std::string& currency = env.get_currency(underlying.get_ticker());
+                for (double date : dates_) {
+                    double tau = inst.get_time_to_expiry() - date;
+                    option_params_.push_back({tau, tau > 0.0 ? env.get_rate(tau, currency) : 0.0,
+                                              tau > 0.0 ? env.get_vol(underlying.get_ticker(), row.strike, tau) : 0.0});
+                }
+            } else {
+                row.strike = inst.get_price();
+            }
+            instruments_.push_back(row);
+        });
+    }
+    term_begin_.push_back(terms_.size());
+}
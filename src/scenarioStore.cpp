@@ -0,0 +1,262 @@
+// Implementation of the shared-memory scenario store
+
+#include "../include/scenarioStore.hh"
+#include "../include/marketEnvironment.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RISK_ENGINE_HAS_SHM 1
+#endif
+
+static size_t align_up(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+// ============================================================================
+// SEGMENTS - POSIX shared memory (no fallback: elsewhere opening throws)
+// ============================================================================
+
+#ifdef RISK_ENGINE_HAS_SHM
+
+static void* create_segment(const std::string& name, size_t size) {
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) throw std::runtime_error("Cannot create scenario store " + name + ": " + std::strerror(errno));
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        throw std::runtime_error("Cannot size scenario store " + name);
+    }
+    void* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        ::shm_unlink(name.c_str());
+        throw std::runtime_error("Cannot map scenario store " + name);
+    }
+    return base;
+}
+
+static const void* open_segment(const std::string& name, size_t& size) {
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) throw std::runtime_error("Cannot open scenario store " + name + ": " + std::strerror(errno));
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ScenarioStoreHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Scenario store " + name + ": not a scenario store");
+    }
+    size = static_cast<size_t>(st.st_size);
+    void* base = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) throw std::runtime_error("Cannot map scenario store " + name);
+    return base;
+}
+
+static void unmap_segment(const void* base, size_t size) {
+    ::munmap(const_cast<void*>(base), size);
+}
+
+static bool unlink_segment(const std::string& name) {
+    return ::shm_unlink(name.c_str()) == 0 || errno == ENOENT;
+}
+
+#else
+
+static void* create_segment(const std::string&, size_t) {
+    throw std::runtime_error("Scenario stores need POSIX shared memory");
+}
+
+static const void* open_segment(const std::string&, size_t&) {
+    throw std::runtime_error("Scenario stores need POSIX shared memory");
+}
+
+static void unmap_segment(const void*, size_t) {}
+static bool unlink_segment(const std::string&) { return true; }
+
+#endif
+
+// ============================================================================
+// PUBLISHER
+// ============================================================================
+
+SharedScenarioStore::SharedScenarioStore(const std::string& name, const std::vector<std::string>& tickers,
+                                         size_t num_dates, size_t num_paths, size_t element_size)
+    : name_(name) {
+    size_t tickers_offset = align_up(sizeof(ScenarioStoreHeader), 8);
+    size_t tickers_size = 0;
+    for (const auto& ticker : tickers) tickers_size += sizeof(std::uint32_t) + ticker.size();
+    size_t dates_offset = align_up(tickers_offset + tickers_size, 8);
+    size_t prices_offset = align_up(dates_offset + num_dates * sizeof(double), 64);
+    size_ = prices_offset + num_dates * num_paths * tickers.size() * element_size;
+    base_ = create_segment(name, size_);
+
+    auto* h = new (base_) ScenarioStoreHeader{};
+    std::memcpy(h->magic, kScenarioStoreMagic, sizeof(kScenarioStoreMagic));
+    h->version = kScenarioStoreVersion;
+    h->byte_order = kScenarioStoreByteOrderMark;
+    h->element_size = static_cast<std::uint32_t>(element_size);
+    h->layout = ScenarioLayout::DatePathAsset;
+    h->num_assets = tickers.size();
+    h->num_dates = num_dates;
+    h->num_paths = num_paths;
+    h->tickers_offset = tickers_offset;
+    h->dates_offset = dates_offset;
+    h->prices_offset = prices_offset;
+    h->total_size = size_;
+    h->ready.store(0, std::memory_order_relaxed);
+
+    char* p = static_cast<char*>(base_) + tickers_offset;
+    for (const auto& ticker : tickers) {
+        auto length = static_cast<std::uint32_t>(ticker.size());
+        std::memcpy(p, &length, sizeof(length));
+        std::memcpy(p + sizeof(length), ticker.data(), ticker.size());
+        p += sizeof(length) + ticker.size();
+    }
+}
+
+void SharedScenarioStore::set_ready(const std::vector<double>& dates) {
+    std::memcpy(static_cast<char*>(base_) + header().dates_offset, dates.data(), dates.size() * sizeof(double));
+    header().ready.store(1, std::memory_order_release);
+}
+
+template <typename Real>
+SharedScenarioStore SharedScenarioStore::publish(const std::string& name, MultiAssetSimulator& simulator,
+                                                 const std::map<std::string, double>& initial_prices,
+                                                 const std::vector<double>& dates, size_t num_paths,
+                                                 size_t steps_per_year, const MarketEnvironment& env) {
+    std::vector<std::string> tickers;
+    for (const auto& [ticker, price] : initial_prices) tickers.push_back(ticker);
+    SharedScenarioStore store(name, tickers, dates.size(), num_paths, sizeof(Real));
+    std::vector<double> snapped = simulator.simulate_scenario_cube<Real>(
+        initial_prices, dates, num_paths, steps_per_year, env, static_cast<Real*>(store.prices()));
+    store.set_ready(snapped);
+    return store;
+}
+
+template <typename Real>
+SharedScenarioStore SharedScenarioStore::publish(const std::string& name, const ScenarioCube<Real>& cube) {
+    SharedScenarioStore store(name, cube.tickers, cube.num_dates(), cube.num_paths, sizeof(Real));
+    std::copy(cube.prices.begin(), cube.prices.end(), static_cast<Real*>(store.prices()));
+    store.set_ready(cube.dates);
+    return store;
+}
+
+SharedScenarioStore::SharedScenarioStore(SharedScenarioStore&& other) noexcept
+    : name_(std::move(other.name_)), base_(other.base_), size_(other.size_), owned_(other.owned_) {
+    other.base_ = nullptr;
+    other.owned_ = false;
+}
+
+SharedScenarioStore& SharedScenarioStore::operator=(SharedScenarioStore&& other) noexcept {
+    if (this != &other) {
+        release();
+        name_ = std::move(other.name_);
+        base_ = other.base_;
+        size_ = other.size_;
+        owned_ = other.owned_;
+        other.base_ = nullptr;
+        other.owned_ = false;
+    }
+    return *this;
+}
+
+void SharedScenarioStore::release() {
+    if (base_) unmap_segment(base_, size_);
+    if (owned_) unlink_segment(name_);
+    base_ = nullptr;
+    owned_ = false;
+}
+
+void SharedScenarioStore::remove(const std::string& name) {
+    if (!unlink_segment(name)) throw std::runtime_error("Cannot remove scenario store " + name);
+}
+
+// ============================================================================
+// READER
+// ============================================================================
+
+ScenarioStoreView::ScenarioStoreView(const std::string& name) {
+    base_ = open_segment(name, size_);
+
+    auto fail = [&](const std::string& reason) {
+        unmap_segment(base_, size_);
+        base_ = nullptr;
+        throw std::runtime_error("Scenario store " + name + ": " + reason);
+    };
+    const auto* h = static_cast<const ScenarioStoreHeader*>(base_);
+    if (std::memcmp(h->magic, kScenarioStoreMagic, sizeof(kScenarioStoreMagic)) != 0) fail("bad magic");
+    if (h->version != kScenarioStoreVersion) fail("unsupported version " + std::to_string(h->version));
+    if (h->byte_order != kScenarioStoreByteOrderMark) fail("byte order mismatch");
+    if (h->ready.load(std::memory_order_acquire) != 1) fail("not published yet");
+    if (h->element_size != sizeof(float) && h->element_size != sizeof(double)) fail("bad element size");
+    if (h->layout != ScenarioLayout::DatePathAsset) fail("unknown layout");
+    if (h->total_size != size_ || h->prices_offset > size_ ||
+        h->num_dates * h->num_paths * h->num_assets * h->element_size != size_ - h->prices_offset ||
+        h->dates_offset + h->num_dates * sizeof(double) > h->prices_offset) {
+        fail("inconsistent layout");
+    }
+
+    const char* p = static_cast<const char*>(base_) + h->tickers_offset;
+    const char* end = static_cast<const char*>(base_) + h->dates_offset;
+    for (std::uint64_t a = 0; a < h->num_assets; ++a) {
+        std::uint32_t length;
+        if (end - p < static_cast<std::ptrdiff_t>(sizeof(length))) fail("truncated tickers");
+        std::memcpy(&length, p, sizeof(length));
+        p += sizeof(length);
+        if (end - p < static_cast<std::ptrdiff_t>(length)) fail("truncated tickers");
+        tickers_.emplace_back(p, length);
+        p += length;
+    }
+    dates_.resize(h->num_dates);
+    std::memcpy(dates_.data(), static_cast<const char*>(base_) + h->dates_offset, dates_.size() * sizeof(double));
+    element_size_ = h->element_size;
+    num_paths_ = h->num_paths;
+    prices_ = static_cast<const char*>(base_) + h->prices_offset;
+}
+
+ScenarioStoreView::ScenarioStoreView(ScenarioStoreView&& other) noexcept
+    : base_(other.base_), size_(other.size_), prices_(other.prices_), element_size_(other.element_size_),
+      num_paths_(other.num_paths_), tickers_(std::move(other.tickers_)), dates_(std::move(other.dates_)) {
+    other.base_ = nullptr;
+}
+
+ScenarioStoreView& ScenarioStoreView::operator=(ScenarioStoreView&& other) noexcept {
+    if (this != &other) {
+        release();
+        base_ = other.base_;
+        size_ = other.size_;
+        prices_ = other.prices_;
+        element_size_ = other.element_size_;
+        num_paths_ = other.num_paths_;
+        tickers_ = std::move(other.tickers_);
+        dates_ = std::move(other.dates_);
+        other.base_ = nullptr;
+    }
+    return *this;
+}
+
+void ScenarioStoreView::release() {
+    if (base_) unmap_segment(base_, size_);
+    base_ = nullptr;
+}
+
+size_t ScenarioStoreView::get_asset_index(const std::string& ticker) const {
+    auto it = std::find(tickers_.begin(), tickers_.end(), ticker);
+    if (it == tickers_.end()) throw std::out_of_range("Scenario store has no asset " + ticker);
+    return static_cast<size_t>(it - tickers_.begin());
+}
+
+template SharedScenarioStore SharedScenarioStore::publish<float>(
+    const std::string&, MultiAssetSimulator&, const std::map<std::string, double>&,
+    const std::vector<double>&, size_t, size_t, const MarketEnvironment&);
+template SharedScenarioStore SharedScenarioStore::publish<double>(
+    const std::string&, MultiAssetSimulator&, const std::map<std::string, double>&,
+    const std::vector<double>&, size_t, size_t, const MarketEnvironment&);
+template SharedScenarioStore SharedScenarioStore::publish<float>(const std::string&, const ScenarioCube<float>&);
+template SharedScenarioStore SharedScenarioStore::publish<double>(const std::string&, const ScenarioCube<double>&);
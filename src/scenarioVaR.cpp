@@ -0,0 +1,149 @@
+// Implementation of the streaming scenario VaR engine
+
+#include "../include/scenarioVaR.hh"
+#include "../include/parallel.hh"
+#include "../include/processShards.hh"
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+
+ScenarioVaREngine::ScenarioVaREngine(Model& model, const MarketEnvironment& env,
+                                     const std::vector<Portfolio>& portfolios,
+                                     const ScenarioVaRSettings& settings)
+    : model_(model), env_(env), settings_(settings),
+      book_(portfolios, env, {0.0, settings.horizon}) {
+    if (!(settings_.horizon > 0.0)) throw std::invalid_argument("ScenarioVaREngine: horizon must be positive");
+    if (settings_.num_scenarios == 0 || settings_.block_scenarios == 0 || settings_.steps_per_year == 0) {
+        throw std::invalid_argument("ScenarioVaREngine: scenarios, block size and steps per year must be positive");
+    }
+
+    // Today's values at today's spots, in each reporting currency
+    std::vector<double> spots;
+    for (const auto& [ticker, spot] : book_.get_initial_prices()) spots.push_back(spot);
+    auto spot_of = [&spots](std::uint32_t f) { return spots[f]; };
+    for (size_t p = 0; p < book_.num_portfolios(); ++p) {
+        double value = 0.0;
+        for (const auto* term = book_.terms_begin(p); term != book_.terms_end(p); ++term) {
+            value += term->quantity * book_.value(term->instrument, 0, spot_of);
+        }
+        std::uint32_t reporting_fx = book_.get_reporting_fx(p);
+        base_values_.push_back(reporting_fx == ScenarioBook::kNone ? value : value / spots[reporting_fx]);
+    }
+    reset();
+}
+
+void ScenarioVaREngine::reset() {
+    sketches_.assign(book_.num_portfolios(), QuantileSketch(settings_.relative_accuracy, settings_.max_buckets));
+}
+
+template <typename F>
+void ScenarioVaREngine::evaluate_block(size_t block, F&& f) const {
+    if (block >= num_blocks()) throw std::out_of_range("ScenarioVaREngine: no such block");
+    size_t first = block * settings_.block_scenarios;
+    size_t num_scenarios = std::min(settings_.block_scenarios, settings_.num_scenarios - first);
+
+    MultiAssetSimulator simulator(model_, settings_.seed + static_cast<unsigned>(block));
+    ScenarioPaths<double> paths = simulator.simulate_terminal_prices<double>(
+        book_.get_initial_prices(), settings_.horizon, num_scenarios, settings_.steps_per_year, env_);
+
+    // Every distinct instrument once per scenario, then each portfolio's terms
+    std::vector<double> values(book_.num_instruments());
+    for (size_t s = 0; s < num_scenarios; ++s) {
+        const double* spots = paths.get_path(s);
+        auto spot_of = [spots](std::uint32_t factor) { return spots[factor]; };
+        for (size_t i = 0; i < values.size(); ++i) values[i] = book_.value(i, 1, spot_of);
+        for (size_t p = 0; p < book_.num_portfolios(); ++p) {
+            double value = 0.0;
+            for (const auto* term = book_.terms_begin(p); term != book_.terms_end(p); ++term) {
+                value += term->quantity * values[term->instrument];
+            }
+            std::uint32_t reporting_fx = book_.get_reporting_fx(p);
+            if (reporting_fx != ScenarioBook::kNone) value /= spots[reporting_fx];
+            f(p, s, value - base_values_[p]);
+        }
+    }
+}
+
+void ScenarioVaREngine::run(size_t block_begin, size_t block_end) {
+    block_end = std::min(block_end, num_blocks());
+    if (block_begin >= block_end || sketches_.empty()) return;
+
+    // Per-thread partial sketches: a block checks out a free set, so at most
+    // one set per thread exists however many blocks there are (a deque keeps
+    // checked-out sets in place while the pool grows)
+    std::deque<std::vector<QuantileSketch>> partials;
+    std::vector<std::vector<QuantileSketch>*> free_partials;
+    std::mutex pool_mutex;
+
+    parallel_for(block_begin, block_end, 1, [&](size_t lo, size_t hi) {
+        std::vector<QuantileSketch>* partial;
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            if (free_partials.empty()) {
+                partials.emplace_back(sketches_.size(),
+                                      QuantileSketch(settings_.relative_accuracy, settings_.max_buckets));
+                partial = &partials.back();
+            } else {
+                partial = free_partials.back();
+                free_partials.pop_back();
+            }
+        }
+        for (size_t block = lo; block < hi; ++block) {
+            evaluate_block(block, [partial](size_t p, size_t, double pnl) { (*partial)[p].add(pnl); });
+        }
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        free_partials.push_back(partial);
+    }, settings_.num_threads);
+
+    for (const auto& partial : partials) {
+        for (size_t p = 0; p < sketches_.size(); ++p) sketches_[p].merge(partial[p]);
+    }
+}
+
+void ScenarioVaREngine::run_sharded(size_t num_processes) {
+    size_t blocks = num_blocks();
+    num_processes = std::min(std::max<size_t>(num_processes, 1), blocks);
+    std::vector<std::vector<char>> partials = run_process_shards(num_processes, [&](size_t shard, SnapshotWriter& out) {
+        ScenarioVaREngine worker(*this);
+        if (worker.settings_.num_threads == 0) {
+            worker.settings_.num_threads = std::max<size_t>(1, hardware_threads() / num_processes);
+        }
+        worker.reset();
+        auto [begin, end] = shard_range(blocks, num_processes, shard);
+        worker.run(begin, end);
+        out.write_size(worker.sketches_.size());
+        for (const auto& sketch : worker.sketches_) SnapshotCodec::write(out, sketch);
+    });
+
+    for (const auto& data : partials) {
+        SnapshotReader in(data.data(), data.size());
+        if (in.read_size() != sketches_.size()) throw std::runtime_error("ScenarioVaREngine: shard result mismatch");
+        for (auto& sketch : sketches_) {
+            QuantileSketch partial;
+            SnapshotCodec::read(in, partial);
+            sketch.merge(partial);
+        }
+        if (!in.at_end()) throw std::runtime_error("ScenarioVaREngine: trailing data in shard result");
+    }
+}
+
+void ScenarioVaREngine::merge(const ScenarioVaREngine& other) {
+    if (other.sketches_.size() != sketches_.size()) {
+        throw std::invalid_argument("ScenarioVaREngine: merging a different set of portfolios");
+    }
+    for (size_t p = 0; p < sketches_.size(); ++p) sketches_[p].merge(other.sketches_[p]);
+}
+
+void ScenarioVaREngine::merge(size_t portfolio, const QuantileSketch& partial) {
+    sketches_.at(portfolio).merge(partial);
+}
+
+void ScenarioVaREngine::block_pnl(size_t block, std::vector<double>& pnl) const {
+    size_t first = block * settings_.block_scenarios;
+    size_t num_scenarios = first < settings_.num_scenarios
+                         ? std::min(settings_.block_scenarios, settings_.num_scenarios - first) : 0;
+    pnl.assign(sketches_.size() * num_scenarios, 0.0);
+    evaluate_block(block, [&](size_t p, size_t s, double value) { pnl[p * num_scenarios + s] = value; });
+}
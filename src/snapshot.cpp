@@ -0,0 +1,507 @@
+// Implementation of the binary snapshot format
+
+#include "../include/snapshot.hh"
+#include "../include/marketSimulator.hh"
+#include "../include/quantileSketch.hh"
+
+#include <cstdio>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RISK_ENGINE_HAS_MMAP 1
+#endif
+
+// ============================================================================
+// FILE I/O
+// ============================================================================
+
+void SnapshotWriter::save(const std::string& path) const {
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("Cannot open snapshot for writing: " + tmp_path);
+        out.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        if (!out) throw std::runtime_error("Failed writing snapshot: " + tmp_path);
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        throw std::runtime_error("Cannot replace snapshot: " + path);
+    }
+}
+
+MappedFile::MappedFile(const std::string& path) {
+#ifdef RISK_ENGINE_HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open snapshot: " + path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat snapshot: " + path);
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+        void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map snapshot: " + path);
+        }
+        data_ = static_cast<const char*>(p);
+        mapped_ = true;
+    }
+    ::close(fd);  // The mapping keeps the file alive
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) throw std::runtime_error("Cannot open snapshot: " + path);
+    fallback_.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(fallback_.data(), static_cast<std::streamsize>(fallback_.size()));
+    data_ = fallback_.data();
+    size_ = fallback_.size();
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef RISK_ENGINE_HAS_MMAP
+    if (mapped_) ::munmap(const_cast<char*>(data_), size_);
+#endif
+}
+
+// ============================================================================
+// MARKET SIMULATOR
+// ============================================================================
+
+void MarketSimulator::save_snapshot(const std::string& path) const {
+    SnapshotWriter out;
+    out.write_bytes(kSnapshotMagic, sizeof(kSnapshotMagic));
+    out.write(kSnapshotVersion);
+    out.write(kSnapshotByteOrderMark);
+    SnapshotCodec::write(out, *this);
+    out.save(path);
+}
+
+MarketSimulator MarketSimulator::load_snapshot(const std::string& path, std::unique_ptr<Model> model) {
+    if (!model) throw std::invalid_argument("load_snapshot requires a model");
+
+    MappedFile file(path);
+    SnapshotReader in(file.data(), file.size());
+
+    char magic[sizeof(kSnapshotMagic)];
+    for (auto& c : magic) c = in.read<char>();
+    if (std::memcmp(magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0) {
+        throw std::runtime_error("Not a snapshot file: " + path);
+    }
+    auto version = in.read<std::uint32_t>();
+    if (version != kSnapshotVersion) {
+        throw std::runtime_error("Unsupported snapshot version " + std::to_string(version) +
+                                 " (expected " + std::to_string(kSnapshotVersion) + ")");
+    }
+    if (in.read<std::uint32_t>() != kSnapshotByteOrderMark) {
+        throw std::runtime_error("Snapshot was written on a machine with a different byte order");
+    }
+
+    MarketSimulator sim(std::move(model));
+    SnapshotCodec::read(in, sim);
+    if (!in.at_end()) throw std::runtime_error("Corrupt snapshot: trailing data");
+    return sim;
+}
+
+void SnapshotCodec::write(SnapshotWriter& out, const MarketSimulator& sim) {
+    write(out, sim.market_env_);
+    write(out, *sim.registry_);
+    out.write_size(sim.portfolios_.size());
+    for (const auto& portfolio : sim.portfolios_) {
+        write(out, portfolio);
+    }
+    out.write(sim.simulation_day_count_);
+    out.write(static_cast<std::uint64_t>(sim.multi_asset_sim_->get_current_regime()));
+}
+
+void SnapshotCodec::read(SnapshotReader& in, MarketSimulator& sim) {
+    read(in, sim.market_env_);
+    read(in, *sim.registry_);
+    sim.tagged_stock_count_ = 0;
+    sim.tag_stock_currencies();
+    size_t num_portfolios = in.read_size();
+    sim.portfolios_.clear();
+    sim.portfolios_.reserve(num_portfolios);
+    for (size_t i = 0; i < num_portfolios; ++i) {
+        sim.portfolios_.emplace_back(sim.registry_);
+        read(in, sim.portfolios_.back());
+    }
+    sim.simulation_day_count_ = in.read<unsigned>();
+    size_t regime = static_cast<size_t>(in.read<std::uint64_t>());
+    if (regime != MultiAssetSimulator::kNoRegime && regime >= sim.market_env_.correlation_regimes_.size()) {
+        throw std::runtime_error("Corrupt snapshot: current regime out of range");
+    }
+    sim.multi_asset_sim_->set_current_regime(regime);
+}
+
+// ============================================================================
+// INSTRUMENTS AND PORTFOLIOS
+// Instruments are re-added pool by pool in index order, so every
+// InstrumentId held by a position is unchanged after the restore.
+// ============================================================================
+
+void SnapshotCodec::write(SnapshotWriter& out, const InstrumentRegistry& registry) {
+    out.write_size(registry.stock_count());
+    registry.for_each_stock([&](const Stock& stock) {
+        out.write_string(stock.get_ticker());
+        out.write_string(stock.get_currency());
+        out.write(stock.get_price());
+    });
+
+    out.write_size(registry.option_count());
+    registry.for_each_option([&](const Option& option) {
+        out.write_string(option.get_ticker());
+        out.write(registry.find(option.get_underlying().get_ticker()));
+        out.write(option.get_price());
+        out.write(option.get_strike());
+        out.write(option.get_time_to_expiry());
+        out.write(static_cast<std::uint8_t>(option.get_type()));
+    });
+
+    out.write_size(registry.bond_count());
+    registry.for_each_bond([&](const Bond& bond) {
+        out.write_string(bond.get_ticker());
+        out.write_string(bond.get_currency());
+        out.write(bond.get_price());
+        out.write(bond.get_duration());
+        out.write(bond.get_coupon_rate());
+    });
+}
+
+void SnapshotCodec::read(SnapshotReader& in, InstrumentRegistry& registry) {
+    if (registry.size() != 0) {
+        throw std::logic_error("Snapshot must be restored into an empty registry");
+    }
+
+    size_t num_stocks = in.read_size();
+    for (size_t i = 0; i < num_stocks; ++i) {
+        std::string ticker = in.read_string();
+        std::string currency = in.read_string();
+        double price = in.read<double>();
+        registry.add_stock(ticker, price, currency);
+    }
+
+    size_t num_options = in.read_size();
+    for (size_t i = 0; i < num_options; ++i) {
+        std::string ticker = in.read_string();
+        auto underlying = in.read<InstrumentId>();
+        double premium = in.read<double>();
+        double strike = in.read<double>();
+        double tte = in.read<double>();
+        auto type = in.read<std::uint8_t>();
+        if (type != static_cast<std::uint8_t>(Option::Type::Call) &&
+            type != static_cast<std::uint8_t>(Option::Type::Put)) {
+            throw std::runtime_error("Corrupt snapshot: bad option type");
+        }
+        registry.add_option(ticker, premium, strike, underlying, tte, static_cast<Option::Type>(type));
+    }
+
+    size_t num_bonds = in.read_size();
+    for (size_t i = 0; i < num_bonds; ++i) {
+        std::string ticker = in.read_string();
+        std::string currency = in.read_string();
+        double price = in.read<double>();
+        double duration = in.read<double>();
+        double coupon = in.read<double>();
+        registry.add_bond(ticker, price, duration, coupon, currency);
+    }
+}
+
+void SnapshotCodec::write(SnapshotWriter& out, const Portfolio& portfolio) {
+    out.write_string(portfolio.owner_);
+    out.write_string(portfolio.currency_);
+    out.write_size(portfolio.positions_.size());
+    for (const auto& pos : portfolio.positions_) {
+        out.write(pos.get_instrument_id());
+        out.write(pos.get_quantity());
+        out.write(pos.get_last_price());
+    }
+
+    out.write_string(portfolio.last_fx_.base_currency_);
+    out.write_size(portfolio.last_fx_.rates_.size());
+    for (const auto& [currency, rate] : portfolio.last_fx_.rates_) {
+        out.write_string(currency);
+        out.write(rate);
+    }
+}
+
+void SnapshotCodec::read(SnapshotReader& in, Portfolio& portfolio) {
+    portfolio.owner_ = in.read_string();
+    portfolio.currency_ = in.read_string();
+    size_t num_positions = in.read_size();
+    portfolio.positions_.clear();
+    portfolio.positions_.reserve(num_positions);
+    for (size_t i = 0; i < num_positions; ++i) {
+        auto id = in.read<InstrumentId>();
+        double quantity = in.read<double>();
+        double last_price = in.read<double>();
+        portfolio.registry_->get(id);  // Validates the id
+        portfolio.positions_.emplace_back(id, quantity, last_price);
+    }
+    portfolio.registry_->bump_generation();
+
+    FxRates fx(in.read_string());
+    size_t num_rates = in.read_size();
+    for (size_t i = 0; i < num_rates; ++i) {
+        std::string currency = in.read_string();
+        fx.set_rate(currency, in.read<double>());
+    }
+    portfolio.last_fx_ = std::move(fx);
+}
+
+// ============================================================================
+// RISK AGGREGATES
+// ============================================================================
+
+void SnapshotCodec::write(SnapshotWriter& out, const QuantileSketch& sketch) {
+    out.write(sketch.relative_accuracy_);
+    out.write_size(sketch.max_buckets_);
+    for (const auto* store : {&sketch.positive_, &sketch.negative_}) {
+        out.write(store->offset);
+        out.write(store->folded_top);
+        out.write_array(store->counts);
+    }
+    out.write(sketch.zero_count_);
+    out.write(sketch.count_);
+}
+
+void SnapshotCodec::read(SnapshotReader& in, QuantileSketch& sketch) {
+    double relative_accuracy = in.read<double>();
+    size_t max_buckets = in.read_size();
+    QuantileSketch restored(relative_accuracy, max_buckets);
+    std::uint64_t total = 0;
+    for (auto* store : {&restored.positive_, &restored.negative_}) {
+        store->offset = in.read<int>();
+        store->folded_top = in.read<int>();
+        store->counts = in.read_array<std::uint64_t>();
+        if (store->counts.size() > max_buckets) throw std::runtime_error("Corrupt snapshot: sketch too large");
+        for (auto c : store->counts) total += c;
+    }
+    restored.zero_count_ = in.read<std::uint64_t>();
+    restored.count_ = in.read<std::uint64_t>();
+    if (total + restored.zero_count_ != restored.count_) {
+        throw std::runtime_error("Corrupt snapshot: sketch counts do not add up");
+    }
+    sketch = std::move(restored);
+}
+
+// ============================================================================
+// MARKET ENVIRONMENT
+// ============================================================================
+
+template <typename V>
+void SnapshotCodec::write_map(SnapshotWriter& out, const std::map<std::string, V>& values) {
+    out.write_size(values.size());
+    for (const auto& [key, value] : values) {
+        out.write_string(key);
+        if constexpr (std::is_same<V, std::string>::value) {
+            out.write_string(value);
+        } else if constexpr (std::is_arithmetic<V>::value) {
+            out.write(value);
+        } else {
+            write(out, value);
+        }
+    }
+}
+
+template <typename V>
+void SnapshotCodec::read_map(SnapshotReader& in, std::map<std::string, V>& values) {
+    values.clear();
+    size_t n = in.read_size();
+    for (size_t i = 0; i < n; ++i) {
+        std::string key = in.read_string();
+        V value{};
+        if constexpr (std::is_same<V, std::string>::value) {
+            value = in.read_string();
+        } else if constexpr (std::is_arithmetic<V>::value) {
+            value = in.read<V>();
+        } else {
+            read(in, value);
+        }
+        values.emplace_hint(values.end(), std::move(key), std::move(value));  // Written sorted
+    }
+}
+
+void SnapshotCodec::write(SnapshotWriter& out, const MarketEnvironment& env) {
+    write_map(out, env.spots_);
+    out.write_string(env.base_currency_);
+    write_map(out, env.fx_currencies_);
+    write_map(out, env.ticker_currencies_);
+    write_map(out, env.yield_curves_);
+    write(out, env.default_yield_curve_);
+    write_map(out, env.vol_surfaces_);
+    write(out, env.default_vol_surface_);
+    write_map(out, env.dividend_curves_);
+    write(out, env.default_dividend_curve_);
+    write(out, env.correlation_matrix_);
+    write(out, env.structured_correlation_);
+    write(out, env.correlation_regimes_);
+    out.write(env.valuation_date_);
+}
+
+void SnapshotCodec::read(SnapshotReader& in, MarketEnvironment& env) {
+    read_map(in, env.spots_);
+    env.base_currency_ = in.read_string();
+    read_map(in, env.fx_currencies_);
+    read_map(in, env.ticker_currencies_);
+    read_map(in, env.yield_curves_);
+    read(in, env.default_yield_curve_);
+    read_map(in, env.vol_surfaces_);
+    read(in, env.default_vol_surface_);
+    read_map(in, env.dividend_curves_);
+    read(in, env.default_dividend_curve_);
+    read(in, env.correlation_matrix_);
+    read(in, env.structured_correlation_);
+    read(in, env.correlation_regimes_);
+    env.valuation_date_ = in.read<double>();
+}
+
+void SnapshotCodec::write(SnapshotWriter& out, const YieldCurve& curve) {
+    out.write_array(curve.tenors_);
+    out.write_array(curve.rates_);
+    out.write(curve.flat_rate_);
+}
+
+void SnapshotCodec::read(SnapshotReader& in, YieldCurve& curve) {
+    curve.tenors_ = in.read_array<double>();
+    curve.rates_ = in.read_array<double>();
+    curve.flat_rate_ = in.read<double>();
+    if (curve.tenors_.size() != curve.rates_.size()) {
+        throw std::runtime_error("Corrupt snapshot: yield curve tenors and rates mismatch");
+    }
+}
+
+void SnapshotCodec::write(SnapshotWriter& out, const VolatilitySurface& surface) {
+    out.write_array(surface.strikes_);
+    out.write_array(surface.expiries_);
+    out.write_size(surface.vols_.size());
+    for (const auto& row : surface.vols_) out.write_array(row);
+    out.write(surface.flat_vol_);
+}
+
+void SnapshotCodec::read(SnapshotReader& in, VolatilitySurface& surface) {
+    surface.strikes_ = in.read_array<double>();
+    surface.expiries_ = in.read_array<double>();
+    surface.vols_.resize(in.read_size());
+    for (auto& row : surface.vols_) row = in.read_array<double>();
+    surface.flat_vol_ = in.read<double>();
+    surface.revision_ = VolatilitySurface::next_revision();
+    bool shape_ok = surface.vols_.size() == surface.expiries_.size();
+    for (const auto& row : surface.vols_) shape_ok = shape_ok && row.size() == surface.strikes_.size();
+    if (!shape_ok) throw std::runtime_error("Corrupt snapshot: vol surface grid size mismatch");
+}
+
+void SnapshotCodec::write(SnapshotWriter& out, const DividendCurve& curve) {
+    out.write_size(curve.discrete_divs_.size());
+    for (const auto& [time, amount] : curve.discrete_divs_) {
+        out.write(time);
+        out.write(amount);
+    }
+    out.write(curve.yield_);
+}
+
+void SnapshotCodec::read(SnapshotReader& in, DividendCurve& curve) {
+    curve.discrete_divs_.resize(in.read_size());
+    for (auto& [time, amount] : curve.discrete_divs_) {
+        time = in.read<double>();
+        amount = in.read<double>();
+    }
+    curve.yield_ = in.read<double>();
+}
+
+// ============================================================================
+// CORRELATION MODELS
+// Factors are stored, never recomputed: restoring an n-asset matrix is two
+// n*n memcpys instead of an O(n^3) Cholesky.
+// ============================================================================
+
+void SnapshotCodec::write(SnapshotWriter& out, const CorrelationMatrix& corr) {
+    out.write_strings(corr.tickers_);
+    out.write_array(corr.corr_matrix_);
+    out.write_array(corr.cholesky_);
+}
+
+void SnapshotCodec::read(SnapshotReader& in, CorrelationMatrix& corr) {
+    corr.tickers_ = in.read_strings();
+    corr.corr_matrix_ = in.read_array<double>();
+    corr.cholesky_ = in.read_array<double>();
+    size_t n = corr.tickers_.size();
+    if (corr.corr_matrix_.size() != n * n || corr.cholesky_.size() != n * n) {
+        throw std::runtime_error("Corrupt snapshot: correlation matrix size mismatch");
+    }
+    corr.cholesky_float_.assign(corr.cholesky_.begin(), corr.cholesky_.end());
+    corr.build_index();
+}
+
+void SnapshotCodec::write(SnapshotWriter& out, const StructuredCorrelation& corr) {
+    out.write_strings(corr.tickers_);
+    out.write_size(corr.num_factors_);
+    out.write_array(corr.loadings_);
+    out.write_size(corr.sector_members_.size());
+    for (const auto& members : corr.sector_members_) out.write_array(members);
+    for (const auto& factor : corr.sector_cholesky_) out.write_array(factor);
+}
+
+void SnapshotCodec::read(SnapshotReader& in, StructuredCorrelation& corr) {
+    corr.tickers_ = in.read_strings();
+    corr.num_factors_ = in.read_size();
+    corr.loadings_ = in.read_array<double>();
+    size_t num_sectors = in.read_size();
+    corr.sector_members_.resize(num_sectors);
+    for (auto& members : corr.sector_members_) members = in.read_array<size_t>();
+    corr.sector_cholesky_.resize(num_sectors);
+    for (auto& factor : corr.sector_cholesky_) factor = in.read_array<double>();
+    size_t n = corr.tickers_.size();
+    if (corr.loadings_.size() != n * corr.num_factors_) {
+        throw std::runtime_error("Corrupt snapshot: factor loadings size mismatch");
+    }
+    // correlate() reads one residual per asset, sector by sector: every
+    // asset must be in exactly one sector, with a b x b factor per sector
+    std::vector<bool> assigned(n, false);
+    size_t num_members = 0;
+    for (size_t s = 0; s < num_sectors; ++s) {
+        const auto& members = corr.sector_members_[s];
+        for (size_t asset : members) {
+            if (asset >= n || assigned[asset]) {
+                throw std::runtime_error("Corrupt snapshot: sector member out of range");
+            }
+            assigned[asset] = true;
+        }
+        num_members += members.size();
+        if (corr.sector_cholesky_[s].size() != members.size() * members.size()) {
+            throw std::runtime_error("Corrupt snapshot: sector Cholesky size mismatch");
+        }
+    }
+    if (num_members != n) {
+        throw std::runtime_error("Corrupt snapshot: assets missing from sectors");
+    }
+
+    corr.ticker_index_.clear();
+    for (size_t i = 0; i < corr.tickers_.size(); ++i) {
+        corr.ticker_index_[corr.tickers_[i]] = i;
+    }
+}
+
+void SnapshotCodec::write(SnapshotWriter& out, const CorrelationRegimes& regimes) {
+    out.write_size(regimes.regimes_.size());
+    for (const auto& regime : regimes.regimes_) write(out, regime);
+    out.write_array(regimes.cumulative_);
+    out.write_size(regimes.initial_regime_);
+}
+
+void SnapshotCodec::read(SnapshotReader& in, CorrelationRegimes& regimes) {
+    regimes.regimes_.resize(in.read_size());
+    for (auto& regime : regimes.regimes_) read(in, regime);
+    regimes.cumulative_ = in.read_array<double>();
+    regimes.initial_regime_ = in.read_size();
+    size_t m = regimes.regimes_.size();
+    if (regimes.cumulative_.size() != m * m || (m > 0 && regimes.initial_regime_ >= m)) {
+        throw std::runtime_error("Corrupt snapshot: regime transition matrix size mismatch");
+    }
+}
@@ -0,0 +1,344 @@
+// Implementation of incremental tick ingestion
+
+#include "../include/tickIngestor.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "../include/parallel.hh"
+
+constexpr size_t kRepriceGrain = 1024;  // Options per parallel task
+constexpr size_t kFoldGrain = 1024;     // Instrument moves per parallel fold task
+
+TickIngestor::TickIngestor(MarketSimulator& market) : market_(market) {
+    sync_with_graph();
+}
+
+// ============================================================================
+// GRAPH SYNC - Re-seed live values whenever the graph was rebuilt
+// ============================================================================
+
+void TickIngestor::rebuild() {
+    market_.rebuild_dependency_graph();
+    sync_with_graph();
+}
+
+void TickIngestor::sync_with_graph() {
+    graph_ = &market_.get_dependency_graph();
+    if (graph_->get_generation() == graph_generation_ && !live_values_.empty()) return;
+    graph_generation_ = graph_->get_generation();
+
+    live_values_.assign(graph_->get_bucket_count(), 0.0);
+    bucket_currency_.assign(graph_->get_bucket_count(), nullptr);
+    for (size_t id = 0; id < market_.get_portfolio_count(); ++id) {
+        const auto& buckets = graph_->get_buckets(id);
+        for (const auto& [ccy, bucket] : buckets) bucket_currency_[bucket] = ccy;
+        for (const auto& [currency, value] : market_.get_portfolio(id).get_value_by_currency()) {
+            for (const auto& [ccy, bucket] : buckets) {
+                if (ccy == currency) live_values_[bucket] = value;
+            }
+        }
+    }
+
+    const InstrumentRegistry& registry = market_.get_registry();
+    targets_.clear();
+    changed_flag_[0].assign(registry.stock_count(), 0);
+    changed_flag_[1].assign(registry.option_count(), 0);
+    changed_flag_[2].assign(registry.bond_count(), 0);
+    option_dirty_flag_.assign(registry.option_count(), 0);
+
+    // Rho of every option at the current market, and per bucket, for
+    // first-order rate moves
+    option_rho_.assign(registry.option_count(), 0.0);
+    option_stale_flag_.assign(registry.option_count(), 0);
+    stale_options_.clear();
+    num_stale_ = 0;
+    PricingContext context(market_.get_market_environment(), registry);
+
+    // Vol and curve point of every option, as the context resolves them
+    option_vol_.resize(registry.option_count());
+    option_curve_node_.resize(registry.option_count());
+    curve_nodes_.clear();
+    std::unordered_map<const std::string*, std::unordered_map<double, std::uint32_t>> node_index;
+    registry.for_each_option_span([&](InstrumentSpan<const Option> options) {
+        for (size_t i = 0; i < options.size(); ++i) {
+            const Option& option = options[i];
+            double T = option.get_time_to_expiry();
+            size_t index = options.get_first_index() + i;
+            option_vol_[index] = context.get_vol(option, T);
+            auto [node, added] = node_index[option.get_currency_ptr()].try_emplace(
+                T, static_cast<std::uint32_t>(curve_nodes_.size()));
+            if (added) curve_nodes_.push_back({option.get_currency_ptr(), T, context.get_curve_point(option, T)});
+            option_curve_node_[index] = node->second;
+        }
+    });
+
+    OptionPricer<kOutputRho> pricer(market_.get_model(), context);
+    registry.for_each_option_span([&](InstrumentSpan<const Option> options) {
+        double* rho = option_rho_.data() + options.get_first_index();
+        pricer.evaluate_batch(
+            options.size(), [&](size_t i) -> const Option& { return options[i]; },
+            [&](size_t i, const PricingResult& result) { rho[i] = result.greeks.rho; });
+    });
+    option_new_rho_ = option_rho_;
+    live_rho_.assign(graph_->get_bucket_count(), 0.0);
+    for (size_t i = 0; i < option_rho_.size(); ++i) {
+        for (const auto& holder : graph_->get_holders(make_instrument_id(InstrumentType::Option, static_cast<std::uint32_t>(i)))) {
+            live_rho_[holder.bucket] += holder.quantity * option_rho_[i];
+        }
+    }
+}
+
+// Resolved once per key; environment slots only for the tick types seen
+TickIngestor::TickTarget& TickIngestor::resolve(const std::string& key) {
+    auto [it, added] = targets_.try_emplace(key);
+    if (added) {
+        InstrumentId id = market_.get_registry().find(key);
+        if (id != kInvalidInstrumentId && get_instrument_type(id) == InstrumentType::Stock) it->second.stock = id;
+    }
+    return it->second;
+}
+
+// Exact rates and discount factors of a currency's expiries from its curve
+void TickIngestor::refresh_curve_nodes(const std::string& currency) {
+    const YieldCurve& curve = market_.get_market_environment().get_yield_curve(currency);
+    for (auto& node : curve_nodes_) {
+        if (*node.currency != currency) continue;
+        double rate = curve.get_rate(node.expiry);
+        node.point = {rate, std::exp(-rate * node.expiry)};
+    }
+}
+
+// ============================================================================
+// BATCH APPLICATION
+// 1. Ticks update the environment and move stocks/bonds directly; vol and
+//    rate ticks refresh the cached vols / curve points they move
+// 2. A moved curve's options take the first-order rho move, folded per
+//    bucket through live_rho_, and go stale
+// 3. Options depending on a moved underlying or surface are repriced once
+//    each, at their cached inputs (refreshing their rho)
+// 4. Every changed price and rho is folded into the live aggregates
+// ============================================================================
+
+void TickIngestor::record_change(InstrumentId id, double old_price) {
+    char& flag = changed_flag_[static_cast<size_t>(get_instrument_type(id))][get_instrument_index(id)];
+    if (flag) return;  // Keep the price from before the batch
+    flag = 1;
+    changed_.emplace_back(id, old_price);
+}
+
+void TickIngestor::mark_option_dirty(InstrumentId option) {
+    char& flag = option_dirty_flag_[get_instrument_index(option)];
+    if (flag) return;
+    flag = 1;
+    dirty_options_.push_back(option);
+}
+
+TickBatchStats TickIngestor::apply(const TickBatch& batch) {
+    auto start = std::chrono::steady_clock::now();
+    sync_with_graph();
+
+    MarketEnvironment& env = market_.get_market_environment();
+    InstrumentRegistry& registry = market_.get_registry();
+    TickBatchStats stats;
+    stats.ticks = batch.size();
+
+    for (const auto& tick : batch) {
+        switch (tick.type) {
+            case TickType::Spot: {
+                TickTarget& target = resolve(tick.key);
+                if (!target.spot) target.spot = &env.get_spot_slot(tick.key);
+                *target.spot = tick.value;
+                if (target.stock == kInvalidInstrumentId) break;
+                Stock& stock = registry.get_stock(target.stock);
+                record_change(target.stock, stock.get_price());
+                stock.set_price(tick.value);
+                for (auto option : registry.get_dependent_options(target.stock)) mark_option_dirty(option);
+                break;
+            }
+            case TickType::Vol: {
+                TickTarget& target = resolve(tick.key);
+                if (!target.surface) target.surface = &env.get_vol_surface_slot(tick.key);
+                target.surface->bump(tick.value);
+                if (target.stock == kInvalidInstrumentId) break;
+                for (auto id : registry.get_dependent_options(target.stock)) {
+                    const Option& option = registry.get_option(id);
+                    option_vol_[get_instrument_index(id)] =
+                        target.surface->get_vol(option.get_strike(), option.get_time_to_expiry());
+                    mark_option_dirty(id);
+                }
+                break;
+            }
+            case TickType::Rate: {
+                env.bump_yield_curve(tick.key, tick.value);
+                refresh_curve_nodes(tick.key);
+                auto shift = std::find_if(rate_shifts_.begin(), rate_shifts_.end(),
+                                          [&](const auto& entry) { return entry.first == tick.key; });
+                if (shift == rate_shifts_.end()) {
+                    rate_shifts_.emplace_back(tick.key, tick.value);
+                } else {
+                    shift->second += tick.value;
+                }
+                // Bonds: first-order duration move, as in the stress test
+                for (auto id : graph_->get_bonds_in_currency(tick.key)) {
+                    Bond& bond = registry.get_bond(id);
+                    record_change(id, bond.get_price());
+                    bond.set_price(bond.get_price() * (1.0 - bond.get_duration() * tick.value));
+                }
+                break;
+            }
+        }
+    }
+    stats.instruments_updated = changed_.size();
+
+    // First order for rate moves. Dirty options move too, so their exact
+    // repricing below folds only what the first-order move missed
+    for (const auto& [currency, shift] : rate_shifts_) {
+        for (size_t bucket = 0; bucket < live_rho_.size(); ++bucket) {
+            if (*bucket_currency_[bucket] == currency) live_values_[bucket] += live_rho_[bucket] * shift;
+        }
+        for (auto id : graph_->get_options_in_currency(currency)) {
+            size_t index = get_instrument_index(id);
+            if (option_rho_[index] == 0.0) continue;
+            Option& option = registry.get_option(id);
+            option.set_price(option.get_price() + option_rho_[index] * shift);
+            if (!option_dirty_flag_[index] && !option_stale_flag_[index]) {
+                option_stale_flag_[index] = 1;
+                stale_options_.push_back(id);
+                ++num_stale_;
+            }
+            ++stats.options_rate_adjusted;
+        }
+    }
+    rate_shifts_.clear();
+
+    reprice_dirty_options(stats);
+    fold_changes(stats);
+
+    stats.elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+TickBatchStats TickIngestor::reprice_stale() {
+    auto start = std::chrono::steady_clock::now();
+    sync_with_graph();
+
+    TickBatchStats stats;
+    for (auto id : stale_options_) {
+        if (option_stale_flag_[get_instrument_index(id)]) mark_option_dirty(id);
+    }
+    stale_options_.clear();
+    reprice_dirty_options(stats);
+    fold_changes(stats);
+
+    stats.elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+// Dirty options: exact price and rho, in parallel (each writes only its own)
+void TickIngestor::reprice_dirty_options(TickBatchStats& stats) {
+    if (dirty_options_.empty()) return;
+    InstrumentRegistry& registry = market_.get_registry();
+    for (auto id : dirty_options_) {
+        size_t index = get_instrument_index(id);
+        record_change(id, registry.get_option(id).get_price());
+        option_dirty_flag_[index] = 0;
+        if (option_stale_flag_[index]) {
+            option_stale_flag_[index] = 0;
+            --num_stale_;
+        }
+    }
+
+    // Inputs are cached, so the context is never read
+    PricingContext context(market_.get_market_environment());
+    OptionPricer<kOutputPrice | kOutputRho> pricer(market_.get_model(), context);
+    parallel_for(0, dirty_options_.size(), kRepriceGrain, [&](size_t lo, size_t hi) {
+        const InstrumentId* ids = dirty_options_.data() + lo;
+        pricer.evaluate_batch_at(
+            hi - lo, [&](size_t i) -> const Option& { return registry.get_option(ids[i]); },
+            [&](size_t i) {
+                size_t index = get_instrument_index(ids[i]);
+                return OptionInputs{curve_nodes_[option_curve_node_[index]].point, option_vol_[index]};
+            },
+            [&](size_t i, const PricingResult& result) {
+                registry.get_option(ids[i]).set_price(result.price);
+                option_new_rho_[get_instrument_index(ids[i])] = result.greeks.rho;
+            });
+    });
+    stats.options_repriced += dirty_options_.size();
+    dirty_options_.clear();
+}
+
+// Every changed price (and repriced option's rho) into the live aggregates:
+// moves are collected first, then split across tasks, each summing its
+// share of the holders into its own bucket accumulators, which are reduced
+// into the live aggregates bucket by bucket
+void TickIngestor::fold_changes(TickBatchStats& stats) {
+    const InstrumentRegistry& registry = market_.get_registry();
+    for (const auto& [id, old_price] : changed_) {
+        size_t type = static_cast<size_t>(get_instrument_type(id));
+        size_t index = get_instrument_index(id);
+        changed_flag_[type][index] = 0;
+
+        double move = registry.get(id).get_price() - old_price;
+        double rho_move = 0.0;
+        if (get_instrument_type(id) == InstrumentType::Option) {
+            rho_move = option_new_rho_[index] - option_rho_[index];
+            option_rho_[index] = option_new_rho_[index];
+        }
+        if (move == 0.0 && rho_move == 0.0) continue;
+        moves_.push_back({id, move, rho_move});
+        stats.positions_touched += graph_->get_holders(id).size();
+    }
+    changed_.clear();
+
+    size_t tasks = std::min(hardware_threads(), moves_.size() / kFoldGrain);
+    if (tasks <= 1) {
+        fold_moves(0, moves_.size(), live_values_.data(), live_rho_.data());
+        moves_.clear();
+        return;
+    }
+
+    size_t buckets = live_values_.size();
+    fold_scratch_.assign(2 * buckets * tasks, 0.0);
+    parallel_for(0, tasks, 1, [&](size_t lo, size_t hi) {
+        for (size_t task = lo; task < hi; ++task) {
+            double* values = fold_scratch_.data() + 2 * buckets * task;
+            fold_moves(moves_.size() * task / tasks, moves_.size() * (task + 1) / tasks, values, values + buckets);
+        }
+    }, tasks);
+    parallel_for(0, buckets, kFoldGrain, [&](size_t lo, size_t hi) {
+        for (size_t task = 0; task < tasks; ++task) {
+            const double* values = fold_scratch_.data() + 2 * buckets * task;
+            for (size_t b = lo; b < hi; ++b) {
+                live_values_[b] += values[b];
+                live_rho_[b] += values[buckets + b];
+            }
+        }
+    });
+    moves_.clear();
+}
+
+void TickIngestor::fold_moves(size_t begin, size_t end, double* values, double* rho) const {
+    for (size_t m = begin; m < end; ++m) {
+        const InstrumentMove& entry = moves_[m];
+        if (entry.rho_move == 0.0) {
+            for (const auto& holder : graph_->get_holders(entry.id)) values[holder.bucket] += holder.quantity * entry.move;
+            continue;
+        }
+        for (const auto& holder : graph_->get_holders(entry.id)) {
+            values[holder.bucket] += holder.quantity * entry.move;
+            rho[holder.bucket] += holder.quantity * entry.rho_move;
+        }
+    }
+}
+
+double TickIngestor::get_portfolio_value(size_t id) const {
+    FxRates fx = market_.get_market_environment().get_fx_rates();
+    const std::string& reporting = market_.get_portfolio(id).get_currency();
+    double total = 0.0;
+    for (const auto& [ccy, bucket] : graph_->get_buckets(id)) {
+        total += live_values_[bucket] * fx.get_conversion(*ccy, reporting);
+    }
+    return total;
+}
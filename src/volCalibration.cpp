@@ -0,0 +1,316 @@
+// Implementation of the implied vol solver and vol surface calibrator
+
+#include "../include/volCalibration.hh"
+#include "../include/normalMath.hh"
+#include "../include/parallel.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+// ============================================================================
+// IMPLIED VOL SOLVER
+// Everything is in total vol v = sigma * sqrt(T) and log-moneyness
+// x = ln(S / K e^{-rT}), where
+//   price = w (S N(w d1) - DK N(w d2)),  d1 = x/v + v/2,  d2 = d1 - v
+//   dprice/dv = S phi(d1),  d2price/dv2 = S phi(d1) d1 d2 / v
+// with w = +1 call / -1 put and DK the discounted strike. In-the-money
+// quotes are solved as the out-of-the-money option of the other type via
+// put-call parity: the time value is the same, without the intrinsic part
+// swamping it in the residual.
+// ============================================================================
+
+// Smallest time value, relative to the premium, an ITM quote may carry:
+// below it the premium's rounding swamps the time value
+constexpr double kMinTimeValue = 1e-9;
+
+// Corrado-Miller total vol for a call worth c; inflection-point vol when
+// the approximation has no real root
+static double initial_total_vol(double S, double DK, double x, double c) {
+    double half_intrinsic = 0.5 * (S - DK);
+    double a = c - half_intrinsic;
+    double discriminant = a * a - (S - DK) * (S - DK) / M_PI;
+    double corrado_miller = std::sqrt(2.0 * M_PI) / (S + DK) * (a + std::sqrt(std::max(discriminant, 0.0)));
+    return discriminant > 0.0 ? corrado_miller : std::sqrt(2.0 * std::fabs(x));
+}
+
+// Unsolved options, structure of arrays; index maps a slot back to its
+// input position
+struct ImpliedVolWork {
+    std::vector<size_t> index;
+    std::vector<double> spot, discounted_strike, moneyness, sign, log_target, v, lo, hi, sqrt_t;
+
+    std::vector<std::vector<double>*> columns() {
+        return {&spot, &discounted_strike, &moneyness, &sign, &log_target, &v, &lo, &hi, &sqrt_t};
+    }
+};
+
+// One branch-free Halley / bisection step for each of n options; change
+// receives |step taken|, or 0 on an exact hit.
+// The residual is taken on log prices: an OTM premium decays like
+// exp(-x^2 / 2v^2) as the vol falls, so in price space Newton crawls
+// (and a tiny premium sits below the residual's rounding), while the
+// log price is close to quadratic in 1/v. A price that rounds to zero or
+// below makes the Halley candidate NaN, which fails both bracket tests and
+// so falls through to bisection. Pointers are __restrict: with this many arrays
+// the compiler would otherwise give up on runtime alias checks.
+static void halley_round(const double* __restrict spot, const double* __restrict discounted_strike,
+                         const double* __restrict moneyness, const double* __restrict sign,
+                         const double* __restrict log_target, double* __restrict v,
+                         double* __restrict lo, double* __restrict hi, double* __restrict change, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        double vi = v[i];
+        double w = sign[i];
+        double d1 = moneyness[i] / vi + 0.5 * vi;
+        double d2 = d1 - vi;
+        double price = w * (spot[i] * ::norm_cdf(w * d1) - discounted_strike[i] * ::norm_cdf(w * d2));
+        double vega = spot[i] * ::norm_pdf(d1);
+        double f = fast_log(price) - log_target[i];
+
+        double slope = vega / price;  // d ln(price) / dv
+        double ratio = f / slope;
+        double correction = 1.0 - 0.5 * ratio * (d1 * d2 / vi - slope);
+        double step = correction > 0.5 ? ratio / correction : ratio;  // Newton where Halley overshoots
+
+        double new_lo = f < 0.0 ? vi : lo[i];
+        double new_hi = f > 0.0 ? vi : hi[i];
+        double candidate = vi - step;
+        double midpoint = 0.5 * (new_lo + new_hi);
+        double next = candidate >= new_lo ? candidate : midpoint;
+        next = candidate <= new_hi ? next : midpoint;
+        lo[i] = new_lo;
+        hi[i] = new_hi;
+        v[i] = next;
+        change[i] = f == 0.0 ? 0.0 : std::fabs(next - vi);
+    }
+}
+
+double ImpliedVolSolver::solve(double S, double K, double T, double r, double premium, bool is_call) const {
+    unsigned char call = is_call;
+    double vol;
+    solve(&S, &K, &T, &r, &premium, &call, &vol, 1);
+    return vol;
+}
+
+void ImpliedVolSolver::solve(const double* S, const double* K, const double* T, const double* r,
+                             const double* premium, const unsigned char* is_call, double* vol_out,
+                             size_t n) const {
+    ImpliedVolWork work;
+    work.index.reserve(n);
+    for (auto* column : work.columns()) column->reserve(n);
+
+    for (size_t i = 0; i < n; ++i) {
+        vol_out[i] = std::numeric_limits<double>::quiet_NaN();
+        if (!(T[i] > 0.0 && S[i] > 0.0 && K[i] > 0.0)) continue;
+
+        double DK = K[i] * fast_exp(-r[i] * T[i]);
+        double w = is_call[i] ? 1.0 : -1.0;
+        double lower = std::max(0.0, w * (S[i] - DK));
+        double upper = is_call[i] ? S[i] : DK;
+        double x = fast_log(S[i] / DK);
+        double otm_sign = x > 0.0 ? -1.0 : 1.0;
+        double otm_premium = otm_sign == w ? premium[i] : premium[i] - w * (S[i] - DK);
+        if (!(premium[i] > lower && premium[i] < upper && otm_premium > kMinTimeValue * premium[i])) continue;
+
+        double root_t = std::sqrt(T[i]);
+        double call_premium = otm_sign > 0.0 ? otm_premium : otm_premium + S[i] - DK;
+        double guess = initial_total_vol(S[i], DK, x, call_premium);
+        double min_v = settings_.min_vol * root_t;
+        double max_v = settings_.max_vol * root_t;
+
+        work.index.push_back(i);
+        work.spot.push_back(S[i]);
+        work.discounted_strike.push_back(DK);
+        work.moneyness.push_back(x);
+        work.sign.push_back(otm_sign);
+        work.log_target.push_back(fast_log(otm_premium));
+        work.v.push_back(guess > min_v && guess < max_v ? guess : 0.5 * (min_v + max_v));
+        work.lo.push_back(min_v);
+        work.hi.push_back(max_v);
+        work.sqrt_t.push_back(root_t);
+    }
+
+    // Converged options leave the working set after each round, so later
+    // rounds only touch the stragglers and stay contiguous loops
+    size_t live = work.index.size();
+    std::vector<double> change(live);
+    std::vector<std::vector<double>*> columns = work.columns();
+    for (unsigned iteration = 0; iteration < settings_.max_iterations && live > 0; ++iteration) {
+        halley_round(work.spot.data(), work.discounted_strike.data(), work.moneyness.data(), work.sign.data(),
+                     work.log_target.data(), work.v.data(), work.lo.data(), work.hi.data(), change.data(), live);
+
+        size_t kept = 0;
+        for (size_t i = 0; i < live; ++i) {
+            if (change[i] <= settings_.tolerance * work.v[i]) {
+                vol_out[work.index[i]] = work.v[i] / work.sqrt_t[i];
+                continue;
+            }
+            work.index[kept] = work.index[i];
+            for (auto* column : columns) (*column)[kept] = (*column)[i];
+            ++kept;
+        }
+        live = kept;
+    }
+    // Unconverged after max_iterations (typically a vol outside [min_vol, max_vol]) stay NaN
+}
+
+// ============================================================================
+// VOL SURFACE CALIBRATOR
+// ============================================================================
+
+struct QuotedVol {
+    double strike;
+    double expiry;
+    double vol;
+    bool out_of_the_money;
+};
+
+struct TickerCalibration {
+    bool built = false;
+    size_t rejected = 0;
+    VolatilitySurface surface;
+};
+
+static size_t axis_index(const std::vector<double>& axis, double value) {
+    return static_cast<size_t>(std::lower_bound(axis.begin(), axis.end(), value) - axis.begin());
+}
+
+// Fills NaN cells of one expiry row from their strike neighbours
+static void fill_strike_gaps(std::vector<double>& row) {
+    size_t previous = row.size();  // Last known cell
+    for (size_t k = 0; k < row.size(); ++k) {
+        if (std::isnan(row[k])) continue;
+        if (previous == row.size()) {
+            std::fill(row.begin(), row.begin() + k, row[k]);
+        } else {
+            for (size_t j = previous + 1; j < k; ++j) {
+                double t = static_cast<double>(j - previous) / static_cast<double>(k - previous);
+                row[j] = row[previous] + t * (row[k] - row[previous]);
+            }
+        }
+        previous = k;
+    }
+    if (previous < row.size()) std::fill(row.begin() + previous + 1, row.end(), row[previous]);
+}
+
+// Grid over the distinct quoted strikes and expiries; OTM quotes take
+// precedence in a cell, equal-precedence quotes are averaged
+static VolatilitySurface build_grid(const std::vector<QuotedVol>& points) {
+    std::vector<double> strikes, expiries;
+    for (const auto& p : points) {
+        strikes.push_back(p.strike);
+        expiries.push_back(p.expiry);
+    }
+    for (auto* axis : {&strikes, &expiries}) {
+        std::sort(axis->begin(), axis->end());
+        axis->erase(std::unique(axis->begin(), axis->end()), axis->end());
+    }
+
+    struct Cell { double sum = 0.0; size_t count = 0; bool out_of_the_money = false; };
+    std::vector<Cell> cells(expiries.size() * strikes.size());
+    for (const auto& p : points) {
+        Cell& cell = cells[axis_index(expiries, p.expiry) * strikes.size() + axis_index(strikes, p.strike)];
+        if (cell.count && cell.out_of_the_money && !p.out_of_the_money) continue;
+        if (cell.count && p.out_of_the_money && !cell.out_of_the_money) cell = Cell{};
+        cell.sum += p.vol;
+        ++cell.count;
+        cell.out_of_the_money = p.out_of_the_money;
+    }
+
+    std::vector<std::vector<double>> vols(expiries.size(), std::vector<double>(strikes.size()));
+    for (size_t e = 0; e < expiries.size(); ++e) {
+        for (size_t k = 0; k < strikes.size(); ++k) {
+            const Cell& cell = cells[e * strikes.size() + k];
+            vols[e][k] = cell.count ? cell.sum / cell.count : std::nan("");
+        }
+        fill_strike_gaps(vols[e]);
+    }
+    return VolatilitySurface(strikes, expiries, vols);
+}
+
+static TickerCalibration calibrate_ticker(const std::vector<OptionQuote>& quotes,
+                                          const std::vector<size_t>& indices,
+                                          const MarketEnvironment& env,
+                                          const ImpliedVolSolver& solver, size_t min_quotes) {
+    TickerCalibration result;
+    size_t n = indices.size();
+    double spot = env.get_spot(quotes[indices.front()].ticker);
+
+    std::vector<double> S(n, spot), K(n), T(n), r(n), premium(n), vol(n);
+    std::vector<unsigned char> is_call(n);
+    for (size_t j = 0; j < n; ++j) {
+        const OptionQuote& q = quotes[indices[j]];
+        K[j] = q.strike;
+        T[j] = q.expiry;
+        r[j] = env.get_rate(q.expiry, q.currency.empty() ? env.get_currency(q.ticker) : q.currency);
+        premium[j] = q.premium;
+        is_call[j] = q.is_call;
+    }
+    solver.solve(S.data(), K.data(), T.data(), r.data(), premium.data(), is_call.data(), vol.data(), n);
+
+    std::vector<QuotedVol> points;
+    points.reserve(n);
+    for (size_t j = 0; j < n; ++j) {
+        if (std::isnan(vol[j])) {
+            ++result.rejected;
+            continue;
+        }
+        double forward = spot * std::exp(r[j] * T[j]);
+        bool otm = is_call[j] ? K[j] >= forward : K[j] <= forward;
+        points.push_back({K[j], T[j], vol[j], otm});
+    }
+    if (points.empty() || points.size() < min_quotes) return result;
+
+    result.surface = build_grid(points);
+    result.built = true;
+    return result;
+}
+
+std::map<std::string, VolatilitySurface> VolSurfaceCalibrator::calibrate(const std::vector<OptionQuote>& quotes,
+                                                                         const MarketEnvironment& env,
+                                                                         CalibrationReport* report) const {
+    // Group quote indices by ticker, tickers in first-seen order
+    std::unordered_map<std::string, size_t> ticker_index;
+    std::vector<std::vector<size_t>> groups;
+    for (size_t i = 0; i < quotes.size(); ++i) {
+        auto [it, inserted] = ticker_index.emplace(quotes[i].ticker, groups.size());
+        if (inserted) groups.emplace_back();
+        groups[it->second].push_back(i);
+    }
+
+    ImpliedVolSolver solver(options_.solver);
+    std::vector<TickerCalibration> results(groups.size());
+    parallel_for(0, groups.size(), 16, [&](size_t begin, size_t end) {
+        for (size_t g = begin; g < end; ++g) {
+            if (!env.has_spot(quotes[groups[g].front()].ticker)) continue;
+            results[g] = calibrate_ticker(quotes, groups[g], env, solver, options_.min_quotes);
+        }
+    }, options_.num_threads);
+
+    std::map<std::string, VolatilitySurface> surfaces;
+    CalibrationReport summary;
+    summary.quotes = quotes.size();
+    for (size_t g = 0; g < groups.size(); ++g) {
+        const std::string& ticker = quotes[groups[g].front()].ticker;
+        summary.rejected_quotes += results[g].rejected;
+        if (results[g].built) {
+            surfaces.emplace(ticker, std::move(results[g].surface));
+        } else {
+            summary.skipped_tickers.push_back(ticker);
+        }
+    }
+    std::sort(summary.skipped_tickers.begin(), summary.skipped_tickers.end());
+    summary.tickers = surfaces.size();
+    if (report) *report = std::move(summary);
+    return surfaces;
+}
+
+CalibrationReport VolSurfaceCalibrator::calibrate_into(const std::vector<OptionQuote>& quotes,
+                                                       MarketEnvironment& env) const {
+    CalibrationReport report;
+    for (auto& [ticker, surface] : calibrate(quotes, env, &report)) {
+        env.set_vol_surface(ticker, std::move(surface));
+    }
+    return report;
+}